@@ -0,0 +1,238 @@
+#include "benchmark_corpus.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <random>
+
+namespace astra::bench {
+
+namespace {
+
+constexpr int kSyntheticFrames = 300;  // 10 s at 30 fps
+constexpr int kSyntheticGop = 60;
+constexpr int kSyntheticAacFrames = 431;  // 10 s at 44.1 kHz
+
+// 720p parameter sets as x264 / x265 emit them, so sequence-header builds parse real syntax.
+const std::vector<uint8_t> kH264Sps = {0x67, 0x64, 0x00, 0x1F, 0xAC, 0xD9, 0x40, 0x50, 0x05, 0xBB,
+                                       0x01, 0x10, 0x00, 0x00, 0x03, 0x00, 0x10, 0x00, 0x00, 0x03,
+                                       0x03, 0xC0, 0xF1, 0x83, 0x19, 0x60};
+const std::vector<uint8_t> kH264Pps = {0x68, 0xEB, 0xE3, 0xCB, 0x22, 0xC0};
+const std::vector<uint8_t> kHevcVps = {0x40, 0x01, 0x0C, 0x01, 0xFF, 0xFF, 0x01, 0x60, 0x00, 0x00,
+                                       0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+                                       0x5D, 0x95, 0x98, 0x09};
+const std::vector<uint8_t> kHevcSps = {0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+                                       0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5D, 0xA0, 0x02,
+                                       0x80, 0x80, 0x2D, 0x16, 0x59, 0x59, 0xA4, 0x93, 0x2B, 0xC0,
+                                       0x5A, 0x70, 0x80, 0x00, 0x01, 0xF4, 0x80, 0x00, 0x3A, 0x98,
+                                       0x04};
+const std::vector<uint8_t> kHevcPps = {0x44, 0x01, 0xC1, 0x72, 0xB4, 0x62, 0x40};
+
+std::vector<uint8_t> ReadCorpusFile(const char* name) {
+    const char* dir = std::getenv("ASTRA_CORPUS_DIR");
+    if (dir == nullptr || *dir == '\0') {
+        return {};
+    }
+    std::ifstream file(std::string(dir) + "/" + name, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+struct Nal {
+    size_t begin = 0;  // start code offset
+    size_t header = 0;  // first byte after the start code
+    size_t end = 0;
+};
+
+std::vector<Nal> FindNals(const std::vector<uint8_t>& stream) {
+    std::vector<Nal> nals;
+    size_t i = 0;
+    while (i + 3 <= stream.size()) {
+        if (stream[i] == 0 && stream[i + 1] == 0 && stream[i + 2] == 1) {
+            const size_t begin = (i > 0 && stream[i - 1] == 0) ? i - 1 : i;
+            if (!nals.empty()) {
+                nals.back().end = begin;
+            }
+            nals.push_back(Nal{begin, i + 3, stream.size()});
+            i += 3;
+        } else {
+            ++i;
+        }
+    }
+    return nals;
+}
+
+// Access units start at an AUD or parameter set following picture data, or at a slice that
+// is the first of its picture.
+std::vector<std::vector<uint8_t>> SplitAccessUnits(const std::vector<uint8_t>& stream, VideoCodecId codec) {
+    std::vector<std::vector<uint8_t>> units;
+    size_t unitBegin = 0;
+    bool unitHasPicture = false;
+    for (const Nal& nal : FindNals(stream)) {
+        if (nal.header + 2 >= nal.end) {
+            continue;
+        }
+        bool vcl = false;
+        bool firstSlice = false;
+        bool prefix = false;
+        if (codec == VideoCodecId::kH264) {
+            const uint8_t type = stream[nal.header] & 0x1F;
+            vcl = type >= 1 && type <= 5;
+            firstSlice = vcl && (stream[nal.header + 1] & 0x80) != 0;  // first_mb_in_slice == 0
+            prefix = type == 6 || type == 7 || type == 8 || type == 9;
+        } else {
+            const uint8_t type = (stream[nal.header] >> 1) & 0x3F;
+            vcl = type < 32;
+            firstSlice = vcl && (stream[nal.header + 2] & 0x80) != 0;  // first_slice_segment_in_pic_flag
+            prefix = type >= 32 && type <= 39;
+        }
+        if (unitHasPicture && (prefix || firstSlice)) {
+            units.emplace_back(stream.begin() + static_cast<std::ptrdiff_t>(unitBegin),
+                               stream.begin() + static_cast<std::ptrdiff_t>(nal.begin));
+            unitBegin = nal.begin;
+            unitHasPicture = false;
+        }
+        unitHasPicture = unitHasPicture || vcl;
+    }
+    if (unitHasPicture) {
+        units.emplace_back(stream.begin() + static_cast<std::ptrdiff_t>(unitBegin), stream.end());
+    }
+    return units;
+}
+
+void AppendNal(std::vector<uint8_t>& unit, const std::vector<uint8_t>& nal) {
+    unit.insert(unit.end(), {0x00, 0x00, 0x00, 0x01});
+    unit.insert(unit.end(), nal.begin(), nal.end());
+}
+
+// Random slice body with emulation prevention applied, so it never contains a start code.
+void AppendSlice(std::vector<uint8_t>& unit, std::initializer_list<uint8_t> header, size_t size, std::mt19937& rng) {
+    unit.insert(unit.end(), {0x00, 0x00, 0x00, 0x01});
+    unit.insert(unit.end(), header);
+    unit.push_back(static_cast<uint8_t>(0x80 | (rng() & 0x7F)));  // first slice of the picture
+    int zeros = 0;
+    for (size_t i = 1; i < size; ++i) {
+        // Bias towards zero bytes like real CABAC output, to exercise the start code scan.
+        auto byte = static_cast<uint8_t>((rng() % 8 == 0) ? 0 : rng());
+        if (zeros >= 2 && byte <= 3) {
+            unit.push_back(0x03);
+            zeros = 0;
+        }
+        unit.push_back(byte);
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    if (unit.back() == 0) {
+        unit.back() = 0x80;  // rbsp_stop_one_bit
+    }
+}
+
+VideoCorpus SynthesizeVideo(VideoCodecId codec) {
+    VideoCorpus corpus;
+    corpus.codec = codec;
+    corpus.source = "synthetic";
+    std::mt19937 rng(codec == VideoCodecId::kH264 ? 264 : 265);
+    std::normal_distribution<double> interSize(9000.0, 2500.0);
+    std::normal_distribution<double> keySize(60000.0, 8000.0);
+    for (int i = 0; i < kSyntheticFrames; ++i) {
+        const bool key = i % kSyntheticGop == 0;
+        const auto size = static_cast<size_t>(std::max(key ? keySize(rng) : interSize(rng), 500.0));
+        std::vector<uint8_t> unit;
+        unit.reserve(size + 256);
+        if (codec == VideoCodecId::kH264) {
+            if (key) {
+                AppendNal(unit, kH264Sps);
+                AppendNal(unit, kH264Pps);
+            }
+            AppendSlice(unit, {static_cast<uint8_t>(key ? 0x65 : 0x41)}, size, rng);
+        } else {
+            if (key) {
+                AppendNal(unit, kHevcVps);
+                AppendNal(unit, kHevcSps);
+                AppendNal(unit, kHevcPps);
+            }
+            AppendSlice(unit, {static_cast<uint8_t>(key ? 0x26 : 0x02), 0x01}, size, rng);
+        }
+        corpus.accessUnits.push_back(std::move(unit));
+    }
+    return corpus;
+}
+
+VideoCorpus BuildVideoCorpus(VideoCodecId codec) {
+    const std::vector<uint8_t> stream = ReadCorpusFile(codec == VideoCodecId::kH264 ? "h264.264" : "hevc.265");
+    if (!stream.empty()) {
+        VideoCorpus corpus;
+        corpus.codec = codec;
+        corpus.accessUnits = SplitAccessUnits(stream, codec);
+        corpus.source = "recorded";
+        if (!corpus.accessUnits.empty()) {
+            return corpus;
+        }
+    }
+    return SynthesizeVideo(codec);
+}
+
+AudioCorpus BuildAudioCorpus() {
+    static const uint32_t kSampleRates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+                                            22050, 16000, 12000, 11025, 8000, 7350};
+    AudioCorpus corpus;
+    const std::vector<uint8_t> stream = ReadCorpusFile("aac.adts");
+    size_t offset = 0;
+    while (offset + 7 <= stream.size()) {
+        const uint8_t* header = stream.data() + offset;
+        if (header[0] != 0xFF || (header[1] & 0xF0) != 0xF0) {
+            break;
+        }
+        const size_t headerSize = (header[1] & 0x01) ? 7 : 9;
+        const size_t frameSize = (static_cast<size_t>(header[3] & 0x03) << 11) |
+                (static_cast<size_t>(header[4]) << 3) | (header[5] >> 5);
+        if (frameSize <= headerSize || offset + frameSize > stream.size()) {
+            break;
+        }
+        if (corpus.frames.empty()) {
+            const uint32_t objectType = ((header[2] >> 6) & 0x03) + 1;
+            const uint32_t rateIndex = (header[2] >> 2) & 0x0F;
+            const uint32_t channels = ((header[2] & 0x01) << 2) | (header[3] >> 6);
+            corpus.config.sampleRate = rateIndex < 13 ? kSampleRates[rateIndex] : 44100;
+            corpus.config.channels = static_cast<uint8_t>(channels);
+            corpus.config.asc = {static_cast<uint8_t>((objectType << 3) | (rateIndex >> 1)),
+                                 static_cast<uint8_t>(((rateIndex & 1) << 7) | (channels << 3))};
+        }
+        corpus.frames.emplace_back(header + headerSize, header + frameSize);
+        offset += frameSize;
+    }
+    if (!corpus.frames.empty()) {
+        corpus.source = "recorded";
+        return corpus;
+    }
+
+    corpus.source = "synthetic";
+    corpus.config.sampleRate = 44100;
+    corpus.config.channels = 2;
+    corpus.config.asc = {0x12, 0x10};  // AAC-LC, 44.1 kHz, stereo
+    std::mt19937 rng(10);
+    std::uniform_int_distribution<size_t> size(300, 420);  // ~128 kbps
+    for (int i = 0; i < kSyntheticAacFrames; ++i) {
+        std::vector<uint8_t> frame(size(rng));
+        for (auto& byte : frame) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        corpus.frames.push_back(std::move(frame));
+    }
+    return corpus;
+}
+
+}  // namespace
+
+const VideoCorpus& LoadVideoCorpus(VideoCodecId codec) {
+    static const VideoCorpus h264 = BuildVideoCorpus(VideoCodecId::kH264);
+    static const VideoCorpus hevc = BuildVideoCorpus(VideoCodecId::kH265);
+    return codec == VideoCodecId::kH264 ? h264 : hevc;
+}
+
+const AudioCorpus& LoadAudioCorpus() {
+    static const AudioCorpus corpus = BuildAudioCorpus();
+    return corpus;
+}
+
+}  // namespace astra::bench
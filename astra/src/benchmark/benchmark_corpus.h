@@ -0,0 +1,38 @@
+#ifndef ASTRASTREAM_BENCHMARK_CORPUS_H
+#define ASTRASTREAM_BENCHMARK_CORPUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FlvMuxer.h"
+
+namespace astra::bench {
+
+// Encoder output to replay through the muxer. Recorded corpora are read from the directory
+// in $ASTRA_CORPUS_DIR:
+//   h264.264   Annex-B H.264 elementary stream
+//   hevc.265   Annex-B HEVC elementary stream
+//   aac.adts   ADTS AAC
+// e.g. dumped from a device session, or `ffmpeg -i in.mp4 -c:v copy -bsf:v h264_mp4toannexb
+// -an h264.264` and `ffmpeg -i in.mp4 -c:a copy -vn -f adts aac.adts`. Missing files fall back
+// to a synthetic stream with the same NAL layout as MediaCodec output (4-byte start codes,
+// parameter sets in front of every IDR) and typical 720p30 frame sizes.
+struct VideoCorpus {
+    VideoCodecId codec = VideoCodecId::kH264;
+    std::vector<std::vector<uint8_t>> accessUnits;  // Annex-B, one encoded picture each
+    std::string source;
+};
+
+struct AudioCorpus {
+    std::vector<std::vector<uint8_t>> frames;  // raw AAC access units
+    AudioConfig config;
+    std::string source;
+};
+
+const VideoCorpus& LoadVideoCorpus(VideoCodecId codec);
+const AudioCorpus& LoadAudioCorpus();
+
+}  // namespace astra::bench
+
+#endif  // ASTRASTREAM_BENCHMARK_CORPUS_H
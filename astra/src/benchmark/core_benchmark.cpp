@@ -0,0 +1,430 @@
+// Throughput of the send path that runs per encoded frame: Annex-B parsing, in-place AVCC
+// rewrite, Exp-Golomb bit reading, sequence header and FLV tag builds, RTMP chunk layout,
+// the packet queue and MPEG-TS packetization.
+// Inputs come from benchmark_corpus.h; point ASTRA_CORPUS_DIR at recorded streams to replay
+// real encoder output.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "AVQueue.h"
+#include "BitReader.h"
+#include "FlvMuxer.h"
+#include "FrameStats.h"
+#include "RtmpChunkWriter.h"
+#include "TsMuxer.h"
+#include "benchmark_corpus.h"
+
+namespace {
+
+using astra::VideoCodecId;
+using astra::bench::LoadAudioCorpus;
+using astra::bench::LoadVideoCorpus;
+
+astra::FlvMuxer MakeMuxer(VideoCodecId codec) {
+    astra::FlvMuxer muxer;
+    astra::VideoConfig video;
+    video.codec = codec;
+    video.width = 1280;
+    video.height = 720;
+    video.fps = 30;
+    muxer.setVideoConfig(video);
+    muxer.setAudioConfig(LoadAudioCorpus().config);
+    // Capture parameter sets from the first keyframe.
+    for (const auto& unit : LoadVideoCorpus(codec).accessUnits) {
+        if (muxer.parseVideoFrame(unit.data(), unit.size()).isKeyFrame) {
+            break;
+        }
+    }
+    return muxer;
+}
+
+// Copying path: split Annex-B, drop parameter sets, length-prefix into a fresh payload.
+void BM_AnnexBParse(benchmark::State& state, VideoCodecId codec) {
+    const auto& corpus = LoadVideoCorpus(codec);
+    astra::FlvMuxer muxer = MakeMuxer(codec);
+    size_t index = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const auto& unit = corpus.accessUnits[index];
+        benchmark::DoNotOptimize(muxer.parseVideoFrame(unit.data(), unit.size()));
+        bytes += unit.size();
+        index = (index + 1) % corpus.accessUnits.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(corpus.source);
+}
+BENCHMARK_CAPTURE(BM_AnnexBParse, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_AnnexBParse, hevc, VideoCodecId::kH265);
+
+// Zero-copy path used with leased encoder buffers. The rewrite is destructive, so each
+// iteration restores the access unit first; BM_AccessUnitCopy measures that restore alone.
+void BM_AvccRewriteInPlace(benchmark::State& state, VideoCodecId codec) {
+    const auto& corpus = LoadVideoCorpus(codec);
+    astra::FlvMuxer muxer = MakeMuxer(codec);
+    std::vector<uint8_t> scratch;
+    size_t index = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const auto& unit = corpus.accessUnits[index];
+        scratch.assign(unit.begin(), unit.end());
+        benchmark::DoNotOptimize(muxer.sliceVideoFrameInPlace(scratch.data(), scratch.size()));
+        bytes += unit.size();
+        index = (index + 1) % corpus.accessUnits.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(corpus.source);
+}
+BENCHMARK_CAPTURE(BM_AvccRewriteInPlace, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_AvccRewriteInPlace, hevc, VideoCodecId::kH265);
+
+void BM_AccessUnitCopy(benchmark::State& state, VideoCodecId codec) {
+    const auto& corpus = LoadVideoCorpus(codec);
+    std::vector<uint8_t> scratch;
+    size_t index = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const auto& unit = corpus.accessUnits[index];
+        scratch.assign(unit.begin(), unit.end());
+        benchmark::ClobberMemory();
+        bytes += unit.size();
+        index = (index + 1) % corpus.accessUnits.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK_CAPTURE(BM_AccessUnitCopy, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_AccessUnitCopy, hevc, VideoCodecId::kH265);
+
+void BM_VideoSequenceHeader(benchmark::State& state, VideoCodecId codec) {
+    astra::FlvMuxer muxer = MakeMuxer(codec);
+    if (!muxer.videoSequenceReady()) {
+        state.SkipWithError("corpus has no parameter sets");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(muxer.buildVideoSequenceHeader());
+    }
+    state.SetLabel(LoadVideoCorpus(codec).source);
+}
+BENCHMARK_CAPTURE(BM_VideoSequenceHeader, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_VideoSequenceHeader, hevc, VideoCodecId::kH265);
+
+// The bit-at-a-time reader FlvMuxer used before BitReader, kept as the baseline: a bounds
+// check per bit, and an RBSP copy (ToRbsp) ahead of every parse.
+class LegacyBitReader {
+public:
+    explicit LegacyBitReader(const std::vector<uint8_t>& data) : data_(data) {}
+
+    uint32_t readBits(uint32_t count) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            value <<= 1U;
+            if (byteOffset_ >= data_.size()) {
+                continue;
+            }
+            value |= (data_[byteOffset_] >> (7U - bitOffset_)) & 0x01U;
+            if (++bitOffset_ == 8U) {
+                bitOffset_ = 0U;
+                ++byteOffset_;
+            }
+        }
+        return value;
+    }
+
+    uint32_t readUE() {
+        uint32_t leadingZeroBits = 0;
+        while (readBits(1) == 0U && leadingZeroBits < 32U) {
+            ++leadingZeroBits;
+        }
+        if (leadingZeroBits == 0U || leadingZeroBits == 32U) {
+            return 0U;
+        }
+        return ((1U << leadingZeroBits) - 1U) + readBits(leadingZeroBits);
+    }
+
+private:
+    const std::vector<uint8_t>& data_;
+    size_t byteOffset_ = 0;
+    uint32_t bitOffset_ = 0;
+};
+
+std::vector<uint8_t> LegacyToRbsp(const std::vector<uint8_t>& nal) {
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(nal.size());
+    uint32_t zeroCount = 0;
+    for (size_t i = 2; i < nal.size(); ++i) {
+        if (zeroCount >= 2 && nal[i] == 0x03) {
+            zeroCount = 0;
+            continue;
+        }
+        rbsp.push_back(nal[i]);
+        zeroCount = nal[i] == 0 ? zeroCount + 1 : 0;
+    }
+    return rbsp;
+}
+
+// A NAL unit of ue(v) codes with the value spread of SPS and slice header fields (mostly
+// small, some up to a few thousand), emulation prevention inserted as an encoder would.
+struct GolombCorpus {
+    std::vector<uint8_t> nal;
+    size_t codes = 0;
+};
+
+const GolombCorpus& LoadGolombCorpus() {
+    static const GolombCorpus corpus = [] {
+        std::mt19937 rng(43);
+        std::vector<uint8_t> rbsp;
+        uint64_t pending = 0;
+        uint32_t pendingBits = 0;
+        auto put = [&](uint32_t value, uint32_t bits) {
+            for (uint32_t i = bits; i-- > 0;) {
+                pending = (pending << 1) | ((value >> i) & 1U);
+                if (++pendingBits == 8) {
+                    rbsp.push_back(static_cast<uint8_t>(pending));
+                    pending = 0;
+                    pendingBits = 0;
+                }
+            }
+        };
+        GolombCorpus result;
+        for (result.codes = 0; result.codes < 4096; ++result.codes) {
+            const uint32_t value = rng() % 8 == 0 ? rng() % 4096 : rng() % 8;
+            const uint32_t codeNum = value + 1;
+            uint32_t length = 0;
+            while ((codeNum >> length) > 1) {
+                ++length;
+            }
+            put(0, length);
+            put(codeNum, length + 1);
+        }
+        put(1, 1);  // rbsp_stop_one_bit
+        put(0, (8 - pendingBits) % 8);
+        result.nal = {0x42, 0x01};  // HEVC SPS NAL header
+        uint32_t zeros = 0;
+        for (uint8_t byte : rbsp) {
+            if (zeros >= 2 && byte <= 0x03) {
+                result.nal.push_back(0x03);
+                zeros = 0;
+            }
+            result.nal.push_back(byte);
+            zeros = byte == 0 ? zeros + 1 : 0;
+        }
+        return result;
+    }();
+    return corpus;
+}
+
+void BM_ExpGolombLegacy(benchmark::State& state) {
+    const GolombCorpus& corpus = LoadGolombCorpus();
+    for (auto _ : state) {
+        const std::vector<uint8_t> rbsp = LegacyToRbsp(corpus.nal);
+        LegacyBitReader reader(rbsp);
+        uint32_t sum = 0;
+        for (size_t i = 0; i < corpus.codes; ++i) {
+            sum += reader.readUE();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(corpus.codes));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.nal.size()));
+}
+BENCHMARK(BM_ExpGolombLegacy);
+
+void BM_ExpGolomb(benchmark::State& state) {
+    const GolombCorpus& corpus = LoadGolombCorpus();
+    for (auto _ : state) {
+        astra::BitReader reader(corpus.nal.data() + 2, corpus.nal.size() - 2, true);
+        uint32_t sum = 0;
+        for (size_t i = 0; i < corpus.codes; ++i) {
+            sum += reader.readUE();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(corpus.codes));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(corpus.nal.size()));
+}
+BENCHMARK(BM_ExpGolomb);
+
+void BM_AudioSequenceHeader(benchmark::State& state) {
+    astra::FlvMuxer muxer = MakeMuxer(VideoCodecId::kH264);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(muxer.buildAudioSequenceHeader());
+    }
+}
+BENCHMARK(BM_AudioSequenceHeader);
+
+void BM_MetadataTag(benchmark::State& state) {
+    astra::FlvMuxer muxer = MakeMuxer(VideoCodecId::kH264);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(muxer.buildMetadataTag());
+    }
+}
+BENCHMARK(BM_MetadataTag);
+
+void BM_VideoTag(benchmark::State& state, VideoCodecId codec) {
+    const auto& corpus = LoadVideoCorpus(codec);
+    astra::FlvMuxer muxer = MakeMuxer(codec);
+    std::vector<astra::ParsedVideoFrame> frames;
+    for (const auto& unit : corpus.accessUnits) {
+        frames.push_back(muxer.parseVideoFrame(unit.data(), unit.size()));
+    }
+    size_t index = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(muxer.buildVideoTag(frames[index]));
+        bytes += frames[index].payload.size();
+        index = (index + 1) % frames.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetLabel(corpus.source);
+}
+BENCHMARK_CAPTURE(BM_VideoTag, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_VideoTag, hevc, VideoCodecId::kH265);
+
+void BM_AudioTag(benchmark::State& state) {
+    const auto& corpus = LoadAudioCorpus();
+    astra::FlvMuxer muxer = MakeMuxer(VideoCodecId::kH264);
+    size_t index = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const auto& frame = corpus.frames[index];
+        benchmark::DoNotOptimize(muxer.buildAudioTag(frame.data(), frame.size()));
+        bytes += frame.size();
+        index = (index + 1) % corpus.frames.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetLabel(corpus.source);
+}
+BENCHMARK(BM_AudioTag);
+
+// Parsed frames plus the matching audio into pooled 1316-byte datagrams; packets/s is the
+// rate an SRT or UDP sender has to sustain.
+void BM_TsMux(benchmark::State& state, VideoCodecId codec) {
+    const auto& corpus = LoadVideoCorpus(codec);
+    const auto& audio = LoadAudioCorpus();
+    astra::FlvMuxer muxer = MakeMuxer(codec);
+    const auto record = muxer.buildDecoderConfigurationRecord();
+    if (!record.has_value()) {
+        state.SkipWithError("corpus has no parameter sets");
+        return;
+    }
+    std::vector<astra::ParsedVideoFrame> frames;
+    for (const auto& unit : corpus.accessUnits) {
+        frames.push_back(muxer.parseVideoFrame(unit.data(), unit.size()));
+    }
+    astra::TsMuxer ts;
+    ts.setVideoTrack(muxer.streamVideoConfig(), *record);
+    ts.setAudioTrack(audio.config);
+    size_t bytes = 0;
+    ts.setDatagramSink([&](astra::TsDatagramPtr datagram) { bytes += datagram->size; });
+    size_t index = 0;
+    size_t audioIndex = 0;
+    int64_t videoUs = 0;
+    int64_t audioUs = 0;
+    for (auto _ : state) {
+        const astra::ParsedVideoFrame& frame = frames[index];
+        const astra::ByteSpan payload{frame.payload.data(), frame.payload.size()};
+        ts.addVideoSample(&payload, 1, videoUs, frame.isKeyFrame);
+        videoUs += 33333;
+        for (; audioUs < videoUs; audioUs += 23220) {
+            const auto& samples = audio.frames[audioIndex];
+            ts.addAudioSample(samples.data(), samples.size(), audioUs);
+            audioIndex = (audioIndex + 1) % audio.frames.size();
+        }
+        index = (index + 1) % frames.size();
+    }
+    ts.flush();
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["packets"] = benchmark::Counter(static_cast<double>(ts.stats().packets),
+                                                   benchmark::Counter::kIsRate);
+    state.counters["pool_allocs"] = static_cast<double>(ts.pool()->allocations());
+    state.SetLabel(corpus.source);
+}
+BENCHMARK_CAPTURE(BM_TsMux, h264, VideoCodecId::kH264);
+BENCHMARK_CAPTURE(BM_TsMux, hevc, VideoCodecId::kH265);
+
+// Chunk headers plus iovecs for a sliced frame; Arg is the negotiated chunk size.
+void BM_RtmpChunkLayout(benchmark::State& state) {
+    const auto& corpus = LoadVideoCorpus(VideoCodecId::kH264);
+    astra::FlvMuxer muxer = MakeMuxer(VideoCodecId::kH264);
+    std::vector<std::vector<uint8_t>> units = corpus.accessUnits;
+    std::vector<std::vector<astra::ByteSpan>> bodies;
+    std::vector<std::array<uint8_t, 5>> headers(units.size());
+    for (size_t i = 0; i < units.size(); ++i) {
+        const astra::ParsedVideoSlices slices = muxer.sliceVideoFrameInPlace(units[i].data(), units[i].size());
+        headers[i] = muxer.buildVideoTagHeader(slices.isKeyFrame);
+        std::vector<astra::ByteSpan> body{astra::ByteSpan{headers[i].data(), headers[i].size()}};
+        body.insert(body.end(), slices.spans.begin(), slices.spans.end());
+        bodies.push_back(std::move(body));
+    }
+    astra::RtmpChunkWriter writer;
+    const auto chunkSize = static_cast<uint32_t>(state.range(0));
+    size_t index = 0;
+    size_t bytes = 0;
+    uint32_t timestamp = 0;
+    for (auto _ : state) {
+        writer.layout(0x09, 0x04, timestamp, 1, bodies[index], chunkSize);
+        benchmark::DoNotOptimize(writer.iovecs().data());
+        bytes += writer.totalBytes();
+        timestamp += 33;
+        index = (index + 1) % bodies.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetLabel(corpus.source);
+}
+BENCHMARK(BM_RtmpChunkLayout)->Arg(128)->Arg(4096)->Arg(60000);
+
+// One producer thread against the consumer loop, as encoder threads feed the send thread.
+void BM_AVQueueThroughput(benchmark::State& state) {
+    const auto payload = static_cast<int>(state.range(0));
+    constexpr int kBatch = 1024;
+    AVQueue queue;
+    for (auto _ : state) {
+        std::thread producer([&] {
+            for (int i = 0; i < kBatch; ++i) {
+                auto* packet = static_cast<RTMPPacket*>(std::malloc(sizeof(RTMPPacket)));
+                RTMPPacket_Alloc(packet, payload);
+                RTMPPacket_Reset(packet);
+                packet->m_nBodySize = static_cast<uint32_t>(payload);
+                queue.putRtmpPacket(packet);
+            }
+        });
+        int received = 0;
+        while (received < kBatch) {
+            AVQueue::Entry entry = queue.getPacket();
+            if (entry.packet) {
+                RTMPPacket_Free(entry.packet);
+                std::free(entry.packet);
+                ++received;
+            }
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_AVQueueThroughput)->Arg(400)->Arg(9000)->UseRealTime();
+
+void BM_FrameStats(benchmark::State& state) {
+    const auto& corpus = LoadVideoCorpus(VideoCodecId::kH264);
+    astra::FrameStats stats;
+    stats.reset(0);
+    size_t index = 0;
+    int64_t timestampMs = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stats.onSample(corpus.accessUnits[index].size(), timestampMs));
+        timestampMs += 33;
+        index = (index + 1) % corpus.accessUnits.size();
+    }
+}
+BENCHMARK(BM_FrameStats);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,208 @@
+// Time to first encoded frame, cold vs warmed-up encoders. Runs on a device (adb push, then
+// run from /data/local/tmp): it drives VideoEncoderNative / AudioEncoderNative against the
+// real MediaCodec. Per run the video encoder is configured and started, frames are drawn into
+// its input surface with EGL at the stream frame rate, and firstFrameLatencyMs() is read once
+// the first packet comes out. Warm runs call warmUp() first and leave it --gap-ms, the time a
+// session spends between being built and going live. AAC is timed over configure + start.
+//
+//   encoder_startup_benchmark [--runs=N] [--gap-ms=N] [--codec=h264|hevc] [--size=WxH]
+//
+// Output is not connected anywhere: PushProxy drops what the encoders send.
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "MediaClock.h"
+#include "codec/AudioEncoderNative.h"
+#include "codec/VideoEncoderNative.h"
+
+namespace {
+
+constexpr int64_t kFirstFrameTimeoutMs = 3000;
+
+struct Options {
+    int runs = 5;
+    int gapMs = 800;
+    astra::VideoCodecId codec = astra::VideoCodecId::kH264;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+};
+
+struct Result {
+    std::vector<double> video;  // configure() to first encoded frame, ms
+    std::vector<double> audio;  // configure() + start(), ms
+    int failures = 0;
+};
+
+double Percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+double ElapsedMs(int64_t startUs) {
+    return static_cast<double>(astra::MonotonicNowUs() - startUs) / 1000.0;
+}
+
+// Draws solid frames into |window| until |encoder| reports its first output.
+bool DrawUntilFirstFrame(ANativeWindow* window, const VideoEncoderNative& encoder, uint32_t fps) {
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        return false;
+    }
+    const EGLint configAttribs[] = {
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+            EGL_RECORDABLE_ANDROID, 1,
+            EGL_NONE,
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        eglTerminate(display);
+        return false;
+    }
+    const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    EGLSurface surface = eglCreateWindowSurface(display, config, window, nullptr);
+    bool ok = context != EGL_NO_CONTEXT && surface != EGL_NO_SURFACE &&
+            eglMakeCurrent(display, surface, surface, context);
+
+    const auto frameInterval = std::chrono::microseconds(1000000 / std::max<uint32_t>(fps, 1));
+    const int64_t startUs = astra::MonotonicNowUs();
+    for (uint32_t frame = 0; ok && encoder.firstFrameLatencyMs() < 0; ++frame) {
+        if (astra::MonotonicNowUs() - startUs > kFirstFrameTimeoutMs * 1000) {
+            ok = false;
+            break;
+        }
+        const float shade = static_cast<float>(frame % 32) / 32.0f;
+        glClearColor(shade, 0.5f, 1.0f - shade, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        eglSwapBuffers(display, surface);
+        std::this_thread::sleep_for(frameInterval);
+    }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    if (context != EGL_NO_CONTEXT) {
+        eglDestroyContext(display, context);
+    }
+    eglTerminate(display);
+    return ok;
+}
+
+void RunOnce(const Options& options, bool warm, Result& result) {
+    VideoEncoderNative::Config videoConfig;
+    videoConfig.streamConfig.codec = options.codec;
+    videoConfig.streamConfig.width = options.width;
+    videoConfig.streamConfig.height = options.height;
+    videoConfig.streamConfig.fps = 30;
+    videoConfig.bitrateKbps = 2500;
+    AudioEncoderNative::Config audioConfig;
+
+    VideoEncoderNative video;
+    AudioEncoderNative audio;
+    if (warm) {
+        video.warmUp(videoConfig);
+        audio.warmUp(audioConfig);
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.gapMs));
+    }
+
+    const int64_t audioStartUs = astra::MonotonicNowUs();
+    if (audio.configure(audioConfig)) {
+        audio.start();
+        result.audio.push_back(ElapsedMs(audioStartUs));
+    } else {
+        ++result.failures;
+    }
+    audio.stop();
+
+    if (!video.configure(videoConfig)) {
+        ++result.failures;
+        return;
+    }
+    video.start();
+    if (DrawUntilFirstFrame(video.inputWindow(), video, videoConfig.streamConfig.fps)) {
+        result.video.push_back(static_cast<double>(video.firstFrameLatencyMs()));
+    } else {
+        ++result.failures;
+    }
+    video.stop();
+}
+
+void PrintRow(const char* name, const std::vector<double>& values) {
+    std::printf("%-12s %6zu %8.1f %8.1f %8.1f %8.1f\n",
+                name,
+                values.size(),
+                Percentile(values, 0.5),
+                Percentile(values, 0.95),
+                values.empty() ? 0.0 : *std::min_element(values.begin(), values.end()),
+                values.empty() ? 0.0 : *std::max_element(values.begin(), values.end()));
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--runs=", 7) == 0) {
+            options.runs = std::max(std::atoi(arg + 7), 1);
+        } else if (std::strncmp(arg, "--gap-ms=", 9) == 0) {
+            options.gapMs = std::max(std::atoi(arg + 9), 0);
+        } else if (std::strcmp(arg, "--codec=hevc") == 0) {
+            options.codec = astra::VideoCodecId::kH265;
+        } else if (std::strncmp(arg, "--size=", 7) == 0) {
+            unsigned width = 0;
+            unsigned height = 0;
+            if (std::sscanf(arg + 7, "%ux%u", &width, &height) == 2 && width > 0 && height > 0) {
+                options.width = width;
+                options.height = height;
+            }
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+    std::printf("%s %ux%u  %d runs  warm-up gap %d ms\n",
+                options.codec == astra::VideoCodecId::kH264 ? "h264" : "hevc",
+                options.width,
+                options.height,
+                options.runs,
+                options.gapMs);
+
+    Result cold;
+    Result warm;
+    // Interleaved so thermal state and codec caching affect both sides alike.
+    for (int run = 0; run < options.runs; ++run) {
+        RunOnce(options, false, cold);
+        RunOnce(options, true, warm);
+    }
+
+    std::printf("%-12s %6s %8s %8s %8s %8s\n", "startup", "runs", "p50 ms", "p95 ms", "min ms", "max ms");
+    PrintRow("video cold", cold.video);
+    PrintRow("video warm", warm.video);
+    PrintRow("aac cold", cold.audio);
+    PrintRow("aac warm", warm.audio);
+    if (cold.failures + warm.failures > 0) {
+        std::printf("%d runs failed\n", cold.failures + warm.failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Reports ns per sample for the capture DSP kernels, vector build against scalar reference,
+// and checks the two agree. Run a Release build on the host or via adb on a device.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "AudioFormatConverter.h"
+#include "PcmKernels.h"
+#include "PolyphaseResampler.h"
+
+namespace {
+
+constexpr size_t kBlockFrames = 960;  // 20 ms at 48 kHz, a typical capture burst
+constexpr int kIterations = 2000;
+constexpr double kPi = 3.14159265358979323846;
+
+volatile float gSink = 0.0f;
+
+double NsPerSample(size_t samplesPerRun, const std::function<void()>& body) {
+    for (int i = 0; i < kIterations / 10; ++i) {
+        body();
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        body();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    return ns / (static_cast<double>(samplesPerRun) * kIterations);
+}
+
+void Report(const char* name, double vectorNs, double scalarNs) {
+    std::printf("%-28s %8.3f ns/sample   scalar %8.3f ns/sample   x%.1f\n",
+                name, vectorNs, scalarNs, scalarNs / vectorNs);
+}
+
+std::vector<float> MakeSignal(size_t samples, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    std::vector<float> signal(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        signal[i] = 0.8f * static_cast<float>(std::sin(2.0 * kPi * 997.0 * static_cast<double>(i) / 48000.0)) +
+                noise(rng);
+    }
+    return signal;
+}
+
+bool CheckKernels() {
+    const std::vector<float> signal = MakeSignal(kBlockFrames * 2 + 3, 7);
+    bool ok = true;
+
+    std::vector<int16_t> vectorOut(signal.size());
+    std::vector<int16_t> scalarOut(signal.size());
+    astra::DitherState vectorDither;
+    astra::DitherState scalarDither;
+    astra::FloatToInt16Dithered(signal.data(), vectorOut.data(), signal.size(), vectorDither);
+    astra::scalar::FloatToInt16Dithered(signal.data(), scalarOut.data(), signal.size(), scalarDither);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        // ARMv7 rounds ties away from zero instead of to even.
+        if (std::abs(vectorOut[i] - scalarOut[i]) > 1) {
+            std::printf("FloatToInt16Dithered mismatch at %zu: %d vs %d\n", i, vectorOut[i], scalarOut[i]);
+            ok = false;
+            break;
+        }
+    }
+
+    std::vector<float> vectorFloat(signal.size());
+    std::vector<float> scalarFloat(signal.size());
+    astra::Int16ToFloat(scalarOut.data(), vectorFloat.data(), signal.size());
+    astra::scalar::Int16ToFloat(scalarOut.data(), scalarFloat.data(), signal.size());
+    if (vectorFloat != scalarFloat) {
+        std::printf("Int16ToFloat mismatch\n");
+        ok = false;
+    }
+
+    const size_t frames = signal.size() / 2;
+    std::vector<float> vectorMono(frames);
+    std::vector<float> scalarMono(frames);
+    astra::DownmixStereoToMono(signal.data(), vectorMono.data(), frames);
+    astra::scalar::DownmixStereoToMono(signal.data(), scalarMono.data(), frames);
+    if (vectorMono != scalarMono) {
+        std::printf("DownmixStereoToMono mismatch\n");
+        ok = false;
+    }
+
+    std::vector<float> vectorStereo(frames * 2);
+    std::vector<float> scalarStereo(frames * 2);
+    astra::UpmixMonoToStereo(vectorMono.data(), vectorStereo.data(), frames);
+    astra::scalar::UpmixMonoToStereo(vectorMono.data(), scalarStereo.data(), frames);
+    if (vectorStereo != scalarStereo) {
+        std::printf("UpmixMonoToStereo mismatch\n");
+        ok = false;
+    }
+
+    const float vectorDot = astra::DotProduct(signal.data(), signal.data() + 1, 37);
+    const float scalarDot = astra::scalar::DotProduct(signal.data(), signal.data() + 1, 37);
+    if (std::fabs(vectorDot - scalarDot) > 1e-4f * std::fabs(scalarDot) + 1e-6f) {
+        std::printf("DotProduct mismatch %f vs %f\n", vectorDot, scalarDot);
+        ok = false;
+    }
+
+    std::vector<int16_t> vectorMix(scalarOut.begin(), scalarOut.end());
+    std::vector<int16_t> scalarMix(scalarOut.begin(), scalarOut.end());
+    for (int16_t gain : {astra::kUnityGainQ15, static_cast<int16_t>(21000)}) {
+        astra::MixInt16Saturating(vectorMix.data(), vectorOut.data(), vectorOut.size(), gain);
+        astra::scalar::MixInt16Saturating(scalarMix.data(), vectorOut.data(), vectorOut.size(), gain);
+    }
+    if (vectorMix != scalarMix) {
+        std::printf("MixInt16Saturating mismatch\n");
+        ok = false;
+    }
+
+    // Saturated mix output has full-scale runs, so clip counting is exercised too.
+    for (int32_t channels = 1; channels <= 3; ++channels) {
+        const size_t levelFrames = vectorMix.size() / static_cast<size_t>(channels);
+        astra::ChannelLevels vectorLevels[3];
+        astra::ChannelLevels scalarLevels[3];
+        astra::AccumulateLevels(vectorMix.data(), levelFrames, channels, vectorLevels);
+        astra::scalar::AccumulateLevels(vectorMix.data(), levelFrames, channels, scalarLevels);
+        for (int32_t c = 0; c < channels; ++c) {
+            if (vectorLevels[c].peak != scalarLevels[c].peak ||
+                vectorLevels[c].sumSquares != scalarLevels[c].sumSquares ||
+                vectorLevels[c].clipped != scalarLevels[c].clipped) {
+                std::printf("AccumulateLevels mismatch channels=%d channel=%d\n", channels, c);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+// Resamples a 1 kHz tone 48k -> 44.1k and returns the worst deviation from the ideal tone.
+double ResamplerError() {
+    astra::PolyphaseResampler resampler;
+    resampler.configure(48000, 44100, 1, kBlockFrames);
+    std::vector<float> in(kBlockFrames);
+    std::vector<float> out(resampler.maxOutputFrames(kBlockFrames));
+    double worst = 0.0;
+    size_t produced = 0;
+    for (size_t block = 0; block < 50; ++block) {
+        for (size_t i = 0; i < kBlockFrames; ++i) {
+            const double t = static_cast<double>(block * kBlockFrames + i) / 48000.0;
+            in[i] = static_cast<float>(0.5 * std::sin(2.0 * kPi * 1000.0 * t));
+        }
+        const double firstPosition = resampler.nextOutputInputPosition();
+        const size_t frames = resampler.process(in.data(), kBlockFrames, out.data(), out.size());
+        for (size_t i = 0; i < frames; ++i) {
+            const double position = firstPosition + static_cast<double>(i) * 48000.0 / 44100.0;
+            const double expected = 0.5 * std::sin(2.0 * kPi * 1000.0 * position / 48000.0);
+            if (produced + i > 64) {
+                worst = std::max(worst, std::fabs(expected - out[i]));
+            }
+        }
+        produced += frames;
+    }
+    return worst;
+}
+
+}  // namespace
+
+int main() {
+    std::printf("PCM kernels built for: %s\n", astra::PcmKernelIsa());
+    if (!CheckKernels()) {
+        return EXIT_FAILURE;
+    }
+    const double resampleError = ResamplerError();
+    std::printf("48k->44.1k 1 kHz tone worst error: %.2e (%.1f dBFS)\n",
+                resampleError, 20.0 * std::log10(resampleError));
+
+    const size_t samples = kBlockFrames * 2;
+    const std::vector<float> signal = MakeSignal(samples, 1);
+    std::vector<int16_t> pcm16(samples);
+    std::vector<float> floats(samples);
+    astra::DitherState dither;
+
+    Report("float->int16 dithered",
+           NsPerSample(samples, [&] { astra::FloatToInt16Dithered(signal.data(), pcm16.data(), samples, dither); }),
+           NsPerSample(samples, [&] {
+               astra::scalar::FloatToInt16Dithered(signal.data(), pcm16.data(), samples, dither);
+           }));
+    Report("int16->float",
+           NsPerSample(samples, [&] { astra::Int16ToFloat(pcm16.data(), floats.data(), samples); }),
+           NsPerSample(samples, [&] { astra::scalar::Int16ToFloat(pcm16.data(), floats.data(), samples); }));
+    Report("stereo->mono (per frame)",
+           NsPerSample(kBlockFrames, [&] { astra::DownmixStereoToMono(signal.data(), floats.data(), kBlockFrames); }),
+           NsPerSample(kBlockFrames, [&] {
+               astra::scalar::DownmixStereoToMono(signal.data(), floats.data(), kBlockFrames);
+           }));
+    Report("mono->stereo (per frame)",
+           NsPerSample(kBlockFrames, [&] { astra::UpmixMonoToStereo(signal.data(), floats.data(), kBlockFrames); }),
+           NsPerSample(kBlockFrames, [&] {
+               astra::scalar::UpmixMonoToStereo(signal.data(), floats.data(), kBlockFrames);
+           }));
+    Report("dot product 32 taps",
+           NsPerSample(32, [&] { gSink = gSink + astra::DotProduct(signal.data(), signal.data() + 32, 32); }),
+           NsPerSample(32, [&] { gSink = gSink + astra::scalar::DotProduct(signal.data(), signal.data() + 32, 32); }));
+
+    std::vector<int16_t> mix(samples);
+    Report("mix int16 saturating x0.7",
+           NsPerSample(samples, [&] { astra::MixInt16Saturating(mix.data(), pcm16.data(), samples, 22938); }),
+           NsPerSample(samples, [&] { astra::scalar::MixInt16Saturating(mix.data(), pcm16.data(), samples, 22938); }));
+
+    for (int32_t channels = 1; channels <= 2; ++channels) {
+        astra::ChannelLevels levels[2];
+        const size_t frames = samples / static_cast<size_t>(channels);
+        const char* name = channels == 1 ? "levels mono" : "levels stereo";
+        Report(name,
+               NsPerSample(samples, [&] { astra::AccumulateLevels(mix.data(), frames, channels, levels); }),
+               NsPerSample(samples, [&] { astra::scalar::AccumulateLevels(mix.data(), frames, channels, levels); }));
+    }
+
+    for (int channels = 1; channels <= 2; ++channels) {
+        astra::PolyphaseResampler resampler;
+        resampler.configure(48000, 44100, channels, kBlockFrames);
+        std::vector<float> out(resampler.maxOutputFrames(kBlockFrames) * static_cast<size_t>(channels));
+        const double ns = NsPerSample(kBlockFrames * static_cast<size_t>(channels), [&] {
+            resampler.process(signal.data(), kBlockFrames, out.data(), out.size() / static_cast<size_t>(channels));
+        });
+        std::printf("resample 48k->44.1k x%d       %8.3f ns/input sample\n", channels, ns);
+        resampler.setDriftPpm(150.0);
+        const double trimmedNs = NsPerSample(kBlockFrames * static_cast<size_t>(channels), [&] {
+            resampler.process(signal.data(), kBlockFrames, out.data(), out.size() / static_cast<size_t>(channels));
+        });
+        std::printf("  with +150 ppm drift trim      %8.3f ns/input sample\n", trimmedNs);
+    }
+
+    astra::AudioFormatConverter converter;
+    astra::PcmFormat device;
+    device.sampleRate = 48000;
+    device.channels = 2;
+    device.isFloat = true;
+    converter.configure(device, 44100, 1, kBlockFrames);
+    const double chainNs = NsPerSample(samples, [&] {
+        const int16_t* out = nullptr;
+        converter.process(signal.data(), kBlockFrames, &out);
+    });
+    std::printf("capture chain f32 48k x2 -> s16 44.1k x1  %8.3f ns/input sample\n", chainNs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,343 @@
+// End-to-end send path: encoder output replayed through PushProxy -> RTMPPush -> librtmp into
+// the loopback ingest, under a few link conditions. Per scenario it reports sustained
+// throughput, per-frame latency (push call to the last chunk parsed by the ingest) and
+// sender CPU per megabit (process CPU minus the ingest thread).
+//
+//   push_e2e_benchmark [--seconds=N] [--speed=X] [--codec=h264|hevc] [--replay=FILE.flv]
+//
+// --speed paces the paced scenarios at X times real time. Inputs come from
+// benchmark_corpus.h, so ASTRA_CORPUS_DIR replays recorded streams. --replay instead plays an
+// FLV recording through PushProxy::startReplay, tags unchanged, looping it to fill --seconds;
+// latency is then measured from each tag's scheduled send time.
+
+#include <signal.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FlvReader.h"
+#include "MediaClock.h"
+#include "PushProxy.h"
+#include "benchmark_corpus.h"
+#include "rtmp_loopback_server.h"
+
+namespace {
+
+using astra::bench::LinkImpairment;
+using astra::bench::ReceivedTag;
+using astra::bench::RtmpLoopbackServer;
+
+constexpr uint32_t kFps = 30;
+constexpr int kConnectTimeoutMs = 5000;
+constexpr int64_t kDrainIdleUs = 2000000;  // give up once the ingest saw nothing new this long
+
+struct Scenario {
+    const char* name;
+    LinkImpairment link;
+    bool paced;
+};
+
+struct Options {
+    double seconds = 10.0;
+    double speed = 1.0;
+    astra::VideoCodecId codec = astra::VideoCodecId::kH264;
+    std::string replayPath;
+};
+
+int64_t ProcessCpuUs() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<int64_t>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000LL +
+            usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+void SleepUntil(int64_t deadlineUs) {
+    const int64_t waitUs = deadlineUs - astra::MonotonicNowUs();
+    if (waitUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+    }
+}
+
+// Returns once the ingest has seen |expectedTags| or stopped making progress.
+void WaitForTags(const RtmpLoopbackServer& server, uint64_t expectedTags) {
+    uint64_t seen = 0;
+    int64_t progressUs = astra::MonotonicNowUs();
+    while (true) {
+        const uint64_t tags = server.stats().tags;
+        const int64_t nowUs = astra::MonotonicNowUs();
+        if (tags >= expectedTags) {
+            break;
+        }
+        if (tags != seen) {
+            seen = tags;
+            progressUs = nowUs;
+        } else if (nowUs - progressUs > kDrainIdleUs) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+void Report(const Scenario& scenario,
+            const RtmpLoopbackServer::Stats& after,
+            const RtmpLoopbackServer::Stats& before,
+            const std::vector<double>& latencyMs,
+            size_t framesPushed,
+            uint64_t mediaBytes,
+            int64_t firstUs,
+            int64_t lastUs,
+            int64_t senderCpuUs) {
+    const double spanS = std::max<double>(static_cast<double>(lastUs - firstUs), 1.0) / 1e6;
+    const double megabits = static_cast<double>(mediaBytes) * 8 / 1e6;
+    const double wireMbps = static_cast<double>(after.bytesReceived - before.bytesReceived) * 8 / 1e6 / spanS;
+    std::printf("%-24s %5zu/%-5zu %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %9.3f%s\n",
+                scenario.name,
+                latencyMs.size(),
+                framesPushed,
+                megabits / spanS,
+                wireMbps,
+                Percentile(latencyMs, 0.5),
+                Percentile(latencyMs, 0.95),
+                Percentile(latencyMs, 0.99),
+                latencyMs.empty() ? 0.0 : *std::max_element(latencyMs.begin(), latencyMs.end()),
+                megabits > 0 ? static_cast<double>(senderCpuUs) / 1000.0 / megabits : 0.0,
+                after.drops > before.drops ? "  (dropped)" : "");
+}
+
+bool RunScenario(RtmpLoopbackServer& server, const Scenario& scenario, const Options& options) {
+    const auto& video = astra::bench::LoadVideoCorpus(options.codec);
+    const auto& audio = astra::bench::LoadAudioCorpus();
+    const auto videoFrames = static_cast<size_t>(options.seconds * kFps);
+    const double speed = scenario.paced ? options.speed : 0.0;
+
+    server.setImpairment(scenario.link);
+    server.clearTags();
+    const RtmpLoopbackServer::Stats before = server.stats();
+
+    astra::VideoConfig videoConfig;
+    videoConfig.codec = options.codec;
+    videoConfig.width = 1280;
+    videoConfig.height = 720;
+    videoConfig.fps = kFps;
+    PushProxy* proxy = PushProxy::getInstance();
+    proxy->init(server.url().c_str(), nullptr);
+    proxy->configureVideo(videoConfig);
+    proxy->configureAudio(audio.config);
+    proxy->start();
+    if (!server.waitForPublish(before.publishes + 1, kConnectTimeoutMs)) {
+        std::printf("%-24s connect failed\n", scenario.name);
+        proxy->stop();
+        return false;
+    }
+    // The publish reply still has to reach librtmp before RTMPPush starts its clock.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50 + scenario.link.rttMs));
+
+    const int64_t cpuBeginUs = ProcessCpuUs();
+    const int64_t serverCpuBeginUs = server.stats().cpuUs;
+    const double videoIntervalUs = 1e6 / kFps;
+    const double audioIntervalUs = 1024e6 / std::max<uint32_t>(audio.config.sampleRate, 1);
+    std::vector<int64_t> pushUs;
+    pushUs.reserve(videoFrames);
+    size_t audioFrames = 0;
+    const int64_t beginUs = astra::MonotonicNowUs();
+    while (pushUs.size() < videoFrames) {
+        const double videoMediaUs = static_cast<double>(pushUs.size()) * videoIntervalUs;
+        const double audioMediaUs = static_cast<double>(audioFrames) * audioIntervalUs;
+        const bool sendAudio = audioMediaUs < videoMediaUs;
+        if (speed > 0) {
+            SleepUntil(beginUs + static_cast<int64_t>(std::min(videoMediaUs, audioMediaUs) / speed));
+        }
+        const int64_t nowUs = astra::MonotonicNowUs();
+        if (sendAudio) {
+            const auto& frame = audio.frames[audioFrames % audio.frames.size()];
+            proxy->pushAudioFrame(frame.data(), frame.size(), nowUs);
+            ++audioFrames;
+        } else {
+            const auto& unit = video.accessUnits[pushUs.size() % video.accessUnits.size()];
+            pushUs.push_back(nowUs);
+            proxy->pushVideoFrame(unit.data(), unit.size(), nowUs);
+        }
+    }
+
+    // Metadata plus both sequence headers ride along with the media.
+    const uint64_t expectedTags = before.tags + 3 + videoFrames + audioFrames;
+    WaitForTags(server, expectedTags);
+    const RtmpLoopbackServer::Stats after = server.stats();
+    const int64_t senderCpuUs = (ProcessCpuUs() - cpuBeginUs) - (after.cpuUs - serverCpuBeginUs);
+    proxy->stop();
+
+    std::vector<double> latencyMs;
+    uint64_t mediaBytes = 0;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    for (const ReceivedTag& tag : server.tags()) {
+        if (tag.type != 8 && tag.type != 9) {
+            continue;
+        }
+        mediaBytes += tag.size;
+        firstUs = firstUs == 0 ? tag.arrivalUs : firstUs;
+        lastUs = tag.arrivalUs;
+        // The queue never reorders or drops, so the n-th video tag is the n-th pushed frame.
+        if (tag.type == 9 && !tag.sequenceHeader && latencyMs.size() < pushUs.size()) {
+            latencyMs.push_back(static_cast<double>(tag.arrivalUs - pushUs[latencyMs.size()]) / 1000.0);
+        }
+    }
+    Report(scenario, after, before, latencyMs, pushUs.size(), mediaBytes, firstUs, lastUs, senderCpuUs);
+    return true;
+}
+
+bool RunReplayScenario(RtmpLoopbackServer& server, const Scenario& scenario, const Options& options) {
+    astra::FlvReader reader;
+    if (!reader.open(options.replayPath)) {
+        std::printf("%-24s cannot open %s\n", scenario.name, options.replayPath.c_str());
+        return false;
+    }
+    // The replayer sends these up front and forwards every other tag, later headers included.
+    const uint64_t upFront[] = {reader.metadata().offset, reader.videoSequenceHeader().offset,
+                                reader.audioSequenceHeader().offset};
+    size_t videoPerLoop = 0;
+    size_t mediaPerLoop = 0;
+    astra::FlvTagView view;
+    while (reader.next(view)) {
+        if (std::find(std::begin(upFront), std::end(upFront), view.offset) != std::end(upFront)) {
+            continue;
+        }
+        ++mediaPerLoop;
+        videoPerLoop += view.type == 9 && !view.sequenceHeader ? 1 : 0;
+    }
+    const auto loops = static_cast<uint32_t>(
+            std::max(1.0, options.seconds * 1000 / std::max<uint32_t>(reader.durationMs(), 1) + 0.5));
+    const double speed = scenario.paced ? options.speed : 0.0;
+
+    server.setImpairment(scenario.link);
+    server.clearTags();
+    const RtmpLoopbackServer::Stats before = server.stats();
+    PushProxy* proxy = PushProxy::getInstance();
+    proxy->init(server.url().c_str(), nullptr);
+    proxy->start();
+    if (!server.waitForPublish(before.publishes + 1, kConnectTimeoutMs)) {
+        std::printf("%-24s connect failed\n", scenario.name);
+        proxy->stop();
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50 + scenario.link.rttMs));
+
+    const int64_t cpuBeginUs = ProcessCpuUs();
+    const int64_t serverCpuBeginUs = server.stats().cpuUs;
+    const int64_t beginUs = astra::MonotonicNowUs();
+    if (!proxy->startReplay(options.replayPath.c_str(), speed, loops)) {
+        std::printf("%-24s replay failed\n", scenario.name);
+        proxy->stop();
+        return false;
+    }
+    const size_t headers = (reader.metadata().body ? 1 : 0) + (reader.videoSequenceHeader().body ? 1 : 0) +
+            (reader.audioSequenceHeader().body ? 1 : 0);
+    WaitForTags(server, before.tags + headers + mediaPerLoop * loops);
+    const RtmpLoopbackServer::Stats after = server.stats();
+    const int64_t senderCpuUs = (ProcessCpuUs() - cpuBeginUs) - (after.cpuUs - serverCpuBeginUs);
+    proxy->stop();
+
+    std::vector<double> latencyMs;
+    uint64_t mediaBytes = 0;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    for (const ReceivedTag& tag : server.tags()) {
+        if (tag.type != 8 && tag.type != 9) {
+            continue;
+        }
+        mediaBytes += tag.size;
+        firstUs = firstUs == 0 ? tag.arrivalUs : firstUs;
+        lastUs = tag.arrivalUs;
+        // Replayed timestamps are the schedule; unpaced, everything is due at once.
+        if (tag.type == 9 && !tag.sequenceHeader) {
+            const double dueUs = speed > 0 ? static_cast<double>(beginUs) + tag.timestamp * 1000.0 / speed
+                                           : static_cast<double>(beginUs);
+            latencyMs.push_back((static_cast<double>(tag.arrivalUs) - dueUs) / 1000.0);
+        }
+    }
+    Report(scenario, after, before, latencyMs, videoPerLoop * loops, mediaBytes, firstUs, lastUs, senderCpuUs);
+    return true;
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = std::max(std::atof(arg + 10), 0.1);
+        } else if (std::strncmp(arg, "--speed=", 8) == 0) {
+            options.speed = std::max(std::atof(arg + 8), 0.01);
+        } else if (std::strcmp(arg, "--codec=hevc") == 0) {
+            options.codec = astra::VideoCodecId::kH265;
+        } else if (std::strncmp(arg, "--replay=", 9) == 0) {
+            options.replayPath = arg + 9;
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    // librtmp writes with plain send(); a dropped connection must fail the call, not the process.
+    signal(SIGPIPE, SIG_IGN);
+    const Options options = ParseOptions(argc, argv);
+
+    RtmpLoopbackServer server;
+    if (!server.start()) {
+        std::printf("cannot listen on 127.0.0.1\n");
+        return 1;
+    }
+    if (options.replayPath.empty()) {
+        const auto& video = astra::bench::LoadVideoCorpus(options.codec);
+        std::printf("ingest %s  video %s (%s)  audio %s  %.1f s at %.2fx\n",
+                    server.url().c_str(),
+                    options.codec == astra::VideoCodecId::kH264 ? "h264" : "hevc",
+                    video.source.c_str(),
+                    astra::bench::LoadAudioCorpus().source.c_str(),
+                    options.seconds,
+                    options.speed);
+    } else {
+        std::printf("ingest %s  replay %s  %.1f s at %.2fx\n",
+                    server.url().c_str(),
+                    options.replayPath.c_str(),
+                    options.seconds,
+                    options.speed);
+    }
+
+    const auto dropAfterMs = static_cast<uint32_t>(options.seconds * 1000 / options.speed / 2);
+    const Scenario scenarios[] = {
+            {"unpaced", {}, false},
+            {"paced", {}, true},
+            {"cap 4 Mbps", {4000000, 0, 0}, true},
+            {"rtt 120 ms", {0, 120, 0}, true},
+            {"cap 3 Mbps + rtt 80 ms", {3000000, 80, 0}, true},
+            {"drop mid-stream", {0, 0, dropAfterMs}, true},
+    };
+    std::printf("%-24s %11s %8s %8s %8s %8s %8s %8s %9s\n",
+                "scenario", "frames", "Mbps", "wire", "p50 ms", "p95 ms", "p99 ms", "max ms", "cpu ms/Mb");
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        ok = (options.replayPath.empty() ? RunScenario(server, scenario, options)
+                                         : RunReplayScenario(server, scenario, options)) && ok;
+    }
+    server.stop();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,683 @@
+#include "rtmp_loopback_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+#include "FlvMuxer.h"
+#include "MediaClock.h"
+
+namespace astra::bench {
+
+namespace {
+
+constexpr size_t kHandshakeSize = 1536;
+constexpr uint32_t kOutChunkSize = 128;  // never renegotiated towards the client
+constexpr uint32_t kMaxMessageSize = 16 * 1024 * 1024;
+constexpr uint32_t kWindowAckSize = 2500000;
+constexpr uint32_t kStreamId = 1;
+
+constexpr uint8_t kTypeSetChunkSize = 1;
+constexpr uint8_t kTypeWindowAckSize = 5;
+constexpr uint8_t kTypeSetPeerBandwidth = 6;
+constexpr uint8_t kTypeAudio = 8;
+constexpr uint8_t kTypeVideo = 9;
+constexpr uint8_t kTypeData = 18;
+constexpr uint8_t kTypeCommand = 20;
+
+int64_t ThreadCpuUs() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000LL + now.tv_nsec / 1000;
+}
+
+uint32_t ReadBe24(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+}
+
+uint32_t ReadBe32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | ReadBe24(p + 1);
+}
+
+uint32_t ReadLe32(const uint8_t* p) {
+    return p[0] | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+            (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void AppendBe(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void AmfString(std::vector<uint8_t>& out, const char* value, bool typed = true) {
+    const size_t length = std::strlen(value);
+    if (typed) {
+        out.push_back(0x02);
+    }
+    AppendBe(out, length, 2);
+    out.insert(out.end(), value, value + length);
+}
+
+void AmfNumber(std::vector<uint8_t>& out, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    out.push_back(0x00);
+    AppendBe(out, bits, 8);
+}
+
+void AmfNull(std::vector<uint8_t>& out) {
+    out.push_back(0x05);
+}
+
+void AmfObjectEnd(std::vector<uint8_t>& out) {
+    out.insert(out.end(), {0x00, 0x00, 0x09});
+}
+
+bool ReadAmfString(const uint8_t* p, size_t size, size_t& pos, std::string& value) {
+    if (pos + 3 > size || p[pos] != 0x02) {
+        return false;
+    }
+    const size_t length = (static_cast<size_t>(p[pos + 1]) << 8) | p[pos + 2];
+    if (pos + 3 + length > size) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(p + pos + 3), length);
+    pos += 3 + length;
+    return true;
+}
+
+bool ReadAmfNumber(const uint8_t* p, size_t size, size_t& pos, double& value) {
+    if (pos + 9 > size || p[pos] != 0x00) {
+        return false;
+    }
+    uint64_t bits = 0;
+    for (size_t i = 1; i <= 8; ++i) {
+        bits = (bits << 8) | p[pos + i];
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    pos += 9;
+    return true;
+}
+
+bool WriteFully(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+}  // namespace
+
+// Byte-level protocol state of one connection. Fed with whatever arrived, in order; produces
+// response bytes and completed tags for the caller to deliver.
+class IngestSession {
+public:
+    IngestSession(uint32_t connection, bool keepPayloads)
+        : connection_(connection), keepPayloads_(keepPayloads) {}
+
+    // Returns false on a protocol violation.
+    bool consume(const uint8_t* data, size_t size, int64_t nowUs) {
+        in_.insert(in_.end(), data, data + size);
+        bool ok = true;
+        while (ok) {
+            const size_t available = in_.size() - inPos_;
+            const uint8_t* p = in_.data() + inPos_;
+            size_t used = 0;
+            if (state_ == State::kC0C1) {
+                if (available < 1 + kHandshakeSize) {
+                    break;
+                }
+                // S0 + S1 (zero time and version, random-ish body) + S2 echoing C1. librtmp
+                // only validates digests for FP9 handshakes, which it skips without a SWF hash.
+                out_.push_back(0x03);
+                out_.resize(out_.size() + kHandshakeSize, 0x5A);
+                out_.insert(out_.end(), p + 1, p + 1 + kHandshakeSize);
+                used = 1 + kHandshakeSize;
+                state_ = State::kC2;
+            } else if (state_ == State::kC2) {
+                if (available < kHandshakeSize) {
+                    break;
+                }
+                used = kHandshakeSize;
+                state_ = State::kChunks;
+            } else {
+                used = parseChunk(p, available, nowUs, ok);
+                if (used == 0) {
+                    break;
+                }
+            }
+            inPos_ += used;
+        }
+        if (inPos_ == in_.size()) {
+            in_.clear();
+            inPos_ = 0;
+        } else if (inPos_ > 64 * 1024) {
+            in_.erase(in_.begin(), in_.begin() + static_cast<std::ptrdiff_t>(inPos_));
+            inPos_ = 0;
+        }
+        return ok;
+    }
+
+    std::vector<uint8_t>& outbound() { return out_; }
+    std::vector<ReceivedTag>& tags() { return tags_; }
+
+    bool takePublished() {
+        const bool published = published_;
+        published_ = false;
+        return published;
+    }
+
+private:
+    enum class State { kC0C1, kC2, kChunks };
+
+    struct ChunkStream {
+        uint32_t timestampField = 0;
+        uint32_t timestamp = 0;
+        uint32_t delta = 0;
+        uint32_t length = 0;
+        uint32_t received = 0;
+        uint32_t streamId = 0;
+        uint8_t type = 0;
+        bool extended = false;
+        std::vector<uint8_t> message;
+    };
+
+    // Parses one chunk if it is complete. Returns the bytes consumed, 0 when more are needed.
+    size_t parseChunk(const uint8_t* p, size_t available, int64_t nowUs, bool& ok) {
+        static constexpr size_t kHeaderSizes[] = {11, 7, 3, 0};
+        const uint8_t fmt = p[0] >> 6;
+        uint32_t csid = p[0] & 0x3F;
+        size_t pos = 1;
+        if (csid == 0) {
+            if (available < 2) {
+                return 0;
+            }
+            csid = 64 + p[1];
+            pos = 2;
+        } else if (csid == 1) {
+            if (available < 3) {
+                return 0;
+            }
+            csid = 64 + p[1] + (static_cast<uint32_t>(p[2]) << 8);
+            pos = 3;
+        }
+        if (available < pos + kHeaderSizes[fmt]) {
+            return 0;
+        }
+
+        ChunkStream& stream = streams_[csid];
+        uint32_t timestampField = stream.timestampField;
+        uint32_t length = stream.length;
+        uint8_t type = stream.type;
+        uint32_t streamId = stream.streamId;
+        const uint8_t* header = p + pos;
+        if (fmt <= 2) {
+            timestampField = ReadBe24(header);
+        }
+        if (fmt <= 1) {
+            length = ReadBe24(header + 3);
+            type = header[6];
+        }
+        if (fmt == 0) {
+            streamId = ReadLe32(header + 7);
+        }
+        pos += kHeaderSizes[fmt];
+        const bool extended = fmt == 3 ? stream.extended : timestampField == 0xFFFFFF;
+        uint32_t timestampValue = timestampField;
+        if (extended) {
+            if (available < pos + 4) {
+                return 0;
+            }
+            timestampValue = ReadBe32(p + pos);
+            pos += 4;
+        }
+
+        const bool newMessage = stream.received == 0;
+        if ((!newMessage && fmt != 3) || length > kMaxMessageSize) {
+            ok = false;
+            return 0;
+        }
+        const size_t payload = std::min<size_t>(length - stream.received, inChunkSize_);
+        if (available < pos + payload) {
+            return 0;
+        }
+
+        if (newMessage) {
+            if (fmt == 0) {
+                stream.timestamp = timestampValue;
+                stream.delta = 0;  // librtmp starts a message with fmt 3 only for an equal timestamp
+            } else if (fmt == 3) {
+                stream.timestamp += stream.delta;
+            } else {
+                stream.delta = timestampValue;
+                stream.timestamp += timestampValue;
+            }
+            stream.message.clear();
+            stream.message.reserve(length);
+        }
+        stream.timestampField = timestampField;
+        stream.length = length;
+        stream.type = type;
+        stream.streamId = streamId;
+        stream.extended = extended;
+        stream.message.insert(stream.message.end(), p + pos, p + pos + payload);
+        stream.received += static_cast<uint32_t>(payload);
+        if (stream.received == stream.length) {
+            stream.received = 0;
+            ok = onMessage(stream, nowUs);
+        }
+        return pos + payload;
+    }
+
+    bool onMessage(ChunkStream& stream, int64_t nowUs) {
+        const std::vector<uint8_t>& body = stream.message;
+        switch (stream.type) {
+            case kTypeSetChunkSize:
+                if (body.size() < 4) {
+                    return false;
+                }
+                inChunkSize_ = std::max<uint32_t>(ReadBe32(body.data()) & 0x7FFFFFFF, 1);
+                return true;
+            case kTypeCommand:
+                onCommand(body);
+                return true;
+            case kTypeAudio:
+            case kTypeVideo:
+            case kTypeData: {
+                ReceivedTag tag;
+                tag.type = stream.type;
+                tag.timestamp = stream.timestamp;
+                tag.size = static_cast<uint32_t>(body.size());
+                tag.arrivalUs = nowUs;
+                tag.connection = connection_;
+                if (stream.type == kTypeVideo && !body.empty()) {
+                    const astra::VideoTagInfo info = astra::InspectVideoTag(body.data(), body.size());
+                    tag.keyFrame = info.keyFrame;
+                    tag.sequenceHeader = info.sequenceHeader;
+                } else if (stream.type == kTypeAudio && body.size() > 1) {
+                    tag.sequenceHeader = (body[0] >> 4) == 10 && body[1] == 0;
+                }
+                if (keepPayloads_) {
+                    tag.body = body;
+                }
+                tags_.push_back(std::move(tag));
+                return true;
+            }
+            default:
+                // Window ack size, user control, acknowledgements: nothing to do for a sink.
+                return true;
+        }
+    }
+
+    void onCommand(const std::vector<uint8_t>& body) {
+        size_t pos = 0;
+        std::string name;
+        double transaction = 0;
+        if (!ReadAmfString(body.data(), body.size(), pos, name) ||
+            !ReadAmfNumber(body.data(), body.size(), pos, transaction)) {
+            return;
+        }
+        std::vector<uint8_t> reply;
+        if (name == "connect") {
+            std::vector<uint8_t> control;
+            AppendBe(control, kWindowAckSize, 4);
+            sendMessage(2, kTypeWindowAckSize, 0, control);
+            control.push_back(2);  // dynamic limit
+            sendMessage(2, kTypeSetPeerBandwidth, 0, control);
+
+            AmfString(reply, "_result");
+            AmfNumber(reply, transaction);
+            reply.push_back(0x03);
+            AmfString(reply, "fmsVer", false);
+            AmfString(reply, "FMS/3,0,1,123");
+            AmfString(reply, "capabilities", false);
+            AmfNumber(reply, 31);
+            AmfObjectEnd(reply);
+            reply.push_back(0x03);
+            AmfString(reply, "level", false);
+            AmfString(reply, "status");
+            AmfString(reply, "code", false);
+            AmfString(reply, "NetConnection.Connect.Success");
+            AmfString(reply, "description", false);
+            AmfString(reply, "Connection succeeded.");
+            AmfString(reply, "objectEncoding", false);
+            AmfNumber(reply, 0);
+            AmfObjectEnd(reply);
+            sendMessage(3, kTypeCommand, 0, reply);
+        } else if (name == "createStream") {
+            AmfString(reply, "_result");
+            AmfNumber(reply, transaction);
+            AmfNull(reply);
+            AmfNumber(reply, kStreamId);
+            sendMessage(3, kTypeCommand, 0, reply);
+        } else if (name == "publish") {
+            AmfString(reply, "onStatus");
+            AmfNumber(reply, 0);
+            AmfNull(reply);
+            reply.push_back(0x03);
+            AmfString(reply, "level", false);
+            AmfString(reply, "status");
+            AmfString(reply, "code", false);
+            AmfString(reply, "NetStream.Publish.Start");
+            AmfString(reply, "description", false);
+            AmfString(reply, "Publishing.");
+            AmfObjectEnd(reply);
+            sendMessage(5, kTypeCommand, kStreamId, reply);
+            published_ = true;
+        }
+        // releaseStream, FCPublish, FCUnpublish, deleteStream: librtmp does not wait on them.
+    }
+
+    void sendMessage(uint8_t csid, uint8_t type, uint32_t streamId, const std::vector<uint8_t>& payload) {
+        out_.push_back(csid);
+        AppendBe(out_, 0, 3);
+        AppendBe(out_, payload.size(), 3);
+        out_.push_back(type);
+        for (int i = 0; i < 4; ++i) {
+            out_.push_back(static_cast<uint8_t>(streamId >> (8 * i)));
+        }
+        for (size_t offset = 0; offset < payload.size(); offset += kOutChunkSize) {
+            if (offset > 0) {
+                out_.push_back(static_cast<uint8_t>(0xC0 | csid));
+            }
+            const size_t count = std::min<size_t>(kOutChunkSize, payload.size() - offset);
+            out_.insert(out_.end(), payload.begin() + static_cast<std::ptrdiff_t>(offset),
+                        payload.begin() + static_cast<std::ptrdiff_t>(offset + count));
+        }
+    }
+
+    const uint32_t connection_;
+    const bool keepPayloads_;
+    State state_ = State::kC0C1;
+    std::vector<uint8_t> in_;
+    size_t inPos_ = 0;
+    std::vector<uint8_t> out_;
+    std::vector<ReceivedTag> tags_;
+    std::unordered_map<uint32_t, ChunkStream> streams_;
+    uint32_t inChunkSize_ = 128;
+    bool published_ = false;
+};
+
+RtmpLoopbackServer::~RtmpLoopbackServer() {
+    stop();
+}
+
+bool RtmpLoopbackServer::start() {
+    if (listenFd_ >= 0) {
+        return true;
+    }
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd_, 4) != 0 ||
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    port_ = ntohs(address.sin_port);
+    stopping_ = false;
+    thread_ = std::thread(&RtmpLoopbackServer::run, this);
+    return true;
+}
+
+void RtmpLoopbackServer::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+    }
+}
+
+std::string RtmpLoopbackServer::url(const std::string& app, const std::string& stream) const {
+    return "rtmp://127.0.0.1:" + std::to_string(port_) + "/" + app + "/" + stream;
+}
+
+void RtmpLoopbackServer::setImpairment(const LinkImpairment& impairment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    impairment_ = impairment;
+}
+
+void RtmpLoopbackServer::setKeepPayloads(bool keep) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keepPayloads_ = keep;
+}
+
+void RtmpLoopbackServer::setTagListener(TagListener listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listener_ = std::move(listener);
+}
+
+bool RtmpLoopbackServer::waitForPublish(uint32_t count, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return publishCond_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                 [&] { return stats_.publishes >= count; });
+}
+
+void RtmpLoopbackServer::dropConnection() {
+    dropRequested_ = true;
+}
+
+RtmpLoopbackServer::Stats RtmpLoopbackServer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.cpuUs = cpuUs_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::vector<ReceivedTag> RtmpLoopbackServer::tags() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tags_;
+}
+
+void RtmpLoopbackServer::clearTags() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tags_.clear();
+}
+
+void RtmpLoopbackServer::run() {
+    cpuBaseUs_ = ThreadCpuUs() - cpuUs_.load(std::memory_order_relaxed);
+    while (!stopping_) {
+        pollfd listener{listenFd_, POLLIN, 0};
+        if (poll(&listener, 1, 50) <= 0) {
+            continue;
+        }
+        const int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        const int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        dropRequested_ = false;
+        serve(fd);
+        close(fd);
+        cpuUs_.store(ThreadCpuUs() - cpuBaseUs_, std::memory_order_relaxed);
+    }
+}
+
+void RtmpLoopbackServer::serve(int fd) {
+    LinkImpairment link;
+    bool keepPayloads = false;
+    TagListener listener;
+    uint32_t connection = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        link = impairment_;
+        keepPayloads = keepPayloads_;
+        listener = listener_;
+        connection = ++stats_.connections;
+    }
+    if (link.bandwidthBps > 0) {
+        // Keep the kernel from absorbing seconds of data ahead of the throttle. Loopback MSS is
+        // ~64 KB; much below a few of those and window updates stall on the persist timer.
+        const int receiveBuffer = static_cast<int>(std::max<uint64_t>(link.bandwidthBps / 8 / 4, 256 * 1024));
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    }
+
+    struct Delayed {
+        int64_t dueUs;
+        std::vector<uint8_t> bytes;
+    };
+    const int64_t halfRttUs = static_cast<int64_t>(link.rttMs) * 500;
+    const double bytesPerUs = static_cast<double>(link.bandwidthBps) / 8e6;
+    const double burst = std::max(static_cast<double>(link.bandwidthBps) / 8 / 50, 4096.0);
+    const double minRead = std::min(burst, 1460.0);
+    double tokens = burst;
+    int64_t refillUs = MonotonicNowUs();
+    int64_t publishUs = -1;
+    bool eof = false;
+    bool open = true;
+    std::deque<Delayed> inbound;
+    std::deque<Delayed> outbound;
+    std::vector<uint8_t> buffer(64 * 1024);
+    IngestSession session(connection, keepPayloads);
+
+    auto deliver = [&](const uint8_t* data, size_t size, int64_t nowUs) {
+        if (!session.consume(data, size, nowUs)) {
+            return false;
+        }
+        std::vector<uint8_t>& response = session.outbound();
+        if (!response.empty()) {
+            if (halfRttUs == 0) {
+                if (!WriteFully(fd, response.data(), response.size())) {
+                    return false;
+                }
+            } else {
+                outbound.push_back(Delayed{nowUs + halfRttUs, response});
+            }
+            response.clear();
+        }
+        if (session.takePublished()) {
+            publishUs = nowUs;
+            onPublish();
+        }
+        for (ReceivedTag& tag : session.tags()) {
+            if (listener) {
+                listener(tag);
+            }
+            onTag(std::move(tag));
+        }
+        session.tags().clear();
+        return true;
+    };
+
+    while (open && !stopping_) {
+        int64_t nowUs = MonotonicNowUs();
+        if (dropRequested_.exchange(false) ||
+            (link.dropAfterMs > 0 && publishUs >= 0 && nowUs - publishUs >= link.dropAfterMs * 1000LL)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.drops;
+            break;
+        }
+        while (open && !inbound.empty() && inbound.front().dueUs <= nowUs) {
+            open = deliver(inbound.front().bytes.data(), inbound.front().bytes.size(), nowUs);
+            inbound.pop_front();
+        }
+        while (open && !outbound.empty() && outbound.front().dueUs <= nowUs) {
+            open = WriteFully(fd, outbound.front().bytes.data(), outbound.front().bytes.size());
+            outbound.pop_front();
+        }
+        if (!open || (eof && inbound.empty())) {
+            break;
+        }
+
+        int timeoutMs = 20;
+        auto waitFor = [&](int64_t dueUs) {
+            timeoutMs = std::min<int>(timeoutMs, static_cast<int>(std::max<int64_t>(dueUs - nowUs + 999, 0) / 1000));
+        };
+        if (!inbound.empty()) {
+            waitFor(inbound.front().dueUs);
+        }
+        if (!outbound.empty()) {
+            waitFor(outbound.front().dueUs);
+        }
+        bool wantRead = !eof;
+        if (wantRead && link.bandwidthBps > 0) {
+            tokens = std::min(burst, tokens + static_cast<double>(nowUs - refillUs) * bytesPerUs);
+            refillUs = nowUs;
+            if (tokens < minRead) {
+                wantRead = false;
+                waitFor(nowUs + static_cast<int64_t>((minRead - tokens) / bytesPerUs));
+            }
+        }
+
+        pollfd descriptor{fd, static_cast<short>(wantRead ? POLLIN : 0), 0};
+        const int ready = poll(&descriptor, 1, timeoutMs);
+        cpuUs_.store(ThreadCpuUs() - cpuBaseUs_, std::memory_order_relaxed);
+        if (ready <= 0 || !wantRead || (descriptor.revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+        size_t limit = buffer.size();
+        if (link.bandwidthBps > 0) {
+            limit = std::min(limit, static_cast<size_t>(tokens));
+        }
+        const ssize_t received = recv(fd, buffer.data(), limit, 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            eof = true;  // still deliver what the RTT delay holds back
+            continue;
+        }
+        tokens -= static_cast<double>(received);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.bytesReceived += static_cast<uint64_t>(received);
+        }
+        nowUs = MonotonicNowUs();
+        if (halfRttUs == 0) {
+            open = deliver(buffer.data(), static_cast<size_t>(received), nowUs);
+        } else {
+            inbound.push_back(Delayed{nowUs + halfRttUs,
+                                      std::vector<uint8_t>(buffer.data(), buffer.data() + received)});
+        }
+    }
+}
+
+void RtmpLoopbackServer::onPublish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.publishes;
+    }
+    publishCond_.notify_all();
+}
+
+void RtmpLoopbackServer::onTag(ReceivedTag tag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.tags;
+    tags_.push_back(std::move(tag));
+}
+
+}  // namespace astra::bench
@@ -0,0 +1,101 @@
+#ifndef ASTRASTREAM_RTMP_LOOPBACK_SERVER_H
+#define ASTRASTREAM_RTMP_LOOPBACK_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace astra::bench {
+
+// Link conditions applied to each accepted connection. The cap throttles how fast the server
+// reads (the receive buffer is shrunk so TCP pushes back on the sender); the RTT is applied
+// as half-RTT delays on received and sent bytes at the application layer.
+struct LinkImpairment {
+    uint64_t bandwidthBps = 0;  // 0: unlimited
+    uint32_t rttMs = 0;
+    uint32_t dropAfterMs = 0;  // close a publishing connection this long after publish; 0: never
+};
+
+// An FLV tag as the ingest reassembled it from the chunk stream.
+struct ReceivedTag {
+    uint8_t type = 0;  // 8 audio, 9 video, 18 script data
+    uint32_t timestamp = 0;
+    uint32_t size = 0;
+    bool keyFrame = false;
+    bool sequenceHeader = false;
+    int64_t arrivalUs = 0;  // CLOCK_MONOTONIC when the last chunk was parsed
+    uint32_t connection = 0;
+    std::vector<uint8_t> body;  // only with keepPayloads
+};
+
+// Minimal single-publisher RTMP ingest on 127.0.0.1 for driving RTMPPush end to end without
+// a CDN: plain handshake, connect / createStream / publish, chunk reassembly with Set Chunk
+// Size. Everything else the client sends is parsed and ignored. One connection is served at
+// a time on a background thread; a dropped publisher may reconnect.
+class RtmpLoopbackServer {
+public:
+    struct Stats {
+        uint32_t connections = 0;
+        uint32_t publishes = 0;
+        uint32_t drops = 0;  // injected, not client-initiated
+        uint64_t bytesReceived = 0;
+        uint64_t tags = 0;
+        int64_t cpuUs = 0;  // thread CPU time of the server, to subtract from process figures
+    };
+    using TagListener = std::function<void(const ReceivedTag&)>;
+
+    RtmpLoopbackServer() = default;
+    ~RtmpLoopbackServer();
+    RtmpLoopbackServer(const RtmpLoopbackServer&) = delete;
+    RtmpLoopbackServer& operator=(const RtmpLoopbackServer&) = delete;
+
+    // Binds an ephemeral port. Listener, impairment and keepPayloads are read per connection.
+    bool start();
+    void stop();
+
+    [[nodiscard]] uint16_t port() const { return port_; }
+    [[nodiscard]] std::string url(const std::string& app = "live", const std::string& stream = "bench") const;
+
+    void setImpairment(const LinkImpairment& impairment);
+    void setKeepPayloads(bool keep);
+    // Called on the server thread for every completed audio, video and script tag.
+    void setTagListener(TagListener listener);
+
+    bool waitForPublish(uint32_t count, int timeoutMs);
+    void dropConnection();
+
+    [[nodiscard]] Stats stats() const;
+    [[nodiscard]] std::vector<ReceivedTag> tags() const;
+    void clearTags();
+
+private:
+    void run();
+    void serve(int fd);
+    void onPublish();
+    void onTag(ReceivedTag tag);
+
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> dropRequested_{false};
+    std::atomic<int64_t> cpuUs_{0};
+    int64_t cpuBaseUs_ = 0;  // server thread only
+
+    mutable std::mutex mutex_;
+    std::condition_variable publishCond_;
+    LinkImpairment impairment_;
+    bool keepPayloads_ = false;
+    TagListener listener_;
+    std::vector<ReceivedTag> tags_;
+    Stats stats_;
+};
+
+}  // namespace astra::bench
+
+#endif  // ASTRASTREAM_RTMP_LOOPBACK_SERVER_H
@@ -0,0 +1,37 @@
+// Host stand-in for the librtmp packet helpers astra_core uses. The prebuilt librtmp only
+// ships Android ABIs; these mirror its allocation layout (body preceded by header room).
+
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include "rtmp.h"
+
+void RTMPPacket_Reset(RTMPPacket* p) {
+    p->m_headerType = 0;
+    p->m_packetType = 0;
+    p->m_nChannel = 0;
+    p->m_nTimeStamp = 0;
+    p->m_nInfoField2 = 0;
+    p->m_hasAbsTimestamp = 0;
+    p->m_nBodySize = 0;
+    p->m_nBytesRead = 0;
+}
+
+int RTMPPacket_Alloc(RTMPPacket* p, int nSize) {
+    auto* buffer = static_cast<char*>(std::calloc(1, static_cast<size_t>(nSize) + RTMP_MAX_HEADER_SIZE));
+    if (!buffer) {
+        return 0;
+    }
+    p->m_body = buffer + RTMP_MAX_HEADER_SIZE;
+    p->m_nBytesRead = 0;
+    return 1;
+}
+
+void RTMPPacket_Free(RTMPPacket* p) {
+    if (p->m_body) {
+        std::free(p->m_body - RTMP_MAX_HEADER_SIZE);
+        p->m_body = nullptr;
+    }
+}
+}
@@ -0,0 +1,401 @@
+#include "srt_loopback_listener.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <random>
+#include <set>
+
+#include "MediaClock.h"
+#include "SrtPacket.h"
+
+namespace astra::bench {
+
+namespace {
+
+constexpr int64_t kAckIntervalUs = 10000;
+constexpr int64_t kMinNakIntervalUs = 20000;
+constexpr uint32_t kListenerSocketId = 0x1F2E3D4C;
+constexpr uint32_t kCookieSeed = 0x5EC0FFEE;
+constexpr size_t kMaxNakRanges = 64;
+
+struct Incoming {
+    int64_t dueUs = 0;
+    std::vector<uint8_t> bytes;
+};
+
+}  // namespace
+
+SrtLoopbackListener::~SrtLoopbackListener() {
+    stop();
+}
+
+bool SrtLoopbackListener::start(uint32_t latencyMs, const SrtImpairment& impairment) {
+    if (fd_ >= 0) {
+        return true;
+    }
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    const int bufferBytes = 4 << 20;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    port_ = ntohs(address.sin_port);
+    latencyMs_ = latencyMs;
+    impairment_ = impairment;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_ = Stats{};
+        streamId_.clear();
+        payload_.clear();
+    }
+    stopping_ = false;
+    thread_ = std::thread(&SrtLoopbackListener::run, this);
+    return true;
+}
+
+void SrtLoopbackListener::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+std::string SrtLoopbackListener::url(const std::string& streamId) const {
+    std::string value = "srt://127.0.0.1:" + std::to_string(port_) + "?latency=" + std::to_string(latencyMs_);
+    if (!streamId.empty()) {
+        value += "&streamid=" + streamId;
+    }
+    return value;
+}
+
+SrtLoopbackListener::Stats SrtLoopbackListener::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::string SrtLoopbackListener::streamId() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streamId_;
+}
+
+std::vector<uint8_t> SrtLoopbackListener::payload() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return payload_;
+}
+
+void SrtLoopbackListener::run() {
+    const int64_t startUs = MonotonicNowUs();
+    const auto elapsed = [startUs](int64_t nowUs) { return static_cast<uint32_t>(nowUs - startUs); };
+    const uint32_t cookie = kCookieSeed ^ port_;
+    std::mt19937 random(impairment_.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    sockaddr_storage peer{};
+    socklen_t peerLength = 0;
+    bool connected = false;
+    uint32_t peerSocket = 0;
+    std::vector<uint8_t> conclusionReply;
+
+    // Receive state, with 64-bit indices so sequence wrap needs no care beyond conversion.
+    uint32_t expectedSequence = 0;  // sequence number of |delivered|
+    int64_t delivered = 0;  // next index to hand over in order
+    int64_t highest = -1;  // highest index received
+    std::map<int64_t, std::vector<uint8_t>> reorder;
+    std::set<int64_t> losses;
+
+    uint32_t ackNumber = 0;
+    std::map<uint32_t, int64_t> ackSentUs;
+    int64_t smoothedRttUs = 100000;  // the protocol's initial estimate
+    int64_t rttVarianceUs = 50000;
+    int64_t nextAckUs = 0;
+    int64_t nextNakUs = 0;
+    uint64_t packetsSinceAck = 0;
+    uint64_t bytesSinceAck = 0;
+    int64_t lastAckUs = startUs;
+
+    std::deque<Incoming> delayed;
+    std::vector<uint8_t> buffer(2048);
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    const auto sendPacket = [&](const std::vector<uint8_t>& packet) {
+        sendto(fd_, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr*>(&peer), peerLength);
+    };
+    const auto indexOf = [&](uint32_t sequence) { return delivered + srt::SequenceOffset(sequence, expectedSequence); };
+    const auto sequenceOf = [&](int64_t index) {
+        return static_cast<uint32_t>((static_cast<int64_t>(expectedSequence) + (index - delivered)) & srt::kMaxSequence);
+    };
+    const auto deliver = [&]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (true) {
+            auto it = reorder.find(delivered);
+            if (it == reorder.end()) {
+                break;
+            }
+            payload_.insert(payload_.end(), it->second.begin(), it->second.end());
+            stats_.bytesDelivered += it->second.size();
+            reorder.erase(it);
+            ++delivered;
+            expectedSequence = srt::SequenceNext(expectedSequence);
+        }
+    };
+    const auto sendNak = [&](int64_t nowUs) {
+        if (losses.empty()) {
+            return;
+        }
+        ranges.clear();
+        for (int64_t index : losses) {
+            if (!ranges.empty() && sequenceOf(index) == srt::SequenceNext(ranges.back().second)) {
+                ranges.back().second = sequenceOf(index);
+            } else if (ranges.size() < kMaxNakRanges) {
+                ranges.emplace_back(sequenceOf(index), sequenceOf(index));
+            }
+        }
+        srt::ControlHeader header;
+        header.type = srt::ControlType::kNak;
+        header.timestampUs = elapsed(nowUs);
+        header.destinationSocket = peerSocket;
+        sendPacket(srt::BuildNak(header, ranges));
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.naksSent;
+    };
+
+    const auto onHandshake = [&](const uint8_t* packet, size_t size) {
+        srt::Handshake request;
+        if (!srt::ParseHandshake(packet, size, request)) {
+            return;
+        }
+        srt::ControlHeader header;
+        header.type = srt::ControlType::kHandshake;
+        header.destinationSocket = request.socketId;
+        header.timestampUs = elapsed(MonotonicNowUs());
+        if (request.type == srt::HandshakeType::kInduction) {
+            srt::Handshake reply;
+            reply.version = srt::kHandshakeVersion5;
+            reply.extension = srt::kInductionMagic;
+            reply.initialSequence = request.initialSequence;
+            reply.type = srt::HandshakeType::kInduction;
+            reply.socketId = kListenerSocketId;
+            reply.cookie = cookie;
+            sendPacket(srt::BuildHandshake(header, reply));
+            return;
+        }
+        if (request.type != srt::HandshakeType::kConclusion) {
+            return;
+        }
+        if (connected) {
+            sendPacket(conclusionReply);  // our response was lost
+            return;
+        }
+        srt::Handshake reply;
+        reply.version = srt::kHandshakeVersion5;
+        reply.initialSequence = request.initialSequence;
+        reply.socketId = kListenerSocketId;
+        if (request.cookie != cookie || !request.hasSrtInfo) {
+            reply.type = static_cast<srt::HandshakeType>(static_cast<uint32_t>(srt::HandshakeType::kRejectBase) + 5);
+            sendPacket(srt::BuildHandshake(header, reply));
+            return;
+        }
+        reply.type = srt::HandshakeType::kConclusion;
+        reply.extension = srt::kExtHsReq;
+        reply.hasSrtInfo = true;
+        reply.srtCommand = srt::kCmdHsRsp;
+        reply.srtVersion = srt::kSrtVersion;
+        reply.srtFlags = srt::kFlagTsbpdSend | srt::kFlagTsbpdRecv | srt::kFlagTooLateDrop |
+                         srt::kFlagPeriodicNak | srt::kFlagRexmit;
+        const auto latency = static_cast<uint16_t>(std::max<uint32_t>(latencyMs_, request.senderDelayMs));
+        reply.receiverDelayMs = latency;
+        reply.senderDelayMs = latency;
+        conclusionReply = srt::BuildHandshake(header, reply);
+        sendPacket(conclusionReply);
+        connected = true;
+        peerSocket = request.socketId;
+        expectedSequence = request.initialSequence;
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.connections;
+        streamId_ = request.streamId;
+    };
+
+    const auto onData = [&](const uint8_t* packet, size_t size, int64_t nowUs) {
+        srt::DataHeader header;
+        if (!connected || !srt::ReadDataHeader(packet, size, header)) {
+            return;
+        }
+        const int64_t index = indexOf(header.sequence);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.packetsReceived;
+            stats_.retransmitted += header.retransmitted ? 1 : 0;
+            if (index < delivered || reorder.count(index) != 0) {
+                ++stats_.duplicates;
+                return;
+            }
+        }
+        ++packetsSinceAck;
+        bytesSinceAck += size;
+        reorder.emplace(index, std::vector<uint8_t>(packet + srt::kHeaderSize, packet + size));
+        losses.erase(index);
+        if (index > highest + 1) {
+            const int64_t firstMissing = std::max(highest + 1, delivered);
+            for (int64_t missing = firstMissing; missing < index; ++missing) {
+                if (reorder.count(missing) == 0) {
+                    losses.insert(missing);
+                }
+            }
+            sendNak(nowUs);
+        }
+        highest = std::max(highest, index);
+        deliver();
+    };
+
+    const auto onDropRequest = [&](const uint8_t* packet, size_t size) {
+        uint32_t first = 0;
+        uint32_t last = 0;
+        if (!srt::ParseDropRequest(packet, size, first, last)) {
+            return;
+        }
+        const int64_t lastIndex = indexOf(last);
+        uint64_t skipped = 0;
+        while (delivered <= lastIndex) {
+            if (reorder.count(delivered) == 0) {
+                losses.erase(delivered);
+                ++delivered;
+                expectedSequence = srt::SequenceNext(expectedSequence);
+                ++skipped;
+            }
+            deliver();
+        }
+        highest = std::max(highest, lastIndex);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.packetsSkipped += skipped;
+    };
+
+    const auto process = [&](const uint8_t* packet, size_t size, int64_t nowUs) {
+        srt::ControlHeader header;
+        if (!srt::ReadControlHeader(packet, size, header)) {
+            onData(packet, size, nowUs);
+            return;
+        }
+        switch (header.type) {
+            case srt::ControlType::kHandshake:
+                onHandshake(packet, size);
+                break;
+            case srt::ControlType::kAckAck: {
+                auto it = ackSentUs.find(header.typeSpecific);
+                if (it != ackSentUs.end()) {
+                    const int64_t sample = nowUs - it->second;
+                    rttVarianceUs = (3 * rttVarianceUs + std::llabs(smoothedRttUs - sample)) / 4;
+                    smoothedRttUs = (7 * smoothedRttUs + sample) / 8;
+                    ackSentUs.erase(ackSentUs.begin(), std::next(it));
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stats_.rttUs = smoothedRttUs;
+                }
+                break;
+            }
+            case srt::ControlType::kDropRequest:
+                onDropRequest(packet, size);
+                break;
+            case srt::ControlType::kShutdown: {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.shutdown = true;
+                break;
+            }
+            default:
+                break;
+        }
+    };
+
+    while (!stopping_) {
+        int64_t nowUs = MonotonicNowUs();
+        int timeoutMs = 5;
+        if (!delayed.empty()) {
+            timeoutMs = static_cast<int>(std::clamp<int64_t>((delayed.front().dueUs - nowUs) / 1000, 0, 5));
+        }
+        pollfd fd{fd_, POLLIN, 0};
+        poll(&fd, 1, timeoutMs);
+        nowUs = MonotonicNowUs();
+        while (true) {
+            sockaddr_storage from{};
+            socklen_t fromLength = sizeof(from);
+            const ssize_t size = recvfrom(fd_, buffer.data(), buffer.size(), MSG_DONTWAIT,
+                                          reinterpret_cast<sockaddr*>(&from), &fromLength);
+            if (size <= 0) {
+                break;
+            }
+            if (!connected) {
+                peer = from;
+                peerLength = fromLength;
+            }
+            if (!srt::IsControl(buffer.data()) && chance(random) < impairment_.lossRate) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++stats_.injectedLosses;
+                continue;
+            }
+            if (impairment_.rttMs == 0) {
+                process(buffer.data(), static_cast<size_t>(size), nowUs);
+            } else {
+                delayed.push_back(Incoming{nowUs + static_cast<int64_t>(impairment_.rttMs) * 1000,
+                                           std::vector<uint8_t>(buffer.begin(), buffer.begin() + size)});
+            }
+        }
+        while (!delayed.empty() && delayed.front().dueUs <= nowUs) {
+            process(delayed.front().bytes.data(), delayed.front().bytes.size(), nowUs);
+            delayed.pop_front();
+        }
+        if (!connected) {
+            continue;
+        }
+        if (nowUs >= nextAckUs) {
+            srt::ControlHeader header;
+            header.type = srt::ControlType::kAck;
+            header.typeSpecific = ++ackNumber;
+            header.timestampUs = elapsed(nowUs);
+            header.destinationSocket = peerSocket;
+            srt::Ack ack;
+            ack.lastAcknowledged = expectedSequence;
+            ack.rttUs = static_cast<uint32_t>(smoothedRttUs);
+            ack.rttVarianceUs = static_cast<uint32_t>(rttVarianceUs);
+            ack.availableBuffer = 8192;
+            const int64_t intervalUs = std::max<int64_t>(nowUs - lastAckUs, 1);
+            ack.packetsPerSecond = static_cast<uint32_t>(packetsSinceAck * 1000000 / intervalUs);
+            ack.bytesPerSecond = static_cast<uint32_t>(bytesSinceAck * 1000000 / intervalUs);
+            ack.linkCapacity = ack.packetsPerSecond;
+            sendPacket(srt::BuildAck(header, ack));
+            ackSentUs[ackNumber] = nowUs;
+            if (ackSentUs.size() > 1024) {
+                ackSentUs.erase(ackSentUs.begin());
+            }
+            packetsSinceAck = 0;
+            bytesSinceAck = 0;
+            lastAckUs = nowUs;
+            nextAckUs = nowUs + kAckIntervalUs;
+        }
+        if (nowUs >= nextNakUs) {
+            // Periodic NAK: losses whose retransmission itself was lost get asked for again.
+            sendNak(nowUs);
+            nextNakUs = nowUs + std::max(kMinNakIntervalUs, smoothedRttUs + 4 * rttVarianceUs);
+        }
+    }
+}
+
+}  // namespace astra::bench
@@ -0,0 +1,76 @@
+#ifndef ASTRASTREAM_SRT_LOOPBACK_LISTENER_H
+#define ASTRASTREAM_SRT_LOOPBACK_LISTENER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace astra::bench {
+
+// Conditions applied to the data packets the listener receives. Lost packets are discarded
+// before the receiver logic sees them (retransmissions included); the delay holds every
+// incoming packet for the whole RTT, so the sender measures it through ACK / ACKACK.
+struct SrtImpairment {
+    double lossRate = 0.0;  // 0..1
+    uint32_t rttMs = 0;
+    uint32_t seed = 1;
+};
+
+// Single-caller SRT live-mode receiver on 127.0.0.1 for driving SrtSender without libsrt:
+// cookie-checked HSv5 handshake answering HSREQ with HSRSP, full ACK every 10 ms, an
+// immediate NAK for every gap plus periodic NAKs, RTT from ACKACK and DROPREQ handling.
+// Payloads are reassembled in sequence order, skipping what the sender dropped.
+class SrtLoopbackListener {
+public:
+    struct Stats {
+        uint32_t connections = 0;
+        uint64_t packetsReceived = 0;  // data packets past the impairment
+        uint64_t retransmitted = 0;  // of those, with the R flag
+        uint64_t duplicates = 0;
+        uint64_t injectedLosses = 0;
+        uint64_t naksSent = 0;
+        uint64_t packetsSkipped = 0;  // never arrived, released by a DROPREQ
+        uint64_t bytesDelivered = 0;
+        int64_t rttUs = 0;
+        bool shutdown = false;  // the caller closed the session
+    };
+
+    SrtLoopbackListener() = default;
+    ~SrtLoopbackListener();
+    SrtLoopbackListener(const SrtLoopbackListener&) = delete;
+    SrtLoopbackListener& operator=(const SrtLoopbackListener&) = delete;
+
+    // |latencyMs| is the receiver's TSBPD delay offered in the handshake response.
+    bool start(uint32_t latencyMs, const SrtImpairment& impairment);
+    void stop();
+
+    [[nodiscard]] uint16_t port() const { return port_; }
+    [[nodiscard]] std::string url(const std::string& streamId = "") const;
+
+    [[nodiscard]] Stats stats() const;
+    [[nodiscard]] std::string streamId() const;
+    // Delivered payload bytes, in order.
+    [[nodiscard]] std::vector<uint8_t> payload() const;
+
+private:
+    void run();
+
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    uint32_t latencyMs_ = 0;
+    SrtImpairment impairment_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+
+    mutable std::mutex mutex_;
+    Stats stats_;
+    std::string streamId_;
+    std::vector<uint8_t> payload_;
+};
+
+}  // namespace astra::bench
+
+#endif  // ASTRASTREAM_SRT_LOOPBACK_LISTENER_H
@@ -0,0 +1,34 @@
+# Platform-neutral part of the native library: muxing, FLV recording, LL-HLS output,
+# queueing, RTMP chunk layout, the SRT sender and the capture DSP. Shared by the Android build and host builds
+# (benchmarks), so nothing here may depend on the NDK. Set NATIVE_ROOT to this directory before
+# including.
+
+file(GLOB ASTRA_CORE_SOURCES CONFIGURE_DEPENDS
+        ${NATIVE_ROOT}/stream/*.cpp
+        ${NATIVE_ROOT}/audio/*.cpp)
+list(APPEND ASTRA_CORE_SOURCES
+        ${NATIVE_ROOT}/push/AVQueue.cpp
+        ${NATIVE_ROOT}/push/FlvRecorder.cpp
+        ${NATIVE_ROOT}/push/HlsSegmenter.cpp
+        ${NATIVE_ROOT}/push/RtmpChunkWriter.cpp
+        ${NATIVE_ROOT}/push/SrtPacket.cpp
+        ${NATIVE_ROOT}/push/SrtSender.cpp)
+
+add_library(astra_core STATIC ${ASTRA_CORE_SOURCES})
+
+target_include_directories(
+        astra_core
+        PUBLIC
+        ${NATIVE_ROOT}/librtmp/include
+        ${NATIVE_ROOT}/common
+        ${NATIVE_ROOT}/stream
+        ${NATIVE_ROOT}/audio
+        ${NATIVE_ROOT}/push
+)
+
+set_target_properties(astra_core PROPERTIES POSITION_INDEPENDENT_CODE ON)
+
+# AVQueue frees queued RTMPPackets, so whoever links astra_core also provides librtmp's
+# RTMPPacket_* functions (the prebuilt librtmp on Android).
+find_package(Threads REQUIRED)
+target_link_libraries(astra_core PUBLIC Threads::Threads)
@@ -0,0 +1,100 @@
+#include "AacSilence.h"
+
+#include <algorithm>
+
+namespace astra {
+
+namespace {
+constexpr uint32_t kElementSce = 0;
+constexpr uint32_t kElementCpe = 1;
+constexpr uint32_t kElementEnd = 7;
+constexpr uint32_t kGlobalGain = 100;  // unused without scale factor bands
+
+class BitWriter {
+public:
+    void put(uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; --i) {
+            if (used_ == 0) {
+                bytes_.push_back(0);
+            }
+            bytes_.back() |= static_cast<uint8_t>(((value >> i) & 1U) << (7 - used_));
+            used_ = (used_ + 1) & 7;
+        }
+    }
+
+    std::vector<uint8_t> take() { return std::move(bytes_); }
+
+private:
+    std::vector<uint8_t> bytes_;
+    int used_ = 0;
+};
+
+// ics_info for a long window with no bands (ISO 14496-3, 4.4.2.1).
+void PutEmptyIcsInfo(BitWriter& bits) {
+    bits.put(0, 1);  // ics_reserved_bit
+    bits.put(0, 2);  // window_sequence: ONLY_LONG_SEQUENCE
+    bits.put(0, 1);  // window_shape
+    bits.put(0, 6);  // max_sfb
+    bits.put(0, 1);  // predictor_data_present
+}
+
+// individual_channel_stream with no sections, scale factors or spectral data.
+void PutEmptyChannelStream(BitWriter& bits, bool withIcsInfo) {
+    bits.put(kGlobalGain, 8);
+    if (withIcsInfo) {
+        PutEmptyIcsInfo(bits);
+    }
+    bits.put(0, 1);  // pulse_data_present
+    bits.put(0, 1);  // tns_data_present
+    bits.put(0, 1);  // gain_control_data_present
+}
+}  // namespace
+
+std::vector<uint8_t> BuildSilentAacFrame(int32_t channels) {
+    BitWriter bits;
+    if (channels == 1) {
+        bits.put(kElementSce, 3);
+        bits.put(0, 4);  // element_instance_tag
+        PutEmptyChannelStream(bits, true);
+    } else if (channels == 2) {
+        bits.put(kElementCpe, 3);
+        bits.put(0, 4);  // element_instance_tag
+        bits.put(1, 1);  // common_window
+        PutEmptyIcsInfo(bits);
+        bits.put(0, 2);  // ms_mask_present
+        PutEmptyChannelStream(bits, false);
+        PutEmptyChannelStream(bits, false);
+    } else {
+        return {};
+    }
+    bits.put(kElementEnd, 3);
+    return bits.take();
+}
+
+void SilenceGate::configure(int32_t channels, int32_t hangoverBlocks) {
+    channels_ = std::min(std::max(channels, 1), kMaxChannels);
+    hangoverBlocks_ = std::max(hangoverBlocks, 0);
+    reset();
+}
+
+void SilenceGate::reset() {
+    silentBlocks_ = 0;
+}
+
+bool SilenceGate::update(const int16_t* pcm, size_t frames, int32_t peakThreshold) {
+    levels_.fill(ChannelLevels{});
+    AccumulateLevels(pcm, frames, channels_, levels_.data());
+    int32_t peak = 0;
+    for (int32_t c = 0; c < channels_; ++c) {
+        peak = std::max(peak, levels_[static_cast<size_t>(c)].peak);
+    }
+    if (peak > peakThreshold) {
+        silentBlocks_ = 0;
+        return false;
+    }
+    // Saturate well past the hangover so long silences cannot wrap the counter.
+    silentBlocks_ = std::min(silentBlocks_ + 1, hangoverBlocks_ + 1);
+    return gated();
+}
+
+}  // namespace astra
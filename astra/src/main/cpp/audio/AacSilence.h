@@ -0,0 +1,43 @@
+#ifndef ASTRASTREAM_AACSILENCE_H
+#define ASTRASTREAM_AACSILENCE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PcmKernels.h"
+
+namespace astra {
+
+// Raw AAC-LC access unit that decodes to 1024 frames of silence: one SCE (mono) or CPE
+// (stereo) with max_sfb = 0, so it carries no spectral data at all (4 or 6 bytes). Returns
+// an empty vector for other layouts.
+std::vector<uint8_t> BuildSilentAacFrame(int32_t channels);
+
+// Decides, block by block, when encoder input has been silent long enough to stop encoding
+// it. Only blocks after |hangoverBlocks| consecutive silent ones are gated, so the encoder
+// has already decayed to silence when frames switch to the cached ones, and the first loud
+// block goes straight back to the encoder.
+class SilenceGate {
+public:
+    void configure(int32_t channels, int32_t hangoverBlocks);
+    void reset();
+
+    // |peakThreshold| is the largest |sample| still treated as silence.
+    bool update(const int16_t* pcm, size_t frames, int32_t peakThreshold);
+
+    [[nodiscard]] bool gated() const { return silentBlocks_ > hangoverBlocks_; }
+
+private:
+    static constexpr int32_t kMaxChannels = 8;
+
+    int32_t channels_ = 1;
+    int32_t hangoverBlocks_ = 8;
+    int32_t silentBlocks_ = 0;
+    std::array<ChannelLevels, kMaxChannels> levels_{};
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_AACSILENCE_H
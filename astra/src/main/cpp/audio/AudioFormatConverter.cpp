@@ -0,0 +1,115 @@
+#include "AudioFormatConverter.h"
+
+#include <algorithm>
+
+namespace astra {
+
+bool AudioFormatConverter::configure(const PcmFormat& input,
+                                     int32_t outputRate,
+                                     int32_t outputChannels,
+                                     size_t maxInputFrames,
+                                     bool driftAdjustable) {
+    if (input.sampleRate <= 0 || input.channels <= 0 || outputRate <= 0 || outputChannels <= 0 ||
+        maxInputFrames == 0) {
+        return false;
+    }
+    input_ = input;
+    outputRate_ = outputRate;
+    outputChannels_ = outputChannels;
+    maxInputFrames_ = maxInputFrames;
+    resampleChannels_ = std::min(input.channels, outputChannels);
+    passthrough_ = !driftAdjustable && !input.isFloat && input.sampleRate == outputRate &&
+            input.channels == outputChannels;
+    if (passthrough_) {
+        reset();
+        return true;
+    }
+
+    if (!resampler_.configure(input.sampleRate, outputRate, resampleChannels_, maxInputFrames, driftAdjustable)) {
+        return false;
+    }
+    const size_t maxOutputFrames = resampler_.maxOutputFrames(maxInputFrames);
+    const auto widest = static_cast<size_t>(std::max(input.channels, outputChannels));
+    floatBuffer_.assign(maxInputFrames * static_cast<size_t>(input.channels), 0.0f);
+    mappedBuffer_.assign(maxInputFrames * static_cast<size_t>(resampleChannels_), 0.0f);
+    resampledBuffer_.assign(maxOutputFrames * static_cast<size_t>(resampleChannels_), 0.0f);
+    upmixBuffer_.assign(maxOutputFrames * widest, 0.0f);
+    output_.assign(maxOutputFrames * static_cast<size_t>(outputChannels), 0);
+    reset();
+    return true;
+}
+
+void AudioFormatConverter::reset() {
+    inputFrames_ = 0;
+    dither_.seed(0x5EED1234u);
+    if (!passthrough_) {
+        resampler_.reset();
+    }
+}
+
+double AudioFormatConverter::nextOutputOffsetFrames() const {
+    if (passthrough_) {
+        return 0.0;
+    }
+    return resampler_.nextOutputInputPosition() - static_cast<double>(inputFrames_);
+}
+
+const float* AudioFormatConverter::mapChannels(const float* in,
+                                               size_t frames,
+                                               int32_t fromChannels,
+                                               int32_t toChannels,
+                                               float* scratch) {
+    if (fromChannels == toChannels) {
+        return in;
+    }
+    if (fromChannels == 2 && toChannels == 1) {
+        DownmixStereoToMono(in, scratch, frames);
+    } else if (fromChannels == 1 && toChannels == 2) {
+        UpmixMonoToStereo(in, scratch, frames);
+    } else {
+        // Uncommon layouts: keep the leading channels, repeat the last one if widening.
+        const auto from = static_cast<size_t>(fromChannels);
+        const auto to = static_cast<size_t>(toChannels);
+        for (size_t i = 0; i < frames; ++i) {
+            for (size_t c = 0; c < to; ++c) {
+                scratch[i * to + c] = in[i * from + std::min(c, from - 1)];
+            }
+        }
+    }
+    return scratch;
+}
+
+size_t AudioFormatConverter::process(const void* in, size_t inputFrames, const int16_t** out) {
+    if (in == nullptr || out == nullptr || inputFrames == 0) {
+        return 0;
+    }
+    if (passthrough_) {
+        *out = static_cast<const int16_t*>(in);
+        inputFrames_ += static_cast<int64_t>(inputFrames);
+        return inputFrames;
+    }
+    inputFrames = std::min(inputFrames, maxInputFrames_);
+
+    const float* samples = nullptr;
+    if (input_.isFloat) {
+        samples = static_cast<const float*>(in);
+    } else {
+        Int16ToFloat(static_cast<const int16_t*>(in),
+                     floatBuffer_.data(),
+                     inputFrames * static_cast<size_t>(input_.channels));
+        samples = floatBuffer_.data();
+    }
+    samples = mapChannels(samples, inputFrames, input_.channels, resampleChannels_, mappedBuffer_.data());
+
+    const size_t maxOutputFrames = resampledBuffer_.size() / static_cast<size_t>(resampleChannels_);
+    const size_t frames = resampler_.process(samples, inputFrames, resampledBuffer_.data(), maxOutputFrames);
+    inputFrames_ += static_cast<int64_t>(inputFrames);
+
+    const float* mapped = mapChannels(resampledBuffer_.data(), frames, resampleChannels_, outputChannels_,
+                                      upmixBuffer_.data());
+    FloatToInt16Dithered(mapped, output_.data(), frames * static_cast<size_t>(outputChannels_), dither_);
+    *out = output_.data();
+    return frames;
+}
+
+}  // namespace astra
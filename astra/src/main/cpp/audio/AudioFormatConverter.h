@@ -0,0 +1,65 @@
+#ifndef ASTRASTREAM_AUDIOFORMATCONVERTER_H
+#define ASTRASTREAM_AUDIOFORMATCONVERTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PcmKernels.h"
+#include "PolyphaseResampler.h"
+
+namespace astra {
+
+struct PcmFormat {
+    int32_t sampleRate = 48000;
+    int32_t channels = 1;
+    bool isFloat = false;
+};
+
+// Capture-side DSP: device PCM (int16 or float, any rate, mono or stereo) to the interleaved
+// int16 layout the AAC encoder is configured for. Downmix runs before the resampler and upmix
+// after it so the filter always works on the smaller channel count.
+class AudioFormatConverter {
+public:
+    // Not realtime-safe; sizes every intermediate buffer for |maxInputFrames| per call.
+    // |driftAdjustable| keeps the resampler engaged so setDriftPpm() can trim the ratio.
+    bool configure(const PcmFormat& input,
+                   int32_t outputRate,
+                   int32_t outputChannels,
+                   size_t maxInputFrames,
+                   bool driftAdjustable = false);
+    void reset();
+    void setDriftPpm(double ppm) { resampler_.setDriftPpm(ppm); }
+
+    // Realtime-safe. Converts |inputFrames| frames and points |out| at the result, which stays
+    // valid until the next call. Returns the number of output frames.
+    size_t process(const void* in, size_t inputFrames, const int16_t** out);
+
+    // Offset, in input frames, from the first frame of the next process() call to the instant
+    // its first output frame represents. Negative while the resampler holds back history.
+    [[nodiscard]] double nextOutputOffsetFrames() const;
+    [[nodiscard]] bool passthrough() const { return passthrough_; }
+    [[nodiscard]] const PcmFormat& inputFormat() const { return input_; }
+
+private:
+    const float* mapChannels(const float* in, size_t frames, int32_t fromChannels, int32_t toChannels, float* scratch);
+
+    PcmFormat input_{};
+    int32_t outputRate_ = 48000;
+    int32_t outputChannels_ = 1;
+    int32_t resampleChannels_ = 1;
+    size_t maxInputFrames_ = 0;
+    bool passthrough_ = true;
+    int64_t inputFrames_ = 0;
+    PolyphaseResampler resampler_;
+    DitherState dither_;
+    std::vector<float> floatBuffer_;
+    std::vector<float> mappedBuffer_;
+    std::vector<float> resampledBuffer_;
+    std::vector<float> upmixBuffer_;
+    std::vector<int16_t> output_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_AUDIOFORMATCONVERTER_H
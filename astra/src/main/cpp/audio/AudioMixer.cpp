@@ -0,0 +1,235 @@
+#include "AudioMixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace astra {
+
+namespace {
+constexpr size_t kRingBlocks = 8;
+constexpr size_t kTargetBlocks = 2;         // stream sources start mixing at this fill
+constexpr size_t kMaxPushFrames = 4096;     // larger pushes are converted in slices
+constexpr double kFillSmoothing = 0.02;     // per block, ~1 s time constant
+constexpr double kDriftPpmPerFrame = 0.25;  // 100 ppm of skew settles 400 frames off target
+constexpr double kMaxDriftPpm = 1000.0;
+
+int16_t GainToQ15(float gain) {
+    if (!(gain > 0.0f)) {
+        return 0;
+    }
+    if (gain >= 0.99999f) {
+        return kUnityGainQ15;
+    }
+    return static_cast<int16_t>(std::lround(gain * 32768.0f));
+}
+}  // namespace
+
+void AudioMixer::configure(int32_t sampleRate, int32_t channels, size_t blockFrames, BlockSink sink) {
+    for (auto& source : sources_) {
+        std::lock_guard<std::mutex> lock(source.producerMutex);
+        source.active.store(false);
+    }
+    sampleRate_ = std::max(sampleRate, 1);
+    channels_ = std::max(channels, 1);
+    blockFrames_ = std::max<size_t>(blockFrames, 1);
+    frameBytes_ = static_cast<size_t>(channels_) * sizeof(int16_t);
+    sink_ = std::move(sink);
+    const size_t blockSamples = blockFrames_ * static_cast<size_t>(channels_);
+    masterBlock_.assign(blockSamples, 0);
+    mixBlock_.assign(blockSamples, 0);
+    sourceBlock_.assign(blockSamples, 0);
+    masterGain_.store(1.0f);
+    reset();
+}
+
+void AudioMixer::reset() {
+    masterFill_ = 0;
+    blockMarker_ = CaptureMarker{};
+    for (auto& source : sources_) {
+        std::lock_guard<std::mutex> lock(source.producerMutex);
+        source.ring.clear();
+        source.converter.reset();
+        source.primed = false;
+        source.filteredFill = 0.0;
+        source.driftPpm.store(0.0);
+    }
+}
+
+AudioMixer::Source* AudioMixer::sourceFor(int32_t sourceId) {
+    if (sourceId <= 0 || static_cast<size_t>(sourceId) > kMaxSources) {
+        return nullptr;
+    }
+    return &sources_[static_cast<size_t>(sourceId - 1)];
+}
+
+int32_t AudioMixer::addSource(const PcmFormat& format, MixerSourceKind kind) {
+    if (masterBlock_.empty()) {
+        return -1;
+    }
+    for (size_t i = 0; i < kMaxSources; ++i) {
+        Source& source = sources_[i];
+        std::lock_guard<std::mutex> lock(source.producerMutex);
+        if (source.active.load()) {
+            continue;
+        }
+        source.kind = kind;
+        source.maxPushFrames = kMaxPushFrames;
+        if (!source.converter.configure(format, sampleRate_, channels_, kMaxPushFrames,
+                                        kind == MixerSourceKind::kStream)) {
+            return -1;
+        }
+        source.ring.allocate(blockFrames_ * frameBytes_ * kRingBlocks);
+        source.gain.store(1.0f);
+        source.driftPpm.store(0.0);
+        source.overruns.store(0);
+        source.underruns.store(0);
+        source.primed = false;
+        source.filteredFill = 0.0;
+        source.active.store(true);
+        return static_cast<int32_t>(i + 1);
+    }
+    return -1;
+}
+
+void AudioMixer::removeSource(int32_t sourceId) {
+    Source* source = sourceFor(sourceId);
+    if (!source) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(source->producerMutex);
+    source->active.store(false);
+    // The mixer raises |mixing| before it checks |active|; once it drops, the slot is ours.
+    while (source->mixing.load()) {
+        std::this_thread::yield();
+    }
+}
+
+void AudioMixer::setGain(int32_t sourceId, float gain) {
+    gain = std::min(std::max(gain, 0.0f), 1.0f);
+    if (sourceId == kMasterSourceId) {
+        masterGain_.store(gain);
+        return;
+    }
+    if (Source* source = sourceFor(sourceId)) {
+        source->gain.store(gain);
+    }
+}
+
+AudioMixer::SourceStats AudioMixer::sourceStats(int32_t sourceId) {
+    SourceStats stats;
+    Source* source = sourceFor(sourceId);
+    if (!source || !source->active.load()) {
+        return stats;
+    }
+    stats.overruns = source->overruns.load(std::memory_order_relaxed);
+    stats.underruns = source->underruns.load(std::memory_order_relaxed);
+    stats.driftPpm = source->driftPpm.load(std::memory_order_relaxed);
+    stats.bufferedFrames = static_cast<uint32_t>(source->ring.readable() / frameBytes_);
+    return stats;
+}
+
+bool AudioMixer::pushSource(int32_t sourceId, const uint8_t* data, size_t size) {
+    Source* source = sourceFor(sourceId);
+    if (!source || data == nullptr || size == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(source->producerMutex);
+    if (!source->active.load()) {
+        return false;
+    }
+    const size_t inputFrameBytes = static_cast<size_t>(source->converter.inputFormat().channels) * sizeof(int16_t);
+    size_t frames = size / inputFrameBytes;
+    if (source->kind == MixerSourceKind::kStream) {
+        source->converter.setDriftPpm(source->driftPpm.load(std::memory_order_relaxed));
+    }
+    bool accepted = true;
+    while (frames > 0) {
+        const size_t slice = std::min(frames, source->maxPushFrames);
+        const int16_t* out = nullptr;
+        const size_t produced = source->converter.process(data, slice, &out);
+        if (produced > 0 &&
+            !source->ring.write(reinterpret_cast<const uint8_t*>(out), produced * frameBytes_)) {
+            source->overruns.fetch_add(1, std::memory_order_relaxed);
+            accepted = false;
+        }
+        data += slice * inputFrameBytes;
+        frames -= slice;
+    }
+    return accepted;
+}
+
+void AudioMixer::pushMaster(const int16_t* pcm, size_t frames, const CaptureMarker& marker) {
+    if (!sink_ || masterBlock_.empty() || pcm == nullptr) {
+        return;
+    }
+    const auto channels = static_cast<size_t>(channels_);
+    size_t offset = 0;
+    while (offset < frames) {
+        if (masterFill_ == 0) {
+            blockMarker_.frameIndex = marker.frameIndex + static_cast<int64_t>(offset);
+            blockMarker_.timeUs = marker.timeUs < 0
+                    ? -1
+                    : marker.timeUs + static_cast<int64_t>(offset) * 1000000LL / sampleRate_;
+        }
+        const size_t count = std::min(frames - offset, blockFrames_ - masterFill_);
+        std::memcpy(masterBlock_.data() + masterFill_ * channels,
+                    pcm + offset * channels,
+                    count * frameBytes_);
+        masterFill_ += count;
+        offset += count;
+        if (masterFill_ == blockFrames_) {
+            mixBlock();
+            masterFill_ = 0;
+        }
+    }
+}
+
+void AudioMixer::mixBlock() {
+    const size_t samples = blockFrames_ * static_cast<size_t>(channels_);
+    std::fill(mixBlock_.begin(), mixBlock_.end(), 0);
+    MixInt16Saturating(mixBlock_.data(), masterBlock_.data(), samples, GainToQ15(masterGain_.load()));
+    for (auto& source : sources_) {
+        source.mixing.store(true);
+        if (source.active.load()) {
+            pullSource(source);
+        }
+        source.mixing.store(false);
+    }
+    sink_(mixBlock_.data(), blockFrames_, blockMarker_);
+}
+
+void AudioMixer::pullSource(Source& source) {
+    const size_t fillFrames = source.ring.readable() / frameBytes_;
+    if (source.kind == MixerSourceKind::kStream) {
+        const double target = static_cast<double>(kTargetBlocks * blockFrames_);
+        if (!source.primed) {
+            if (static_cast<double>(fillFrames) < target) {
+                return;
+            }
+            source.primed = true;
+            source.filteredFill = static_cast<double>(fillFrames);
+        }
+        source.filteredFill += kFillSmoothing * (static_cast<double>(fillFrames) - source.filteredFill);
+        const double ppm = (source.filteredFill - target) * kDriftPpmPerFrame;
+        source.driftPpm.store(std::min(std::max(ppm, -kMaxDriftPpm), kMaxDriftPpm), std::memory_order_relaxed);
+    }
+
+    const size_t frames = std::min(fillFrames, blockFrames_);
+    if (frames < blockFrames_ && source.kind == MixerSourceKind::kStream) {
+        // Ran dry: play what is left and wait for the ring to refill before mixing again.
+        source.underruns.fetch_add(1, std::memory_order_relaxed);
+        source.primed = false;
+    }
+    if (frames == 0) {
+        return;
+    }
+    source.ring.read(reinterpret_cast<uint8_t*>(sourceBlock_.data()), frames * frameBytes_);
+    MixInt16Saturating(mixBlock_.data(),
+                       sourceBlock_.data(),
+                       frames * static_cast<size_t>(channels_),
+                       GainToQ15(source.gain.load(std::memory_order_relaxed)));
+}
+
+}  // namespace astra
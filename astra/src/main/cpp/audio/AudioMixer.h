@@ -0,0 +1,98 @@
+#ifndef ASTRASTREAM_AUDIOMIXER_H
+#define ASTRASTREAM_AUDIOMIXER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "AudioFormatConverter.h"
+#include "PcmRingBuffer.h"
+
+namespace astra {
+
+enum class MixerSourceKind : uint8_t {
+    kStream = 0,  // continuous feed on its own clock (playback capture); drift-compensated
+    kClip = 1,    // bursts pushed on demand (sound effects); plays out whatever is queued
+};
+
+// Mixes the microphone with app-provided PCM sources into fixed-size blocks in the encoder
+// format. The microphone is the clock master: every block it completes pulls exactly one block
+// from each source ring, and stream sources are resampled a few hundred ppm faster or slower
+// to keep their ring near a target fill instead of slowly over- or under-running.
+class AudioMixer {
+public:
+    static constexpr int32_t kMasterSourceId = 0;
+    static constexpr size_t kMaxSources = 4;
+
+    struct SourceStats {
+        uint64_t overruns = 0;   // pushes dropped because the source ring was full
+        uint64_t underruns = 0;  // blocks a stream source could not fill
+        double driftPpm = 0.0;   // current ratio trim applied to the source
+        uint32_t bufferedFrames = 0;
+    };
+
+    using BlockSink = std::function<void(const int16_t* pcm, size_t frames, const CaptureMarker& marker)>;
+
+    // Not realtime-safe; call while capture is stopped.
+    void configure(int32_t sampleRate, int32_t channels, size_t blockFrames, BlockSink sink);
+    void reset();
+
+    // Control thread. Returns a source id (> 0), or -1 when every slot is taken.
+    int32_t addSource(const PcmFormat& format, MixerSourceKind kind);
+    void removeSource(int32_t sourceId);
+    // Gain in [0, 1]; kMasterSourceId addresses the microphone.
+    void setGain(int32_t sourceId, float gain);
+
+    [[nodiscard]] SourceStats sourceStats(int32_t sourceId);
+
+    // Producer thread of |sourceId|: interleaved int16 in the format given to addSource().
+    bool pushSource(int32_t sourceId, const uint8_t* data, size_t size);
+
+    // Capture callback: encoder-format PCM from the microphone. Never blocks.
+    void pushMaster(const int16_t* pcm, size_t frames, const CaptureMarker& marker);
+
+private:
+    struct Source {
+        std::mutex producerMutex;  // producer and add/remove only; the mixer never takes it
+        std::atomic<bool> active{false};
+        std::atomic<bool> mixing{false};
+        std::atomic<float> gain{1.0f};
+        std::atomic<double> driftPpm{0.0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> underruns{0};
+        MixerSourceKind kind = MixerSourceKind::kStream;
+        size_t maxPushFrames = 0;
+        AudioFormatConverter converter;
+        PcmRingBuffer ring;
+        // Mixer thread only.
+        bool primed = false;
+        double filteredFill = 0.0;
+    };
+
+    void mixBlock();
+    void pullSource(Source& source);
+    Source* sourceFor(int32_t sourceId);
+
+    int32_t sampleRate_ = 44100;
+    int32_t channels_ = 1;
+    size_t blockFrames_ = 1024;
+    size_t frameBytes_ = 2;
+    BlockSink sink_;
+    std::atomic<float> masterGain_{1.0f};
+    std::array<Source, kMaxSources> sources_;
+
+    // Mixer (capture callback) state.
+    std::vector<int16_t> masterBlock_;
+    std::vector<int16_t> mixBlock_;
+    std::vector<int16_t> sourceBlock_;
+    size_t masterFill_ = 0;
+    CaptureMarker blockMarker_{};
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_AUDIOMIXER_H
@@ -0,0 +1,93 @@
+#include "AudioTimestamper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace astra {
+
+namespace {
+// Errors beyond this mean capture restarted or the clock stepped; follow the hardware.
+constexpr double kResyncThresholdUs = 100000.0;
+constexpr double kErrorSmoothing = 0.02;
+constexpr double kOffsetGain = 0.05;
+// The offset may move by at most 0.05% of the audio time that elapsed.
+constexpr double kMaxSlewRatio = 0.0005;
+constexpr double kDriftGain = 0.5;
+constexpr double kMaxDriftPpm = 1000.0;
+}  // namespace
+
+void AudioTimestamper::reset(int32_t sampleRate) {
+    sampleRate_ = std::max(sampleRate, 1);
+    anchored_ = false;
+    driftPpm_ = 0.0;
+    lastPtsUs_ = -1;
+    anchor(0, 0.0);
+    anchored_ = false;
+}
+
+void AudioTimestamper::anchor(int64_t frameIndex, double timeUs) {
+    anchored_ = true;
+    anchorIndex_ = frameIndex;
+    anchorTimeUs_ = timeUs;
+    offsetUs_ = 0.0;
+    filteredErrorUs_ = 0.0;
+    lastIndex_ = frameIndex;
+    driftWindowIndex_ = frameIndex;
+    driftWindowErrorUs_ = 0.0;
+}
+
+double AudioTimestamper::nominalUs(int64_t frameIndex) const {
+    const double elapsedUs = static_cast<double>(frameIndex - anchorIndex_) * 1e6 /
+            static_cast<double>(sampleRate_);
+    return anchorTimeUs_ + elapsedUs * (1.0 + driftPpm_ * 1e-6) + offsetUs_;
+}
+
+int64_t AudioTimestamper::ptsForFrame(int64_t frameIndex, int64_t observedUs) {
+    if (!anchored_) {
+        anchor(frameIndex, observedUs >= 0 ? static_cast<double>(observedUs) : 0.0);
+    }
+
+    if (observedUs >= 0) {
+        const double errorUs = static_cast<double>(observedUs) - nominalUs(frameIndex);
+        if (std::fabs(errorUs) > kResyncThresholdUs) {
+            anchor(frameIndex, static_cast<double>(observedUs));
+        } else {
+            filteredErrorUs_ += kErrorSmoothing * (errorUs - filteredErrorUs_);
+
+            const int64_t stepFrames = std::max<int64_t>(frameIndex - lastIndex_, 0);
+            const double stepUs = static_cast<double>(stepFrames) * 1e6 / static_cast<double>(sampleRate_);
+            const double maxSlew = stepUs * kMaxSlewRatio;
+            const double slew = std::clamp(filteredErrorUs_ * kOffsetGain, -maxSlew, maxSlew);
+            offsetUs_ += slew;
+            filteredErrorUs_ -= slew;
+
+            // Roughly once a second, turn the error that keeps building up into a rate
+            // correction. Re-basing at the current position keeps the timeline continuous.
+            const int64_t windowFrames = frameIndex - driftWindowIndex_;
+            if (windowFrames >= sampleRate_) {
+                const double windowUs = static_cast<double>(windowFrames) * 1e6 /
+                        static_cast<double>(sampleRate_);
+                const double residualUs = filteredErrorUs_ - driftWindowErrorUs_ + offsetUs_;
+                const double base = nominalUs(frameIndex);
+                driftPpm_ = std::clamp(driftPpm_ + kDriftGain * residualUs / windowUs * 1e6,
+                                       -kMaxDriftPpm,
+                                       kMaxDriftPpm);
+                anchorIndex_ = frameIndex;
+                anchorTimeUs_ = base;
+                offsetUs_ = 0.0;
+                driftWindowIndex_ = frameIndex;
+                driftWindowErrorUs_ = filteredErrorUs_;
+            }
+        }
+        lastIndex_ = frameIndex;
+    }
+
+    auto pts = static_cast<int64_t>(std::llround(nominalUs(frameIndex)));
+    if (lastPtsUs_ >= 0 && pts <= lastPtsUs_) {
+        pts = lastPtsUs_ + 1;
+    }
+    lastPtsUs_ = pts;
+    return pts;
+}
+
+}  // namespace astra
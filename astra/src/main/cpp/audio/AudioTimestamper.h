@@ -0,0 +1,39 @@
+#ifndef ASTRASTREAM_AUDIOTIMESTAMPER_H
+#define ASTRASTREAM_AUDIOTIMESTAMPER_H
+
+#include <cstdint>
+
+namespace astra {
+
+// Turns capture frame indices into presentation times on the monotonic clock. The sample
+// count drives the timeline; hardware capture times only steer it through a drift estimate
+// and a rate-limited offset so timestamps never jump unless capture really restarted.
+class AudioTimestamper {
+public:
+    void reset(int32_t sampleRate);
+
+    // |observedUs| is the hardware capture time of |frameIndex|, or negative when unknown.
+    int64_t ptsForFrame(int64_t frameIndex, int64_t observedUs);
+
+    [[nodiscard]] double driftPpm() const { return driftPpm_; }
+
+private:
+    void anchor(int64_t frameIndex, double timeUs);
+    double nominalUs(int64_t frameIndex) const;
+
+    int32_t sampleRate_ = 44100;
+    bool anchored_ = false;
+    int64_t anchorIndex_ = 0;
+    double anchorTimeUs_ = 0.0;
+    double offsetUs_ = 0.0;
+    double filteredErrorUs_ = 0.0;
+    double driftPpm_ = 0.0;
+    int64_t lastIndex_ = 0;
+    int64_t driftWindowIndex_ = 0;
+    double driftWindowErrorUs_ = 0.0;
+    int64_t lastPtsUs_ = -1;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_AUDIOTIMESTAMPER_H
@@ -0,0 +1,77 @@
+#include "LevelMeter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace astra {
+
+namespace {
+constexpr float kFullScale = 32768.0f;
+
+uint32_t FloatBits(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+}  // namespace
+
+void LevelMeter::configure(int32_t sampleRate, int32_t channels, int32_t windowMs) {
+    sampleRate_ = std::max(sampleRate, 1);
+    channels_ = std::min(std::max(channels, 1), kMaxChannels);
+    windowFrames_ = std::max<size_t>(
+            static_cast<size_t>(sampleRate_) * static_cast<size_t>(std::max(windowMs, 1)) / 1000, 1);
+    reset();
+}
+
+void LevelMeter::reset() {
+    windowFill_ = 0;
+    levels_.fill(ChannelLevels{});
+    totalClipped_.fill(0);
+    publish(0);
+}
+
+void LevelMeter::process(const int16_t* pcm, size_t frames, int64_t startTimeUs) {
+    if (pcm == nullptr) {
+        return;
+    }
+    const auto channels = static_cast<size_t>(channels_);
+    size_t offset = 0;
+    while (offset < frames) {
+        const size_t count = std::min(frames - offset, windowFrames_ - windowFill_);
+        AccumulateLevels(pcm + offset * channels, count, channels_, levels_.data());
+        windowFill_ += count;
+        offset += count;
+        if (windowFill_ == windowFrames_) {
+            const int64_t endTimeUs = startTimeUs < 0
+                    ? -1
+                    : startTimeUs + static_cast<int64_t>(offset) * 1000000LL / sampleRate_;
+            publish(endTimeUs);
+            windowFill_ = 0;
+            levels_.fill(ChannelLevels{});
+        }
+    }
+}
+
+void LevelMeter::publish(int64_t endTimeUs) {
+    const uint32_t sequence = snapshot_.sequence.load(std::memory_order_relaxed);
+    snapshot_.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const float windowFrames = static_cast<float>(std::max<size_t>(windowFill_, 1));
+    snapshot_.channels.store(channels_, std::memory_order_relaxed);
+    snapshot_.timeUs.store(endTimeUs, std::memory_order_relaxed);
+    for (int32_t c = 0; c < channels_; ++c) {
+        const ChannelLevels& level = levels_[static_cast<size_t>(c)];
+        totalClipped_[static_cast<size_t>(c)] += level.clipped;
+        const float rms = std::sqrt(static_cast<float>(level.sumSquares) / windowFrames) / kFullScale;
+        ChannelSlot& slot = snapshot_.slots[static_cast<size_t>(c)];
+        slot.peakBits.store(FloatBits(static_cast<float>(level.peak) / kFullScale), std::memory_order_relaxed);
+        slot.rmsBits.store(FloatBits(std::min(rms, 1.0f)), std::memory_order_relaxed);
+        slot.clipped.store(totalClipped_[static_cast<size_t>(c)], std::memory_order_relaxed);
+    }
+
+    snapshot_.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace astra
@@ -0,0 +1,74 @@
+#ifndef ASTRASTREAM_LEVELMETER_H
+#define ASTRASTREAM_LEVELMETER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "PcmKernels.h"
+
+namespace astra {
+
+// Per-channel peak, RMS and clip meter run inside the capture callback. Every window it
+// publishes a snapshot into a fixed block of native memory that Java maps once as a direct
+// ByteBuffer and polls under a sequence check, so metering adds no JNI calls to the audio
+// thread and no locks to either side.
+//
+// Snapshot layout, native byte order:
+//   0   uint32  sequence, odd while a snapshot is being written
+//   4   int32   channel count
+//   8   int64   CLOCK_MONOTONIC capture time of the window end, in us
+//   16  per channel, 16 bytes each, up to kMaxChannels:
+//         float peak (linear, 0..1), float rms (linear, 0..1),
+//         uint32 clipped samples since start, uint32 reserved
+class LevelMeter {
+public:
+    static constexpr int32_t kMaxChannels = 8;
+    static constexpr size_t kHeaderBytes = 16;
+    static constexpr size_t kChannelBytes = 16;
+    static constexpr size_t kSnapshotBytes = kHeaderBytes + kChannelBytes * kMaxChannels;
+
+    LevelMeter() = default;
+    LevelMeter(const LevelMeter&) = delete;
+    LevelMeter& operator=(const LevelMeter&) = delete;
+
+    // Not realtime-safe; call while capture is stopped. Also clears the published snapshot.
+    void configure(int32_t sampleRate, int32_t channels, int32_t windowMs = 50);
+    void reset();
+
+    // Capture callback: interleaved encoder-format PCM whose first frame was captured at
+    // |startTimeUs| (-1 when unknown).
+    void process(const int16_t* pcm, size_t frames, int64_t startTimeUs);
+
+    [[nodiscard]] void* snapshot() { return &snapshot_; }
+
+private:
+    struct ChannelSlot {
+        std::atomic<uint32_t> peakBits{0};
+        std::atomic<uint32_t> rmsBits{0};
+        std::atomic<uint32_t> clipped{0};
+        std::atomic<uint32_t> reserved{0};
+    };
+    struct Snapshot {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<int32_t> channels{0};
+        std::atomic<int64_t> timeUs{0};
+        std::array<ChannelSlot, kMaxChannels> slots;
+    };
+    static_assert(sizeof(Snapshot) == kSnapshotBytes, "snapshot layout is shared with Java");
+
+    void publish(int64_t endTimeUs);
+
+    int32_t sampleRate_ = 48000;
+    int32_t channels_ = 1;
+    size_t windowFrames_ = 2400;
+    size_t windowFill_ = 0;
+    std::array<ChannelLevels, kMaxChannels> levels_{};
+    std::array<uint32_t, kMaxChannels> totalClipped_{};
+    alignas(16) Snapshot snapshot_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_LEVELMETER_H
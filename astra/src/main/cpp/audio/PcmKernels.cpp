@@ -0,0 +1,487 @@
+#include "PcmKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ASTRA_PCM_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ASTRA_PCM_SSE2 1
+#endif
+
+namespace astra {
+
+namespace {
+constexpr float kInt16Scale = 32768.0f;
+constexpr float kInt16InvScale = 1.0f / 32768.0f;
+constexpr float kDitherScale = 1.0f / 65536.0f;
+
+inline uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13U;
+    state ^= state >> 17U;
+    state ^= state << 5U;
+    return state;
+}
+
+// Difference of two 16-bit uniforms: triangular PDF spanning +/-1 LSB.
+inline float TpdfFromBits(uint32_t bits) {
+    return (static_cast<float>(bits >> 16U) - static_cast<float>(bits & 0xFFFFU)) * kDitherScale;
+}
+
+inline int16_t QuantizeSample(float sample, float dither) {
+    float value = sample * kInt16Scale + dither;
+    value = std::min(std::max(value, -32768.0f), 32767.0f);
+    return static_cast<int16_t>(std::lrintf(value));
+}
+
+inline int16_t SaturateInt16(int32_t value) {
+    return static_cast<int16_t>(std::min(std::max(value, -32768), 32767));
+}
+
+#if ASTRA_PCM_NEON
+inline float HorizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    const float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+inline int32x4_t RoundToInt(float32x4_t v) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(v);
+#else
+    // ARMv7 only truncates; bias away from zero first.
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000U));
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+    return vcvtq_s32_f32(vaddq_f32(v, half));
+#endif
+}
+#endif
+
+#if ASTRA_PCM_SSE2
+inline float HorizontalSum(__m128 v) {
+    const __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m128 sums = _mm_add_ps(v, shuffled);
+    return _mm_cvtss_f32(_mm_add_ss(sums, _mm_movehl_ps(shuffled, sums)));
+}
+#endif
+}  // namespace
+
+void DitherState::seed(uint32_t value) {
+    for (uint32_t i = 0; i < 4; ++i) {
+        uint32_t state = value ^ (0x9E3779B9u * (i + 1));
+        lanes[i] = state != 0 ? state : 0x6D2B79F5u;
+    }
+}
+
+namespace scalar {
+
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither) {
+    for (size_t i = 0; i < count; ++i) {
+        const float noise = TpdfFromBits(NextRandom(dither.lanes[i & 3U]));
+        out[i] = QuantizeSample(in[i], noise);
+    }
+}
+
+void Int16ToFloat(const int16_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * kInt16InvScale;
+    }
+}
+
+void DownmixStereoToMono(const float* in, float* out, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        out[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+    }
+}
+
+void UpmixMonoToStereo(const float* in, float* out, size_t frames) {
+    // Walk backwards so |out| may alias |in|.
+    for (size_t i = frames; i-- > 0;) {
+        const float sample = in[i];
+        out[2 * i] = sample;
+        out[2 * i + 1] = sample;
+    }
+}
+
+float DotProduct(const float* a, const float* b, size_t count) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15) {
+    for (size_t i = 0; i < count; ++i) {
+        int32_t sample = src[i];
+        if (gainQ15 != kUnityGainQ15) {
+            sample = std::min((sample * gainQ15 + 0x4000) >> 15, 32767);
+        }
+        dst[i] = SaturateInt16(static_cast<int32_t>(dst[i]) + sample);
+    }
+}
+
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels) {
+    const auto stride = static_cast<size_t>(channels);
+    for (size_t c = 0; c < stride; ++c) {
+        ChannelLevels& level = levels[c];
+        for (size_t i = 0; i < frames; ++i) {
+            const int32_t sample = pcm[i * stride + c];
+            const int32_t magnitude = std::min(std::abs(sample), 32767);
+            level.peak = std::max(level.peak, magnitude);
+            level.sumSquares += static_cast<uint64_t>(static_cast<int64_t>(sample) * sample);
+            level.clipped += magnitude == 32767 ? 1U : 0U;
+        }
+    }
+}
+
+}  // namespace scalar
+
+#if ASTRA_PCM_NEON
+
+const char* PcmKernelIsa() { return "neon"; }
+
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither) {
+    uint32x4_t state = vld1q_u32(dither.lanes);
+    const float32x4_t scale = vdupq_n_f32(kInt16Scale);
+    const float32x4_t ditherScale = vdupq_n_f32(kDitherScale);
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    const uint32x4_t lowMask = vdupq_n_u32(0xFFFFU);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        state = veorq_u32(state, vshlq_n_u32(state, 13));
+        state = veorq_u32(state, vshrq_n_u32(state, 17));
+        state = veorq_u32(state, vshlq_n_u32(state, 5));
+        const float32x4_t noise = vmulq_f32(
+                vsubq_f32(vcvtq_f32_u32(vshrq_n_u32(state, 16)), vcvtq_f32_u32(vandq_u32(state, lowMask))),
+                ditherScale);
+        float32x4_t value = vmlaq_f32(noise, vld1q_f32(in + i), scale);
+        value = vminq_f32(vmaxq_f32(value, lo), hi);
+        vst1_s16(out + i, vqmovn_s32(RoundToInt(value)));
+    }
+    vst1q_u32(dither.lanes, state);
+    scalar::FloatToInt16Dithered(in + i, out + i, count - i, dither);
+}
+
+void Int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const float32x4_t scale = vdupq_n_f32(kInt16InvScale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+    }
+    scalar::Int16ToFloat(in + i, out + i, count - i);
+}
+
+void DownmixStereoToMono(const float* in, float* out, size_t frames) {
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + 2 * i);
+        vst1q_f32(out + i, vmulq_f32(vaddq_f32(lr.val[0], lr.val[1]), half));
+    }
+    scalar::DownmixStereoToMono(in + 2 * i, out + i, frames - i);
+}
+
+void UpmixMonoToStereo(const float* in, float* out, size_t frames) {
+    if (out < in + frames && in < out + 2 * frames) {
+        scalar::UpmixMonoToStereo(in, out, frames);
+        return;
+    }
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t mono = vld1q_f32(in + i);
+        vst2q_f32(out + 2 * i, float32x4x2_t{{mono, mono}});
+    }
+    scalar::UpmixMonoToStereo(in + i, out + 2 * i, frames - i);
+}
+
+float DotProduct(const float* a, const float* b, size_t count) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return HorizontalSum(vaddq_f32(acc0, acc1)) + scalar::DotProduct(a + i, b + i, count - i);
+}
+
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15) {
+    const int16x8_t gain = vdupq_n_s16(gainQ15);
+    const bool unity = gainQ15 == kUnityGainQ15;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t samples = vld1q_s16(src + i);
+        if (!unity) {
+            // Saturating rounding doubling multiply-high: round(src * gain / 2^15).
+            samples = vqrdmulhq_s16(samples, gain);
+        }
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), samples));
+    }
+    scalar::MixInt16Saturating(dst + i, src + i, count - i, gainQ15);
+}
+
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels) {
+    if (channels != 1 && channels != 2) {
+        scalar::AccumulateLevels(pcm, frames, channels, levels);
+        return;
+    }
+    // One vector per channel; stereo is split with vld2.
+    const auto stride = static_cast<size_t>(channels);
+    const int16x8_t fullScale = vdupq_n_s16(32767);
+    int16x8_t peak[2] = {vdupq_n_s16(0), vdupq_n_s16(0)};
+    uint64x2_t squares[2] = {vdupq_n_u64(0), vdupq_n_u64(0)};
+    uint32x4_t clipped[2] = {vdupq_n_u32(0), vdupq_n_u32(0)};
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8_t samples[2];
+        if (stride == 2) {
+            const int16x8x2_t lr = vld2q_s16(pcm + i * 2);
+            samples[0] = lr.val[0];
+            samples[1] = lr.val[1];
+        } else {
+            samples[0] = vld1q_s16(pcm + i);
+        }
+        for (size_t c = 0; c < stride; ++c) {
+            const int16x8_t magnitude = vqabsq_s16(samples[c]);
+            peak[c] = vmaxq_s16(peak[c], magnitude);
+            // Squares of int16 fit in uint32; widen pairwise into the 64-bit sums.
+            const int32x4_t low = vmull_s16(vget_low_s16(samples[c]), vget_low_s16(samples[c]));
+            const int32x4_t high = vmull_s16(vget_high_s16(samples[c]), vget_high_s16(samples[c]));
+            squares[c] = vpadalq_u32(squares[c], vreinterpretq_u32_s32(low));
+            squares[c] = vpadalq_u32(squares[c], vreinterpretq_u32_s32(high));
+            clipped[c] = vpadalq_u16(clipped[c], vshrq_n_u16(vceqq_s16(magnitude, fullScale), 15));
+        }
+    }
+    for (size_t c = 0; c < stride; ++c) {
+        int16_t lanes[8];
+        vst1q_s16(lanes, peak[c]);
+        for (int16_t lane : lanes) {
+            levels[c].peak = std::max<int32_t>(levels[c].peak, lane);
+        }
+        levels[c].sumSquares += vgetq_lane_u64(squares[c], 0) + vgetq_lane_u64(squares[c], 1);
+        levels[c].clipped += vgetq_lane_u32(clipped[c], 0) + vgetq_lane_u32(clipped[c], 1) +
+                vgetq_lane_u32(clipped[c], 2) + vgetq_lane_u32(clipped[c], 3);
+    }
+    scalar::AccumulateLevels(pcm + i * stride, frames - i, channels, levels);
+}
+
+#elif ASTRA_PCM_SSE2
+
+const char* PcmKernelIsa() { return "sse2"; }
+
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither) {
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither.lanes));
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    const __m128 ditherScale = _mm_set1_ps(kDitherScale);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+        // Both halves fit in 16 bits, so the signed int32 -> float conversion is exact.
+        const __m128 noise = _mm_mul_ps(
+                _mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(state, 16)),
+                           _mm_cvtepi32_ps(_mm_and_si128(state, lowMask))),
+                ditherScale);
+        __m128 value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), noise);
+        value = _mm_min_ps(_mm_max_ps(value, lo), hi);
+        const __m128i rounded = _mm_cvtps_epi32(value);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(rounded, rounded));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither.lanes), state);
+    scalar::FloatToInt16Dithered(in + i, out + i, count - i, dither);
+}
+
+void Int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(kInt16InvScale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    scalar::Int16ToFloat(in + i, out + i, count - i);
+}
+
+void DownmixStereoToMono(const float* in, float* out, size_t frames) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+    scalar::DownmixStereoToMono(in + 2 * i, out + i, frames - i);
+}
+
+void UpmixMonoToStereo(const float* in, float* out, size_t frames) {
+    if (out < in + frames && in < out + 2 * frames) {
+        scalar::UpmixMonoToStereo(in, out, frames);
+        return;
+    }
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 mono = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(mono, mono));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(mono, mono));
+    }
+    scalar::UpmixMonoToStereo(in + i, out + 2 * i, frames - i);
+}
+
+float DotProduct(const float* a, const float* b, size_t count) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    return HorizontalSum(_mm_add_ps(acc0, acc1)) + scalar::DotProduct(a + i, b + i, count - i);
+}
+
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15) {
+    const __m128i gain = _mm_set1_epi16(gainQ15);
+    const __m128i rounding = _mm_set1_epi32(0x4000);
+    const bool unity = gainQ15 == kUnityGainQ15;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (!unity) {
+            // SSE2 has no rounding multiply-high; rebuild the 32-bit products and narrow.
+            const __m128i low = _mm_mullo_epi16(samples, gain);
+            const __m128i high = _mm_mulhi_epi16(samples, gain);
+            const __m128i products0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(low, high), rounding), 15);
+            const __m128i products1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(low, high), rounding), 15);
+            samples = _mm_packs_epi32(products0, products1);
+        }
+        const __m128i mixed = _mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)), samples);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), mixed);
+    }
+    scalar::MixInt16Saturating(dst + i, src + i, count - i, gainQ15);
+}
+
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels) {
+    if (channels != 1 && channels != 2) {
+        scalar::AccumulateLevels(pcm, frames, channels, levels);
+        return;
+    }
+    // Stereo is regrouped to L0..L3 R0..R3 so each 64-bit half belongs to one channel; for
+    // mono both halves feed the same channel.
+    const bool stereo = channels == 2;
+    const auto stride = static_cast<size_t>(channels);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fullScale = _mm_set1_epi16(32767);
+    __m128i peak = zero;
+    __m128i squaresLow = zero;
+    __m128i squaresHigh = zero;
+    __m128i clipped = zero;  // 16-bit lane counters, flushed before they can wrap
+    uint32_t clipLow = 0;
+    uint32_t clipHigh = 0;
+    size_t pending = 0;
+    auto flushClips = [&] {
+        alignas(16) uint16_t counts[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(counts), clipped);
+        for (int lane = 0; lane < 4; ++lane) {
+            clipLow += counts[lane];
+            clipHigh += counts[lane + 4];
+        }
+        clipped = zero;
+        pending = 0;
+    };
+    const size_t framesPerVector = 8 / stride;
+    size_t i = 0;
+    for (; i + framesPerVector <= frames; i += framesPerVector) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pcm + i * stride));
+        if (stereo) {
+            samples = _mm_shufflelo_epi16(samples, _MM_SHUFFLE(3, 1, 2, 0));
+            samples = _mm_shufflehi_epi16(samples, _MM_SHUFFLE(3, 1, 2, 0));
+            samples = _mm_shuffle_epi32(samples, _MM_SHUFFLE(3, 1, 2, 0));
+        }
+        const __m128i magnitude = _mm_max_epi16(samples, _mm_subs_epi16(zero, samples));
+        peak = _mm_max_epi16(peak, magnitude);
+        // A pair of squares reaches 2^31 at most, so the madd lanes are read as unsigned.
+        const __m128i pairs = _mm_madd_epi16(samples, samples);
+        squaresLow = _mm_add_epi64(squaresLow, _mm_unpacklo_epi32(pairs, zero));
+        squaresHigh = _mm_add_epi64(squaresHigh, _mm_unpackhi_epi32(pairs, zero));
+        clipped = _mm_sub_epi16(clipped, _mm_cmpeq_epi16(magnitude, fullScale));
+        if (++pending == 0xFFFF) {
+            flushClips();
+        }
+    }
+    flushClips();
+
+    alignas(16) int16_t peaks[8];
+    alignas(16) uint64_t low[2];
+    alignas(16) uint64_t high[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(peaks), peak);
+    _mm_store_si128(reinterpret_cast<__m128i*>(low), squaresLow);
+    _mm_store_si128(reinterpret_cast<__m128i*>(high), squaresHigh);
+    int32_t peakLow = 0;
+    int32_t peakHigh = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        peakLow = std::max<int32_t>(peakLow, peaks[lane]);
+        peakHigh = std::max<int32_t>(peakHigh, peaks[lane + 4]);
+    }
+    ChannelLevels& first = levels[0];
+    ChannelLevels& second = levels[stereo ? 1 : 0];
+    first.peak = std::max(first.peak, peakLow);
+    second.peak = std::max(second.peak, peakHigh);
+    first.sumSquares += low[0] + low[1];
+    second.sumSquares += high[0] + high[1];
+    first.clipped += clipLow;
+    second.clipped += clipHigh;
+    scalar::AccumulateLevels(pcm + i * stride, frames - i, channels, levels);
+}
+
+#else
+
+const char* PcmKernelIsa() { return "scalar"; }
+
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither) {
+    scalar::FloatToInt16Dithered(in, out, count, dither);
+}
+
+void Int16ToFloat(const int16_t* in, float* out, size_t count) {
+    scalar::Int16ToFloat(in, out, count);
+}
+
+void DownmixStereoToMono(const float* in, float* out, size_t frames) {
+    scalar::DownmixStereoToMono(in, out, frames);
+}
+
+void UpmixMonoToStereo(const float* in, float* out, size_t frames) {
+    scalar::UpmixMonoToStereo(in, out, frames);
+}
+
+float DotProduct(const float* a, const float* b, size_t count) {
+    return scalar::DotProduct(a, b, count);
+}
+
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15) {
+    scalar::MixInt16Saturating(dst, src, count, gainQ15);
+}
+
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels) {
+    scalar::AccumulateLevels(pcm, frames, channels, levels);
+}
+
+#endif
+
+}  // namespace astra
@@ -0,0 +1,57 @@
+#ifndef ASTRASTREAM_PCMKERNELS_H
+#define ASTRASTREAM_PCMKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace astra {
+
+// Four independent xorshift32 generators, one per SIMD lane. Sample i always draws from
+// lane i % 4, so the vector and scalar kernels produce the same dither sequence.
+struct DitherState {
+    uint32_t lanes[4] = {0x9E3779B9u, 0x7F4A7C15u, 0x94D049BBu, 0xBF58476Du};
+
+    void seed(uint32_t value);
+};
+
+// Float [-1, 1) to int16 with TPDF dither of +/-1 LSB and saturation. |count| is in samples.
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither);
+void Int16ToFloat(const int16_t* in, float* out, size_t count);
+
+// Interleaved stereo to mono by averaging, and mono to interleaved stereo by duplication.
+void DownmixStereoToMono(const float* in, float* out, size_t frames);
+void UpmixMonoToStereo(const float* in, float* out, size_t frames);
+
+float DotProduct(const float* a, const float* b, size_t count);
+
+// dst = saturate(dst + round(src * gain)) with |gainQ15| in Q15; kUnityGainQ15 adds |src| as-is.
+constexpr int16_t kUnityGainQ15 = 32767;
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15);
+
+struct ChannelLevels {
+    int32_t peak = 0;         // largest |sample|
+    uint64_t sumSquares = 0;
+    uint32_t clipped = 0;     // samples at full scale
+};
+
+// Adds interleaved int16 |frames| into |levels[channel]|. Mono and stereo are vectorized;
+// wider layouts take the scalar path.
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels);
+
+// Name of the instruction set the kernels above were built for ("neon", "sse2", "scalar").
+const char* PcmKernelIsa();
+
+// Portable references for the kernels above; used as fallbacks and to check the vector code.
+namespace scalar {
+void FloatToInt16Dithered(const float* in, int16_t* out, size_t count, DitherState& dither);
+void Int16ToFloat(const int16_t* in, float* out, size_t count);
+void DownmixStereoToMono(const float* in, float* out, size_t frames);
+void UpmixMonoToStereo(const float* in, float* out, size_t frames);
+float DotProduct(const float* a, const float* b, size_t count);
+void MixInt16Saturating(int16_t* dst, const int16_t* src, size_t count, int16_t gainQ15);
+void AccumulateLevels(const int16_t* pcm, size_t frames, int32_t channels, ChannelLevels* levels);
+}  // namespace scalar
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_PCMKERNELS_H
@@ -0,0 +1,85 @@
+#include "PcmRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace astra {
+
+void PcmRingBuffer::allocate(size_t minCapacity) {
+    size_t capacity = 1;
+    while (capacity < minCapacity) {
+        capacity <<= 1U;
+    }
+    buffer_.assign(capacity, 0);
+    mask_ = capacity - 1;
+    clear();
+}
+
+void PcmRingBuffer::clear() {
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    markerHead_.store(0, std::memory_order_relaxed);
+    markerTail_.store(0, std::memory_order_relaxed);
+    currentMarker_ = MarkerSlot{};
+}
+
+bool PcmRingBuffer::write(const uint8_t* data, size_t size, const CaptureMarker& marker) {
+    if (buffer_.empty() || data == nullptr) {
+        return false;
+    }
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    if (buffer_.size() - (head - tail) < size) {
+        return false;
+    }
+    const size_t offset = head & mask_;
+    const size_t first = std::min(size, buffer_.size() - offset);
+    std::memcpy(buffer_.data() + offset, data, first);
+    std::memcpy(buffer_.data(), data + first, size - first);
+
+    // When the marker slots are full the consumer extrapolates from the previous one.
+    const size_t markerHead = markerHead_.load(std::memory_order_relaxed);
+    if (markerHead - markerTail_.load(std::memory_order_acquire) < kMarkerSlots) {
+        markers_[markerHead % kMarkerSlots] = MarkerSlot{head, marker};
+        markerHead_.store(markerHead + 1, std::memory_order_release);
+    }
+    head_.store(head + size, std::memory_order_release);
+    return true;
+}
+
+bool PcmRingBuffer::read(uint8_t* out, size_t size, CaptureMarker* marker, size_t* bytesSinceMarker) {
+    if (buffer_.empty() || out == nullptr) {
+        return false;
+    }
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    if (head - tail < size) {
+        return false;
+    }
+    size_t markerTail = markerTail_.load(std::memory_order_relaxed);
+    const size_t markerHead = markerHead_.load(std::memory_order_acquire);
+    while (markerTail != markerHead && markers_[markerTail % kMarkerSlots].position <= tail) {
+        currentMarker_ = markers_[markerTail % kMarkerSlots];
+        ++markerTail;
+    }
+    markerTail_.store(markerTail, std::memory_order_release);
+    if (marker) {
+        *marker = currentMarker_.marker;
+    }
+    if (bytesSinceMarker) {
+        *bytesSinceMarker = tail - currentMarker_.position;
+    }
+
+    const size_t offset = tail & mask_;
+    const size_t first = std::min(size, buffer_.size() - offset);
+    std::memcpy(out, buffer_.data() + offset, first);
+    std::memcpy(out + first, buffer_.data(), size - first);
+    tail_.store(tail + size, std::memory_order_release);
+    return true;
+}
+
+size_t PcmRingBuffer::readable() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+}
+
+}  // namespace astra
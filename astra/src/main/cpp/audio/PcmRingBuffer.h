@@ -0,0 +1,55 @@
+#ifndef ASTRASTREAM_PCMRINGBUFFER_H
+#define ASTRASTREAM_PCMRINGBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace astra {
+
+struct CaptureMarker {
+    int64_t frameIndex = 0;  // capture-side index of the first frame in a write
+    int64_t timeUs = -1;     // monotonic capture time of that frame, negative when unknown
+};
+
+// Single-producer/single-consumer byte ring. The producer side never blocks or allocates so
+// it can run on the AAudio realtime callback; the consumer is the encoder feeder thread.
+class PcmRingBuffer {
+public:
+    PcmRingBuffer() = default;
+
+    // Not thread-safe; call while neither side is running.
+    void allocate(size_t minCapacity);
+    void clear();
+
+    // Producer: writes all of |data| or nothing, tagging its first byte with |marker|.
+    bool write(const uint8_t* data, size_t size, const CaptureMarker& marker = {});
+    // Consumer: copies exactly |size| bytes into |out| or nothing. |marker| receives the
+    // latest marker at or before the first byte read and |bytesSinceMarker| its distance.
+    bool read(uint8_t* out, size_t size, CaptureMarker* marker = nullptr, size_t* bytesSinceMarker = nullptr);
+
+    [[nodiscard]] size_t readable() const;
+    [[nodiscard]] size_t capacity() const { return buffer_.size(); }
+
+private:
+    struct MarkerSlot {
+        size_t position = 0;
+        CaptureMarker marker;
+    };
+    static constexpr size_t kMarkerSlots = 64;
+
+    std::vector<uint8_t> buffer_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::array<MarkerSlot, kMarkerSlots> markers_{};
+    alignas(64) std::atomic<size_t> markerHead_{0};
+    alignas(64) std::atomic<size_t> markerTail_{0};
+    MarkerSlot currentMarker_{};
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_PCMRINGBUFFER_H
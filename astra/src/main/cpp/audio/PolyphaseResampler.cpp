@@ -0,0 +1,206 @@
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "PcmKernels.h"
+
+namespace astra {
+
+namespace {
+constexpr uint32_t kMinPhases = 64;
+constexpr uint32_t kMaxPhases = 1024;
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kKaiserBeta = 8.0;
+constexpr double kPassbandFraction = 0.91;
+constexpr size_t kLeadFrames = PolyphaseResampler::kTaps / 2 - 1;
+
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double quarterSquared = x * x * 0.25;
+    for (int k = 1; k < 32; ++k) {
+        term *= quarterSquared / (static_cast<double>(k) * k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+}  // namespace
+
+bool PolyphaseResampler::configure(int32_t inputRate,
+                                   int32_t outputRate,
+                                   int32_t channels,
+                                   size_t maxInputFrames,
+                                   bool driftAdjustable) {
+    if (inputRate <= 0 || outputRate <= 0 || channels <= 0 || maxInputFrames == 0) {
+        return false;
+    }
+    inputRate_ = inputRate;
+    outputRate_ = outputRate;
+    channels_ = channels;
+    passthrough_ = inputRate == outputRate && !driftAdjustable;
+
+    const int32_t divisor = std::gcd(inputRate, outputRate);
+    const auto interpolation = static_cast<uint32_t>(outputRate / divisor);
+    const auto decimation = static_cast<uint32_t>(inputRate / divisor);
+    if (interpolation <= kMaxPhases) {
+        // Oversample the bank for small factors so phases stay fine-grained.
+        const uint32_t multiple = (kMinPhases + interpolation - 1) / interpolation;
+        phases_ = interpolation * multiple;
+        nominalStep_ = static_cast<double>(decimation) * multiple;
+    } else {
+        // Awkward ratios: a fixed bank with a fractional step.
+        phases_ = kMaxPhases;
+        nominalStep_ = static_cast<double>(inputRate) * kMaxPhases / outputRate;
+    }
+    minStepPhases_ = static_cast<uint32_t>(nominalStep_ * (1.0 - kMaxDriftPpm * 1e-6));
+    applyStep(nominalStep_);
+
+    history_.assign(static_cast<size_t>(channels), std::vector<float>(kTaps + maxInputFrames + 2, 0.0f));
+    if (!passthrough_) {
+        buildFilterBank();
+    }
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset() {
+    for (auto& channel : history_) {
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    }
+    buffered_ = passthrough_ ? 0 : kLeadFrames;
+    start_ = 0;
+    phase_ = 0;
+    fraction_ = 0;
+    discardedFrames_ = passthrough_ ? 0 : -static_cast<int64_t>(kLeadFrames);
+}
+
+void PolyphaseResampler::applyStep(double stepPhases) {
+    const double whole = std::floor(stepPhases);
+    stepPhases_ = static_cast<uint32_t>(whole);
+    stepFraction_ = static_cast<uint32_t>((stepPhases - whole) * 4294967296.0);
+}
+
+void PolyphaseResampler::setDriftPpm(double ppm) {
+    if (passthrough_) {
+        return;
+    }
+    ppm = std::min(std::max(ppm, -kMaxDriftPpm), kMaxDriftPpm);
+    applyStep(nominalStep_ * (1.0 + ppm * 1e-6));
+}
+
+void PolyphaseResampler::buildFilterBank() {
+    const double ratio = std::min(1.0, static_cast<double>(outputRate_) / inputRate_);
+    const double cutoff = 0.5 * ratio * kPassbandFraction;  // cycles per input frame
+    const double halfWidth = static_cast<double>(kTaps) / 2.0;
+    const double windowNorm = BesselI0(kKaiserBeta);
+
+    // One extra row (a whole frame of delay) lets phase interpolation read row phase + 1
+    // without wrapping to the next input frame.
+    bank_.assign(static_cast<size_t>(phases_ + 1) * kTaps, 0.0f);
+    std::vector<double> taps(kTaps);
+    for (uint32_t phase = 0; phase <= phases_; ++phase) {
+        double sum = 0.0;
+        for (size_t m = 0; m < kTaps; ++m) {
+            // Distance from the output instant to input tap m, in input frames.
+            const double x = static_cast<double>(phase) / phases_ + static_cast<double>(kLeadFrames) -
+                    static_cast<double>(m);
+            const double arg = 2.0 * cutoff * x;
+            const double sinc = std::fabs(arg) < 1e-9 ? 1.0 : std::sin(kPi * arg) / (kPi * arg);
+            const double edge = x / halfWidth;
+            const double window = std::fabs(edge) >= 1.0
+                    ? 0.0
+                    : BesselI0(kKaiserBeta * std::sqrt(1.0 - edge * edge)) / windowNorm;
+            taps[m] = 2.0 * cutoff * sinc * window;
+            sum += taps[m];
+        }
+        // Unity DC gain per phase keeps the phases from modulating the signal level.
+        float* dst = bank_.data() + static_cast<size_t>(phase) * kTaps;
+        for (size_t m = 0; m < kTaps; ++m) {
+            dst[m] = static_cast<float>(sum != 0.0 ? taps[m] / sum : 0.0);
+        }
+    }
+}
+
+size_t PolyphaseResampler::maxOutputFrames(size_t inputFrames) const {
+    if (passthrough_) {
+        return inputFrames;
+    }
+    return (inputFrames + kTaps) * phases_ / std::max<uint32_t>(minStepPhases_, 1) + 2;
+}
+
+double PolyphaseResampler::nextOutputInputPosition() const {
+    return static_cast<double>(discardedFrames_ + static_cast<int64_t>(start_)) +
+            (static_cast<double>(phase_) + fraction_ / 4294967296.0) / phases_ +
+            (passthrough_ ? 0.0 : static_cast<double>(kLeadFrames));
+}
+
+size_t PolyphaseResampler::process(const float* in,
+                                   size_t inputFrames,
+                                   float* out,
+                                   size_t maxOutputFrames) {
+    if (history_.empty() || in == nullptr || out == nullptr) {
+        return 0;
+    }
+    const auto channels = static_cast<size_t>(channels_);
+    if (passthrough_) {
+        const size_t frames = std::min(inputFrames, maxOutputFrames);
+        std::memcpy(out, in, frames * channels * sizeof(float));
+        discardedFrames_ += static_cast<int64_t>(inputFrames);
+        return frames;
+    }
+
+    const size_t capacity = history_[0].size();
+    inputFrames = std::min(inputFrames, capacity - buffered_);
+    for (size_t c = 0; c < channels; ++c) {
+        float* dst = history_[c].data() + buffered_;
+        const float* src = in + c;
+        for (size_t i = 0; i < inputFrames; ++i) {
+            dst[i] = src[i * channels];
+        }
+    }
+    buffered_ += inputFrames;
+
+    size_t produced = 0;
+    while (start_ + kTaps <= buffered_ && produced < maxOutputFrames) {
+        const float* coefficients = bank_.data() + static_cast<size_t>(phase_) * kTaps;
+        float* frame = out + produced * channels;
+        if (fraction_ == 0 && stepFraction_ == 0) {
+            for (size_t c = 0; c < channels; ++c) {
+                frame[c] = DotProduct(history_[c].data() + start_, coefficients, kTaps);
+            }
+        } else {
+            const float weight = static_cast<float>(fraction_ / 4294967296.0);
+            for (size_t c = 0; c < channels; ++c) {
+                const float* window = history_[c].data() + start_;
+                const float a = DotProduct(window, coefficients, kTaps);
+                const float b = DotProduct(window, coefficients + kTaps, kTaps);
+                frame[c] = a + (b - a) * weight;
+            }
+        }
+        ++produced;
+        const uint64_t fraction = static_cast<uint64_t>(fraction_) + stepFraction_;
+        fraction_ = static_cast<uint32_t>(fraction);
+        phase_ += stepPhases_ + static_cast<uint32_t>(fraction >> 32U);
+        start_ += phase_ / phases_;
+        phase_ %= phases_;
+    }
+
+    const size_t consumed = std::min(start_, buffered_);
+    if (consumed > 0) {
+        for (auto& channel : history_) {
+            std::memmove(channel.data(), channel.data() + consumed, (buffered_ - consumed) * sizeof(float));
+        }
+        buffered_ -= consumed;
+        start_ -= consumed;
+        discardedFrames_ += static_cast<int64_t>(consumed);
+    }
+    return produced;
+}
+
+}  // namespace astra
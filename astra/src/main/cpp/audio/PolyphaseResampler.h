@@ -0,0 +1,68 @@
+#ifndef ASTRASTREAM_POLYPHASERESAMPLER_H
+#define ASTRASTREAM_POLYPHASERESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace astra {
+
+// Windowed-sinc polyphase resampler for interleaved float PCM. The filter bank is built
+// for the exact rational ratio (48000 -> 44100 is 147/160), so steady-state conversion
+// involves no per-sample trig or division; each output is one SIMD dot product per channel.
+// A drift trim moves the ratio off the exact value; outputs then interpolate between the two
+// neighbouring phases, which costs a second dot product.
+class PolyphaseResampler {
+public:
+    static constexpr size_t kTaps = 32;
+    static constexpr double kMaxDriftPpm = 5000.0;
+
+    // Not realtime-safe: builds the filter bank and sizes buffers for |maxInputFrames|.
+    // |driftAdjustable| keeps the filter in the path even when the rates match.
+    bool configure(int32_t inputRate,
+                   int32_t outputRate,
+                   int32_t channels,
+                   size_t maxInputFrames,
+                   bool driftAdjustable = false);
+    void reset();
+
+    // Realtime-safe. Positive values consume input faster (fewer outputs per input frame).
+    void setDriftPpm(double ppm);
+
+    // Consumes all |inputFrames| (at most the configured maximum) and writes up to
+    // |maxOutputFrames| interleaved frames to |out|. Returns the number of frames written.
+    size_t process(const float* in, size_t inputFrames, float* out, size_t maxOutputFrames);
+
+    // Upper bound on outputs produced by a single process() call of |inputFrames|.
+    [[nodiscard]] size_t maxOutputFrames(size_t inputFrames) const;
+    // Input frame index, counted from reset(), that the next output frame is centred on.
+    [[nodiscard]] double nextOutputInputPosition() const;
+    [[nodiscard]] bool passthrough() const { return passthrough_; }
+    [[nodiscard]] int32_t inputRate() const { return inputRate_; }
+    [[nodiscard]] int32_t outputRate() const { return outputRate_; }
+
+private:
+    void buildFilterBank();
+    void applyStep(double stepPhases);
+
+    int32_t inputRate_ = 0;
+    int32_t outputRate_ = 0;
+    int32_t channels_ = 1;
+    bool passthrough_ = true;
+    uint32_t phases_ = 1;      // filter bank size, a multiple of the interpolation factor
+    double nominalStep_ = 1.0;
+    uint32_t stepPhases_ = 1;  // input advance per output, in 1/phases_ of a frame
+    uint32_t stepFraction_ = 0;  // and its remainder in 1/2^32 of a phase
+    uint32_t fraction_ = 0;
+    uint32_t minStepPhases_ = 1;
+    std::vector<float> bank_;  // (phases_ + 1) x kTaps, taps ordered oldest input first
+    std::vector<std::vector<float>> history_;  // per-channel planar input window
+    size_t buffered_ = 0;      // frames in each history_ channel
+    size_t start_ = 0;         // first history frame under the filter for the next output
+    uint32_t phase_ = 0;
+    int64_t discardedFrames_ = 0;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_POLYPHASERESAMPLER_H
@@ -2,9 +2,13 @@
 
 #include <android/log.h>
 
+#include <time.h>
+
+#include <algorithm>
 #include <cstring>
 
 #include "../codec/NativeStreamEngine.h"
+#include "../stream/MediaClock.h"
 
 namespace {
 constexpr const char* kTag = "NativeAudioCapturer";
@@ -45,16 +49,11 @@ bool NativeAudioCapturer::configureStreamLocked(int32_t sampleRate,
     AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_INPUT);
     AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
     AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_SHARED);
-    AAudioStreamBuilder_setSampleRate(builder, sampleRate);
+    // Leave the rate to the device so input stays on the native fast path; the converter
+    // resamples to the encoder rate when they differ.
     AAudioStreamBuilder_setChannelCount(builder, channels);
-    if (bytesPerSample == 4) {
-        AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_FLOAT);
-    } else if (bytesPerSample == 1) {
-        AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_I16);
-        bytesPerSample = 2;
-    } else {
-        AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_I16);
-    }
+    AAudioStreamBuilder_setFormat(builder,
+                                  bytesPerSample == 4 ? AAUDIO_FORMAT_PCM_FLOAT : AAUDIO_FORMAT_PCM_I16);
     AAudioStreamBuilder_setDataCallback(builder, &NativeAudioCapturer::DataCallback, this);
     AAudioStreamBuilder_setErrorCallback(builder, &NativeAudioCapturer::ErrorCallback, this);
 
@@ -66,9 +65,28 @@ bool NativeAudioCapturer::configureStreamLocked(int32_t sampleRate,
         return false;
     }
 
+    astra::PcmFormat device;
+    device.sampleRate = AAudioStream_getSampleRate(stream_);
+    device.channels = AAudioStream_getChannelCount(stream_);
+    device.isFloat = AAudioStream_getFormat(stream_) == AAUDIO_FORMAT_PCM_FLOAT;
+    const int32_t capacityFrames = AAudioStream_getBufferCapacityInFrames(stream_);
+    const size_t maxCallbackFrames = static_cast<size_t>(std::max(capacityFrames, 4096));
+    if (!converter_.configure(device, sampleRate, channels, maxCallbackFrames)) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag,
+                            "Unsupported capture format rate=%d channels=%d",
+                            device.sampleRate, device.channels);
+        AAudioStream_close(stream_);
+        stream_ = nullptr;
+        return false;
+    }
+    __android_log_print(ANDROID_LOG_INFO, kTag,
+                        "Capture %d Hz x%d %s -> %d Hz x%d int16%s",
+                        device.sampleRate, device.channels, device.isFloat ? "float" : "int16",
+                        sampleRate, channels, converter_.passthrough() ? " (passthrough)" : "");
+
     sampleRate_ = sampleRate;
     channelCount_ = channels;
-    bytesPerSample_ = bytesPerSample;
+    meter_.configure(sampleRate, channels);
     capturing_.store(false);
     return true;
 }
@@ -82,6 +100,9 @@ bool NativeAudioCapturer::start() {
     if (capturing_.load()) {
         return true;
     }
+    capturedFrames_ = 0;
+    converter_.reset();
+    meter_.reset();
     const aaudio_result_t result = AAudioStream_requestStart(stream_);
     if (result != AAUDIO_OK) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "AAudioStream_requestStart failed %d", result);
@@ -113,11 +134,28 @@ void NativeAudioCapturer::setMute(bool muted) {
 }
 
 size_t NativeAudioCapturer::frameSizeBytes() const {
-    return static_cast<size_t>(channelCount_) * static_cast<size_t>(bytesPerSample_);
+    const astra::PcmFormat& device = converter_.inputFormat();
+    return static_cast<size_t>(device.channels) * (device.isFloat ? sizeof(float) : sizeof(int16_t));
+}
+
+int64_t NativeAudioCapturer::captureTimeUs(AAudioStream* stream, int32_t numFrames) const {
+    const int64_t rate = std::max(converter_.inputFormat().sampleRate, 1);
+    int64_t framePosition = 0;
+    int64_t timeNs = 0;
+    if (stream &&
+        AAudioStream_getTimestamp(stream, CLOCK_MONOTONIC, &framePosition, &timeNs) == AAUDIO_OK &&
+        timeNs > 0) {
+        // The hardware timestamp pins |framePosition|; the first frame handed to this
+        // callback is frame |framesRead| of the same stream.
+        const int64_t framesRead = AAudioStream_getFramesRead(stream);
+        return timeNs / 1000 + (framesRead - framePosition) * 1000000LL / rate;
+    }
+    // No timestamp yet (stream warming up): the buffer just finished filling.
+    return astra::MonotonicNowUs() - static_cast<int64_t>(numFrames) * 1000000LL / rate;
 }
 
 aaudio_data_callback_result_t NativeAudioCapturer::DataCallback(
-        AAudioStream*,
+        AAudioStream* stream,
         void* userData,
         void* audioData,
         int32_t numFrames) {
@@ -130,9 +168,23 @@ aaudio_data_callback_result_t NativeAudioCapturer::DataCallback(
     if (self->muted_.load()) {
         std::memset(audioData, 0, totalBytes);
     }
+    const int64_t deviceRate = std::max(self->converter_.inputFormat().sampleRate, 1);
+    const double leadFrames = self->converter_.nextOutputOffsetFrames();
+    const int16_t* pcm = nullptr;
+    const size_t outputFrames = self->converter_.process(audioData, static_cast<size_t>(numFrames), &pcm);
+    if (outputFrames == 0) {
+        return AAUDIO_CALLBACK_RESULT_CONTINUE;
+    }
+    astra::CaptureMarker marker;
+    marker.frameIndex = self->capturedFrames_;
+    marker.timeUs = self->captureTimeUs(stream, numFrames) +
+            static_cast<int64_t>(leadFrames * 1000000.0 / static_cast<double>(deviceRate));
+    self->capturedFrames_ += static_cast<int64_t>(outputFrames);
+    self->meter_.process(pcm, outputFrames, marker.timeUs);
     NativeStreamEngine::Instance().pushAudioPcm(
-            static_cast<uint8_t*>(audioData),
-            totalBytes);
+            reinterpret_cast<const uint8_t*>(pcm),
+            outputFrames * static_cast<size_t>(self->channelCount_) * sizeof(int16_t),
+            marker);
     return AAUDIO_CALLBACK_RESULT_CONTINUE;
 }
 
@@ -7,6 +7,9 @@
 #include <cstdint>
 #include <mutex>
 
+#include "../audio/AudioFormatConverter.h"
+#include "../audio/LevelMeter.h"
+
 class NativeAudioCapturer {
 public:
     static NativeAudioCapturer& Instance();
@@ -17,6 +20,9 @@ public:
     void release();
     void setMute(bool muted);
 
+    // Level snapshot memory (see astra::LevelMeter), valid for the life of the process.
+    void* levelSnapshot() { return meter_.snapshot(); }
+
 private:
     NativeAudioCapturer() = default;
     ~NativeAudioCapturer() = default;
@@ -36,14 +42,18 @@ private:
 
     bool configureStreamLocked(int32_t sampleRate, int32_t channels, int32_t bytesPerSample);
     size_t frameSizeBytes() const;
+    int64_t captureTimeUs(AAudioStream* stream, int32_t numFrames) const;
 
     std::mutex mutex_;
     AAudioStream* stream_ = nullptr;
+    // Encoder-facing format; the device format lives in converter_.inputFormat().
     int32_t sampleRate_ = 48000;
     int32_t channelCount_ = 1;
-    int32_t bytesPerSample_ = 2;
+    astra::AudioFormatConverter converter_;
+    astra::LevelMeter meter_;
     std::atomic<bool> capturing_{false};
     std::atomic<bool> muted_{false};
+    int64_t capturedFrames_ = 0;  // touched only by the data callback
 };
 
 #endif  // ASTRASTREAM_NATIVE_AUDIO_CAPTURER_H
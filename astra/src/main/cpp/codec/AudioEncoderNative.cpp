@@ -5,6 +5,7 @@
 #include <media/NdkMediaFormat.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <vector>
 
@@ -16,32 +17,27 @@ constexpr const char* kTag = "AudioEncoderNative";
 constexpr const char* kAacMime = "audio/mp4a-latm";
 constexpr const char* kCsd0Key = "csd-0";
 constexpr int32_t kAacProfileLc = 2;
+constexpr std::size_t kAacFrameSamples = 1024;
+constexpr std::size_t kRingAacFrames = 16;
+constexpr int64_t kInputDequeueTimeoutUs = 10000;
+constexpr int32_t kDtxHangoverBlocks = 8;  // ~190 ms of silence before frames are replaced
 
 inline int32_t ClampBitrate(int32_t bitrateKbps) {
     return bitrateKbps > 0 ? bitrateKbps : 64;
 }
-}
-
-AudioEncoderNative::AudioEncoderNative() = default;
 
-AudioEncoderNative::~AudioEncoderNative() {
-    stop();
-    releaseCodec();
+bool SameFormat(const AudioEncoderNative::Config& prepared, const AudioEncoderNative::Config& requested) {
+    return prepared.sampleRate == requested.sampleRate && prepared.channels == requested.channels &&
+           prepared.bytesPerSample == requested.bytesPerSample &&
+           ClampBitrate(prepared.bitrateKbps) == ClampBitrate(requested.bitrateKbps);
 }
 
-bool AudioEncoderNative::configure(const Config& config) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    stop();
-    releaseCodec();
-
-    config_ = config;
-    formatConfigured_ = false;
-    totalSamples_ = 0;
-
-    codec_ = AMediaCodec_createEncoderByType(kAacMime);
-    if (!codec_) {
+// Created and configured, not started; nullptr on failure.
+AMediaCodec* CreateAacEncoder(const AudioEncoderNative::Config& config) {
+    AMediaCodec* codec = AMediaCodec_createEncoderByType(kAacMime);
+    if (!codec) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to create AAC encoder");
-        return false;
+        return nullptr;
     }
 
     AMediaFormat* format = AMediaFormat_new();
@@ -56,7 +52,7 @@ bool AudioEncoderNative::configure(const Config& config) {
     AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, maxInputSize);
 
     media_status_t status = AMediaCodec_configure(
-            codec_,
+            codec,
             format,
             nullptr,
             nullptr,
@@ -64,11 +60,69 @@ bool AudioEncoderNative::configure(const Config& config) {
     AMediaFormat_delete(format);
     if (status != AMEDIA_OK) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "AMediaCodec_configure failed: %d", status);
-        releaseCodec();
-        return false;
+        AMediaCodec_delete(codec);
+        return nullptr;
     }
+    return codec;
+}
+}
+
+AudioEncoderNative::AudioEncoderNative()
+    : warm_(SameFormat, [](AMediaCodec*& codec) { AMediaCodec_delete(codec); }) {}
 
-    return true;
+AudioEncoderNative::~AudioEncoderNative() {
+    stop();
+    releaseCodec();
+    warm_.reset();
+}
+
+bool AudioEncoderNative::configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop();
+    releaseCodec();
+
+    config_ = config;
+    formatConfigured_ = false;
+    consumedFrames_ = 0;
+    timestamper_.reset(std::max(config.sampleRate, 1));
+    clockDriftPpm_.store(0.0);
+    pcmFrameBytes_ = kAacFrameSamples *
+            static_cast<std::size_t>(std::max(config.channels, 1)) *
+            static_cast<std::size_t>(std::max(config.bytesPerSample, 1));
+    // Only while stopped and unpublished from capture (see PcmRingBuffer::allocate), and
+    // only when the format needs a bigger ring; start() clears it otherwise.
+    if (ring_.capacity() < pcmFrameBytes_ * kRingAacFrames) {
+        ring_.allocate(pcmFrameBytes_ * kRingAacFrames);
+    }
+    block_.assign(pcmFrameBytes_, 0);
+    overruns_.store(0);
+    droppedFrames_.store(0);
+    underruns_.store(0);
+    dtxFrames_.store(0);
+    // The gate reads int16 samples; other widths simply never enter DTX.
+    silentFrame_ = config.bytesPerSample == 2 ? astra::BuildSilentAacFrame(config.channels)
+                                              : std::vector<uint8_t>{};
+    silenceGate_.configure(config.channels, kDtxHangoverBlocks);
+
+    if (auto warm = warm_.take(config)) {
+        codec_ = *warm;
+        __android_log_print(ANDROID_LOG_INFO, kTag, "Using warmed-up AAC encoder");
+    }
+    if (!codec_) {
+        codec_ = CreateAacEncoder(config);
+    }
+    return codec_ != nullptr;
+}
+
+void AudioEncoderNative::warmUp(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) {
+        return;
+    }
+    warm_.prepare(config, [](const Config& requested) -> std::optional<AMediaCodec*> {
+        AMediaCodec* codec = CreateAacEncoder(requested);
+        return codec ? std::optional<AMediaCodec*>(codec) : std::nullopt;
+    });
 }
 
 void AudioEncoderNative::start() {
@@ -80,12 +134,25 @@ void AudioEncoderNative::start() {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to start AAC encoder");
         return;
     }
+    ring_.clear();
+    silenceGate_.reset();
+    dtxActive_ = false;
+    codecQueued_.store(0);
+    codecDrained_.store(0);
+    {
+        std::lock_guard<std::mutex> emitLock(emitMutex_);
+        lastEmittedPtsUs_ = -1;
+    }
     running_.store(true);
+    feedThread_ = std::thread(&AudioEncoderNative::feedLoop, this);
     drainThread_ = std::thread(&AudioEncoderNative::drainLoop, this);
 }
 
 void AudioEncoderNative::stop() {
     running_.store(false);
+    if (feedThread_.joinable()) {
+        feedThread_.join();
+    }
     if (drainThread_.joinable()) {
         drainThread_.join();
     }
@@ -95,47 +162,150 @@ void AudioEncoderNative::stop() {
     formatConfigured_ = false;
 }
 
-void AudioEncoderNative::queuePcm(const uint8_t* data, std::size_t size) {
-    if (!codec_ || !running_.load() || data == nullptr || size == 0) {
+void AudioEncoderNative::queuePcm(const uint8_t* data,
+                                  std::size_t size,
+                                  const astra::CaptureMarker& marker) {
+    // Runs on the capture callback: no locks, no codec calls, no waiting.
+    if (!running_.load(std::memory_order_relaxed) || data == nullptr || size == 0) {
         return;
     }
+    if (!ring_.write(data, size, marker)) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t frameBytes = pcmFrameBytes_ / kAacFrameSamples;
+        droppedFrames_.fetch_add(frameBytes > 0 ? size / frameBytes : 0, std::memory_order_relaxed);
+    }
+}
 
-    std::size_t offset = 0;
-    while (offset < size) {
-        AMediaCodecBufferInfo info{};
-        const ssize_t index = AMediaCodec_dequeueInputBuffer(codec_, 1000);
-        if (index >= 0) {
-            size_t bufferSize = 0;
-            uint8_t* buffer = AMediaCodec_getInputBuffer(codec_, index, &bufferSize);
-            if (!buffer || bufferSize == 0) {
-                AMediaCodec_queueInputBuffer(codec_, index, 0, 0, 0, 0);
-                continue;
+void AudioEncoderNative::feedLoop() {
+    const int64_t sampleRate = std::max(config_.sampleRate, 1);
+    const auto frameDuration = std::chrono::microseconds(
+            static_cast<int64_t>(kAacFrameSamples) * 1000000LL / sampleRate);
+    const std::size_t bytesPerFrame = pcmFrameBytes_ / kAacFrameSamples;
+    bool starving = false;
+    auto lastFrame = std::chrono::steady_clock::now();
+
+    while (running_.load()) {
+        const std::size_t buffered = ring_.readable();
+        if (buffered < pcmFrameBytes_) {
+            const auto now = std::chrono::steady_clock::now();
+            if (!starving && now - lastFrame > frameDuration * 2) {
+                underruns_.fetch_add(1, std::memory_order_relaxed);
+                starving = true;
             }
-            const size_t remaining = size - offset;
-            const size_t copyBytes = std::min(remaining, bufferSize);
-            std::memcpy(buffer, data + offset, copyBytes);
-            const int64_t pts = computePtsUs(copyBytes);
-            AMediaCodec_queueInputBuffer(codec_,
-                                         index,
-                                         0,
-                                         static_cast<int32_t>(copyBytes),
-                                         pts,
-                                         0);
-            offset += copyBytes;
-        } else if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
-            break;
-        } else {
-            __android_log_print(ANDROID_LOG_WARN, kTag, "dequeueInputBuffer status=%zd", index);
-            break;
+            const int64_t missingFrames = static_cast<int64_t>((pcmFrameBytes_ - buffered) / bytesPerFrame);
+            const auto wait = std::chrono::microseconds(
+                    std::max<int64_t>(missingFrames * 1000000LL / sampleRate, 1000));
+            std::this_thread::sleep_for(std::min<std::chrono::microseconds>(wait, frameDuration));
+            continue;
+        }
+
+        astra::CaptureMarker marker;
+        std::size_t bytesSinceMarker = 0;
+        ring_.read(block_.data(), pcmFrameBytes_, &marker, &bytesSinceMarker);
+        const int64_t pts = computePtsUs(marker, bytesSinceMarker);
+        starving = false;
+        lastFrame = std::chrono::steady_clock::now();
+
+        const bool gated = !silentFrame_.empty() && dtxEnabled_.load(std::memory_order_relaxed) &&
+                silenceGate_.update(reinterpret_cast<const int16_t*>(block_.data()),
+                                    kAacFrameSamples,
+                                    dtxSilencePeak_.load(std::memory_order_relaxed));
+        if (gated) {
+            if (!dtxActive_) {
+                enterDtx();
+            }
+            emitFrame(silentFrame_.data(), silentFrame_.size(), pts);
+            dtxFrames_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (dtxActive_) {
+            __android_log_print(ANDROID_LOG_DEBUG, kTag, "DTX off at pts=%lld", static_cast<long long>(pts));
+            dtxActive_ = false;
+        }
+        if (!queueToCodec(pts) && running_.load()) {
+            droppedFrames_.fetch_add(kAacFrameSamples, std::memory_order_relaxed);
         }
     }
 }
 
+bool AudioEncoderNative::queueToCodec(int64_t ptsUs) {
+    while (running_.load()) {
+        const ssize_t index = AMediaCodec_dequeueInputBuffer(codec_, kInputDequeueTimeoutUs);
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+            continue;
+        }
+        if (index < 0) {
+            // Anything but a timeout means the codec is in error; retrying would only spin.
+            __android_log_print(ANDROID_LOG_ERROR, kTag, "dequeueInputBuffer failed status=%zd, frame dropped", index);
+            return false;
+        }
+        size_t bufferSize = 0;
+        uint8_t* buffer = AMediaCodec_getInputBuffer(codec_, index, &bufferSize);
+        if (!buffer || bufferSize < pcmFrameBytes_) {
+            __android_log_print(ANDROID_LOG_ERROR, kTag,
+                                "Input buffer too small: %zu < %zu", bufferSize, pcmFrameBytes_);
+            AMediaCodec_queueInputBuffer(codec_, index, 0, 0, 0, 0);
+            return false;
+        }
+        std::memcpy(buffer, block_.data(), pcmFrameBytes_);
+        codecQueued_.fetch_add(1, std::memory_order_relaxed);
+        AMediaCodec_queueInputBuffer(codec_,
+                                     index,
+                                     0,
+                                     static_cast<int32_t>(pcmFrameBytes_),
+                                     ptsUs,
+                                     0);
+        return true;
+    }
+    return false;
+}
+
+void AudioEncoderNative::enterDtx() {
+    // Let the codec hand back the hangover blocks it still holds so they go out ahead of
+    // the cached frames. Anything later than this is dropped by emitFrame().
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(
+            static_cast<int64_t>(kAacFrameSamples) * 2000000LL / std::max(config_.sampleRate, 1));
+    while (codecDrained_.load() < codecQueued_.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, kTag, "DTX on, %llu codec frames outstanding",
+                        static_cast<unsigned long long>(codecQueued_.load() - codecDrained_.load()));
+    dtxActive_ = true;
+}
+
+void AudioEncoderNative::emitFrame(const uint8_t* data, std::size_t size, int64_t ptsUs) {
+    std::lock_guard<std::mutex> lock(emitMutex_);
+    if (ptsUs <= lastEmittedPtsUs_) {
+        return;
+    }
+    lastEmittedPtsUs_ = ptsUs;
+    PushProxy::getInstance()->pushAudioFrame(data, size, ptsUs);
+}
+
+AudioEncoderNative::PipelineStats AudioEncoderNative::pipelineStats() const {
+    PipelineStats stats;
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.droppedFrames = droppedFrames_.load(std::memory_order_relaxed);
+    stats.underruns = underruns_.load(std::memory_order_relaxed);
+    const std::size_t bytesPerFrame = pcmFrameBytes_ / kAacFrameSamples;
+    stats.bufferedFrames = bytesPerFrame > 0
+            ? static_cast<uint32_t>(ring_.readable() / bytesPerFrame)
+            : 0;
+    stats.clockDriftPpm = clockDriftPpm_.load(std::memory_order_relaxed);
+    stats.dtxFrames = dtxFrames_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 void AudioEncoderNative::setCallback(JavaCallback* callback) {
     std::lock_guard<std::mutex> lock(mutex_);
     callback_ = callback;
 }
 
+void AudioEncoderNative::setDtx(bool enabled, int32_t silencePeak) {
+    dtxSilencePeak_.store(std::min(std::max(silencePeak, 0), 32767), std::memory_order_relaxed);
+    dtxEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
 void AudioEncoderNative::drainLoop() {
     while (true) {
         if (!codec_) {
@@ -146,10 +316,11 @@ void AudioEncoderNative::drainLoop() {
         if (index >= 0) {
             size_t bufferSize = 0;
             uint8_t* buffer = AMediaCodec_getOutputBuffer(codec_, index, &bufferSize);
-            if (buffer && info.size > 0 && static_cast<size_t>(info.offset + info.size) <= bufferSize) {
-                PushProxy::getInstance()->pushAudioFrame(buffer + info.offset,
-                                                         static_cast<size_t>(info.size),
-                                                         info.presentationTimeUs);
+            const bool codecConfig = (info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) != 0;
+            if (!codecConfig && buffer && info.size > 0 &&
+                static_cast<size_t>(info.offset + info.size) <= bufferSize) {
+                emitFrame(buffer + info.offset, static_cast<size_t>(info.size), info.presentationTimeUs);
+                codecDrained_.fetch_add(1, std::memory_order_relaxed);
             }
             const bool endOfStream = (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) != 0;
             AMediaCodec_releaseOutputBuffer(codec_, index, false);
@@ -205,9 +376,22 @@ void AudioEncoderNative::releaseCodec() {
     }
 }
 
-int64_t AudioEncoderNative::computePtsUs(std::size_t bytes) {
-    const std::size_t samples = bytes / static_cast<std::size_t>(config_.bytesPerSample * std::max(config_.channels, 1));
-    totalSamples_ += static_cast<int64_t>(samples);
+int64_t AudioEncoderNative::computePtsUs(const astra::CaptureMarker& marker,
+                                         std::size_t bytesSinceMarker) {
+    const std::size_t bytesPerFrame = pcmFrameBytes_ / kAacFrameSamples;
+    const auto framesSinceMarker = static_cast<int64_t>(bytesSinceMarker / std::max<std::size_t>(bytesPerFrame, 1));
     const int64_t sampleRate = std::max(config_.sampleRate, 1);
-    return totalSamples_ * 1000000LL / sampleRate;
+
+    int64_t frameIndex = consumedFrames_;
+    int64_t observedUs = -1;
+    if (marker.timeUs >= 0) {
+        // Capture-side index, so frames dropped on overrun still advance the timeline.
+        frameIndex = marker.frameIndex + framesSinceMarker;
+        observedUs = marker.timeUs + framesSinceMarker * 1000000LL / sampleRate;
+    }
+    consumedFrames_ += static_cast<int64_t>(kAacFrameSamples);
+
+    const int64_t pts = timestamper_.ptsForFrame(frameIndex, observedUs);
+    clockDriftPpm_.store(timestamper_.driftPpm(), std::memory_order_relaxed);
+    return pts;
 }
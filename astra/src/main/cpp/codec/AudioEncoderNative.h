@@ -9,6 +9,12 @@
 #include <cstdint>
 #include <mutex>
 #include <thread>
+#include <vector>
+
+#include "../audio/AacSilence.h"
+#include "../audio/AudioTimestamper.h"
+#include "../audio/PcmRingBuffer.h"
+#include "../stream/WarmSlot.h"
 
 class JavaCallback;
 
@@ -21,28 +27,74 @@ public:
         int32_t bytesPerSample = 2;
     };
 
+    struct PipelineStats {
+        uint64_t overruns = 0;       // capture callbacks dropped because the ring was full
+        uint64_t droppedFrames = 0;  // PCM frames lost to those overruns or to codec input errors
+        uint64_t underruns = 0;      // times the feeder ran dry while capture was expected
+        uint32_t bufferedFrames = 0;
+        double clockDriftPpm = 0.0;  // capture clock vs nominal sample rate
+        uint64_t dtxFrames = 0;      // silent blocks sent as cached frames instead of encoded
+    };
+
     AudioEncoderNative();
     ~AudioEncoderNative();
 
+    // Creates and configures the AAC codec for |config| on a background thread; configure()
+    // takes it when the format matches and discards it otherwise.
+    void warmUp(const Config& config);
     bool configure(const Config& config);
     void start();
     void stop();
-    void queuePcm(const uint8_t* data, std::size_t size);
+    // Capture thread, lock-free. The caller keeps it from overlapping configure() or the
+    // destructor; outside start() / stop() the PCM is dropped.
+    void queuePcm(const uint8_t* data, std::size_t size, const astra::CaptureMarker& marker = {});
     void setCallback(JavaCallback* callback);
+    // Discontinuous transmission: once input stays at or below |silencePeak| (int16 |sample|)
+    // past a short hangover, blocks skip the codec and go out as cached silent AAC frames
+    // with their usual timestamps. Only mono and stereo have a cached frame.
+    void setDtx(bool enabled, int32_t silencePeak);
+    PipelineStats pipelineStats() const;
 
 private:
+    void feedLoop();
     void drainLoop();
     void handleFormatChange();
     void releaseCodec();
-    int64_t computePtsUs(std::size_t bytes);
+    bool queueToCodec(int64_t ptsUs);
+    void enterDtx();
+    void emitFrame(const uint8_t* data, std::size_t size, int64_t ptsUs);
+    int64_t computePtsUs(const astra::CaptureMarker& marker, std::size_t bytesSinceMarker);
 
     Config config_{};
     AMediaCodec* codec_ = nullptr;
+    astra::WarmSlot<Config, AMediaCodec*> warm_;
+    std::thread feedThread_;
     std::thread drainThread_;
     std::atomic<bool> running_{false};
     std::mutex mutex_;
     bool formatConfigured_ = false;
-    int64_t totalSamples_ = 0;
+    int64_t consumedFrames_ = 0;
+    astra::AudioTimestamper timestamper_;
+    std::atomic<double> clockDriftPpm_{0.0};
+    astra::PcmRingBuffer ring_;
+    std::size_t pcmFrameBytes_ = 0;
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> droppedFrames_{0};
+    std::atomic<uint64_t> underruns_{0};
+
+    // DTX. The feed thread owns the gate and the block; emitFrame() orders codec and cached
+    // output so a late codec frame can never land behind a cached one.
+    std::atomic<bool> dtxEnabled_{false};  // opt-in via setDtx()
+    std::atomic<int32_t> dtxSilencePeak_{2};
+    astra::SilenceGate silenceGate_;
+    std::vector<uint8_t> silentFrame_;
+    std::vector<uint8_t> block_;
+    bool dtxActive_ = false;
+    std::atomic<uint64_t> codecQueued_{0};
+    std::atomic<uint64_t> codecDrained_{0};
+    std::atomic<uint64_t> dtxFrames_{0};
+    std::mutex emitMutex_;
+    int64_t lastEmittedPtsUs_ = -1;
     JavaCallback* callback_ = nullptr;
 };
 
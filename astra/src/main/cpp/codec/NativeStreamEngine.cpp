@@ -2,10 +2,14 @@
 
 #include <android/log.h>
 
+#include <algorithm>
+#include <thread>
+
 #include "../callback/JavaCallback.h"
 
 namespace {
 constexpr const char* kTag = "NativeStreamEngine";
+constexpr std::size_t kMixBlockFrames = 1024;  // one AAC frame
 }
 
 NativeStreamEngine& NativeStreamEngine::Instance() {
@@ -16,120 +20,294 @@ NativeStreamEngine& NativeStreamEngine::Instance() {
 void NativeStreamEngine::setCallback(JavaCallback* callback) {
     std::lock_guard<std::mutex> lock(mutex_);
     callback_ = callback;
-    if (video_) {
-        video_->setCallback(callback_);
+    if (auto* video = primaryVideo()) {
+        video->setCallback(callback_);
     }
     if (audio_) {
         audio_->setCallback(callback_);
     }
 }
 
+void NativeStreamEngine::warmUpVideo(const astra::VideoConfig& config,
+                                     int32_t bitrateKbps,
+                                     int32_t iframeInterval,
+                                     uint32_t temporalLayers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& video = video_[0];
+    if (!video) {
+        video = std::make_unique<VideoEncoderNative>();
+        video->setCallback(callback_);
+    }
+    VideoEncoderNative::Config encoderConfig{};
+    encoderConfig.streamConfig = config;
+    encoderConfig.bitrateKbps = bitrateKbps;
+    encoderConfig.iframeInterval = iframeInterval;
+    // Part of the codec format: must match what prepareVideoSurface() asks for.
+    encoderConfig.temporalLayers = std::max(temporalLayers, 1u);
+    video->warmUp(encoderConfig);
+}
+
 jobject NativeStreamEngine::prepareVideoSurface(JNIEnv* env,
                                                const astra::VideoConfig& config,
                                                int32_t bitrateKbps,
-                                               int32_t iframeInterval) {
+                                               int32_t iframeInterval,
+                                               bool leaseOutputBuffers,
+                                               uint32_t temporalLayers) {
+    return prepareVideoLayer(env, 0, config, bitrateKbps, iframeInterval, leaseOutputBuffers, temporalLayers);
+}
+
+jobject NativeStreamEngine::prepareVideoLayer(JNIEnv* env,
+                                             uint32_t layer,
+                                             const astra::VideoConfig& config,
+                                             int32_t bitrateKbps,
+                                             int32_t iframeInterval,
+                                             bool leaseOutputBuffers,
+                                             uint32_t temporalLayers) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (!video_) {
-        video_ = std::make_unique<VideoEncoderNative>();
-        video_->setCallback(callback_);
+    auto& video = video_[layer];
+    if (!video) {
+        video = std::make_unique<VideoEncoderNative>();
+        // Stats describe the primary stream only.
+        video->setCallback(layer == 0 ? callback_ : nullptr);
     }
     VideoEncoderNative::Config encoderConfig{};
     encoderConfig.streamConfig = config;
     encoderConfig.bitrateKbps = bitrateKbps;
     encoderConfig.iframeInterval = iframeInterval;
-    if (!video_->configure(encoderConfig)) {
-        __android_log_print(ANDROID_LOG_ERROR, kTag, "Video encoder configure failed");
-        video_.reset();
+    encoderConfig.leaseOutputBuffers = leaseOutputBuffers;
+    encoderConfig.layer = layer;
+    encoderConfig.temporalLayers = std::max(temporalLayers, 1u);
+    if (!video->configure(encoderConfig)) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Video encoder configure failed layer=%u", layer);
+        video_.erase(layer);
         return nullptr;
     }
-    return video_->createInputSurface(env);
+    if (videoStarted_) {
+        video->start();  // joins a running session; its first frame is a key frame
+    }
+    return video->createInputSurface(env);
 }
 
 void NativeStreamEngine::releaseVideoSurface() {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (video_) {
-        video_->stop();
-        video_->releaseSurface();
-        video_.reset();
+    for (auto& entry : video_) {
+        entry.second->stop();
+        entry.second->releaseSurface();
+    }
+    video_.clear();
+    videoStarted_ = false;
+}
+
+void NativeStreamEngine::releaseVideoLayer(uint32_t layer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = video_.find(layer);
+    if (it != video_.end()) {
+        it->second->stop();
+        it->second->releaseSurface();
+        video_.erase(it);
     }
 }
 
 void NativeStreamEngine::startVideo() {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (video_) {
-        video_->start();
+    for (auto& entry : video_) {
+        entry.second->start();
     }
+    videoStarted_ = true;
 }
 
 void NativeStreamEngine::stopVideo() {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (video_) {
-        video_->stop();
+    for (auto& entry : video_) {
+        entry.second->stop();
     }
+    videoStarted_ = false;
 }
 
 void NativeStreamEngine::updateVideoBitrate(int32_t bitrateKbps) {
+    updateVideoLayerBitrate(0, bitrateKbps);
+}
+
+void NativeStreamEngine::updateVideoLayerBitrate(uint32_t layer, int32_t bitrateKbps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = video_.find(layer);
+    if (it != video_.end()) {
+        it->second->updateBitrate(bitrateKbps);
+    }
+}
+
+jobject NativeStreamEngine::prepareVideoReconfigure(JNIEnv* env,
+                                                   const astra::VideoConfig& config,
+                                                   int32_t bitrateKbps,
+                                                   int32_t iframeInterval) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (video_) {
-        video_->updateBitrate(bitrateKbps);
+    auto* video = primaryVideo();
+    if (!video) {
+        return nullptr;
     }
+    VideoEncoderNative::Config encoderConfig{};
+    encoderConfig.streamConfig = config;
+    encoderConfig.bitrateKbps = bitrateKbps;
+    encoderConfig.iframeInterval = iframeInterval;
+    return video->prepareReconfigure(env, encoderConfig);
+}
+
+bool NativeStreamEngine::commitVideoReconfigure() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* video = primaryVideo();
+    return video && video->commitReconfigure();
+}
+
+VideoEncoderNative* NativeStreamEngine::primaryVideo() {
+    const auto it = video_.find(0);
+    return it != video_.end() ? it->second.get() : nullptr;
 }
 
 void NativeStreamEngine::configureAudioEncoder(int32_t sampleRate,
                                                int32_t channels,
                                                int32_t bitrateKbps,
-                                               int32_t bytesPerSample) {
+                                               int32_t /*bytesPerSample*/) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (!audio_) {
         audio_ = std::make_unique<AudioEncoderNative>();
         audio_->setCallback(callback_);
+        audio_->setDtx(audioDtxEnabled_, audioDtxSilencePeak_);
     }
     AudioEncoderNative::Config config{};
     config.sampleRate = sampleRate;
     config.channels = channels;
     config.bitrateKbps = bitrateKbps;
-    config.bytesPerSample = bytesPerSample <= 0 ? 2 : bytesPerSample;
-    if (!audio_->configure(config)) {
-        __android_log_print(ANDROID_LOG_ERROR, kTag, "Audio encoder configure failed");
-        audio_.reset();
-    }
+    // The capture DSP stage always hands the encoder 16-bit PCM, whatever the device format.
+    config.bytesPerSample = 2;
+    // The codec is built in the background now and taken over by startAudio().
+    audio_->warmUp(config);
+    audioConfig_ = config;
+    audioConfigPending_ = true;
+    audioChannels_.store(std::max(channels, 1));
+    mixer_.configure(sampleRate, audioChannels_.load(), kMixBlockFrames,
+                     [this](const int16_t* pcm, std::size_t frames, const astra::CaptureMarker& marker) {
+                         queueMixedPcm(pcm, frames, marker);
+                     });
 }
 
 void NativeStreamEngine::startAudio() {
     std::lock_guard<std::mutex> lock(mutex_);
+    unpublishAudio();
+    if (audio_ && audioConfigPending_) {
+        audioConfigPending_ = false;
+        if (!audio_->configure(audioConfig_)) {
+            __android_log_print(ANDROID_LOG_ERROR, kTag, "Audio encoder configure failed");
+            audio_.reset();
+        }
+    }
     if (audio_) {
+        mixer_.reset();
         audio_->start();
+        liveAudio_.store(audio_.get());  // configured and running: capture may feed it now
     }
 }
 
 void NativeStreamEngine::stopAudio() {
     std::lock_guard<std::mutex> lock(mutex_);
+    unpublishAudio();
     if (audio_) {
         audio_->stop();
     }
 }
 
-void NativeStreamEngine::pushAudioPcm(const uint8_t* data, std::size_t size) {
-    AudioEncoderNative* audio = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio = audio_.get();
+void NativeStreamEngine::unpublishAudio() {
+    liveAudio_.store(nullptr);
+    // A callback holds the encoder for one ring write at most, so this is a short spin.
+    while (audioCallbacks_.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void NativeStreamEngine::pushAudioPcm(const uint8_t* data,
+                                      std::size_t size,
+                                      const astra::CaptureMarker& marker) {
+    // Microphone PCM drives the mixer, which hands whole AAC frames to queueMixedPcm.
+    const std::size_t frameBytes = static_cast<std::size_t>(audioChannels_.load(std::memory_order_relaxed)) *
+            sizeof(int16_t);
+    mixer_.pushMaster(reinterpret_cast<const int16_t*>(data), size / frameBytes, marker);
+}
+
+void NativeStreamEngine::queueMixedPcm(const int16_t* pcm,
+                                       std::size_t frames,
+                                       const astra::CaptureMarker& marker) {
+    // Realtime capture callback: no lock. The count keeps unpublishAudio() from returning
+    // while the encoder loaded here is still in use.
+    audioCallbacks_.fetch_add(1);
+    if (AudioEncoderNative* audio = liveAudio_.load()) {
+        audio->queuePcm(reinterpret_cast<const uint8_t*>(pcm),
+                        frames * static_cast<std::size_t>(audioChannels_.load(std::memory_order_relaxed)) *
+                                sizeof(int16_t),
+                        marker);
+    }
+    audioCallbacks_.fetch_sub(1);
+}
+
+AudioEncoderNative::PipelineStats NativeStreamEngine::audioPipelineStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!audio_) {
+        return {};
+    }
+    return audio_->pipelineStats();
+}
+
+void NativeStreamEngine::setAudioDtx(bool enabled, int32_t silencePeak) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    audioDtxEnabled_ = enabled;
+    audioDtxSilencePeak_ = silencePeak;
+    if (audio_) {
+        audio_->setDtx(enabled, silencePeak);
     }
-    if (audio) {
-        audio->queuePcm(data, size);
+}
+
+int32_t NativeStreamEngine::addAudioSource(int32_t sampleRate,
+                                           int32_t channels,
+                                           astra::MixerSourceKind kind) {
+    astra::PcmFormat format;
+    format.sampleRate = sampleRate;
+    format.channels = channels;
+    format.isFloat = false;
+    const int32_t sourceId = mixer_.addSource(format, kind);
+    if (sourceId < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag,
+                            "addAudioSource failed rate=%d channels=%d", sampleRate, channels);
     }
+    return sourceId;
+}
+
+void NativeStreamEngine::removeAudioSource(int32_t sourceId) {
+    mixer_.removeSource(sourceId);
+}
+
+bool NativeStreamEngine::pushAudioSourcePcm(int32_t sourceId, const uint8_t* data, std::size_t size) {
+    return mixer_.pushSource(sourceId, data, size);
+}
+
+void NativeStreamEngine::setAudioSourceGain(int32_t sourceId, float gain) {
+    mixer_.setGain(sourceId, gain);
+}
+
+astra::AudioMixer::SourceStats NativeStreamEngine::audioSourceStats(int32_t sourceId) {
+    return mixer_.sourceStats(sourceId);
 }
 
 void NativeStreamEngine::shutdown() {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (video_) {
-        video_->stop();
-        video_->releaseSurface();
-        video_.reset();
+    for (auto& entry : video_) {
+        entry.second->stop();
+        entry.second->releaseSurface();
     }
+    video_.clear();
+    videoStarted_ = false;
+    unpublishAudio();
     if (audio_) {
         audio_->stop();
         audio_.reset();
     }
+    audioConfigPending_ = false;
     callback_ = nullptr;
 }
@@ -3,13 +3,16 @@
 
 #include <jni.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 
 #include "AudioEncoderNative.h"
 #include "VideoEncoderNative.h"
+#include "../audio/AudioMixer.h"
 
 class JavaCallback;
 
@@ -19,22 +22,59 @@ public:
 
     void setCallback(JavaCallback* callback);
 
+    // Session built: prepare the primary encoder in the background so prepareVideoSurface()
+    // does not pay for codec creation when going live. configureAudioEncoder() does the same
+    // for AAC, whose codec startAudio() then takes over.
+    void warmUpVideo(const astra::VideoConfig& config,
+                     int32_t bitrateKbps,
+                     int32_t iframeInterval,
+                     uint32_t temporalLayers);
     jobject prepareVideoSurface(JNIEnv* env,
                                 const astra::VideoConfig& config,
                                 int32_t bitrateKbps,
-                                int32_t iframeInterval);
-    void releaseVideoSurface();
+                                int32_t iframeInterval,
+                                bool leaseOutputBuffers = false,
+                                uint32_t temporalLayers = 1);
+    void releaseVideoSurface();  // every layer
     void startVideo();
     void stopVideo();
     void updateVideoBitrate(int32_t bitrateKbps);
 
+    // Simulcast: one encoder per layer, each fed by the renderer through its own surface and
+    // sending to its own PushProxy layer; layer 0 is the surface above. Audio stays shared.
+    jobject prepareVideoLayer(JNIEnv* env,
+                              uint32_t layer,
+                              const astra::VideoConfig& config,
+                              int32_t bitrateKbps,
+                              int32_t iframeInterval,
+                              bool leaseOutputBuffers,
+                              uint32_t temporalLayers);
+    void releaseVideoLayer(uint32_t layer);
+    void updateVideoLayerBitrate(uint32_t layer, int32_t bitrateKbps);
+    // Live switch to a new size / frame rate, same codec: render into the returned surface,
+    // then commit once a frame is on it. Blocks while the new codec is configured.
+    jobject prepareVideoReconfigure(JNIEnv* env,
+                                    const astra::VideoConfig& config,
+                                    int32_t bitrateKbps,
+                                    int32_t iframeInterval);
+    bool commitVideoReconfigure();
+
     void configureAudioEncoder(int32_t sampleRate,
                                int32_t channels,
                                int32_t bitrateKbps,
                                int32_t bytesPerSample);
     void startAudio();
     void stopAudio();
-    void pushAudioPcm(const uint8_t* data, std::size_t size);
+    void pushAudioPcm(const uint8_t* data, std::size_t size, const astra::CaptureMarker& marker = {});
+    AudioEncoderNative::PipelineStats audioPipelineStats();
+    void setAudioDtx(bool enabled, int32_t silencePeak);
+
+    // Extra PCM sources mixed over the microphone (playback capture, sound effects).
+    int32_t addAudioSource(int32_t sampleRate, int32_t channels, astra::MixerSourceKind kind);
+    void removeAudioSource(int32_t sourceId);
+    bool pushAudioSourcePcm(int32_t sourceId, const uint8_t* data, std::size_t size);
+    void setAudioSourceGain(int32_t sourceId, float gain);
+    astra::AudioMixer::SourceStats audioSourceStats(int32_t sourceId);
 
     void shutdown();
 
@@ -43,9 +83,26 @@ private:
     NativeStreamEngine(const NativeStreamEngine&) = delete;
     NativeStreamEngine& operator=(const NativeStreamEngine&) = delete;
 
+    VideoEncoderNative* primaryVideo();
+    void queueMixedPcm(const int16_t* pcm, std::size_t frames, const astra::CaptureMarker& marker);
+    // Takes the encoder away from the capture path and waits for a callback still using it
+    // to return; call before stopping, reconfiguring or destroying it.
+    void unpublishAudio();
+
     std::mutex mutex_;
-    std::unique_ptr<VideoEncoderNative> video_;
+    std::map<uint32_t, std::unique_ptr<VideoEncoderNative>> video_;  // by simulcast layer
+    bool videoStarted_ = false;
     std::unique_ptr<AudioEncoderNative> audio_;
+    astra::AudioMixer mixer_;
+    AudioEncoderNative::Config audioConfig_{};
+    bool audioConfigPending_ = false;  // configured by the next startAudio()
+    std::atomic<int32_t> audioChannels_{1};
+    // The capture callback's view of audio_: set only while it is started, and read without
+    // a lock. audioCallbacks_ counts callbacks between loading it and done using it.
+    std::atomic<AudioEncoderNative*> liveAudio_{nullptr};
+    std::atomic<int32_t> audioCallbacks_{0};
+    bool audioDtxEnabled_ = false;  // opt-in: setAudioDtx()
+    int32_t audioDtxSilencePeak_ = 2;  // dither on a muted float mic stays within +/-1 LSB
     JavaCallback* callback_ = nullptr;
 };
 
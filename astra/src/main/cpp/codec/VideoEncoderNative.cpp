@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <string>
+#include <thread>
 
 #include "../callback/JavaCallback.h"
 #include "../common/PushProxy.h"
@@ -17,12 +19,19 @@ constexpr int32_t kBitrateModeCbr = 2;
 constexpr int32_t kAvcProfileHigh = 0x08;
 constexpr int32_t kAvcLevel4 = 0x200;
 constexpr int32_t kHevcProfileMain = 1;
+constexpr int32_t kAv1ProfileMain8 = 0x1;
 constexpr const char* kMimeAvc = "video/avc";
 constexpr const char* kMimeHevc = "video/hevc";
+constexpr const char* kMimeAv1 = "video/av01";
 constexpr const char* kKeyLevel = "level";
 constexpr const char* kKeyVideoBitrate = "video-bitrate";
 constexpr const char* kKeyBitrateMode = "bitrate-mode";
 constexpr const char* kKeyProfile = "profile";
+constexpr const char* kKeyTemporalSchema = "ts-schema";
+constexpr uint32_t kMaxTemporalLayers = 3;
+constexpr const char* kKeyRequestSyncFrame = "request-sync";  // PARAMETER_KEY_REQUEST_SYNC_FRAME
+constexpr uint32_t kBufferFlagKeyFrame = 1;  // BUFFER_FLAG_KEY_FRAME
+constexpr int64_t kMinKeyFrameRequestGapMs = 1000;
 
 inline int32_t ClampBitrate(int32_t bitrateKbps) {
     return bitrateKbps > 0 ? bitrateKbps : 600;
@@ -36,33 +45,38 @@ inline uint32_t SanitizeDimension(uint32_t value) {
 }
 
 const char* MimeForCodec(astra::VideoCodecId codec) {
-    return codec == astra::VideoCodecId::kH265 ? kMimeHevc : kMimeAvc;
+    switch (codec) {
+        case astra::VideoCodecId::kH265: return kMimeHevc;
+        case astra::VideoCodecId::kAv1: return kMimeAv1;
+        default: return kMimeAvc;
+    }
 }
 
-}  // namespace
-
-VideoEncoderNative::VideoEncoderNative() = default;
-
-VideoEncoderNative::~VideoEncoderNative() {
-    stop();
-    releaseSurface();
-    releaseCodec();
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-bool VideoEncoderNative::configure(const Config& config) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    stop();
-    releaseSurface();
-    releaseCodec();
-
-    config_ = config;
-    formatConfigured_ = false;
+// Whether a codec configured for |prepared| can serve |requested|; lease and layer settings
+// are not part of the codec format.
+bool SameFormat(const VideoEncoderNative::Config& prepared, const VideoEncoderNative::Config& requested) {
+    return prepared.streamConfig.codec == requested.streamConfig.codec &&
+           SanitizeDimension(prepared.streamConfig.width) == SanitizeDimension(requested.streamConfig.width) &&
+           SanitizeDimension(prepared.streamConfig.height) == SanitizeDimension(requested.streamConfig.height) &&
+           std::max(prepared.streamConfig.fps, 1u) == std::max(requested.streamConfig.fps, 1u) &&
+           ClampBitrate(prepared.bitrateKbps) == ClampBitrate(requested.bitrateKbps) &&
+           std::max(prepared.iframeInterval, 1) == std::max(requested.iframeInterval, 1) &&
+           prepared.temporalLayers == requested.temporalLayers;
+}
 
+// Configured for surface input, with the input surface created; nullptr on failure. Records
+// the temporal layers the codec accepted in config.streamConfig for the muxers.
+AMediaCodec* CreateSurfaceEncoder(VideoEncoderNative::Config& config, ANativeWindow** surface) {
     const char* mime = MimeForCodec(config.streamConfig.codec);
-    codec_ = AMediaCodec_createEncoderByType(mime);
-    if (!codec_) {
+    AMediaCodec* codec = AMediaCodec_createEncoderByType(mime);
+    if (!codec) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to create codec for %s", mime);
-        return false;
+        return nullptr;
     }
 
     AMediaFormat* format = AMediaFormat_new();
@@ -77,34 +91,119 @@ bool VideoEncoderNative::configure(const Config& config) {
 
     if (config.streamConfig.codec == astra::VideoCodecId::kH265) {
         AMediaFormat_setInt32(format, kKeyProfile, kHevcProfileMain);
+    } else if (config.streamConfig.codec == astra::VideoCodecId::kAv1) {
+        AMediaFormat_setInt32(format, kKeyProfile, kAv1ProfileMain8);
     } else {
         AMediaFormat_setInt32(format, kKeyProfile, kAvcProfileHigh);
         AMediaFormat_setInt32(format, kKeyLevel, kAvcLevel4);
     }
+    const uint32_t temporalLayers = std::min(config.temporalLayers, kMaxTemporalLayers);
+    if (temporalLayers > 1) {
+        const std::string schema = "android.generic." + std::to_string(temporalLayers);
+        AMediaFormat_setString(format, kKeyTemporalSchema, schema.c_str());
+    }
 
     media_status_t status = AMediaCodec_configure(
-            codec_,
+            codec,
             format,
             nullptr,
             nullptr,
             AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
     AMediaFormat_delete(format);
     if (status != AMEDIA_OK) {
+        AMediaCodec_delete(codec);
+        if (temporalLayers > 1) {
+            __android_log_print(ANDROID_LOG_WARN, kTag, "%u temporal layers not supported (%d); encoding without",
+                                temporalLayers, status);
+            VideoEncoderNative::Config single = config;
+            single.temporalLayers = 1;
+            AMediaCodec* fallback = CreateSurfaceEncoder(single, surface);
+            config.streamConfig.temporalLayers = single.streamConfig.temporalLayers;
+            return fallback;
+        }
         __android_log_print(ANDROID_LOG_ERROR, kTag, "AMediaCodec_configure failed: %d", status);
-        releaseCodec();
-        return false;
+        return nullptr;
     }
 
     ANativeWindow* createdSurface = nullptr;
-    status = AMediaCodec_createInputSurface(codec_, &createdSurface);
+    status = AMediaCodec_createInputSurface(codec, &createdSurface);
     if (status != AMEDIA_OK || createdSurface == nullptr) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to create input surface status=%d", status);
-        releaseCodec();
+        AMediaCodec_delete(codec);
+        return nullptr;
+    }
+    *surface = createdSurface;
+    config.streamConfig.temporalLayers = std::max(temporalLayers, 1u);
+    return codec;
+}
+
+}  // namespace
+
+VideoEncoderNative::VideoEncoderNative()
+    : warm_(SameFormat, [](WarmEncoder& warm) {
+          AMediaCodec_delete(warm.codec);
+          ANativeWindow_release(warm.surface);
+      }) {}
+
+VideoEncoderNative::~VideoEncoderNative() {
+    stop();
+    releaseSurface();
+    releaseCodec();
+    warm_.reset();
+}
+
+void VideoEncoderNative::warmUp(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (codec_) {
+        return;  // already configured; a second codec would only compete for the hardware
+    }
+    // A warm-up already prepared, or being prepared, for this format is kept.
+    warm_.prepare(config, [](const Config& requested) -> std::optional<WarmEncoder> {
+        const int64_t startMs = NowMs();
+        Config prepared = requested;
+        WarmEncoder warm;
+        warm.codec = CreateSurfaceEncoder(prepared, &warm.surface);
+        warm.temporalLayers = prepared.streamConfig.temporalLayers;
+        __android_log_print(ANDROID_LOG_INFO, kTag, "Warm-up %s in %lld ms (%ux%u@%u)",
+                            warm.codec ? "ready" : "failed", static_cast<long long>(NowMs() - startMs),
+                            requested.streamConfig.width, requested.streamConfig.height, requested.streamConfig.fps);
+        return warm.codec ? std::optional<WarmEncoder>(warm) : std::nullopt;
+    });
+}
+
+bool VideoEncoderNative::configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop();
+    releaseSurface();
+    releaseCodec();
+
+    config_ = config;
+    formatConfigured_ = false;
+    configuredAtMs_ = NowMs();
+    firstFrameLatencyMs_.store(-1);
+
+    ANativeWindow* createdSurface = nullptr;
+    AMediaCodec* codec = nullptr;
+    // Waits out a warm-up still running: cheaper than starting over when it is nearly done.
+    if (auto warm = warm_.take(config)) {
+        codec = warm->codec;
+        createdSurface = warm->surface;
+        config_.streamConfig.temporalLayers = warm->temporalLayers;
+        __android_log_print(ANDROID_LOG_INFO, kTag, "Using warmed-up encoder");
+    }
+    if (!codec) {
+        codec = CreateSurfaceEncoder(config_, &createdSurface);
+    }
+    if (!codec) {
         return false;
     }
-    inputSurface_ = createdSurface;
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        codec_ = codec;
+        inputSurface_ = createdSurface;
+    }
 
-    PushProxy::getInstance()->configureVideo(config_.streamConfig);
+    PushProxy::getInstance()->configureLayerVideo(config_.layer, config_.streamConfig);
     return true;
 }
 
@@ -133,29 +232,47 @@ void VideoEncoderNative::start() {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to start codec");
         return;
     }
+    createLeaseOwner();
     running_.store(true);
+    keyFrameRequested_.store(false);
+    lastKeyFrameRequestMs_ = 0;
     const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now().time_since_epoch()).count();
     stats_.reset(nowMs);
+    PushProxy::getInstance()->setKeyFrameHandler(config_.layer, [this] { requestKeyFrame(); });
     drainThread_ = std::thread(&VideoEncoderNative::drainLoop, this);
 }
 
 void VideoEncoderNative::stop() {
+    uint32_t layer = 0;
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        layer = config_.layer;
+    }
+    if (running_.load()) {
+        PushProxy::getInstance()->setKeyFrameHandler(layer, nullptr);
+    }
     running_.store(false);
-    if (codec_) {
-        AMediaCodec_signalEndOfInputStream(codec_);
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        if (codec_) {
+            AMediaCodec_signalEndOfInputStream(codec_);
+        }
     }
     if (drainThread_.joinable()) {
         drainThread_.join();
     }
+    revokeLeases();
     if (codec_) {
         AMediaCodec_stop(codec_);
     }
+    releaseStandby();
     formatConfigured_ = false;
 }
 
 void VideoEncoderNative::updateBitrate(int32_t bitrateKbps) {
     std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> codecLock(codecMutex_);
     if (!codec_) return;
     AMediaFormat* params = AMediaFormat_new();
     AMediaFormat_setInt32(params, kKeyVideoBitrate, ClampBitrate(bitrateKbps) * 1024);
@@ -163,6 +280,87 @@ void VideoEncoderNative::updateBitrate(int32_t bitrateKbps) {
     AMediaFormat_delete(params);
 }
 
+void VideoEncoderNative::requestKeyFrame() {
+    keyFrameRequested_.store(true, std::memory_order_relaxed);
+}
+
+void VideoEncoderNative::issueKeyFrameRequest() {
+    const int64_t nowMs = NowMs();
+    if (nowMs - lastKeyFrameRequestMs_ < kMinKeyFrameRequestGapMs) {
+        return;  // stays pending until the gap has passed
+    }
+    keyFrameRequested_.store(false, std::memory_order_relaxed);
+    lastKeyFrameRequestMs_ = nowMs;
+    AMediaFormat* params = AMediaFormat_new();
+    AMediaFormat_setInt32(params, kKeyRequestSyncFrame, 0);
+    const media_status_t status = AMediaCodec_setParameters(codec_, params);
+    AMediaFormat_delete(params);
+    if (status != AMEDIA_OK) {
+        __android_log_print(ANDROID_LOG_WARN, kTag, "Key frame request failed: %d", status);
+    }
+}
+
+jobject VideoEncoderNative::prepareReconfigure(JNIEnv* env, const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!codec_ || !running_.load()) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Reconfigure requested while not encoding");
+        return nullptr;
+    }
+    Config current;
+    {
+        // The standby is only released by a completed or aborted handover: replacing it once
+        // committed would leave the old codec at end of stream with nothing to switch to.
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        if (standbyCodec_ || handoverRequested_.load()) {
+            __android_log_print(ANDROID_LOG_WARN, kTag, "Reconfigure already in progress");
+            return nullptr;
+        }
+        current = config_;
+    }
+    if (config.streamConfig.codec != current.streamConfig.codec) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Reconfigure cannot change the codec");
+        return nullptr;
+    }
+    Config next = config;
+    next.leaseOutputBuffers = current.leaseOutputBuffers;
+    next.maxOutputLeases = current.maxOutputLeases;
+    next.layer = current.layer;
+    next.temporalLayers = current.temporalLayers;
+
+    // The current codec keeps encoding meanwhile: the drain thread never takes mutex_.
+    ANativeWindow* surface = nullptr;
+    AMediaCodec* codec = CreateSurfaceEncoder(next, &surface);
+    if (!codec) {
+        return nullptr;
+    }
+    if (AMediaCodec_start(codec) != AMEDIA_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to start standby codec");
+        ANativeWindow_release(surface);
+        AMediaCodec_delete(codec);
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        standbyCodec_ = codec;
+        standbySurface_ = surface;
+        standbyConfig_ = next;
+    }
+    __android_log_print(ANDROID_LOG_INFO, kTag, "Standby encoder ready %ux%u@%u %d kbps",
+                        config.streamConfig.width, config.streamConfig.height,
+                        config.streamConfig.fps, config.bitrateKbps);
+    return ANativeWindow_toSurface(env, surface);
+}
+
+bool VideoEncoderNative::commitReconfigure() {
+    std::lock_guard<std::mutex> codecLock(codecMutex_);
+    if (!standbyCodec_ || !codec_ || !running_.load()) {
+        return false;
+    }
+    handoverRequested_.store(true);
+    AMediaCodec_signalEndOfInputStream(codec_);
+    return true;
+}
+
 void VideoEncoderNative::setCallback(JavaCallback* callback) {
     std::lock_guard<std::mutex> lock(mutex_);
     callback_ = callback;
@@ -173,20 +371,49 @@ void VideoEncoderNative::drainLoop() {
         if (!codec_) {
             break;
         }
+        if (keyFrameRequested_.load(std::memory_order_relaxed)) {
+            issueKeyFrameRequest();
+        }
         AMediaCodecBufferInfo info{};
         const ssize_t index = AMediaCodec_dequeueOutputBuffer(codec_, &info, 10000);
         if (index >= 0) {
             size_t bufferSize = 0;
             uint8_t* buffer = AMediaCodec_getOutputBuffer(codec_, index, &bufferSize);
+            bool leased = false;
             if (buffer && info.size > 0 && static_cast<size_t>(info.offset + info.size) <= bufferSize) {
-                PushProxy::getInstance()->pushVideoFrame(buffer + info.offset,
-                                                         static_cast<size_t>(info.size),
-                                                         info.presentationTimeUs);
+                if ((info.flags & kBufferFlagKeyFrame) != 0) {
+                    // Answers whatever was asked before it; requests made while it is sent stay.
+                    keyFrameRequested_.store(false, std::memory_order_relaxed);
+                }
+                if (auto lease = leaseOutputBuffer(static_cast<size_t>(index),
+                                                   buffer + info.offset,
+                                                   static_cast<size_t>(info.size))) {
+                    leased = PushProxy::getInstance()->pushLeasedLayerVideoFrame(config_.layer, lease, info.presentationTimeUs);
+                    if (!leased) {
+                        lease.detach();
+                    }
+                }
+                if (!leased) {
+                    PushProxy::getInstance()->pushLayerVideoFrame(config_.layer,
+                                                                  buffer + info.offset,
+                                                                  static_cast<size_t>(info.size),
+                                                                  info.presentationTimeUs);
+                }
                 signalStats(static_cast<std::size_t>(info.size));
+                if (firstFrameLatencyMs_.load(std::memory_order_relaxed) < 0) {
+                    firstFrameLatencyMs_.store(NowMs() - configuredAtMs_);
+                    __android_log_print(ANDROID_LOG_INFO, kTag, "First encoded frame %lld ms after configure",
+                                        static_cast<long long>(firstFrameLatencyMs_.load()));
+                }
             }
             const bool endOfStream = (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) != 0;
-            AMediaCodec_releaseOutputBuffer(codec_, index, false);
+            if (!leased) {
+                AMediaCodec_releaseOutputBuffer(codec_, index, false);
+            }
             if (endOfStream) {
+                if (running_.load() && handoverRequested_.load() && handOver()) {
+                    continue;
+                }
                 break;
             }
         } else if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
@@ -204,6 +431,70 @@ void VideoEncoderNative::drainLoop() {
     }
 }
 
+bool VideoEncoderNative::handOver() {
+    // Frames of the old codec still in the send queue are copied out and go out as queued.
+    revokeLeases();
+
+    AMediaCodec* retired = nullptr;
+    ANativeWindow* retiredSurface = nullptr;
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        handoverRequested_.store(false);
+        if (!standbyCodec_) {
+            return false;
+        }
+        retired = codec_;
+        retiredSurface = inputSurface_;
+        codec_ = standbyCodec_;
+        inputSurface_ = standbySurface_;
+        config_ = standbyConfig_;
+        standbyCodec_ = nullptr;
+        standbySurface_ = nullptr;
+        formatConfigured_ = false;
+    }
+    AMediaCodec_stop(retired);
+    AMediaCodec_delete(retired);
+    if (retiredSurface) {
+        ANativeWindow_release(retiredSurface);
+    }
+    createLeaseOwner();
+    // Same connection: the new parameter sets bring a fresh sequence header and onMetaData.
+    PushProxy::getInstance()->updateLayerVideoConfig(config_.layer, config_.streamConfig);
+    __android_log_print(ANDROID_LOG_INFO, kTag, "Switched encoder to %ux%u@%u",
+                        config_.streamConfig.width, config_.streamConfig.height, config_.streamConfig.fps);
+    return true;
+}
+
+void VideoEncoderNative::releaseStandby() {
+    AMediaCodec* codec = nullptr;
+    ANativeWindow* surface = nullptr;
+    {
+        std::lock_guard<std::mutex> codecLock(codecMutex_);
+        codec = standbyCodec_;
+        surface = standbySurface_;
+        standbyCodec_ = nullptr;
+        standbySurface_ = nullptr;
+        handoverRequested_.store(false);
+    }
+    if (codec) {
+        AMediaCodec_stop(codec);
+        AMediaCodec_delete(codec);
+    }
+    if (surface) {
+        ANativeWindow_release(surface);
+    }
+}
+
+void VideoEncoderNative::createLeaseOwner() {
+    if (!config_.leaseOutputBuffers || config_.maxOutputLeases == 0) {
+        return;
+    }
+    AMediaCodec* codec = codec_;
+    leaseOwner_ = std::make_shared<astra::BufferLeaseOwner>(
+            config_.maxOutputLeases,
+            [codec](size_t index) { AMediaCodec_releaseOutputBuffer(codec, index, false); });
+}
+
 void VideoEncoderNative::handleFormatChange() {
     if (formatConfigured_) {
         return;
@@ -225,6 +516,27 @@ void VideoEncoderNative::signalStats(std::size_t bytes) {
     }
 }
 
+astra::EncodedBufferLease VideoEncoderNative::leaseOutputBuffer(size_t index,
+                                                                uint8_t* data,
+                                                                size_t size) {
+    if (!leaseOwner_ || !leaseOwner_->tryAcquire()) {
+        return {};
+    }
+    return astra::EncodedBufferLease(leaseOwner_, index, data, size);
+}
+
+void VideoEncoderNative::revokeLeases() {
+    if (!leaseOwner_) {
+        return;
+    }
+    // Frames still queued or mid-write carry on from copies; the codec gets nothing back.
+    leaseOwner_->revoke();
+    if (const uint32_t outstanding = leaseOwner_->outstanding()) {
+        __android_log_print(ANDROID_LOG_INFO, kTag, "Copied %u leased output buffers before stop", outstanding);
+    }
+    leaseOwner_.reset();
+}
+
 void VideoEncoderNative::releaseCodec() {
     if (codec_) {
         AMediaCodec_delete(codec_);
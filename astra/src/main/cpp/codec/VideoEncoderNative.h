@@ -8,11 +8,14 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <thread>
 
+#include "../stream/EncodedBufferLease.h"
 #include "../stream/FlvMuxer.h"
 #include "../stream/FrameStats.h"
+#include "../stream/WarmSlot.h"
 
 class JavaCallback;
 
@@ -22,34 +25,89 @@ public:
         astra::VideoConfig streamConfig;
         int32_t bitrateKbps = 0;
         int32_t iframeInterval = 2;
+        // Opt-in: hand output buffers to the sender instead of copying them. At most
+        // maxOutputLeases buffers are out at once so the codec always has some to fill.
+        bool leaseOutputBuffers = false;
+        uint32_t maxOutputLeases = 3;
+        // Simulcast layer whose muxer and connection the output goes to; 0 is the primary.
+        uint32_t layer = 0;
+        // Temporal layering (SVC-T, "ts-schema" android.generic.N, N <= 3): the top layer is
+        // never referenced, so the sender can drop it under congestion. Encoders without
+        // support fall back to a single layer; streamConfig.temporalLayers is what it got.
+        uint32_t temporalLayers = 1;
     };
 
     VideoEncoderNative();
     ~VideoEncoderNative();
 
+    // Creates and configures a codec for |config| on a background thread, ahead of
+    // configure(): AMediaCodec create + configure takes 100-400 ms on many devices. configure()
+    // takes the prepared codec when the format matches and discards it otherwise.
+    void warmUp(const Config& config);
     bool configure(const Config& config);
     jobject createInputSurface(JNIEnv* env);
+    ANativeWindow* inputWindow() const { return inputSurface_; }
+    // From configure() to the first encoded frame; -1 until one arrives.
+    int64_t firstFrameLatencyMs() const { return firstFrameLatencyMs_.load(); }
     void releaseSurface();
     void start();
     void stop();
     void updateBitrate(int32_t bitrateKbps);
+    // An IDR ahead of the key-frame interval, e.g. for a destination that just connected. Any
+    // thread; the drain thread issues it, at most one per kMinKeyFrameRequestGapMs, so a burst
+    // of requests (and any already answered by a key frame coming out) yields one IDR.
+    void requestKeyFrame();
     void setCallback(JavaCallback* callback);
 
+    // Live reconfiguration (size, frame rate, bitrate; not the codec) without a restart.
+    // prepareReconfigure starts a standby codec and returns its input surface while the
+    // current one keeps encoding. Once the renderer draws into the new surface,
+    // commitReconfigure ends the current codec's input; the drain thread sends what it has
+    // left, then switches to the standby codec, whose output starts with a key frame.
+    jobject prepareReconfigure(JNIEnv* env, const Config& config);
+    bool commitReconfigure();
+
 private:
     void drainLoop();
+    // Drain thread, at the current codec's end of stream: false when there is nothing to
+    // switch to.
+    bool handOver();
+    void releaseStandby();
+    void createLeaseOwner();
     void handleFormatChange();
     void releaseCodec();
     void signalStats(std::size_t bytes);
+    void issueKeyFrameRequest();  // drain thread
+    astra::EncodedBufferLease leaseOutputBuffer(size_t index, uint8_t* data, size_t size);
+    void revokeLeases();
 
-    Config config_{};
+    Config config_{};  // handOver() replaces it on the drain thread, under codecMutex_
     AMediaCodec* codec_ = nullptr;
     ANativeWindow* inputSurface_ = nullptr;
     std::thread drainThread_;
     std::atomic<bool> running_{false};
     std::mutex mutex_;
+    // codec_ / inputSurface_ / config_ against the drain thread's handover, and the standby codec.
+    std::mutex codecMutex_;
+    AMediaCodec* standbyCodec_ = nullptr;
+    ANativeWindow* standbySurface_ = nullptr;
+    Config standbyConfig_{};
+    std::atomic<bool> handoverRequested_{false};
+
+    struct WarmEncoder {
+        AMediaCodec* codec = nullptr;
+        ANativeWindow* surface = nullptr;
+        uint32_t temporalLayers = 1;  // what the codec accepted; see VideoConfig::temporalLayers
+    };
+    astra::WarmSlot<Config, WarmEncoder> warm_;
+    int64_t configuredAtMs_ = 0;
+    std::atomic<int64_t> firstFrameLatencyMs_{-1};
+    std::atomic<bool> keyFrameRequested_{false};
+    int64_t lastKeyFrameRequestMs_ = 0;  // drain thread
     bool formatConfigured_ = false;
     JavaCallback* callback_ = nullptr;
     astra::FrameStats stats_;
+    std::shared_ptr<astra::BufferLeaseOwner> leaseOwner_;
 };
 
 #endif  // ASTRASTREAM_VIDEOENCODERNATIVE_H
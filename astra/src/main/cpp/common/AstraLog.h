@@ -0,0 +1,45 @@
+#ifndef ASTRASTREAM_ASTRALOG_H
+#define ASTRASTREAM_ASTRALOG_H
+
+// Logging for code that also builds off-device (astra_core). On Android this is
+// __android_log_print; host builds write warnings and errors to stderr and drop the rest,
+// still format-checking the dropped calls so their arguments count as used.
+
+#if defined(__ANDROID__)
+
+#include <android/log.h>
+
+#define ASTRA_LOGD(tag, ...) __android_log_print(ANDROID_LOG_DEBUG, tag, __VA_ARGS__)
+#define ASTRA_LOGI(tag, ...) __android_log_print(ANDROID_LOG_INFO, tag, __VA_ARGS__)
+#define ASTRA_LOGW(tag, ...) __android_log_print(ANDROID_LOG_WARN, tag, __VA_ARGS__)
+#define ASTRA_LOGE(tag, ...) __android_log_print(ANDROID_LOG_ERROR, tag, __VA_ARGS__)
+
+#else
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace astra {
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 3, 4)))
+#endif
+inline void HostLog(char level, const char* tag, const char* format, ...) {
+    std::fprintf(stderr, "%c/%s: ", level, tag);
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+}
+
+}  // namespace astra
+
+#define ASTRA_LOGD(tag, ...) ((void) sizeof((::astra::HostLog('D', tag, __VA_ARGS__), 0)))
+#define ASTRA_LOGI(tag, ...) ((void) sizeof((::astra::HostLog('I', tag, __VA_ARGS__), 0)))
+#define ASTRA_LOGW(tag, ...) ::astra::HostLog('W', tag, __VA_ARGS__)
+#define ASTRA_LOGE(tag, ...) ::astra::HostLog('E', tag, __VA_ARGS__)
+
+#endif
+
+#endif  // ASTRASTREAM_ASTRALOG_H
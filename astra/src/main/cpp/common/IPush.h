@@ -3,10 +3,26 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <utility>
 
 #include "IThread.h"
+#include "../stream/EncodedBufferLease.h"
 #include "../stream/FlvMuxer.h"
 
+// Transport-level measurements from engines that have them (SRT). TCP-based RTMP leaves
+// these to the kernel and reports none.
+struct PushLinkStats {
+    int64_t rttUs = 0;
+    uint64_t packetsSent = 0;
+    uint64_t packetsRetransmitted = 0;
+    uint64_t packetsLost = 0;
+    uint64_t packetsDropped = 0;  // given up on because they would arrive too late
+    uint64_t bytesSent = 0;
+    uint64_t receiveRateBps = 0;
+    uint32_t latencyMs = 0;
+};
+
 class IPush : public IThread {
 public:
     ~IPush() override = default;
@@ -16,8 +32,40 @@ public:
     void main() override = 0;
     virtual void configureVideo(const astra::VideoConfig& config) = 0;
     virtual void configureAudio(const astra::AudioConfig& config) = 0;
+    // Encoder switched size or frame rate without a codec change; the stream carries on.
+    virtual void updateVideoConfig(const astra::VideoConfig& /*config*/) {}
     virtual void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) = 0;
     virtual void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) = 0;
+    // Takes ownership of |lease| and returns true when the engine can send straight from the
+    // encoder buffer; otherwise |lease| is left untouched and the caller copies instead.
+    virtual bool pushLeasedVideoFrame(astra::EncodedBufferLease& /*lease*/, int64_t /*pts*/) {
+        return false;
+    }
+    // Queues a finished FLV tag body (audio, video or script data) as-is, bypassing the
+    // muxer. Used to replay recordings; false when the engine cannot take raw tags.
+    virtual bool pushFlvTag(uint8_t /*tagType*/, const uint8_t* /*body*/, size_t /*size*/, uint32_t /*timestamp*/) {
+        return false;
+    }
+    // Fills |stats| while connected; false when the engine has no link statistics.
+    virtual bool linkStats(PushLinkStats& /*stats*/) const {
+        return false;
+    }
+
+    // Where requestKeyFrame() goes; set once, before start().
+    void setKeyFrameRequester(std::function<void(const char* reason)> requester) {
+        keyFrameRequester_ = std::move(requester);
+    }
+
+protected:
+    // The receiver cannot decode until the next key frame: a new connection, or frames lost.
+    void requestKeyFrame(const char* reason) const {
+        if (keyFrameRequester_) {
+            keyFrameRequester_(reason);
+        }
+    }
+
+private:
+    std::function<void(const char* reason)> keyFrameRequester_;
 };
 
 #endif  // ASTRASTREAM_IPUSH_H
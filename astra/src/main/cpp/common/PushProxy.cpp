@@ -1,10 +1,15 @@
 #include "PushProxy.h"
 
-#include <android/log.h>
+#include <cstring>
 #include <string>
 
+#include "AstraLog.h"
+#include "../stream/MediaClock.h"
+
 namespace {
 constexpr const char* kTag = "PushProxy";
+// A live frame this recent means an encoder is running, and a replay would interleave with it.
+constexpr int64_t kLiveIdleUs = 1000 * 1000;
 
 std::string MaskUrl(const char* url) {
     if (url == nullptr) {
@@ -26,10 +31,25 @@ std::string MaskUrl(const char* url) {
     }
     return value.substr(0, separator + 1) + masked;
 }
+
+bool IsSrtUrl(const char* url) {
+    return url != nullptr && strncasecmp(url, "srt://", 6) == 0;
+}
 }  // namespace
 
 IPush* PushProxy::getPushEngine() {
-    return rtmpPush;
+    return pushEngine;
+}
+
+bool PushProxy::liveMutedForReplay() {
+    lastLiveFrameUs.store(astra::MonotonicNowUs(), std::memory_order_relaxed);
+    if (!replaying.load()) {
+        return false;
+    }
+    if (!liveMuted.exchange(true)) {
+        ASTRA_LOGW(kTag, "live frames muted on the primary connection until the replay stops");
+    }
+    return true;
 }
 
 PushProxy::PushProxy() = default;
@@ -40,102 +60,434 @@ PushProxy* PushProxy::getInstance() {
 }
 
 void PushProxy::init(const char* url, JavaCallback** callback) {
-    __android_log_print(ANDROID_LOG_INFO,
-                        kTag,
-                        "init url=%s callback=%p",
-                        MaskUrl(url).c_str(),
-                        callback ? *callback : nullptr);
-    if (rtmpPush) {
-        __android_log_print(ANDROID_LOG_INFO, kTag, "releasing existing rtmpPush=%p", rtmpPush);
-        rtmpPush->stop();
-        delete rtmpPush;
-        rtmpPush = nullptr;
+    ASTRA_LOGI(kTag,
+               "init url=%s callback=%p",
+               MaskUrl(url).c_str(),
+               callback ? *callback : nullptr);
+    if (pushEngine) {
+        ASTRA_LOGI(kTag, "releasing existing engine=%p", pushEngine);
+        pushEngine->stop();
+        delete pushEngine;
+        pushEngine = nullptr;
     }
     if (javaCallback) {
-        __android_log_print(ANDROID_LOG_INFO, kTag, "clearing previous javaCallback=%p", javaCallback);
+        ASTRA_LOGI(kTag, "clearing previous javaCallback=%p", javaCallback);
         delete javaCallback;
         javaCallback = nullptr;
     }
 
     javaCallback = callback ? *callback : nullptr;
-    rtmpPush = new RTMPPush(url, callback);
-    __android_log_print(ANDROID_LOG_INFO, kTag, "rtmpPush created=%p", rtmpPush);
+    if (IsSrtUrl(url)) {
+        pushEngine = new SRTPush(url, callback);
+    } else {
+        pushEngine = new RTMPPush(url, callback);
+    }
+    pushEngine->setKeyFrameRequester([this](const char* reason) { requestKeyFrame(0, reason); });
+    ASTRA_LOGI(kTag, "engine created=%p srt=%d", pushEngine, IsSrtUrl(url) ? 1 : 0);
 
     if (pendingVideoConfig.has_value()) {
-        __android_log_print(ANDROID_LOG_DEBUG, kTag, "applying pending video config after init");
-        rtmpPush->configureVideo(pendingVideoConfig.value());
+        ASTRA_LOGD(kTag, "applying pending video config after init");
+        pushEngine->configureVideo(pendingVideoConfig.value());
     }
     if (pendingAudioConfig.has_value()) {
-        __android_log_print(ANDROID_LOG_DEBUG, kTag, "applying pending audio config after init");
-        rtmpPush->configureAudio(pendingAudioConfig.value());
+        ASTRA_LOGD(kTag, "applying pending audio config after init");
+        pushEngine->configureAudio(pendingAudioConfig.value());
     }
 }
 
 void PushProxy::configureVideo(const astra::VideoConfig& config) {
     pendingVideoConfig = config;
-    __android_log_print(ANDROID_LOG_INFO,
-                        kTag,
-                        "configureVideo -> %ux%u@%u codec=%d",
-                        config.width,
-                        config.height,
-                        config.fps,
-                        static_cast<int>(config.codec));
+    ASTRA_LOGI(kTag,
+               "configureVideo -> %ux%u@%u codec=%d",
+               config.width,
+               config.height,
+               config.fps,
+               static_cast<int>(config.codec));
     if (auto* engine = getPushEngine()) {
         engine->configureVideo(config);
     }
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (recorder) {
+        recorder->configureVideo(config);
+    }
+    if (hlsSegmenter) {
+        hlsSegmenter->configureVideo(config);
+    }
+}
+
+void PushProxy::updateVideoConfig(const astra::VideoConfig& config) {
+    if (pendingVideoConfig.has_value()) {
+        pendingVideoConfig->width = config.width;
+        pendingVideoConfig->height = config.height;
+        pendingVideoConfig->fps = config.fps;
+        pendingVideoConfig->temporalLayers = config.temporalLayers;
+    } else {
+        pendingVideoConfig = config;
+    }
+    ASTRA_LOGI(kTag, "updateVideoConfig -> %ux%u@%u", config.width, config.height, config.fps);
+    if (auto* engine = getPushEngine()) {
+        engine->updateVideoConfig(config);
+    }
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (recorder) {
+        recorder->updateVideoConfig(config);
+    }
+    if (hlsSegmenter) {
+        hlsSegmenter->updateVideoConfig(config);
+    }
 }
 
 void PushProxy::configureAudio(const astra::AudioConfig& config) {
     pendingAudioConfig = config;
-    __android_log_print(ANDROID_LOG_INFO,
-                        kTag,
-                        "configureAudio -> sampleRate=%u channels=%u sampleBits=%u asc=%zu",
-                        config.sampleRate,
-                        config.channels,
-                        config.sampleSizeBits,
-                        config.asc.size());
+    ASTRA_LOGI(kTag,
+               "configureAudio -> sampleRate=%u channels=%u sampleBits=%u asc=%zu",
+               config.sampleRate,
+               config.channels,
+               config.sampleSizeBits,
+               config.asc.size());
     if (auto* engine = getPushEngine()) {
         engine->configureAudio(config);
     }
+    {
+        std::lock_guard<std::mutex> lock(layerMutex);
+        for (auto& entry : layers) {
+            entry.second->configureAudio(config);
+        }
+    }
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (recorder) {
+        recorder->configureAudio(config);
+    }
+    if (hlsSegmenter) {
+        hlsSegmenter->configureAudio(config);
+    }
 }
 
 void PushProxy::start() {
     auto* engine = getPushEngine();
     if (engine) {
-        __android_log_print(ANDROID_LOG_INFO, kTag, "start engine=%p", engine);
+        ASTRA_LOGI(kTag, "start engine=%p", engine);
         engine->start();
     } else {
-        __android_log_print(ANDROID_LOG_WARN, kTag, "start requested but engine unavailable");
+        ASTRA_LOGW(kTag, "start requested but engine unavailable");
     }
 }
 
 void PushProxy::stop() {
+    stopReplay();
+    removeLayers();
     auto* engine = getPushEngine();
     if (engine) {
-        __android_log_print(ANDROID_LOG_INFO, kTag, "stop engine=%p", engine);
+        ASTRA_LOGI(kTag, "stop engine=%p", engine);
         engine->stop();
         delete engine;
-        rtmpPush = nullptr;
+        pushEngine = nullptr;
     }
     if (javaCallback) {
-        __android_log_print(ANDROID_LOG_INFO, kTag, "release javaCallback=%p", javaCallback);
+        ASTRA_LOGI(kTag, "release javaCallback=%p", javaCallback);
         delete javaCallback;
         javaCallback = nullptr;
     }
 }
 
 void PushProxy::pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) {
+    bool recorded = false;
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        if (recorder) {
+            recorder->pushVideoFrame(data, length, pts);
+            recorded = true;
+        }
+        if (hlsSegmenter) {
+            hlsSegmenter->pushVideoFrame(data, length, pts);
+            recorded = true;
+        }
+    }
+    if (liveMutedForReplay()) {
+        return;
+    }
     if (auto* engine = getPushEngine()) {
         engine->pushVideoFrame(data, length, pts);
-    } else {
-        __android_log_print(ANDROID_LOG_WARN, kTag, "drop video frame length=%zu pts=%lld: engine missing", length, static_cast<long long>(pts));
+    } else if (!recorded) {
+        ASTRA_LOGW(kTag, "drop video frame length=%zu pts=%lld: engine missing", length, static_cast<long long>(pts));
     }
 }
 
 void PushProxy::pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) {
+    bool recorded = false;
+    {
+        // One audio encode feeds every simulcast layer.
+        std::lock_guard<std::mutex> lock(layerMutex);
+        for (auto& entry : layers) {
+            entry.second->pushAudioFrame(data, length, pts);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        if (recorder) {
+            recorder->pushAudioFrame(data, length, pts);
+            recorded = true;
+        }
+        if (hlsSegmenter) {
+            hlsSegmenter->pushAudioFrame(data, length, pts);
+            recorded = true;
+        }
+    }
+    if (liveMutedForReplay()) {
+        return;
+    }
     if (auto* engine = getPushEngine()) {
         engine->pushAudioFrame(data, length, pts);
+    } else if (!recorded) {
+        ASTRA_LOGW(kTag, "drop audio frame length=%zu pts=%lld: engine missing", length, static_cast<long long>(pts));
+    }
+}
+
+bool PushProxy::pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts) {
+    {
+        // Local sinks parse Annex-B, which the in-place rewrite destroys: take the copy path.
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        if (recorder || hlsSegmenter) {
+            return false;
+        }
+    }
+    if (liveMutedForReplay()) {
+        lease.reset();  // taken and dropped; a copy would be muted as well
+        return true;
+    }
+    if (auto* engine = getPushEngine()) {
+        return engine->pushLeasedVideoFrame(lease, pts);
+    }
+    return false;
+}
+
+bool PushProxy::linkStats(PushLinkStats& stats) {
+    auto* engine = getPushEngine();
+    return engine != nullptr && engine->linkStats(stats);
+}
+
+void PushProxy::setKeyFrameHandler(uint32_t layer, std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(keyFrameMutex);
+    if (handler) {
+        keyFrameHandlers[layer] = std::move(handler);
     } else {
-        __android_log_print(ANDROID_LOG_WARN, kTag, "drop audio frame length=%zu pts=%lld: engine missing", length, static_cast<long long>(pts));
+        keyFrameHandlers.erase(layer);
+    }
+}
+
+void PushProxy::requestKeyFrame(uint32_t layer, const char* reason) {
+    std::lock_guard<std::mutex> lock(keyFrameMutex);
+    const auto it = keyFrameHandlers.find(layer);
+    if (it == keyFrameHandlers.end()) {
+        return;
+    }
+    ASTRA_LOGD(kTag, "key frame requested layer=%u: %s", layer, reason);
+    it->second();
+}
+
+bool PushProxy::addLayer(uint32_t layer, const char* url) {
+    if (layer == 0 || url == nullptr) {
+        ASTRA_LOGW(kTag, "addLayer needs a layer above 0 and a url");
+        return false;
+    }
+    removeLayer(layer);
+    std::unique_ptr<IPush> engine;
+    if (IsSrtUrl(url)) {
+        engine = std::make_unique<SRTPush>(url, nullptr);
+    } else {
+        engine = std::make_unique<RTMPPush>(url, nullptr);
+    }
+    if (pendingAudioConfig.has_value()) {
+        engine->configureAudio(pendingAudioConfig.value());
+    }
+    engine->setKeyFrameRequester([this, layer](const char* reason) { requestKeyFrame(layer, reason); });
+    engine->start();
+    ASTRA_LOGI(kTag, "addLayer %u url=%s srt=%d", layer, MaskUrl(url).c_str(), IsSrtUrl(url) ? 1 : 0);
+    std::lock_guard<std::mutex> lock(layerMutex);
+    layers[layer] = std::move(engine);
+    return true;
+}
+
+void PushProxy::removeLayer(uint32_t layer) {
+    std::unique_ptr<IPush> previous;
+    {
+        std::lock_guard<std::mutex> lock(layerMutex);
+        const auto it = layers.find(layer);
+        if (it == layers.end()) {
+            return;
+        }
+        previous = std::move(it->second);
+        layers.erase(it);
+    }
+    // Joins the sender thread: not under the lock the encoders take.
+    previous->stop();
+    ASTRA_LOGI(kTag, "removeLayer %u", layer);
+}
+
+void PushProxy::removeLayers() {
+    std::map<uint32_t, std::unique_ptr<IPush>> previous;
+    {
+        std::lock_guard<std::mutex> lock(layerMutex);
+        previous.swap(layers);
+    }
+    for (auto& entry : previous) {
+        entry.second->stop();
+    }
+}
+
+void PushProxy::configureLayerVideo(uint32_t layer, const astra::VideoConfig& config) {
+    if (layer == 0) {
+        configureVideo(config);
+        return;
+    }
+    ASTRA_LOGI(kTag, "configureLayerVideo %u -> %ux%u@%u", layer, config.width, config.height, config.fps);
+    std::lock_guard<std::mutex> lock(layerMutex);
+    const auto it = layers.find(layer);
+    if (it == layers.end()) {
+        ASTRA_LOGW(kTag, "configureLayerVideo: layer %u has no connection", layer);
+        return;
+    }
+    it->second->configureVideo(config);
+}
+
+void PushProxy::updateLayerVideoConfig(uint32_t layer, const astra::VideoConfig& config) {
+    if (layer == 0) {
+        updateVideoConfig(config);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(layerMutex);
+    const auto it = layers.find(layer);
+    if (it != layers.end()) {
+        it->second->updateVideoConfig(config);
+    }
+}
+
+void PushProxy::pushLayerVideoFrame(uint32_t layer, const uint8_t* data, size_t length, int64_t pts) {
+    if (layer == 0) {
+        pushVideoFrame(data, length, pts);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(layerMutex);
+    const auto it = layers.find(layer);
+    if (it != layers.end()) {
+        it->second->pushVideoFrame(data, length, pts);
+    }
+}
+
+bool PushProxy::pushLeasedLayerVideoFrame(uint32_t layer, astra::EncodedBufferLease& lease, int64_t pts) {
+    if (layer == 0) {
+        return pushLeasedVideoFrame(lease, pts);
+    }
+    std::lock_guard<std::mutex> lock(layerMutex);
+    const auto it = layers.find(layer);
+    return it != layers.end() && it->second->pushLeasedVideoFrame(lease, pts);
+}
+
+bool PushProxy::startRecording(const char* path) {
+    if (path == nullptr) {
+        return false;
+    }
+    auto next = std::make_unique<FlvRecorder>();
+    if (pendingVideoConfig.has_value()) {
+        next->configureVideo(pendingVideoConfig.value());
+    }
+    if (pendingAudioConfig.has_value()) {
+        next->configureAudio(pendingAudioConfig.value());
+    }
+    if (!next->start(path)) {
+        ASTRA_LOGE(kTag, "startRecording failed path=%s", path);
+        return false;
+    }
+    stopRecording();
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    recorder = std::move(next);
+    ASTRA_LOGI(kTag, "startRecording path=%s", path);
+    requestKeyFrame(0, "recording started");  // the file starts at a key frame
+    return true;
+}
+
+bool PushProxy::stopRecording() {
+    std::unique_ptr<FlvRecorder> previous;
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        previous = std::move(recorder);
+    }
+    // Final flush and metadata patch run here, not under the lock the encoders take.
+    return previous ? previous->stop() : true;
+}
+
+bool PushProxy::startHls(const char* directory, const HlsSegmenter::Options& options) {
+    if (directory == nullptr) {
+        return false;
+    }
+    auto next = std::make_unique<HlsSegmenter>();
+    if (pendingVideoConfig.has_value()) {
+        next->configureVideo(pendingVideoConfig.value());
+    }
+    if (pendingAudioConfig.has_value()) {
+        next->configureAudio(pendingAudioConfig.value());
+    }
+    if (!next->start(directory, options)) {
+        ASTRA_LOGE(kTag, "startHls failed directory=%s", directory);
+        return false;
+    }
+    stopHls();
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    hlsSegmenter = std::move(next);
+    ASTRA_LOGI(kTag, "startHls directory=%s", directory);
+    requestKeyFrame(0, "hls started");  // the first segment starts at a key frame
+    return true;
+}
+
+void PushProxy::stopHls() {
+    std::unique_ptr<HlsSegmenter> previous;
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        previous = std::move(hlsSegmenter);
+    }
+    if (previous) {
+        previous->stop();
+    }
+}
+
+bool PushProxy::startReplay(const char* path, double speed, uint32_t loops) {
+    stopReplay();
+    if (path == nullptr || getPushEngine() == nullptr) {
+        ASTRA_LOGW(kTag, "startReplay requires a path and a connected engine");
+        return false;
+    }
+    const int64_t lastLiveUs = lastLiveFrameUs.load(std::memory_order_relaxed);
+    if (lastLiveUs != 0 && astra::MonotonicNowUs() - lastLiveUs < kLiveIdleUs) {
+        ASTRA_LOGW(kTag, "startReplay refused: live encoders are sending to the same connection");
+        return false;
+    }
+    replayer = std::make_unique<astra::FlvReplayer>(
+            [this](uint8_t tagType, const uint8_t* body, size_t size, uint32_t timestamp) {
+                if (auto* engine = getPushEngine()) {
+                    engine->pushFlvTag(tagType, body, size, timestamp);
+                }
+            });
+    astra::FlvReplayer::Options options;
+    options.speed = speed;
+    options.loops = loops;
+    liveMuted = false;
+    replaying = true;
+    if (!replayer->start(path, options)) {
+        replayer.reset();
+        replaying = false;
+        return false;
+    }
+    ASTRA_LOGI(kTag, "startReplay path=%s speed=%.2f loops=%u", path, speed, loops);
+    return true;
+}
+
+void PushProxy::stopReplay() {
+    if (replayer) {
+        replayer->stop();
+        replayer.reset();
+    }
+    replaying = false;
+    if (liveMuted.exchange(false)) {
+        requestKeyFrame(0, "replay stopped");  // live resumes mid-GOP otherwise
     }
 }
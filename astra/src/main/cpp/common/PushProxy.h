@@ -1,11 +1,20 @@
 #ifndef ASTRASTREAM_PUSHPROXY_H
 #define ASTRASTREAM_PUSHPROXY_H
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 
+#include "../push/FlvRecorder.h"
+#include "../push/HlsSegmenter.h"
 #include "../push/RTMPPush.h"
+#include "../push/SRTPush.h"
 #include "IPush.h"
+#include "../stream/FlvReplayer.h"
 
 class PushProxy {
 public:
@@ -14,20 +23,69 @@ public:
     void init(const char* url, JavaCallback** javaCallback);
     void configureVideo(const astra::VideoConfig& config);
     void configureAudio(const astra::AudioConfig& config);
+    // Live encoder switch (same codec): sinks keep their connection and files.
+    void updateVideoConfig(const astra::VideoConfig& config);
     void start();
     void stop();
     void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts);
     void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts);
+    bool pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts);
+    bool linkStats(PushLinkStats& stats);
+
+    // Key frames on demand. The encoder feeding |layer| registers a handler (nullptr removes
+    // it); engines and local sinks that need a key frame to start or recover ask through
+    // requestKeyFrame. The handler runs on the asking thread and must only flag the request.
+    void setKeyFrameHandler(uint32_t layer, std::function<void()> handler);
+    void requestKeyFrame(uint32_t layer, const char* reason);
+
+    // Simulcast: further renditions, each with its own muxer and connection to |url|. Layer 0
+    // is the stream set up by init() and is not added here. Audio frames go to every layer.
+    // Connection events of extra layers are logged only; the Java callback belongs to layer 0.
+    bool addLayer(uint32_t layer, const char* url);
+    void removeLayer(uint32_t layer);
+    void removeLayers();
+    // The layer-aware forms of the calls above; layer 0 takes the primary path.
+    void configureLayerVideo(uint32_t layer, const astra::VideoConfig& config);
+    void updateLayerVideoConfig(uint32_t layer, const astra::VideoConfig& config);
+    void pushLayerVideoFrame(uint32_t layer, const uint8_t* data, size_t length, int64_t pts);
+    bool pushLeasedLayerVideoFrame(uint32_t layer, astra::EncodedBufferLease& lease, int64_t pts);
+
+    // Records to an FLV file next to (or without) the live push, from the configured streams.
+    bool startRecording(const char* path);
+    bool stopRecording();
+
+    // Writes a rolling LL-HLS window into |directory| for pull-based ingest.
+    bool startHls(const char* directory, const HlsSegmenter::Options& options);
+    void stopHls();
+
+    // Feeds an FLV recording through the sender in place of the encoders, for reproducing
+    // captured streams and as a repeatable load. |speed| 0 sends as fast as the queue takes it.
+    // Refused while live frames are arriving; encoders started during a replay are muted on
+    // the primary connection until stopReplay(), which then asks them for a key frame.
+    bool startReplay(const char* path, double speed, uint32_t loops);
+    void stopReplay();
 
 private:
     PushProxy();
 
     IPush* getPushEngine();
+    bool liveMutedForReplay();  // records live activity; true while a replay owns the engine
 
-    RTMPPush* rtmpPush = nullptr;
+    IPush* pushEngine = nullptr;  // RTMPPush, or SRTPush for srt:// urls
     JavaCallback* javaCallback = nullptr;
     std::optional<astra::VideoConfig> pendingVideoConfig;
     std::optional<astra::AudioConfig> pendingAudioConfig;
+    std::mutex sinkMutex;  // guards the local sinks below against the encoder threads
+    std::unique_ptr<FlvRecorder> recorder;
+    std::unique_ptr<HlsSegmenter> hlsSegmenter;
+    std::unique_ptr<astra::FlvReplayer> replayer;
+    std::atomic<bool> replaying{false};
+    std::atomic<bool> liveMuted{false};  // a live frame was dropped during this replay
+    std::atomic<int64_t> lastLiveFrameUs{0};
+    std::mutex layerMutex;  // guards |layers| against the encoder threads
+    std::map<uint32_t, std::unique_ptr<IPush>> layers;  // simulcast layers 1..N
+    std::mutex keyFrameMutex;  // held while a handler runs, so removing one waits it out
+    std::map<uint32_t, std::function<void()>> keyFrameHandlers;
 };
 
 #endif  // ASTRASTREAM_PUSHPROXY_H
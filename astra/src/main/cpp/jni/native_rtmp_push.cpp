@@ -94,6 +94,37 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     PushProxy::getInstance()->stop();
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeConnectLayer(
+        JNIEnv* env, jclass, jlong handle, jint layer, jstring url) {
+    if (url == nullptr || layer <= 0) {
+        return JNI_FALSE;
+    }
+    const char* layerUrl = env->GetStringUTFChars(url, nullptr);
+    __android_log_print(ANDROID_LOG_INFO,
+                        kTag,
+                        "nativeConnectLayer handle=%lld layer=%d url=%s",
+                        static_cast<long long>(handle),
+                        layer,
+                        MaskUrl(layerUrl).c_str());
+    const bool added = PushProxy::getInstance()->addLayer(static_cast<uint32_t>(layer), layerUrl);
+    env->ReleaseStringUTFChars(url, layerUrl);
+    return added ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeDisconnectLayer(
+        JNIEnv*, jclass, jlong handle, jint layer) {
+    __android_log_print(ANDROID_LOG_INFO,
+                        kTag,
+                        "nativeDisconnectLayer handle=%lld layer=%d",
+                        static_cast<long long>(handle),
+                        layer);
+    if (layer > 0) {
+        PushProxy::getInstance()->removeLayer(static_cast<uint32_t>(layer));
+    }
+}
+
 JNIEXPORT void JNICALL
 Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeConfigureVideo(
         JNIEnv*, jclass, jlong handle, jint width, jint height, jint fps, jint codecOrdinal) {
@@ -109,7 +140,11 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     config.width = static_cast<uint32_t>(std::max(0, width));
     config.height = static_cast<uint32_t>(std::max(0, height));
     config.fps = static_cast<uint32_t>(std::max(0, fps));
-    config.codec = codecOrdinal == 0 ? astra::VideoCodecId::kH264 : astra::VideoCodecId::kH265;
+    switch (codecOrdinal) {
+        case 0: config.codec = astra::VideoCodecId::kH264; break;
+        case 2: config.codec = astra::VideoCodecId::kAv1; break;
+        default: config.codec = astra::VideoCodecId::kH265; break;
+    }
     PushProxy::getInstance()->configureVideo(config);
 }
 
@@ -174,4 +209,57 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     PushProxy::getInstance()->pushAudioFrame(base + offset, static_cast<size_t>(size), static_cast<int64_t>(pts));
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStartReplay(
+        JNIEnv* env, jclass, jlong handle, jstring path, jdouble speed, jint loops) {
+    if (path == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* filePath = env->GetStringUTFChars(path, nullptr);
+    __android_log_print(ANDROID_LOG_INFO,
+                        kTag,
+                        "nativeStartReplay handle=%lld path=%s speed=%.2f loops=%d",
+                        static_cast<long long>(handle),
+                        filePath,
+                        speed,
+                        loops);
+    const bool started = PushProxy::getInstance()->startReplay(
+            filePath, std::max(0.0, static_cast<double>(speed)), static_cast<uint32_t>(std::max(0, loops)));
+    env->ReleaseStringUTFChars(path, filePath);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStopReplay(
+        JNIEnv*, jclass, jlong handle) {
+    __android_log_print(ANDROID_LOG_INFO, kTag, "nativeStopReplay handle=%lld", static_cast<long long>(handle));
+    PushProxy::getInstance()->stopReplay();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeGetLinkStats(
+        JNIEnv* env, jclass, jlong /*handle*/) {
+    PushLinkStats stats;
+    if (!PushProxy::getInstance()->linkStats(stats)) {
+        return nullptr;
+    }
+    const jlong values[8] = {
+            static_cast<jlong>(stats.rttUs),
+            static_cast<jlong>(stats.packetsSent),
+            static_cast<jlong>(stats.packetsRetransmitted),
+            static_cast<jlong>(stats.packetsLost),
+            static_cast<jlong>(stats.packetsDropped),
+            static_cast<jlong>(stats.bytesSent),
+            static_cast<jlong>(stats.receiveRateBps),
+            static_cast<jlong>(stats.latencyMs),
+    };
+    jlongArray array = env->NewLongArray(8);
+    if (!array) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to allocate link stats array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(array, 0, 8, values);
+    return array;
+}
+
 }  // extern "C"
@@ -36,7 +36,11 @@ int SanitizeBitrate(int value, int fallback) {
 }
 
 astra::VideoCodecId ResolveCodec(int codecOrdinal) {
-    return codecOrdinal == 1 ? astra::VideoCodecId::kH265 : astra::VideoCodecId::kH264;
+    switch (codecOrdinal) {
+        case 1: return astra::VideoCodecId::kH265;
+        case 2: return astra::VideoCodecId::kAv1;
+        default: return astra::VideoCodecId::kH264;
+    }
 }
 
 }  // namespace
@@ -57,7 +61,8 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
         jint videoFps,
         jint videoBitrateKbps,
         jint iframeInterval,
-        jint codecOrdinal) {
+        jint codecOrdinal,
+        jint temporalLayers) {
     const int sanitizedSampleRate = SanitizeSampleRate(sampleRate);
     const int sanitizedChannels = SanitizeChannels(channels);
     const int sanitizedBytesPerSample = SanitizeBytesPerSample(bytesPerSample);
@@ -80,8 +85,11 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     PushProxy::getInstance()->configureVideo(videoConfig);
     NativeStreamEngine::Instance().updateVideoBitrate(
             SanitizeBitrate(videoBitrateKbps, 1000));
-    const int sanitizedIframe = std::max(iframeInterval, 1);
-    (void) sanitizedIframe;  // iframe interval applied when preparing video surface
+    // The encoder itself is created when the surface is prepared; warm one up for it now.
+    NativeStreamEngine::Instance().warmUpVideo(videoConfig,
+                                               SanitizeBitrate(videoBitrateKbps, 1000),
+                                               std::max(iframeInterval, 1),
+                                               static_cast<uint32_t>(std::max(temporalLayers, 1)));
 }
 
 JNIEXPORT void JNICALL
@@ -122,4 +130,57 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     NativeAudioCapturer::Instance().setMute(muted == JNI_TRUE);
 }
 
+JNIEXPORT jobject JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeGetAudioLevelBuffer(
+        JNIEnv* env, jclass, jlong /*handle*/) {
+    return env->NewDirectByteBuffer(NativeAudioCapturer::Instance().levelSnapshot(),
+                                    static_cast<jlong>(astra::LevelMeter::kSnapshotBytes));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStartRecording(
+        JNIEnv* env, jclass, jlong /*handle*/, jstring path) {
+    if (path == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* filePath = env->GetStringUTFChars(path, nullptr);
+    const bool started = PushProxy::getInstance()->startRecording(filePath);
+    env->ReleaseStringUTFChars(path, filePath);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStopRecording(
+        JNIEnv*, jclass, jlong /*handle*/) {
+    return PushProxy::getInstance()->stopRecording() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStartHls(
+        JNIEnv* env,
+        jclass,
+        jlong /*handle*/,
+        jstring directory,
+        jint partDurationMs,
+        jint segmentDurationMs,
+        jint windowSegments) {
+    if (directory == nullptr) {
+        return JNI_FALSE;
+    }
+    HlsSegmenter::Options options;
+    options.partDurationMs = static_cast<uint32_t>(std::max(0, partDurationMs));
+    options.segmentDurationMs = static_cast<uint32_t>(std::max(0, segmentDurationMs));
+    options.windowSegments = static_cast<uint32_t>(std::max(0, windowSegments));
+    const char* path = env->GetStringUTFChars(directory, nullptr);
+    const bool started = PushProxy::getInstance()->startHls(path, options);
+    env->ReleaseStringUTFChars(directory, path);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeStopHls(
+        JNIEnv*, jclass, jlong /*handle*/) {
+    PushProxy::getInstance()->stopHls();
+}
+
 }  // extern "C"
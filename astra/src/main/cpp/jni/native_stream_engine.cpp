@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <android/log.h>
+#include <cmath>
 
 #include "../codec/NativeStreamEngine.h"
 
@@ -16,7 +17,11 @@ uint32_t SanitizeDimension(int value) {
 }
 
 astra::VideoCodecId ResolveCodec(int codecOrdinal) {
-    return codecOrdinal == 1 ? astra::VideoCodecId::kH265 : astra::VideoCodecId::kH264;
+    switch (codecOrdinal) {
+        case 1: return astra::VideoCodecId::kH265;
+        case 2: return astra::VideoCodecId::kAv1;
+        default: return astra::VideoCodecId::kH264;
+    }
 }
 
 }  // namespace
@@ -33,7 +38,9 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
         jint fps,
         jint bitrateKbps,
         jint iframeInterval,
-        jint codecOrdinal) {
+        jint codecOrdinal,
+        jboolean zeroCopyOutput,
+        jint temporalLayers) {
     astra::VideoConfig config;
     config.width = SanitizeDimension(width);
     config.height = SanitizeDimension(height);
@@ -43,7 +50,9 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
             env,
             config,
             std::max(bitrateKbps, 100),
-            std::max(iframeInterval, 1));
+            std::max(iframeInterval, 1),
+            zeroCopyOutput == JNI_TRUE,
+            static_cast<uint32_t>(std::max(temporalLayers, 1)));
     if (!surface) {
         __android_log_print(ANDROID_LOG_ERROR, kTag, "prepareVideoSurface failed");
     }
@@ -74,6 +83,91 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     NativeStreamEngine::Instance().updateVideoBitrate(std::max(bitrateKbps, 100));
 }
 
+JNIEXPORT jobject JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativePrepareVideoLayer(
+        JNIEnv* env,
+        jclass,
+        jlong /*handle*/,
+        jint layer,
+        jint width,
+        jint height,
+        jint fps,
+        jint bitrateKbps,
+        jint iframeInterval,
+        jint codecOrdinal,
+        jboolean zeroCopyOutput,
+        jint temporalLayers) {
+    if (layer <= 0) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "prepareVideoLayer: layer %d is not a simulcast layer", layer);
+        return nullptr;
+    }
+    astra::VideoConfig config;
+    config.width = SanitizeDimension(width);
+    config.height = SanitizeDimension(height);
+    config.fps = static_cast<uint32_t>(std::max(fps, 1));
+    config.codec = ResolveCodec(codecOrdinal);
+    auto surface = NativeStreamEngine::Instance().prepareVideoLayer(
+            env,
+            static_cast<uint32_t>(layer),
+            config,
+            std::max(bitrateKbps, 100),
+            std::max(iframeInterval, 1),
+            zeroCopyOutput == JNI_TRUE,
+            static_cast<uint32_t>(std::max(temporalLayers, 1)));
+    if (!surface) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "prepareVideoLayer %d failed", layer);
+    }
+    return surface;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeReleaseVideoLayer(
+        JNIEnv*, jclass, jlong /*handle*/, jint layer) {
+    if (layer > 0) {
+        NativeStreamEngine::Instance().releaseVideoLayer(static_cast<uint32_t>(layer));
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeUpdateVideoLayerBitrate(
+        JNIEnv*, jclass, jlong /*handle*/, jint layer, jint bitrateKbps) {
+    NativeStreamEngine::Instance().updateVideoLayerBitrate(static_cast<uint32_t>(std::max(layer, 0)),
+                                                           std::max(bitrateKbps, 100));
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativePrepareVideoReconfigure(
+        JNIEnv* env,
+        jclass,
+        jlong /*handle*/,
+        jint width,
+        jint height,
+        jint fps,
+        jint bitrateKbps,
+        jint iframeInterval,
+        jint codecOrdinal) {
+    astra::VideoConfig config;
+    config.width = SanitizeDimension(width);
+    config.height = SanitizeDimension(height);
+    config.fps = static_cast<uint32_t>(std::max(fps, 1));
+    config.codec = ResolveCodec(codecOrdinal);
+    auto surface = NativeStreamEngine::Instance().prepareVideoReconfigure(
+            env,
+            config,
+            std::max(bitrateKbps, 100),
+            std::max(iframeInterval, 1));
+    if (!surface) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "prepareVideoReconfigure failed");
+    }
+    return surface;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeCommitVideoReconfigure(
+        JNIEnv*, jclass, jlong /*handle*/) {
+    return NativeStreamEngine::Instance().commitVideoReconfigure() ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT void JNICALL
 Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeConfigureAudioEncoder(
         JNIEnv*, jclass, jlong /*handle*/, jint sampleRate, jint channels, jint bitrateKbps,
@@ -97,4 +191,89 @@ Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nati
     NativeStreamEngine::Instance().stopAudio();
 }
 
+JNIEXPORT jlongArray JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeGetAudioPipelineStats(
+        JNIEnv* env, jclass, jlong /*handle*/) {
+    const auto stats = NativeStreamEngine::Instance().audioPipelineStats();
+    const jlong values[6] = {
+            static_cast<jlong>(stats.overruns),
+            static_cast<jlong>(stats.droppedFrames),
+            static_cast<jlong>(stats.underruns),
+            static_cast<jlong>(stats.bufferedFrames),
+            static_cast<jlong>(stats.clockDriftPpm * 1000.0),  // parts per billion
+            static_cast<jlong>(stats.dtxFrames),
+    };
+    jlongArray array = env->NewLongArray(6);
+    if (!array) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to allocate audio stats array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(array, 0, 6, values);
+    return array;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeSetAudioDtx(
+        JNIEnv*, jclass, jlong /*handle*/, jboolean enabled, jfloat silenceThresholdDbfs) {
+    // dBFS to the largest int16 magnitude still counted as silence.
+    const double peak = 32768.0 * std::pow(10.0, static_cast<double>(silenceThresholdDbfs) / 20.0);
+    NativeStreamEngine::Instance().setAudioDtx(
+            enabled == JNI_TRUE, static_cast<int32_t>(std::min(std::max(peak, 0.0), 32767.0)));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeAddAudioSource(
+        JNIEnv*, jclass, jlong /*handle*/, jint sampleRate, jint channels, jint kindOrdinal) {
+    const auto kind = kindOrdinal == 1 ? astra::MixerSourceKind::kClip : astra::MixerSourceKind::kStream;
+    return NativeStreamEngine::Instance().addAudioSource(
+            std::max(sampleRate, 8000),
+            std::min(std::max(channels, 1), 2),
+            kind);
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeRemoveAudioSource(
+        JNIEnv*, jclass, jlong /*handle*/, jint sourceId) {
+    NativeStreamEngine::Instance().removeAudioSource(sourceId);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativePushAudioSourcePcm(
+        JNIEnv* env, jclass, jlong /*handle*/, jint sourceId, jobject buffer, jint offset, jint size) {
+    auto* base = buffer ? static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer)) : nullptr;
+    const jlong capacity = buffer ? env->GetDirectBufferCapacity(buffer) : -1;
+    if (!base || offset < 0 || size <= 0 || static_cast<jlong>(offset) + size > capacity) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "pushAudioSourcePcm needs a direct buffer in range");
+        return JNI_FALSE;
+    }
+    const bool accepted = NativeStreamEngine::Instance().pushAudioSourcePcm(
+            sourceId, base + offset, static_cast<std::size_t>(size));
+    return accepted ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeSetAudioSourceGain(
+        JNIEnv*, jclass, jlong /*handle*/, jint sourceId, jfloat gain) {
+    NativeStreamEngine::Instance().setAudioSourceGain(sourceId, gain);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_astra_avpush_infrastructure_stream_nativebridge_NativeSenderBridge_nativeGetAudioSourceStats(
+        JNIEnv* env, jclass, jlong /*handle*/, jint sourceId) {
+    const auto stats = NativeStreamEngine::Instance().audioSourceStats(sourceId);
+    const jlong values[4] = {
+            static_cast<jlong>(stats.overruns),
+            static_cast<jlong>(stats.underruns),
+            static_cast<jlong>(stats.driftPpm * 1000.0),  // parts per billion
+            static_cast<jlong>(stats.bufferedFrames),
+    };
+    jlongArray array = env->NewLongArray(4);
+    if (!array) {
+        __android_log_print(ANDROID_LOG_ERROR, kTag, "Failed to allocate audio source stats array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(array, 0, 4, values);
+    return array;
+}
+
 }  // extern "C"
@@ -68,6 +68,16 @@ Java_com_astra_avpush_infrastructure_camera_renderer_EncodeRenderer_nativeOnDraw
     renderer->draw();
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_astra_avpush_infrastructure_camera_renderer_EncodeRenderer_nativeOnDrawLayer(
+        JNIEnv* /*env*/, jobject /*thiz*/, jlong handle, jint width, jint height) {
+    auto* renderer = fromHandle<EncodeRendererNative>(handle);
+    if (renderer == nullptr) {
+        return;
+    }
+    renderer->drawLayer(width, height);
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_astra_avpush_infrastructure_camera_renderer_EncodeRenderer_nativeApplyWatermark(
         JNIEnv* env, jobject /*thiz*/, jlong handle, jobject bitmap, jfloatArray coords_array,
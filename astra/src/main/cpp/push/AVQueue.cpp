@@ -1,6 +1,11 @@
 #include "AVQueue.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
+#include <utility>
+
+#include "../stream/MediaClock.h"
 
 AVQueue::AVQueue() {
     pthread_mutex_init(&mutexPacket, nullptr);
@@ -13,39 +18,58 @@ AVQueue::~AVQueue() {
     pthread_cond_destroy(&condPacket);
 }
 
-int AVQueue::putRtmpPacket(RTMPPacket* packet) {
+int AVQueue::putRtmpPacket(RTMPPacket* packet, uint8_t temporalId) {
+    if (packet == nullptr) {
+        return -1;
+    }
+    Entry entry;
+    entry.packet = packet;
+    entry.temporalId = temporalId;
+    put(std::move(entry));
+    return 0;
+}
+
+int AVQueue::putLeasedPacket(std::unique_ptr<LeasedVideoPacket> packet, uint8_t temporalId) {
     if (packet == nullptr) {
         return -1;
     }
+    Entry entry;
+    entry.leased = std::move(packet);
+    entry.temporalId = temporalId;
+    put(std::move(entry));
+    return 0;
+}
+
+void AVQueue::put(Entry entry) {
+    entry.queuedUs = astra::MonotonicNowUs();
     pthread_mutex_lock(&mutexPacket);
-    queuePacket.push(packet);
+    queuePacket.push_back(std::move(entry));
     pthread_cond_signal(&condPacket);
     pthread_mutex_unlock(&mutexPacket);
-    return 0;
 }
 
-RTMPPacket* AVQueue::getRtmpPacket() {
+AVQueue::Entry AVQueue::getPacket() {
     pthread_mutex_lock(&mutexPacket);
-    RTMPPacket* packet = nullptr;
+    Entry entry;
     if (!queuePacket.empty()) {
-        packet = queuePacket.front();
-        queuePacket.pop();
+        entry = std::move(queuePacket.front());
+        queuePacket.pop_front();
     } else {
         pthread_cond_wait(&condPacket, &mutexPacket);
     }
     pthread_mutex_unlock(&mutexPacket);
-    return packet;
+    return entry;
 }
 
 void AVQueue::clearQueue() {
+    std::deque<Entry> pending;
     pthread_mutex_lock(&mutexPacket);
-    while (!queuePacket.empty()) {
-        RTMPPacket* packet = queuePacket.front();
-        queuePacket.pop();
-        RTMPPacket_Free(packet);
-        std::free(packet);
-    }
+    std::swap(pending, queuePacket);
     pthread_mutex_unlock(&mutexPacket);
+    // Leased buffers go back to the encoder outside the queue lock.
+    for (Entry& entry : pending) {
+        release(entry);
+    }
 }
 
 void AVQueue::notifyQueue() {
@@ -53,3 +77,35 @@ void AVQueue::notifyQueue() {
     pthread_cond_signal(&condPacket);
     pthread_mutex_unlock(&mutexPacket);
 }
+
+int64_t AVQueue::backlogUs() {
+    pthread_mutex_lock(&mutexPacket);
+    const int64_t queuedUs = queuePacket.empty() ? 0 : queuePacket.front().queuedUs;
+    pthread_mutex_unlock(&mutexPacket);
+    return queuedUs > 0 ? astra::MonotonicNowUs() - queuedUs : 0;
+}
+
+size_t AVQueue::shedTemporalLayers(uint8_t temporalId) {
+    std::deque<Entry> shed;
+    pthread_mutex_lock(&mutexPacket);
+    // Only layers above 0 are ever tagged, so audio and headers (layer 0) always stay.
+    const auto kept = std::stable_partition(queuePacket.begin(), queuePacket.end(), [temporalId](const Entry& entry) {
+        return entry.temporalId == 0 || entry.temporalId < temporalId;
+    });
+    std::move(kept, queuePacket.end(), std::back_inserter(shed));
+    queuePacket.erase(kept, queuePacket.end());
+    pthread_mutex_unlock(&mutexPacket);
+    for (Entry& entry : shed) {
+        release(entry);
+    }
+    return shed.size();
+}
+
+void AVQueue::release(Entry& entry) {
+    if (entry.packet) {
+        RTMPPacket_Free(entry.packet);
+        std::free(entry.packet);
+        entry.packet = nullptr;
+    }
+    entry.leased.reset();
+}
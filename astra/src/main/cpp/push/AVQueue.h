@@ -2,24 +2,59 @@
 #define ASTRASTREAM_AVQUEUE_H
 
 #include <pthread.h>
-#include <queue>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "../stream/EncodedBufferLease.h"
+#include "../stream/FlvMuxer.h"
 
 extern "C" {
 #include "../librtmp/include/rtmp.h"
 }
 
+// Video message whose NAL payload still lives in a leased encoder output buffer.
+struct LeasedVideoPacket {
+    astra::EncodedBufferLease lease;
+    std::array<uint8_t, 5> tagHeader{};
+    std::vector<astra::ByteSpan> body;  // tagHeader followed by the in-place NAL runs
+    const uint8_t* leaseBase = nullptr;  // lease.data() when body was built; see sendLeasedPacket
+    uint32_t timestamp = 0;
+};
+
 class AVQueue {
 public:
+    struct Entry {
+        RTMPPacket* packet = nullptr;
+        std::unique_ptr<LeasedVideoPacket> leased;
+        int64_t queuedUs = 0;
+        uint8_t temporalId = 0;  // video only; see ParsedVideoFrame::temporalId
+
+        explicit operator bool() const { return packet != nullptr || leased != nullptr; }
+    };
+
     AVQueue();
     ~AVQueue();
 
-    int putRtmpPacket(RTMPPacket* packet);
-    RTMPPacket* getRtmpPacket();
+    int putRtmpPacket(RTMPPacket* packet, uint8_t temporalId = 0);
+    int putLeasedPacket(std::unique_ptr<LeasedVideoPacket> packet, uint8_t temporalId = 0);
+    Entry getPacket();
     void clearQueue();
     void notifyQueue();
+    // Time the oldest queued packet has waited; 0 when the queue is empty.
+    int64_t backlogUs();
+    // Removes queued video of temporal layer |temporalId| and above; returns how many.
+    size_t shedTemporalLayers(uint8_t temporalId);
 
 private:
-    std::queue<RTMPPacket*> queuePacket;
+    void put(Entry entry);
+    static void release(Entry& entry);
+
+    std::deque<Entry> queuePacket;
     pthread_mutex_t mutexPacket{};
     pthread_cond_t condPacket{};
 };
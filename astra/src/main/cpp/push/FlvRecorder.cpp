@@ -0,0 +1,155 @@
+#include "FlvRecorder.h"
+
+#include <algorithm>
+
+#include "../common/AstraLog.h"
+
+namespace {
+constexpr const char* kTag = "FlvRecorder";
+constexpr uint8_t kTagAudio = 8;
+constexpr uint8_t kTagVideo = 9;
+constexpr uint8_t kTagScript = 18;
+}  // namespace
+
+FlvRecorder::~FlvRecorder() {
+    stop();
+}
+
+void FlvRecorder::configureVideo(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    muxer_.setVideoConfig(config);
+    hasVideo_ = config.width > 0 && config.height > 0;
+}
+
+void FlvRecorder::updateVideoConfig(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    muxer_.updateVideoConfig(config);
+}
+
+void FlvRecorder::configureAudio(const astra::AudioConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    muxer_.setAudioConfig(config);
+    audioExpected_ = config.sampleRate > 0;
+    hasAudio_ = muxer_.audioSequenceReady();
+    // The AAC config can land after the opening keyframe; its header then precedes the first
+    // audio tag instead of sitting at the start of the file.
+    if (begun_ && hasAudio_ && !audioHeaderWritten_) {
+        writeAudioHeaderLocked(lastAudioTimestamp_);
+    }
+}
+
+bool FlvRecorder::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hasVideo_ && !audioExpected_) {
+        ASTRA_LOGE(kTag, "start: no stream configured");
+        return false;
+    }
+    begun_ = false;
+    audioHeaderWritten_ = false;
+    lastVideoTimestamp_ = 0;
+    lastAudioTimestamp_ = 0;
+    if (!writer_.open(path, audioExpected_, hasVideo_)) {
+        return false;
+    }
+    ASTRA_LOGI(kTag, "recording to %s video=%d audio=%d", path.c_str(), hasVideo_ ? 1 : 0, audioExpected_ ? 1 : 0);
+    return true;
+}
+
+bool FlvRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!writer_.isOpen()) {
+        return true;
+    }
+    if (begun_ && hasVideo_) {
+        const std::vector<uint8_t> sequenceEnd = muxer_.buildVideoSequenceEnd();
+        if (!sequenceEnd.empty()) {
+            writer_.writeTag(kTagVideo, lastVideoTimestamp_, sequenceEnd);
+        }
+    }
+    const bool ok = writer_.close();
+    const auto stats = writer_.stats();
+    ASTRA_LOGI(kTag, "recording closed ok=%d bytes=%llu tags=%llu stalls=%u",
+               ok ? 1 : 0,
+               static_cast<unsigned long long>(stats.bytes),
+               static_cast<unsigned long long>(stats.tags),
+               stats.stalls);
+    return ok;
+}
+
+void FlvRecorder::pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!writer_.isOpen() || !hasVideo_) {
+        return;
+    }
+    const astra::ParsedVideoFrame frame = muxer_.parseVideoFrame(data, length);
+    if (!frame.hasData()) {
+        return;
+    }
+    if (!begun_) {
+        if (!frame.isKeyFrame) {
+            return;
+        }
+        beginLocked(pts);
+    }
+    const uint32_t timestamp = timestampLocked(pts, lastVideoTimestamp_);
+    if (frame.isKeyFrame && muxer_.videoSequenceChanged()) {
+        // New parameter sets mid-recording; onMetaData stays the one the writer patches on close.
+        if (auto sequence = muxer_.buildVideoSequenceHeader()) {
+            writer_.writeTag(kTagVideo, timestamp, *sequence);
+        }
+    }
+    const auto header = muxer_.buildVideoTagHeader(frame.isKeyFrame);
+    const astra::ByteSpan parts[] = {
+            {header.data(), header.size()},
+            {frame.payload.data(), frame.payload.size()},
+    };
+    writer_.writeTag(kTagVideo, timestamp, parts, 2);
+}
+
+void FlvRecorder::pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!writer_.isOpen() || !hasAudio_) {
+        return;
+    }
+    if (!begun_) {
+        if (hasVideo_) {
+            return;
+        }
+        beginLocked(pts);
+    }
+    if (pts < epochUs_) {
+        return;  // captured before the opening keyframe
+    }
+    const std::vector<uint8_t> payload = muxer_.buildAudioTag(data, length);
+    if (!payload.empty()) {
+        writer_.writeTag(kTagAudio, timestampLocked(pts, lastAudioTimestamp_), payload);
+    }
+}
+
+void FlvRecorder::beginLocked(int64_t pts) {
+    epochUs_ = pts;
+    begun_ = true;
+    if (auto metadata = muxer_.buildMetadataTag()) {
+        writer_.writeTag(kTagScript, 0, *metadata);
+    }
+    if (hasVideo_) {
+        if (auto sequence = muxer_.buildVideoSequenceHeader()) {
+            writer_.writeTag(kTagVideo, 0, *sequence);
+        }
+    }
+    if (hasAudio_) {
+        writeAudioHeaderLocked(0);
+    }
+}
+
+void FlvRecorder::writeAudioHeaderLocked(uint32_t timestamp) {
+    if (auto sequence = muxer_.buildAudioSequenceHeader()) {
+        audioHeaderWritten_ = writer_.writeTag(kTagAudio, timestamp, *sequence);
+    }
+}
+
+uint32_t FlvRecorder::timestampLocked(int64_t pts, uint32_t& lastTimestamp) const {
+    const int64_t timestampMs = std::max<int64_t>((pts - epochUs_) / 1000, 0);
+    lastTimestamp = std::max(static_cast<uint32_t>(timestampMs), lastTimestamp);
+    return lastTimestamp;
+}
@@ -0,0 +1,50 @@
+#ifndef ASTRASTREAM_FLVRECORDER_H
+#define ASTRASTREAM_FLVRECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "../stream/FlvFileWriter.h"
+#include "../stream/FlvMuxer.h"
+
+// Local FLV recording fed with the same encoder output as the live push, alongside it or
+// on its own. The file starts at the first video keyframe (first audio frame when there is
+// no video) so it opens decodable; timestamps count from that frame's pts.
+class FlvRecorder {
+public:
+    FlvRecorder() = default;
+    ~FlvRecorder();
+
+    void configureVideo(const astra::VideoConfig& config);
+    void updateVideoConfig(const astra::VideoConfig& config);
+    void configureAudio(const astra::AudioConfig& config);
+    bool start(const std::string& path);
+    bool stop();
+
+    // Called from the encoder threads; only copies into the writer's block.
+    void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts);
+    void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts);
+
+    [[nodiscard]] astra::FlvFileWriter::Stats stats() const { return writer_.stats(); }
+
+private:
+    void beginLocked(int64_t pts);
+    void writeAudioHeaderLocked(uint32_t timestamp);
+    uint32_t timestampLocked(int64_t pts, uint32_t& lastTimestamp) const;
+
+    std::mutex mutex_;
+    astra::FlvMuxer muxer_;
+    astra::FlvFileWriter writer_;
+    bool hasVideo_ = false;
+    bool hasAudio_ = false;  // AudioSpecificConfig known
+    bool audioExpected_ = false;
+    bool begun_ = false;
+    bool audioHeaderWritten_ = false;
+    int64_t epochUs_ = 0;
+    uint32_t lastVideoTimestamp_ = 0;
+    uint32_t lastAudioTimestamp_ = 0;
+};
+
+#endif  // ASTRASTREAM_FLVRECORDER_H
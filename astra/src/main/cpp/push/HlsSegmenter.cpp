@@ -0,0 +1,352 @@
+#include "HlsSegmenter.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+
+#include "../common/AstraLog.h"
+
+namespace {
+constexpr const char* kTag = "HlsSegmenter";
+constexpr const char* kInitName = "init.mp4";
+constexpr const char* kPlaylistName = "index.m3u8";
+constexpr size_t kMaxPooledBuffers = 16;
+
+bool WriteFully(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+}  // namespace
+
+HlsSegmenter::~HlsSegmenter() {
+    stop();
+}
+
+void HlsSegmenter::configureVideo(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.setVideoConfig(config);
+    hasVideo_ = config.width > 0 && config.height > 0;
+}
+
+void HlsSegmenter::updateVideoConfig(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.updateVideoConfig(config);
+}
+
+void HlsSegmenter::configureAudio(const astra::AudioConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.setAudioConfig(config);
+    audioExpected_ = config.sampleRate > 0;
+}
+
+bool HlsSegmenter::start(const std::string& directory, const Options& options) {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hasVideo_ && !audioExpected_) {
+        ASTRA_LOGE(kTag, "start: no stream configured");
+        return false;
+    }
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        ASTRA_LOGE(kTag, "start: cannot create %s errno=%d", directory.c_str(), errno);
+        return false;
+    }
+    options_ = options;
+    options_.partDurationMs = std::max<uint32_t>(options_.partDurationMs, 33);
+    options_.segmentDurationMs = std::max(options_.segmentDurationMs, options_.partDurationMs);
+    options_.windowSegments = std::max<uint32_t>(options_.windowSegments, 2);
+    directory_ = directory;
+    segments_.clear();
+    nextSequence_ = 0;
+    initIndex_ = 0;
+    discontinuityPending_ = false;
+    discontinuitySequence_ = 0;
+    muxer_.reset();
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex_);
+        stopping_ = false;
+        stats_ = Stats{};
+    }
+    writer_ = std::thread(&HlsSegmenter::writerLoop, this);
+    active_ = true;
+    ASTRA_LOGI(kTag, "writing LL-HLS to %s part=%u ms segment=%u ms window=%u",
+               directory.c_str(), options_.partDurationMs, options_.segmentDurationMs, options_.windowSegments);
+    return true;
+}
+
+void HlsSegmenter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_ && muxer_) {
+            muxer_->flush();
+            if (!segments_.empty()) {
+                segments_.back().complete = true;
+            }
+            publishLocked(true);
+        }
+        active_ = false;
+        muxer_.reset();
+    }
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex_);
+        stopping_ = true;
+    }
+    queueCond_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+        const Stats stats = this->stats();
+        ASTRA_LOGI(kTag, "stopped parts=%llu segments=%llu bytes=%llu errors=%llu",
+                   static_cast<unsigned long long>(stats.parts),
+                   static_cast<unsigned long long>(stats.segments),
+                   static_cast<unsigned long long>(stats.bytes),
+                   static_cast<unsigned long long>(stats.writeErrors));
+    }
+}
+
+void HlsSegmenter::pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || !hasVideo_) {
+        return;
+    }
+    const astra::ParsedVideoFrame frame = parser_.parseVideoFrame(data, length);
+    if (!frame.hasData()) {
+        return;
+    }
+    if (muxer_ && frame.isKeyFrame && parser_.parameterSetGeneration() != videoGeneration_) {
+        // Encoder switched: the sample entry changes, so close the segment on a new init.
+        muxer_->flush();
+        if (!segments_.empty()) {
+            segments_.back().complete = true;
+            discontinuityPending_ = true;
+        }
+        muxer_.reset();
+        ++initIndex_;
+    }
+    if (!muxer_ && (!frame.isKeyFrame || !beginLocked())) {
+        return;
+    }
+    const astra::ByteSpan payload{frame.payload.data(), frame.payload.size()};
+    muxer_->addVideoSample(&payload, 1, pts, frame.isKeyFrame);
+}
+
+void HlsSegmenter::pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        return;
+    }
+    if (!muxer_ && (hasVideo_ || !beginLocked())) {
+        return;
+    }
+    muxer_->addAudioSample(data, length, pts);
+}
+
+HlsSegmenter::Stats HlsSegmenter::stats() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return stats_;
+}
+
+bool HlsSegmenter::beginLocked() {
+    // The init segment carries both sample entries, so wait for the AAC config as well.
+    if (audioExpected_ && !parser_.audioSequenceReady()) {
+        return false;
+    }
+    astra::Fmp4Muxer::Options options;
+    options.partDurationUs = static_cast<int64_t>(options_.partDurationMs) * 1000;
+    auto muxer = std::make_unique<astra::Fmp4Muxer>(options);
+    if (hasVideo_) {
+        auto record = parser_.buildDecoderConfigurationRecord();
+        if (!record.has_value()) {
+            return false;
+        }
+        muxer->setVideoTrack(parser_.streamVideoConfig(), std::move(*record));
+        videoGeneration_ = parser_.parameterSetGeneration();
+    }
+    if (audioExpected_) {
+        muxer->setAudioTrack(parser_.audioConfig());
+    }
+    muxer->setFragmentSink([this](const astra::ByteSpan* parts, size_t count,
+                                  const astra::Fmp4Muxer::FragmentInfo& info) {
+        onFragment(parts, count, info);
+    });
+    if (initIndex_ == 0) {
+        initUri_ = kInitName;
+    } else {
+        char name[32];
+        std::snprintf(name, sizeof(name), "init_%u.mp4", initIndex_);
+        initUri_ = name;
+    }
+    const std::vector<uint8_t>& init = muxer->initSegment();
+    const astra::ByteSpan initSpan{init.data(), init.size()};
+    enqueue(DiskOp::Kind::kPublish, directory_ + "/" + initUri_, &initSpan, 1);
+    muxer_ = std::move(muxer);
+    return true;
+}
+
+void HlsSegmenter::onFragment(const astra::ByteSpan* parts, size_t count, const astra::Fmp4Muxer::FragmentInfo& info) {
+    // Runs inside Fmp4Muxer calls, so mutex_ is already held.
+    const int64_t segmentTargetUs = static_cast<int64_t>(options_.segmentDurationMs) * 1000;
+    const int64_t toleranceUs = static_cast<int64_t>(options_.partDurationMs) * 500;
+    const bool newSegment = segments_.empty() || segments_.back().complete ||
+            (info.independent && segments_.back().durationUs >= segmentTargetUs - toleranceUs);
+    if (newSegment) {
+        if (!segments_.empty()) {
+            segments_.back().complete = true;
+        }
+        astra::HlsSegment segment;
+        segment.sequence = nextSequence_++;
+        char name[48];
+        std::snprintf(name, sizeof(name), "segment_%" PRIu64 ".m4s", segment.sequence);
+        segment.uri = name;
+        segment.initUri = initUri_;
+        segment.discontinuity = discontinuityPending_;
+        discontinuityPending_ = false;
+        segments_.push_back(std::move(segment));
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex_);
+            ++stats_.segments;
+        }
+        // One file per segment leaves the window: constant work however long the stream runs.
+        if (segments_.size() > options_.windowSegments + 1) {
+            const astra::HlsSegment& oldest = segments_.front();
+            enqueue(DiskOp::Kind::kRemove, directory_ + "/" + oldest.uri, nullptr, 0);
+            if (oldest.discontinuity) {
+                ++discontinuitySequence_;
+            }
+            if (oldest.initUri != segments_[1].initUri) {
+                enqueue(DiskOp::Kind::kRemove, directory_ + "/" + oldest.initUri, nullptr, 0);
+            }
+            segments_.pop_front();
+        }
+    }
+
+    astra::HlsSegment& segment = segments_.back();
+    astra::HlsPart part;
+    part.durationUs = info.durationUs;
+    part.offset = segment.bytes;
+    part.size = info.bytes;
+    part.independent = info.independent;
+    segment.parts.push_back(part);
+    segment.bytes += info.bytes;
+    segment.durationUs += info.durationUs;
+    enqueue(DiskOp::Kind::kAppend, directory_ + "/" + segment.uri, parts, count);
+    publishLocked(false);
+}
+
+void HlsSegmenter::publishLocked(bool ended) {
+    astra::HlsPlaylistParams params;
+    params.initUri = initUri_;
+    params.discontinuitySequence = discontinuitySequence_;
+    params.targetDurationUs = static_cast<int64_t>(options_.segmentDurationMs) * 1000;
+    params.partTargetUs = static_cast<int64_t>(options_.partDurationMs) * 1000;
+    params.ended = ended;
+    const std::string playlist = astra::RenderLlHlsPlaylist(segments_, params);
+    const astra::ByteSpan span{reinterpret_cast<const uint8_t*>(playlist.data()), playlist.size()};
+    enqueue(DiskOp::Kind::kPublish, directory_ + "/" + kPlaylistName, &span, 1);
+}
+
+void HlsSegmenter::enqueue(DiskOp::Kind kind, std::string path, const astra::ByteSpan* parts, size_t count) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    DiskOp op;
+    op.kind = kind;
+    op.path = std::move(path);
+    if (!freeBuffers_.empty()) {
+        op.data = std::move(freeBuffers_.back());
+        freeBuffers_.pop_back();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        op.data.insert(op.data.end(), parts[i].data, parts[i].data + parts[i].size);
+    }
+    queuedBytes_ += op.data.size();
+    stats_.maxQueuedBytes = std::max(stats_.maxQueuedBytes, queuedBytes_);
+    if (kind == DiskOp::Kind::kAppend) {
+        ++stats_.parts;
+        stats_.bytes += op.data.size();
+    }
+    queue_.push_back(std::move(op));
+    lock.unlock();
+    queueCond_.notify_one();
+}
+
+void HlsSegmenter::writerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    while (true) {
+        queueCond_.wait(lock, [&] { return !queue_.empty() || stopping_; });
+        if (queue_.empty()) {
+            break;  // stopping, and everything queued before stop() has been written
+        }
+        DiskOp op = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        runOp(op);
+        lock.lock();
+        queuedBytes_ -= op.data.size();
+        if (freeBuffers_.size() < kMaxPooledBuffers) {
+            op.data.clear();
+            freeBuffers_.push_back(std::move(op.data));
+        }
+    }
+    lock.unlock();
+    if (segmentFd_ >= 0) {
+        ::close(segmentFd_);
+        segmentFd_ = -1;
+    }
+    segmentPath_.clear();
+}
+
+void HlsSegmenter::runOp(DiskOp& op) {
+    bool ok = true;
+    switch (op.kind) {
+        case DiskOp::Kind::kAppend:
+            if (op.path != segmentPath_) {
+                if (segmentFd_ >= 0) {
+                    ::close(segmentFd_);
+                }
+                segmentFd_ = ::open(op.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                segmentPath_ = op.path;
+            }
+            ok = segmentFd_ >= 0 && WriteFully(segmentFd_, op.data.data(), op.data.size());
+            break;
+        case DiskOp::Kind::kPublish: {
+            // Readers see the old file or the new one, never a partial write.
+            const std::string temporary = op.path + ".tmp";
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            ok = fd >= 0 && WriteFully(fd, op.data.data(), op.data.size());
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            ok = ok && ::rename(temporary.c_str(), op.path.c_str()) == 0;
+            break;
+        }
+        case DiskOp::Kind::kRemove:
+            if (op.path == segmentPath_ && segmentFd_ >= 0) {
+                ::close(segmentFd_);
+                segmentFd_ = -1;
+                segmentPath_.clear();
+            }
+            ok = ::unlink(op.path.c_str()) == 0 || errno == ENOENT;
+            if (ok) {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                ++stats_.removed;
+            }
+            break;
+    }
+    if (!ok) {
+        ASTRA_LOGE(kTag, "%s failed errno=%d", op.path.c_str(), errno);
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        ++stats_.writeErrors;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef ASTRASTREAM_HLSSEGMENTER_H
+#define ASTRASTREAM_HLSSEGMENTER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../stream/FlvMuxer.h"
+#include "../stream/Fmp4Muxer.h"
+#include "../stream/HlsPlaylist.h"
+
+// Low-latency HLS output into a directory an edge web server pulls from. The encoded stream
+// is cut into CMAF parts of about |partDurationMs|; a segment starts on the first keyframe
+// after it reaches |segmentDurationMs|. Each segment is one file that its parts address by
+// byte range, so the rolling window drops one file per segment. index.m3u8 is replaced by
+// rename after every part. All file work runs on a writer thread; encoder threads only copy.
+// An encoder switch (new parameter sets) ends the segment, writes a new init segment and
+// marks the next one as a discontinuity.
+class HlsSegmenter {
+public:
+    struct Options {
+        uint32_t partDurationMs = 200;
+        uint32_t segmentDurationMs = 2000;
+        uint32_t windowSegments = 6;  // complete segments kept on disk and in the playlist
+    };
+
+    struct Stats {
+        uint64_t parts = 0;
+        uint64_t segments = 0;
+        uint64_t bytes = 0;
+        uint64_t removed = 0;
+        uint64_t writeErrors = 0;
+        size_t maxQueuedBytes = 0;  // high-water mark of data waiting for the writer
+    };
+
+    HlsSegmenter() = default;
+    ~HlsSegmenter();
+    HlsSegmenter(const HlsSegmenter&) = delete;
+    HlsSegmenter& operator=(const HlsSegmenter&) = delete;
+
+    void configureVideo(const astra::VideoConfig& config);
+    // Same codec, new size or frame rate: the next keyframe opens a new init segment.
+    void updateVideoConfig(const astra::VideoConfig& config);
+    void configureAudio(const astra::AudioConfig& config);
+    bool start(const std::string& directory, const Options& options);
+    void stop();
+
+    void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts);
+    void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts);
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct DiskOp {
+        enum class Kind : uint8_t { kAppend, kPublish, kRemove };
+        Kind kind = Kind::kAppend;
+        std::string path;
+        std::vector<uint8_t> data;
+    };
+
+    bool beginLocked();
+    void onFragment(const astra::ByteSpan* parts, size_t count, const astra::Fmp4Muxer::FragmentInfo& info);
+    void publishLocked(bool ended);
+    void enqueue(DiskOp::Kind kind, std::string path, const astra::ByteSpan* parts, size_t count);
+    void writerLoop();
+    void runOp(DiskOp& op);
+
+    std::mutex mutex_;  // muxing state, taken by the encoder threads
+    astra::FlvMuxer parser_;
+    std::unique_ptr<astra::Fmp4Muxer> muxer_;
+    Options options_;
+    std::string directory_;
+    bool active_ = false;
+    bool hasVideo_ = false;
+    bool audioExpected_ = false;
+    std::deque<astra::HlsSegment> segments_;
+    uint64_t nextSequence_ = 0;
+    uint32_t videoGeneration_ = 0;  // parameter sets the current init segment was built from
+    uint32_t initIndex_ = 0;
+    std::string initUri_;
+    bool discontinuityPending_ = false;
+    uint64_t discontinuitySequence_ = 0;
+
+    mutable std::mutex queueMutex_;
+    std::condition_variable queueCond_;
+    std::deque<DiskOp> queue_;
+    std::vector<std::vector<uint8_t>> freeBuffers_;
+    size_t queuedBytes_ = 0;
+    bool stopping_ = false;
+    Stats stats_;
+    std::thread writer_;
+    int segmentFd_ = -1;  // writer thread only
+    std::string segmentPath_;
+};
+
+#endif  // ASTRASTREAM_HLSSEGMENTER_H
@@ -1,20 +1,56 @@
 #include "RTMPPush.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <string>
 #include <cstdarg>
+#include <iterator>
+#include <vector>
+
+#include "../stream/MediaClock.h"
 
 extern "C" {
 #include "../librtmp/include/log.h"
 }
 
 namespace {
+// Pts further than this from "now" is not on the monotonic clock (e.g. a codec that
+// rebases to zero) and is ignored in favour of arrival time.
+constexpr int64_t kMaxPtsSkewUs = 5LL * 1000 * 1000;
+// Send queue backlog at which the top temporal layer is shed, and at which it comes back.
+constexpr int64_t kShedBacklogUs = 500 * 1000;
+constexpr int64_t kResumeBacklogUs = 150 * 1000;
+
 std::string AValToString(const AVal& v) {
     if (!v.av_val || v.av_len <= 0) return "";
     return std::string(v.av_val, v.av_len);
 }
 
+// Points whatever still refers into [from, from + size) at the same offset from |to|.
+void RebaseSpans(std::vector<astra::ByteSpan>& spans, const uint8_t* from, size_t size, const uint8_t* to) {
+    if (from == to || !from || !to) {
+        return;
+    }
+    for (auto& span : spans) {
+        if (span.data >= from && span.data < from + size) {
+            span.data = to + (span.data - from);
+        }
+    }
+}
+
+void RebaseIovecs(std::vector<iovec>& vecs, const uint8_t* from, size_t size, const uint8_t* to) {
+    if (from == to || !from || !to) {
+        return;
+    }
+    for (auto& vec : vecs) {
+        const auto* data = static_cast<const uint8_t*>(vec.iov_base);
+        if (data >= from && data < from + size) {
+            vec.iov_base = const_cast<uint8_t*>(to + (data - from));
+        }
+    }
+}
+
 const char* ProtocolName(int protocol) {
     switch (protocol) {
         case RTMP_PROTOCOL_RTMP: return "rtmp";
@@ -28,6 +64,7 @@ const char* ProtocolName(int protocol) {
     }
 }
 
+#if defined(__ANDROID__)
 void RtmpAndroidLogCallback(int level, const char* fmt, va_list args) {
     int prio = ANDROID_LOG_DEBUG;
     switch (level) {
@@ -44,6 +81,8 @@ void RtmpAndroidLogCallback(int level, const char* fmt, va_list args) {
     vsnprintf(buffer, sizeof(buffer), fmt, args);
     __android_log_print(prio, "librtmp", "%s", buffer);
 }
+#endif
+
 std::string MaskUrl(const char* url) {
     if (url == nullptr) {
         return "null";
@@ -64,6 +103,102 @@ std::string MaskUrl(const char* url) {
     }
     return value.substr(0, separator + 1) + masked;
 }
+
+// Enhanced RTMP codecs this client can publish as ExVideoTagHeader. H.264 keeps the legacy
+// tag format and needs no entry.
+constexpr const char* kPublishFourCcList[] = {"av01", "hvc1"};
+
+void AppendAmfString(std::vector<uint8_t>& out, const char* value, size_t length) {
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length));
+    out.insert(out.end(), value, value + length);
+}
+
+void AppendAmfNamedString(std::vector<uint8_t>& out, const char* name, const AVal& value) {
+    AppendAmfString(out, name, std::strlen(name));
+    out.push_back(AMF_STRING);
+    AppendAmfString(out, value.av_val, static_cast<size_t>(value.av_len));
+}
+
+void AppendAmfNumber(std::vector<uint8_t>& out, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    out.push_back(AMF_NUMBER);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(bits >> shift));
+    }
+}
+
+// The connect command librtmp would send for a publisher, plus the Enhanced RTMP fourCcList
+// that tells the server which ExVideoTagHeader codecs to expect. librtmp has no hook for
+// extra command-object properties, so the body is built here and handed to RTMP_Connect.
+// Empty when the auth and conn= arguments do not fit librtmp's own 4 KB connect packet.
+std::vector<uint8_t> BuildConnectCommand(RTMP& rtmp) {
+    static const char kConnect[] = "connect";
+    static const char kNonPrivate[] = "nonprivate";
+    static const char kFlashVer[] = "FMLE/3.0 (compatible; FMSc/1.0)";
+    const AVal type{const_cast<char*>(kNonPrivate), static_cast<int>(sizeof(kNonPrivate) - 1)};
+    const AVal defaultFlashVer{const_cast<char*>(kFlashVer), static_cast<int>(sizeof(kFlashVer) - 1)};
+
+    std::vector<uint8_t> body;
+    body.reserve(256);
+    body.push_back(AMF_STRING);
+    AppendAmfString(body, kConnect, sizeof(kConnect) - 1);
+    AppendAmfNumber(body, 1.0);  // transaction id
+
+    body.push_back(AMF_OBJECT);
+    AppendAmfNamedString(body, "app", rtmp.Link.app);
+    AppendAmfNamedString(body, "type", type);
+    AppendAmfNamedString(body, "flashVer", rtmp.Link.flashVer.av_len > 0 ? rtmp.Link.flashVer : defaultFlashVer);
+    if (rtmp.Link.swfUrl.av_len > 0) {
+        AppendAmfNamedString(body, "swfUrl", rtmp.Link.swfUrl);
+    }
+    if (rtmp.Link.tcUrl.av_len > 0) {
+        AppendAmfNamedString(body, "tcUrl", rtmp.Link.tcUrl);
+    }
+
+    static const char kFourCcList[] = "fourCcList";
+    AppendAmfString(body, kFourCcList, sizeof(kFourCcList) - 1);
+    body.push_back(AMF_STRICT_ARRAY);
+    const uint32_t count = std::size(kPublishFourCcList);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        body.push_back(static_cast<uint8_t>(count >> shift));
+    }
+    for (const char* fourCc : kPublishFourCcList) {
+        body.push_back(AMF_STRING);
+        AppendAmfString(body, fourCc, std::strlen(fourCc));
+    }
+
+    // What SendConnectPacket adds after the fixed fields: objectEncoding, then the auth
+    // argument and the conn= URL options (token / auth ingests) after the command object.
+    char tail[4096];
+    char* const tailEnd = tail + sizeof(tail);
+    char* enc = tail;
+    if (rtmp.m_fEncoding != 0.0 || rtmp.m_bSendEncoding) {
+        static const char kObjectEncoding[] = "objectEncoding";
+        const AVal name{const_cast<char*>(kObjectEncoding), static_cast<int>(sizeof(kObjectEncoding) - 1)};
+        enc = AMF_EncodeNamedNumber(enc, tailEnd, &name, rtmp.m_fEncoding);
+    }
+    if (enc && enc + 3 < tailEnd) {
+        *enc++ = 0;
+        *enc++ = 0;
+        *enc++ = AMF_OBJECT_END;
+    } else {
+        enc = nullptr;
+    }
+    if (enc && rtmp.Link.auth.av_len > 0) {
+        enc = AMF_EncodeBoolean(enc, tailEnd, rtmp.Link.lFlags & RTMP_LF_AUTH);
+        enc = enc ? AMF_EncodeString(enc, tailEnd, &rtmp.Link.auth) : nullptr;
+    }
+    for (int i = 0; enc && i < rtmp.Link.extras.o_num; ++i) {
+        enc = AMFProp_Encode(&rtmp.Link.extras.o_props[i], enc, tailEnd);
+    }
+    if (!enc || body.size() + static_cast<size_t>(enc - tail) > sizeof(tail)) {
+        return {};
+    }
+    body.insert(body.end(), tail, enc);
+    return body;
+}
 }  // namespace
 
 RTMPPush::RTMPPush(const char* url, JavaCallback** javaCallback)
@@ -91,8 +226,17 @@ void RTMPPush::configureVideo(const astra::VideoConfig& config) {
          config.height,
          config.fps,
          static_cast<int>(config.codec));
+    std::lock_guard<std::mutex> lock(mutex_);
     muxer_.setVideoConfig(config);
     headersRequested_ = false;
+    topTemporalId_ = 0;
+    sheddingTopLayer_ = false;
+}
+
+void RTMPPush::updateVideoConfig(const astra::VideoConfig& config) {
+    LOGD("updateVideoConfig width=%u height=%u fps=%u", config.width, config.height, config.fps);
+    std::lock_guard<std::mutex> lock(mutex_);
+    muxer_.updateVideoConfig(config);
 }
 
 void RTMPPush::configureAudio(const astra::AudioConfig& config) {
@@ -101,6 +245,7 @@ void RTMPPush::configureAudio(const astra::AudioConfig& config) {
          config.channels,
          config.sampleSizeBits,
          config.asc.size());
+    std::lock_guard<std::mutex> lock(mutex_);
     muxer_.setAudioConfig(config);
     headersRequested_ = false;
 }
@@ -120,6 +265,7 @@ void RTMPPush::stop() {
         mQueue->notifyQueue();
     }
     joinWorker();
+    std::lock_guard<std::mutex> lock(mutex_);
     if (mQueue) {
         mQueue->clearQueue();
         delete mQueue;
@@ -127,16 +273,21 @@ void RTMPPush::stop() {
     }
     muxer_.reset();
     headersRequested_ = false;
+    sheddingTopLayer_ = false;
     lastVideoTimestamp_ = 0;
     lastAudioTimestamp_ = 0;
 }
 
-void RTMPPush::pushVideoFrame(const uint8_t* data, size_t length, int64_t /*pts*/) {
+void RTMPPush::pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
     astra::ParsedVideoFrame frame = muxer_.parseVideoFrame(data, length);
     if (!frame.hasData()) {
         LOGD("pushVideoFrame skipped: encoder headers pending or frame empty");
         return;
     }
+    if (shedTopLayer(frame.temporalId)) {
+        return;
+    }
 
     ensureHeaders();
 
@@ -146,18 +297,97 @@ void RTMPPush::pushVideoFrame(const uint8_t* data, size_t length, int64_t /*pts*
         return;
     }
 
-    uint32_t timestamp = 0;
-    if (mStartTime > 0) {
-        timestamp = RTMP_GetTime() - mStartTime;
-        lastVideoTimestamp_ = timestamp;
-    } else if (lastVideoTimestamp_ != 0) {
-        timestamp = lastVideoTimestamp_;
+    const uint32_t timestamp = mediaTimestamp(pts, lastVideoTimestamp_);
+    if (frame.isKeyFrame && muxer_.videoSequenceChanged()) {
+        sendChangedVideoSequence(timestamp);
     }
+    enqueuePacket(payload.data(), payload.size(), RTMP_PACKET_TYPE_VIDEO, timestamp, 0x04, frame.temporalId);
+}
 
-    enqueuePacket(payload.data(), payload.size(), RTMP_PACKET_TYPE_VIDEO, timestamp, 0x04);
+bool RTMPPush::pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mQueue || !lease) {
+        return false;
+    }
+    astra::ParsedVideoSlices slices = muxer_.sliceVideoFrameInPlace(lease.data(), lease.size());
+    if (!slices.hasData()) {
+        return false;
+    }
+    if (shedTopLayer(slices.temporalId)) {
+        lease.reset();  // dropped here; the caller must not send a copy either
+        return true;
+    }
+
+    ensureHeaders();
+
+    auto packet = std::make_unique<LeasedVideoPacket>();
+    packet->tagHeader = muxer_.buildVideoTagHeader(slices.isKeyFrame);
+    packet->body.reserve(slices.spans.size() + 1);
+    packet->body.push_back(astra::ByteSpan{packet->tagHeader.data(), packet->tagHeader.size()});
+    packet->body.insert(packet->body.end(), slices.spans.begin(), slices.spans.end());
+    packet->timestamp = mediaTimestamp(pts, lastVideoTimestamp_);
+    packet->leaseBase = lease.data();
+    if (slices.isKeyFrame && muxer_.videoSequenceChanged()) {
+        sendChangedVideoSequence(packet->timestamp);
+    }
+    packet->lease = std::move(lease);
+    mQueue->putLeasedPacket(std::move(packet), slices.temporalId);
+    return true;
 }
 
-void RTMPPush::pushAudioFrame(const uint8_t* data, size_t length, int64_t /*pts*/) {
+bool RTMPPush::shedTopLayer(uint8_t temporalId) {
+    topTemporalId_ = std::max(topTemporalId_, temporalId);
+    if (topTemporalId_ == 0 || !mQueue) {
+        return false;  // no temporal layering: every frame is a reference
+    }
+    const int64_t backlogUs = mQueue->backlogUs();
+    if (!sheddingTopLayer_ && backlogUs > kShedBacklogUs) {
+        sheddingTopLayer_ = true;
+        // Nothing references the top layer, so what is already queued of it can go as well.
+        const size_t shed = mQueue->shedTemporalLayers(topTemporalId_);
+        LOGD("shedding temporal layer %u: backlog=%lld ms, %zu queued frames dropped",
+             topTemporalId_, static_cast<long long>(backlogUs / 1000), shed);
+    } else if (sheddingTopLayer_ && backlogUs < kResumeBacklogUs) {
+        sheddingTopLayer_ = false;
+        LOGD("temporal layer %u resumed", topTemporalId_);
+    }
+    return sheddingTopLayer_ && temporalId >= topTemporalId_;
+}
+
+bool RTMPPush::pushFlvTag(uint8_t tagType, const uint8_t* body, size_t size, uint32_t timestamp) {
+    uint8_t channel = 0;
+    switch (tagType) {
+        case RTMP_PACKET_TYPE_AUDIO: channel = 0x05; break;
+        case RTMP_PACKET_TYPE_VIDEO: channel = 0x04; break;
+        case RTMP_PACKET_TYPE_INFO:  channel = 0x03; break;
+        default: return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    enqueuePacket(body, size, tagType, timestamp, channel);
+    return true;
+}
+
+uint32_t RTMPPush::mediaTimestamp(int64_t ptsUs, uint32_t& lastTimestamp) {
+    if (mStartTime <= 0) {
+        return lastTimestamp;
+    }
+    // Surface-input video and AAudio-anchored audio both carry CLOCK_MONOTONIC pts, so
+    // one epoch keeps them in sync. Anything else falls back to arrival time.
+    int64_t timestampMs = -1;
+    const int64_t nowUs = astra::MonotonicNowUs();
+    if (ptsUs > 0 && std::llabs(nowUs - ptsUs) < kMaxPtsSkewUs) {
+        timestampMs = (ptsUs - mediaEpochUs_) / 1000;
+    }
+    if (timestampMs < 0) {
+        timestampMs = RTMP_GetTime() - mStartTime;
+    }
+    const uint32_t timestamp = std::max(static_cast<uint32_t>(timestampMs), lastTimestamp);
+    lastTimestamp = timestamp;
+    return timestamp;
+}
+
+void RTMPPush::pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (!muxer_.audioSequenceReady()) {
         LOGD("pushAudioFrame skipped: audio sequence header not ready");
         return;
@@ -170,15 +400,8 @@ void RTMPPush::pushAudioFrame(const uint8_t* data, size_t length, int64_t /*pts*
         return;
     }
 
-    uint32_t timestamp = 0;
-    if (mStartTime > 0) {
-        timestamp = RTMP_GetTime() - mStartTime;
-        lastAudioTimestamp_ = timestamp;
-    } else if (lastAudioTimestamp_ != 0) {
-        timestamp = lastAudioTimestamp_;
-    }
-
-    enqueuePacket(payload.data(), payload.size(), RTMP_PACKET_TYPE_AUDIO, timestamp, 0x05);
+    enqueuePacket(payload.data(), payload.size(), RTMP_PACKET_TYPE_AUDIO,
+                  mediaTimestamp(pts, lastAudioTimestamp_), 0x05);
 }
 
 void RTMPPush::main() {
@@ -190,7 +413,8 @@ void RTMPPush::enqueuePacket(const uint8_t* data,
                              size_t length,
                              uint8_t packetType,
                              uint32_t timestamp,
-                             uint8_t channel) {
+                             uint8_t channel,
+                             uint8_t temporalId) {
     if (!mQueue || !data || length == 0) {
         LOGE("enqueuePacket invalid input queue=%p data=%p length=%zu", mQueue, data, length);
         return;
@@ -213,7 +437,7 @@ void RTMPPush::enqueuePacket(const uint8_t* data,
     packet->m_nChannel = channel;
     packet->m_headerType = RTMP_PACKET_SIZE_LARGE;
 
-    mQueue->putRtmpPacket(packet);
+    mQueue->putRtmpPacket(packet, temporalId);
     if (packetType != RTMP_PACKET_TYPE_VIDEO || timestamp == 0) {
         LOGD("enqueuePacket type=%u timestamp=%u channel=%u size=%zu", packetType, timestamp, channel, length);
     }
@@ -252,6 +476,16 @@ void RTMPPush::ensureHeaders() {
     }
 }
 
+void RTMPPush::sendChangedVideoSequence(uint32_t timestamp) {
+    if (auto metadata = muxer_.buildMetadataTag()) {
+        enqueuePacket(metadata->data(), metadata->size(), RTMP_PACKET_TYPE_INFO, timestamp, 0x03);
+    }
+    if (auto videoHeader = muxer_.buildVideoSequenceHeader()) {
+        enqueuePacket(videoHeader->data(), videoHeader->size(), RTMP_PACKET_TYPE_VIDEO, timestamp, 0x04);
+        LOGD("video sequence changed; header resent size=%zu timestamp=%u", videoHeader->size(), timestamp);
+    }
+}
+
 void RTMPPush::onConnecting() {
     LOGD("onConnecting start url=%s", MaskUrl(mRtmpUrl).c_str());
     if (mCallback) {
@@ -273,9 +507,11 @@ void RTMPPush::onConnecting() {
         return;
     }
 
+#if defined(__ANDROID__)
     // Enable verbose librtmp logs to Android logcat for diagnosis
     RTMP_LogSetCallback(RtmpAndroidLogCallback);
     RTMP_LogSetLevel(RTMP_LOGDEBUG);
+#endif
 
     RTMP_Init(mRtmp);
     const int setupResult = RTMP_SetupURL(mRtmp, mRtmpUrl);
@@ -304,7 +540,27 @@ void RTMPPush::onConnecting() {
 
     mRtmp->Link.timeout = 10;
     RTMP_EnableWrite(mRtmp);
-    const int connectResult = RTMP_Connect(mRtmp, nullptr);
+    const std::vector<uint8_t> connectCommand = BuildConnectCommand(*mRtmp);
+    if (connectCommand.empty()) {
+        LOGE("RTMP connect command too large for the URL's auth / conn= options");
+        if (mCallback) {
+            mCallback->onConnectFail(RtmpErrorCode::ConnectFailure);
+        }
+        release();
+        return;
+    }
+    RTMPPacket connectPacket;
+    RTMPPacket_Alloc(&connectPacket, static_cast<int>(connectCommand.size()));
+    RTMPPacket_Reset(&connectPacket);
+    std::memcpy(connectPacket.m_body, connectCommand.data(), connectCommand.size());
+    connectPacket.m_packetType = RTMP_PACKET_TYPE_INVOKE;
+    connectPacket.m_nBodySize = static_cast<uint32_t>(connectCommand.size());
+    connectPacket.m_nChannel = 0x03;
+    connectPacket.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    // librtmp numbers the invokes it sends itself; continue after our transaction 1.
+    mRtmp->m_numInvokes = 1;
+    const int connectResult = RTMP_Connect(mRtmp, &connectPacket);
+    RTMPPacket_Free(&connectPacket);
     if (!connectResult) {
         LOGE("RTMP_Connect failed result=%d", connectResult);
         if (mCallback) {
@@ -324,25 +580,34 @@ void RTMPPush::onConnecting() {
         return;
     }
 
-    mStartTime = RTMP_GetTime();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mStartTime = RTMP_GetTime();
+        mediaEpochUs_ = astra::MonotonicNowUs();
+        headersRequested_ = false;
+    }
     LOGD("onConnecting success startTime=%ld", mStartTime);
 
     if (mCallback) {
         mCallback->onConnectSuccess();
     }
+    requestKeyFrame("connected");  // a viewer joining now should not wait out the GOP
 
     isPusher = 1;
-    headersRequested_ = false;
     LOGD("onConnecting entering send loop");
 
     while (true) {
         if (!isPusher || !mQueue) {
             LOGD("send loop exiting isPusher=%d queue=%p", isPusher, mQueue);
+            sendVideoSequenceEnd();
             release();
             break;
         }
-        RTMPPacket* packet = mQueue->getRtmpPacket();
-        if (packet != nullptr) {
+        AVQueue::Entry entry = mQueue->getPacket();
+        if (entry.leased) {
+            sendLeasedPacket(*entry.leased);
+        }
+        if (RTMPPacket* packet = entry.packet) {
             packet->m_nInfoField2 = mRtmp->m_stream_id;
             const int result = RTMP_SendPacket(mRtmp, packet, 1);
             if (!result) {
@@ -356,6 +621,109 @@ void RTMPPush::onConnecting() {
     LOGE("RTMP connection closed");
 }
 
+bool RTMPPush::canWriteVectored() const {
+    // Tunnelled, encrypted and TLS links transform bytes inside librtmp.
+    return mRtmp != nullptr &&
+           (mRtmp->Link.protocol & (RTMP_FEATURE_HTTP | RTMP_FEATURE_ENC | RTMP_FEATURE_SSL)) == 0 &&
+           mRtmp->m_sb.sb_socket >= 0;
+}
+
+void RTMPPush::sendLeasedPacket(LeasedVideoPacket& packet) {
+    if (!canWriteVectored()) {
+        size_t bodySize = 0;
+        for (const auto& span : packet.body) {
+            bodySize += span.size;
+        }
+        RTMPPacket rtmpPacket;
+        RTMPPacket_Alloc(&rtmpPacket, static_cast<int>(bodySize));
+        RTMPPacket_Reset(&rtmpPacket);
+        {
+            // Pinned only for the copy; the send below goes out from the packet.
+            auto pin = packet.lease.pin();
+            RebaseSpans(packet.body, packet.leaseBase, packet.lease.size(), packet.lease.data());
+            packet.leaseBase = packet.lease.data();
+            char* cursor = rtmpPacket.m_body;
+            for (const auto& span : packet.body) {
+                std::memcpy(cursor, span.data, span.size);
+                cursor += span.size;
+            }
+        }
+        packet.lease.reset();
+        rtmpPacket.m_packetType = RTMP_PACKET_TYPE_VIDEO;
+        rtmpPacket.m_nBodySize = static_cast<uint32_t>(bodySize);
+        rtmpPacket.m_nTimeStamp = packet.timestamp;
+        rtmpPacket.m_hasAbsTimestamp = FALSE;
+        rtmpPacket.m_nChannel = 0x04;
+        rtmpPacket.m_headerType = RTMP_PACKET_SIZE_LARGE;
+        rtmpPacket.m_nInfoField2 = mRtmp->m_stream_id;
+        if (!RTMP_SendPacket(mRtmp, &rtmpPacket, 1)) {
+            LOGE("sendLeasedPacket RTMP_SendPacket failed size=%zu", bodySize);
+        }
+        RTMPPacket_Free(&rtmpPacket);
+        return;
+    }
+
+    // Written in place without the owner lock. A frame revoked while queued already points at
+    // the copy; one revoked mid-write moves over to it the next time the socket is full.
+    const uint8_t* base = packet.lease.beginRead();
+    RebaseSpans(packet.body, packet.leaseBase, packet.lease.size(), base);
+    chunkWriter_.layout(RTMP_PACKET_TYPE_VIDEO,
+                        0x04,
+                        packet.timestamp,
+                        mRtmp->m_stream_id,
+                        packet.body,
+                        static_cast<uint32_t>(mRtmp->m_outChunkSize));
+    auto vecs = chunkWriter_.iovecs();
+    bool inPlace = !packet.lease.revoked();
+    const bool written = astra::RtmpChunkWriter::writeFully(
+            mRtmp->m_sb.sb_socket, vecs, [&packet, &base, &inPlace](std::vector<iovec>& pending) {
+                if (inPlace && packet.lease.revoked()) {
+                    const uint8_t* copy = packet.lease.followCopy();
+                    RebaseIovecs(pending, base, packet.lease.size(), copy);
+                    base = copy;
+                    inPlace = false;
+                }
+            });
+    if (!written) {
+        LOGE("sendLeasedPacket write failed size=%zu", chunkWriter_.totalBytes());
+    }
+    packet.lease.endRead();
+    packet.lease.reset();
+}
+
+void RTMPPush::sendVideoSequenceEnd() {
+    if (!mRtmp || !RTMP_IsConnected(mRtmp)) {
+        return;
+    }
+    std::vector<uint8_t> body;
+    uint32_t timestamp = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!muxer_.hasSentVideoSequence()) {
+            return;
+        }
+        body = muxer_.buildVideoSequenceEnd();
+        timestamp = lastVideoTimestamp_;
+    }
+    if (body.empty()) {
+        return;
+    }
+    RTMPPacket packet;
+    RTMPPacket_Alloc(&packet, static_cast<int>(body.size()));
+    RTMPPacket_Reset(&packet);
+    std::memcpy(packet.m_body, body.data(), body.size());
+    packet.m_packetType = RTMP_PACKET_TYPE_VIDEO;
+    packet.m_nBodySize = static_cast<uint32_t>(body.size());
+    packet.m_nTimeStamp = timestamp;
+    packet.m_nChannel = 0x04;
+    packet.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    packet.m_nInfoField2 = mRtmp->m_stream_id;
+    if (!RTMP_SendPacket(mRtmp, &packet, 0)) {
+        LOGE("sendVideoSequenceEnd RTMP_SendPacket failed size=%zu", body.size());
+    }
+    RTMPPacket_Free(&packet);
+}
+
 void RTMPPush::release() {
     LOGD("release rtmp=%p", mRtmp);
     if (!mRtmp) {
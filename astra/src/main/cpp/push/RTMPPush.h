@@ -3,21 +3,22 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <vector>
 
 #include "AVQueue.h"
+#include "RtmpChunkWriter.h"
 #include "IPush.h"
 #include "JavaCallback.h"
+#include "../common/AstraLog.h"
 #include "../stream/FlvMuxer.h"
 
-#include <android/log.h>
-
 #define TAG "astra"
 
 #define LOG_SHOW true
 
-#define LOGD(FORMAT, ...) __android_log_print(ANDROID_LOG_DEBUG, TAG, FORMAT, ##__VA_ARGS__);
-#define LOGE(FORMAT, ...) __android_log_print(ANDROID_LOG_ERROR, TAG, FORMAT, ##__VA_ARGS__);
+#define LOGD(FORMAT, ...) ASTRA_LOGD(TAG, FORMAT, ##__VA_ARGS__);
+#define LOGE(FORMAT, ...) ASTRA_LOGE(TAG, FORMAT, ##__VA_ARGS__);
 
 class RTMPPush : public IPush {
 public:
@@ -28,27 +29,53 @@ public:
     void stop() override;
     void main() override;
     void configureVideo(const astra::VideoConfig& config) override;
+    void updateVideoConfig(const astra::VideoConfig& config) override;
     void configureAudio(const astra::AudioConfig& config) override;
     void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) override;
     void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) override;
+    bool pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts) override;
+    bool pushFlvTag(uint8_t tagType, const uint8_t* body, size_t size, uint32_t timestamp) override;
 
     void onConnecting();
     void release();
 
 private:
-    void enqueuePacket(const uint8_t* data, size_t length, uint8_t packetType, uint32_t timestamp, uint8_t channel);
+    void enqueuePacket(const uint8_t* data,
+                       size_t length,
+                       uint8_t packetType,
+                       uint32_t timestamp,
+                       uint8_t channel,
+                       uint8_t temporalId = 0);
+    // Congestion response for temporally layered video: while the send queue lags, frames of
+    // the top layer are dropped (true), halving the frame rate of a two-layer stream without
+    // waiting for a key frame.
+    bool shedTopLayer(uint8_t temporalId);
     void ensureHeaders();
+    // Inline onMetaData and sequence header ahead of the key frame that starts new
+    // parameter sets, stamped with that frame's timestamp.
+    void sendChangedVideoSequence(uint32_t timestamp);
+    uint32_t mediaTimestamp(int64_t ptsUs, uint32_t& lastTimestamp);
+    void sendLeasedPacket(LeasedVideoPacket& packet);
+    // Ends the video sequence before the connection closes; the server can tell a finished
+    // stream from a dropped one. Send thread; built under mutex_, sent outside it.
+    void sendVideoSequenceEnd();
+    bool canWriteVectored() const;
 
+    std::mutex mutex_;  // muxing state and the timestamps, taken by the encoder threads
     astra::FlvMuxer muxer_;
+    astra::RtmpChunkWriter chunkWriter_;
     RTMP* mRtmp = nullptr;
     char* mRtmpUrl = nullptr;
     AVQueue* mQueue = nullptr;
     JavaCallback* mCallback = nullptr;
     int isPusher = 0;
     long mStartTime = 0;
+    int64_t mediaEpochUs_ = 0;
     uint32_t lastVideoTimestamp_ = 0;
     uint32_t lastAudioTimestamp_ = 0;
     bool headersRequested_ = false;
+    uint8_t topTemporalId_ = 0;  // highest temporal layer seen since configureVideo
+    bool sheddingTopLayer_ = false;
 };
 
 #endif  // ASTRASTREAM_RTMPPUSH_H
@@ -0,0 +1,130 @@
+#include "RtmpChunkWriter.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+namespace astra {
+
+namespace {
+
+constexpr uint32_t kMaxPlainTimestamp = 0xFFFFFF;
+constexpr size_t kType0HeaderSize = 12;
+constexpr size_t kType3HeaderSize = 1;
+constexpr size_t kExtendedTimestampSize = 4;
+
+#ifdef IOV_MAX
+constexpr size_t kMaxIovecsPerWrite = IOV_MAX;
+#else
+constexpr size_t kMaxIovecsPerWrite = 1024;
+#endif
+
+void WriteBigEndian(uint8_t* out, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (8 * (bytes - 1 - i))) & 0xFF);
+    }
+}
+
+}  // namespace
+
+void RtmpChunkWriter::layout(uint8_t packetType,
+                             uint8_t channel,
+                             uint32_t timestamp,
+                             int32_t streamId,
+                             const std::vector<ByteSpan>& payload,
+                             uint32_t chunkSize) {
+    iovecs_.clear();
+    totalBytes_ = 0;
+
+    size_t bodySize = 0;
+    for (const auto& span : payload) {
+        bodySize += span.size;
+    }
+    chunkSize = std::max<uint32_t>(chunkSize, 1);
+    const size_t chunkCount = std::max<size_t>((bodySize + chunkSize - 1) / chunkSize, 1);
+    const bool extended = timestamp >= kMaxPlainTimestamp;
+    const size_t firstHeaderSize = kType0HeaderSize + (extended ? kExtendedTimestampSize : 0);
+    const size_t nextHeaderSize = kType3HeaderSize + (extended ? kExtendedTimestampSize : 0);
+
+    // Sized once up front; the iovecs below point into this storage.
+    headers_.assign(firstHeaderSize + (chunkCount - 1) * nextHeaderSize, 0);
+    iovecs_.reserve(payload.size() + chunkCount * 2);
+
+    uint8_t* header = headers_.data();
+    header[0] = static_cast<uint8_t>(channel & 0x3F);
+    WriteBigEndian(header + 1, extended ? kMaxPlainTimestamp : timestamp, 3);
+    WriteBigEndian(header + 4, static_cast<uint32_t>(bodySize), 3);
+    header[7] = packetType;
+    const auto streamIdValue = static_cast<uint32_t>(streamId);
+    header[8] = static_cast<uint8_t>(streamIdValue & 0xFF);
+    header[9] = static_cast<uint8_t>((streamIdValue >> 8) & 0xFF);
+    header[10] = static_cast<uint8_t>((streamIdValue >> 16) & 0xFF);
+    header[11] = static_cast<uint8_t>((streamIdValue >> 24) & 0xFF);
+    if (extended) {
+        WriteBigEndian(header + kType0HeaderSize, timestamp, kExtendedTimestampSize);
+    }
+    iovecs_.push_back(iovec{header, firstHeaderSize});
+    header += firstHeaderSize;
+
+    size_t chunkRemaining = chunkSize;
+    for (const auto& span : payload) {
+        size_t offset = 0;
+        while (offset < span.size) {
+            if (chunkRemaining == 0) {
+                header[0] = static_cast<uint8_t>(0xC0 | (channel & 0x3F));
+                if (extended) {
+                    WriteBigEndian(header + kType3HeaderSize, timestamp, kExtendedTimestampSize);
+                }
+                iovecs_.push_back(iovec{header, nextHeaderSize});
+                header += nextHeaderSize;
+                chunkRemaining = chunkSize;
+            }
+            const size_t piece = std::min(chunkRemaining, span.size - offset);
+            iovecs_.push_back(iovec{const_cast<uint8_t*>(span.data + offset), piece});
+            offset += piece;
+            chunkRemaining -= piece;
+        }
+    }
+    totalBytes_ = headers_.size() + bodySize;
+}
+
+bool RtmpChunkWriter::writeFully(int fd, std::vector<iovec>& vecs, const WaitHook& onWait) {
+    size_t first = 0;
+    while (first < vecs.size()) {
+        msghdr message{};
+        message.msg_iov = vecs.data() + first;
+        message.msg_iovlen = std::min(vecs.size() - first, kMaxIovecsPerWrite);
+        const ssize_t written = sendmsg(fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            if (onWait) {
+                onWait(vecs);
+            }
+            pollfd waiter{fd, POLLOUT, 0};
+            if (poll(&waiter, 1, onWait ? kWaitSliceMs : -1) < 0 && errno != EINTR) {
+                return false;
+            }
+            continue;
+        }
+        auto remaining = static_cast<size_t>(written);
+        while (first < vecs.size() && remaining >= vecs[first].iov_len) {
+            remaining -= vecs[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            vecs[first].iov_base = static_cast<uint8_t*>(vecs[first].iov_base) + remaining;
+            vecs[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+}  // namespace astra
@@ -0,0 +1,45 @@
+#ifndef ASTRASTREAM_RTMPCHUNKWRITER_H
+#define ASTRASTREAM_RTMPCHUNKWRITER_H
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../stream/FlvMuxer.h"
+
+namespace astra {
+
+// Lays out one RTMP message as chunk headers interleaved with caller-owned payload spans so
+// it can go out with a single gathered write instead of being copied into an RTMPPacket.
+class RtmpChunkWriter {
+public:
+    void layout(uint8_t packetType,
+                uint8_t channel,
+                uint32_t timestamp,
+                int32_t streamId,
+                const std::vector<ByteSpan>& payload,
+                uint32_t chunkSize);
+
+    [[nodiscard]] const std::vector<iovec>& iovecs() const { return iovecs_; }
+    [[nodiscard]] size_t totalBytes() const { return totalBytes_; }
+
+    using WaitHook = std::function<void(std::vector<iovec>& pending)>;
+
+    // Sends every vector, resuming after partial writes. False on socket error. While the
+    // socket is full, |onWait| runs about every kWaitSliceMs and may repoint what is pending.
+    static bool writeFully(int fd, std::vector<iovec>& vecs, const WaitHook& onWait = nullptr);
+
+    static constexpr int kWaitSliceMs = 10;
+
+private:
+    std::vector<uint8_t> headers_;
+    std::vector<iovec> iovecs_;
+    size_t totalBytes_ = 0;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_RTMPCHUNKWRITER_H
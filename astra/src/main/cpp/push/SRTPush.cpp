@@ -0,0 +1,221 @@
+#include "SRTPush.h"
+
+#include <algorithm>
+
+#include "../common/AstraLog.h"
+
+namespace {
+constexpr const char* kTag = "SRTPush";
+}  // namespace
+
+SRTPush::SRTPush(const char* url, JavaCallback** javaCallback)
+    : url_(url ? url : ""), callback_(javaCallback ? *javaCallback : nullptr) {}
+
+SRTPush::~SRTPush() {
+    stop();
+}
+
+void SRTPush::configureVideo(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.setVideoConfig(config);
+    hasVideo_ = config.width > 0 && config.height > 0;
+    topTemporalId_ = 0;
+    sheddingTopLayer_ = false;
+    muxer_.reset();  // new track: restart at the next keyframe with fresh tables
+}
+
+void SRTPush::updateVideoConfig(const astra::VideoConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.updateVideoConfig(config);  // the PMT stays; the next keyframe carries the new SPS
+}
+
+void SRTPush::configureAudio(const astra::AudioConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parser_.setAudioConfig(config);
+    audioExpected_ = config.sampleRate > 0;
+    muxer_.reset();
+}
+
+void SRTPush::start() {
+    startWorker();
+}
+
+void SRTPush::stop() {
+    sender_.close();
+    joinWorker();
+    std::lock_guard<std::mutex> lock(mutex_);
+    muxer_.reset();
+}
+
+void SRTPush::main() {
+    if (callback_) {
+        callback_->onConnecting(ThreadContext::Worker);
+    }
+    astra::SrtOptions options;
+    std::string error;
+    if (!astra::ParseSrtUrl(url_, options, error)) {
+        ASTRA_LOGE(kTag, "bad url: %s", error.c_str());
+        if (callback_) {
+            callback_->onConnectFail(RtmpErrorCode::UrlSetupFailure);
+        }
+        return;
+    }
+    if (!sender_.connect(options, error)) {
+        ASTRA_LOGE(kTag, "connect %s:%u failed: %s", options.host.c_str(), options.port, error.c_str());
+        if (callback_) {
+            callback_->onConnectFail(RtmpErrorCode::ConnectFailure);
+        }
+        return;
+    }
+    if (callback_) {
+        callback_->onConnectSuccess();
+    }
+    requestKeyFrame("connected");  // the TS stream starts at the next key frame
+    const bool closedLocally = sender_.run();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        muxer_.reset();
+    }
+    const astra::SrtStats stats = sender_.stats();
+    ASTRA_LOGI(kTag, "link ended sent=%llu rexmit=%llu lost=%llu dropped=%llu",
+               static_cast<unsigned long long>(stats.packetsSent),
+               static_cast<unsigned long long>(stats.packetsRetransmitted),
+               static_cast<unsigned long long>(stats.packetsLost),
+               static_cast<unsigned long long>(stats.packetsDropped));
+    if (!closedLocally && callback_) {
+        callback_->onConnectFail(RtmpErrorCode::Closed);
+    }
+}
+
+void SRTPush::pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Parsed even while unconnected so the parameter sets are known at the first keyframe.
+    const astra::ParsedVideoFrame frame = parser_.parseVideoFrame(data, length);
+    if (!frame.hasData()) {
+        return;
+    }
+    const astra::ByteSpan payload{frame.payload.data(), frame.payload.size()};
+    addVideoLocked(&payload, 1, pts, frame.isKeyFrame, frame.temporalId);
+}
+
+bool SRTPush::pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts) {
+    if (!lease) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    {
+        auto pinned = lease.pin();
+        if (!pinned.owns_lock()) {
+            return false;
+        }
+        const astra::ParsedVideoSlices slices = parser_.sliceVideoFrameInPlace(lease.data(), lease.size());
+        if (!slices.hasData()) {
+            return false;
+        }
+        // The muxer copies the slices into datagrams here, so the buffer goes back right away.
+        addVideoLocked(slices.spans.data(), slices.spans.size(), pts, slices.isKeyFrame, slices.temporalId);
+    }
+    lease.reset();
+    return true;
+}
+
+void SRTPush::pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!sender_.connected()) {
+        return;
+    }
+    if (!muxer_ && (hasVideo_ || !beginLocked())) {
+        return;
+    }
+    muxer_->addAudioSample(data, length, pts);
+    muxer_->flush();
+}
+
+bool SRTPush::linkStats(PushLinkStats& stats) const {
+    if (!sender_.connected()) {
+        return false;
+    }
+    const astra::SrtStats link = sender_.stats();
+    stats.rttUs = link.rttUs;
+    stats.packetsSent = link.packetsSent;
+    stats.packetsRetransmitted = link.packetsRetransmitted;
+    stats.packetsLost = link.packetsLost;
+    stats.packetsDropped = link.packetsDropped;
+    stats.bytesSent = link.bytesSent;
+    stats.receiveRateBps = link.receiveRateBps;
+    stats.latencyMs = link.latencyMs;
+    return true;
+}
+
+void SRTPush::addVideoLocked(const astra::ByteSpan* parts,
+                             size_t count,
+                             int64_t pts,
+                             bool keyFrame,
+                             uint8_t temporalId) {
+    if (!sender_.connected()) {
+        muxer_.reset();
+        return;
+    }
+    const astra::SrtStats link = sender_.stats();
+    if (link.packetsDropped != droppedSeen_) {
+        // Too-late drops broke the receiver's reference chain until the next key frame.
+        droppedSeen_ = link.packetsDropped;
+        requestKeyFrame("packets dropped");
+    }
+    if (shedTopLayerLocked(temporalId, link.latencyMs)) {
+        return;
+    }
+    if (!muxer_ && (!keyFrame || !beginLocked())) {
+        return;
+    }
+    if (keyFrame && parser_.parameterSetGeneration() != videoGeneration_) {
+        // New parameter sets (a resolution switch): repeat them from this keyframe on.
+        auto record = parser_.buildDecoderConfigurationRecord();
+        if (record.has_value() && muxer_->setVideoTrack(parser_.streamVideoConfig(), *record)) {
+            videoGeneration_ = parser_.parameterSetGeneration();
+        }
+    }
+    muxer_->addVideoSample(parts, count, pts, keyFrame);
+    // One access unit per flush keeps a frame from waiting on the next one to fill a datagram.
+    muxer_->flush();
+}
+
+bool SRTPush::shedTopLayerLocked(uint8_t temporalId, uint32_t latencyMs) {
+    topTemporalId_ = std::max(topTemporalId_, temporalId);
+    if (topTemporalId_ == 0 || latencyMs == 0) {
+        return false;
+    }
+    const int64_t budgetUs = static_cast<int64_t>(latencyMs) * 1000;
+    const int64_t backlogUs = sender_.backlogUs();
+    if (!sheddingTopLayer_ && backlogUs > budgetUs / 2) {
+        sheddingTopLayer_ = true;
+        ASTRA_LOGI(kTag, "shedding temporal layer %u: backlog=%lld ms of %u",
+                   topTemporalId_, static_cast<long long>(backlogUs / 1000), latencyMs);
+    } else if (sheddingTopLayer_ && backlogUs < budgetUs / 8) {
+        sheddingTopLayer_ = false;
+        ASTRA_LOGI(kTag, "temporal layer %u resumed", topTemporalId_);
+    }
+    return sheddingTopLayer_ && temporalId >= topTemporalId_;
+}
+
+bool SRTPush::beginLocked() {
+    // PMT lists both streams, so wait for the AAC config as well.
+    if (audioExpected_ && !parser_.audioSequenceReady()) {
+        return false;
+    }
+    auto muxer = std::make_unique<astra::TsMuxer>(pool_);
+    if (hasVideo_) {
+        auto record = parser_.buildDecoderConfigurationRecord();
+        if (!record.has_value() || !muxer->setVideoTrack(parser_.streamVideoConfig(), *record)) {
+            return false;
+        }
+        videoGeneration_ = parser_.parameterSetGeneration();
+    }
+    if (audioExpected_ && !muxer->setAudioTrack(parser_.audioConfig())) {
+        return false;
+    }
+    muxer->setDatagramSink([this](astra::TsDatagramPtr datagram) { sender_.send(std::move(datagram)); });
+    muxer_ = std::move(muxer);
+    ASTRA_LOGI(kTag, "ts stream started video=%d audio=%d", hasVideo_ ? 1 : 0, audioExpected_ ? 1 : 0);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef ASTRASTREAM_SRTPUSH_H
+#define ASTRASTREAM_SRTPUSH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "IPush.h"
+#include "JavaCallback.h"
+#include "SrtSender.h"
+#include "../stream/FlvMuxer.h"
+#include "../stream/TsMuxer.h"
+
+// Push engine for srt:// URLs: MPEG-TS in SRT live mode. The encoder threads mux straight
+// into pooled datagrams which the worker thread sends, so there is no packet queue of its
+// own; the SRT latency budget decides what is too old to send. Frames arriving before the
+// handshake completes are dropped and the stream starts at the next keyframe.
+class SRTPush : public IPush {
+public:
+    SRTPush(const char* url, JavaCallback** javaCallback);
+    ~SRTPush() override;
+
+    void start() override;
+    void stop() override;
+    void main() override;
+    void configureVideo(const astra::VideoConfig& config) override;
+    void updateVideoConfig(const astra::VideoConfig& config) override;
+    void configureAudio(const astra::AudioConfig& config) override;
+    void pushVideoFrame(const uint8_t* data, size_t length, int64_t pts) override;
+    void pushAudioFrame(const uint8_t* data, size_t length, int64_t pts) override;
+    bool pushLeasedVideoFrame(astra::EncodedBufferLease& lease, int64_t pts) override;
+    bool linkStats(PushLinkStats& stats) const override;
+
+private:
+    bool beginLocked();
+    void addVideoLocked(const astra::ByteSpan* parts, size_t count, int64_t pts, bool keyFrame, uint8_t temporalId);
+    // Temporally layered video: while half the latency budget sits unsent, frames of the top
+    // layer are dropped (true) before they are muxed, so the rest arrives in time.
+    bool shedTopLayerLocked(uint8_t temporalId, uint32_t latencyMs);
+
+    std::string url_;
+    JavaCallback* callback_ = nullptr;
+    astra::SrtSender sender_;
+    std::shared_ptr<astra::TsDatagramPool> pool_ = astra::TsDatagramPool::create();
+
+    std::mutex mutex_;  // muxing state, taken by the encoder threads
+    astra::FlvMuxer parser_;
+    std::unique_ptr<astra::TsMuxer> muxer_;
+    uint32_t videoGeneration_ = 0;  // parser_ parameter sets the muxer's video track was set from
+    uint8_t topTemporalId_ = 0;  // highest temporal layer seen since configureVideo
+    bool sheddingTopLayer_ = false;
+    uint64_t droppedSeen_ = 0;  // sender_ packetsDropped already answered with a key frame request
+    bool hasVideo_ = false;
+    bool audioExpected_ = false;
+};
+
+#endif  // ASTRASTREAM_SRTPUSH_H
@@ -0,0 +1,272 @@
+#include "SrtPacket.h"
+
+#include <algorithm>
+
+namespace astra::srt {
+
+namespace {
+
+constexpr size_t kAckFullSize = 28;
+constexpr size_t kAckSmallSize = 16;
+constexpr size_t kAckLightSize = 4;
+constexpr uint32_t kLossRangeFlag = 0x80000000;
+
+void PutU32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t GetU32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+void AppendU32(std::vector<uint8_t>& out, uint32_t value) {
+    const size_t position = out.size();
+    out.resize(position + 4);
+    PutU32(out.data() + position, value);
+}
+
+std::vector<uint8_t> StartControl(const ControlHeader& header, size_t cifSize) {
+    std::vector<uint8_t> packet(kHeaderSize);
+    packet.reserve(kHeaderSize + cifSize);
+    WriteControlHeader(packet.data(), header);
+    return packet;
+}
+
+// libsrt sends the Stream ID as 32-bit words with the bytes of each word reversed.
+void AppendStreamId(std::vector<uint8_t>& out, const std::string& streamId) {
+    const size_t words = (streamId.size() + 3) / 4;
+    const size_t position = out.size();
+    out.resize(position + words * 4, 0);
+    for (size_t i = 0; i < streamId.size(); ++i) {
+        out[position + (i & ~size_t{3}) + 3 - (i & 3)] = static_cast<uint8_t>(streamId[i]);
+    }
+}
+
+std::string ReadStreamId(const uint8_t* data, size_t words) {
+    std::string value(words * 4, '\0');
+    for (size_t i = 0; i < value.size(); ++i) {
+        value[i] = static_cast<char>(data[(i & ~size_t{3}) + 3 - (i & 3)]);
+    }
+    value.resize(std::min(value.find('\0'), value.size()));
+    return value;
+}
+
+}  // namespace
+
+int32_t SequenceOffset(uint32_t a, uint32_t b) {
+    const uint32_t distance = (a - b) & kMaxSequence;
+    if (distance > kMaxSequence / 2) {
+        return -static_cast<int32_t>(kMaxSequence - distance) - 1;
+    }
+    return static_cast<int32_t>(distance);
+}
+
+void WriteDataHeader(uint8_t* out, const DataHeader& header) {
+    PutU32(out, header.sequence & kMaxSequence);
+    PutU32(out + 4, kPositionSolo | (header.retransmitted ? kRetransmittedFlag : 0) |
+                            (header.messageNumber & kMaxMessageNumber));
+    PutU32(out + 8, header.timestampUs);
+    PutU32(out + 12, header.destinationSocket);
+}
+
+bool ReadDataHeader(const uint8_t* packet, size_t size, DataHeader& header) {
+    if (size < kHeaderSize || IsControl(packet)) {
+        return false;
+    }
+    header.sequence = GetU32(packet) & kMaxSequence;
+    const uint32_t word = GetU32(packet + 4);
+    header.messageNumber = word & kMaxMessageNumber;
+    header.retransmitted = (word & kRetransmittedFlag) != 0;
+    header.timestampUs = GetU32(packet + 8);
+    header.destinationSocket = GetU32(packet + 12);
+    return true;
+}
+
+void WriteControlHeader(uint8_t* out, const ControlHeader& header) {
+    PutU32(out, 0x80000000u | (static_cast<uint32_t>(header.type) << 16));
+    PutU32(out + 4, header.typeSpecific);
+    PutU32(out + 8, header.timestampUs);
+    PutU32(out + 12, header.destinationSocket);
+}
+
+bool ReadControlHeader(const uint8_t* packet, size_t size, ControlHeader& header) {
+    if (size < kHeaderSize || !IsControl(packet)) {
+        return false;
+    }
+    header.type = static_cast<ControlType>((GetU32(packet) >> 16) & 0x7FFF);
+    header.typeSpecific = GetU32(packet + 4);
+    header.timestampUs = GetU32(packet + 8);
+    header.destinationSocket = GetU32(packet + 12);
+    return true;
+}
+
+std::vector<uint8_t> BuildHandshake(const ControlHeader& header, const Handshake& handshake) {
+    std::vector<uint8_t> packet = StartControl(header, kHandshakeSize + 64 + handshake.streamId.size());
+    AppendU32(packet, handshake.version);
+    AppendU32(packet, (static_cast<uint32_t>(handshake.encryption) << 16) | handshake.extension);
+    AppendU32(packet, handshake.initialSequence);
+    AppendU32(packet, handshake.mtu);
+    AppendU32(packet, handshake.flowWindow);
+    AppendU32(packet, static_cast<uint32_t>(handshake.type));
+    AppendU32(packet, handshake.socketId);
+    AppendU32(packet, handshake.cookie);
+    for (uint32_t word : handshake.peerAddress) {
+        AppendU32(packet, word);
+    }
+    if (handshake.hasSrtInfo) {
+        AppendU32(packet, (static_cast<uint32_t>(handshake.srtCommand) << 16) | 3);
+        AppendU32(packet, handshake.srtVersion);
+        AppendU32(packet, handshake.srtFlags);
+        AppendU32(packet, (static_cast<uint32_t>(handshake.receiverDelayMs) << 16) | handshake.senderDelayMs);
+    }
+    if (!handshake.streamId.empty()) {
+        AppendU32(packet, (static_cast<uint32_t>(kCmdStreamId) << 16) |
+                                  static_cast<uint32_t>((handshake.streamId.size() + 3) / 4));
+        AppendStreamId(packet, handshake.streamId);
+    }
+    return packet;
+}
+
+bool ParseHandshake(const uint8_t* packet, size_t size, Handshake& handshake) {
+    ControlHeader header;
+    if (!ReadControlHeader(packet, size, header) || header.type != ControlType::kHandshake ||
+        size < kHeaderSize + kHandshakeSize) {
+        return false;
+    }
+    const uint8_t* cif = packet + kHeaderSize;
+    handshake.version = GetU32(cif);
+    handshake.encryption = static_cast<uint16_t>(GetU32(cif + 4) >> 16);
+    handshake.extension = static_cast<uint16_t>(GetU32(cif + 4));
+    handshake.initialSequence = GetU32(cif + 8) & kMaxSequence;
+    handshake.mtu = GetU32(cif + 12);
+    handshake.flowWindow = GetU32(cif + 16);
+    handshake.type = static_cast<HandshakeType>(GetU32(cif + 20));
+    handshake.socketId = GetU32(cif + 24);
+    handshake.cookie = GetU32(cif + 28);
+    for (size_t i = 0; i < 4; ++i) {
+        handshake.peerAddress[i] = GetU32(cif + 32 + 4 * i);
+    }
+    handshake.hasSrtInfo = false;
+    handshake.streamId.clear();
+
+    size_t offset = kHeaderSize + kHandshakeSize;
+    while (offset + 4 <= size) {
+        const uint32_t word = GetU32(packet + offset);
+        const uint16_t command = static_cast<uint16_t>(word >> 16);
+        const size_t words = word & 0xFFFF;
+        offset += 4;
+        if (offset + words * 4 > size) {
+            return false;
+        }
+        const uint8_t* body = packet + offset;
+        if ((command == kCmdHsReq || command == kCmdHsRsp) && words >= 3) {
+            handshake.hasSrtInfo = true;
+            handshake.srtCommand = command;
+            handshake.srtVersion = GetU32(body);
+            handshake.srtFlags = GetU32(body + 4);
+            handshake.receiverDelayMs = static_cast<uint16_t>(GetU32(body + 8) >> 16);
+            handshake.senderDelayMs = static_cast<uint16_t>(GetU32(body + 8));
+        } else if (command == kCmdStreamId) {
+            handshake.streamId = ReadStreamId(body, words);
+        }
+        offset += words * 4;
+    }
+    return true;
+}
+
+std::vector<uint8_t> BuildAck(const ControlHeader& header, const Ack& ack) {
+    std::vector<uint8_t> packet = StartControl(header, kAckFullSize);
+    AppendU32(packet, ack.lastAcknowledged & kMaxSequence);
+    if (ack.light) {
+        return packet;
+    }
+    AppendU32(packet, ack.rttUs);
+    AppendU32(packet, ack.rttVarianceUs);
+    AppendU32(packet, ack.availableBuffer);
+    AppendU32(packet, ack.packetsPerSecond);
+    AppendU32(packet, ack.linkCapacity);
+    AppendU32(packet, ack.bytesPerSecond);
+    return packet;
+}
+
+bool ParseAck(const uint8_t* packet, size_t size, Ack& ack) {
+    if (size < kHeaderSize + kAckLightSize) {
+        return false;
+    }
+    const uint8_t* cif = packet + kHeaderSize;
+    const size_t cifSize = size - kHeaderSize;
+    ack = Ack{};
+    ack.lastAcknowledged = GetU32(cif) & kMaxSequence;
+    ack.light = cifSize < kAckSmallSize;
+    if (ack.light) {
+        return true;
+    }
+    ack.rttUs = GetU32(cif + 4);
+    ack.rttVarianceUs = GetU32(cif + 8);
+    ack.availableBuffer = GetU32(cif + 12);
+    if (cifSize >= kAckFullSize) {
+        ack.packetsPerSecond = GetU32(cif + 16);
+        ack.linkCapacity = GetU32(cif + 20);
+        ack.bytesPerSecond = GetU32(cif + 24);
+    }
+    return true;
+}
+
+std::vector<uint8_t> BuildNak(const ControlHeader& header, const std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+    std::vector<uint8_t> packet = StartControl(header, ranges.size() * 8);
+    for (const auto& [first, last] : ranges) {
+        if (first == last) {
+            AppendU32(packet, first & kMaxSequence);
+        } else {
+            AppendU32(packet, kLossRangeFlag | (first & kMaxSequence));
+            AppendU32(packet, last & kMaxSequence);
+        }
+    }
+    return packet;
+}
+
+bool ParseNak(const uint8_t* packet, size_t size, std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+    ranges.clear();
+    for (size_t offset = kHeaderSize; offset + 4 <= size; offset += 4) {
+        const uint32_t word = GetU32(packet + offset);
+        if ((word & kLossRangeFlag) == 0) {
+            ranges.emplace_back(word, word);
+            continue;
+        }
+        if (offset + 8 > size) {
+            return false;
+        }
+        offset += 4;
+        ranges.emplace_back(word & kMaxSequence, GetU32(packet + offset) & kMaxSequence);
+    }
+    return size >= kHeaderSize;
+}
+
+std::vector<uint8_t> BuildDropRequest(const ControlHeader& header, uint32_t firstSequence, uint32_t lastSequence) {
+    std::vector<uint8_t> packet = StartControl(header, 8);
+    AppendU32(packet, firstSequence & kMaxSequence);
+    AppendU32(packet, lastSequence & kMaxSequence);
+    return packet;
+}
+
+bool ParseDropRequest(const uint8_t* packet, size_t size, uint32_t& firstSequence, uint32_t& lastSequence) {
+    if (size < kHeaderSize + 8) {
+        return false;
+    }
+    firstSequence = GetU32(packet + kHeaderSize) & kMaxSequence;
+    lastSequence = GetU32(packet + kHeaderSize + 4) & kMaxSequence;
+    return true;
+}
+
+std::vector<uint8_t> BuildControl(const ControlHeader& header) {
+    // Keepalive, ACKACK and shutdown carry a 4-byte placeholder control information field.
+    std::vector<uint8_t> packet = StartControl(header, 4);
+    AppendU32(packet, 0);
+    return packet;
+}
+
+}  // namespace astra::srt
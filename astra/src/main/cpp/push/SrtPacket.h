@@ -0,0 +1,141 @@
+#ifndef ASTRASTREAM_SRTPACKET_H
+#define ASTRASTREAM_SRTPACKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace astra::srt {
+
+// SRT wire format (draft-sharabayko-srt, live mode, no encryption): the 16-byte packet
+// header, the v5 handshake with its HSREQ/HSRSP and Stream ID extensions, ACK and NAK
+// bodies. Everything is big-endian 32-bit words. Shared by SrtSender and the loopback
+// listener used to test it.
+
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kHandshakeSize = 48;
+constexpr size_t kMaxPayload = 1316;  // seven TS packets, the live-mode default
+constexpr uint32_t kMaxSequence = 0x7FFFFFFF;
+constexpr uint32_t kMaxMessageNumber = 0x03FFFFFF;
+
+enum class ControlType : uint16_t {
+    kHandshake = 0x0000,
+    kKeepalive = 0x0001,
+    kAck = 0x0002,
+    kNak = 0x0003,
+    kShutdown = 0x0005,
+    kAckAck = 0x0006,
+    kDropRequest = 0x0007,
+};
+
+enum class HandshakeType : uint32_t {
+    kInduction = 0x00000001,
+    kConclusion = 0xFFFFFFFF,
+    kAgreement = 0xFFFFFFFE,
+    kDone = 0xFFFFFFFD,
+    // Rejections sent back in place of a conclusion are 1000 + reason.
+    kRejectBase = 1000,
+};
+
+constexpr uint32_t kHandshakeVersion4 = 4;
+constexpr uint32_t kHandshakeVersion5 = 5;
+constexpr uint16_t kInductionMagic = 0x4A17;  // listener's extension field in its induction reply
+constexpr uint16_t kUdtDgram = 2;  // caller's extension field in its induction request
+
+// Handshake extension flags (conclusion) and extension block types.
+constexpr uint16_t kExtHsReq = 0x0001;
+constexpr uint16_t kExtConfig = 0x0004;
+constexpr uint16_t kCmdHsReq = 1;
+constexpr uint16_t kCmdHsRsp = 2;
+constexpr uint16_t kCmdStreamId = 5;
+
+// HSREQ/HSRSP capability flags.
+constexpr uint32_t kFlagTsbpdSend = 0x01;
+constexpr uint32_t kFlagTsbpdRecv = 0x02;
+constexpr uint32_t kFlagTooLateDrop = 0x08;
+constexpr uint32_t kFlagPeriodicNak = 0x10;
+constexpr uint32_t kFlagRexmit = 0x20;
+
+constexpr uint32_t kSrtVersion = 0x00010500;  // speaks the 1.5 handshake
+
+// Data packet position: solo message, one packet per message in live mode.
+constexpr uint32_t kPositionSolo = 0xC0000000;
+constexpr uint32_t kRetransmittedFlag = 0x04000000;
+
+struct DataHeader {
+    uint32_t sequence = 0;
+    uint32_t messageNumber = 0;
+    bool retransmitted = false;
+    uint32_t timestampUs = 0;
+    uint32_t destinationSocket = 0;
+};
+
+struct ControlHeader {
+    ControlType type = ControlType::kKeepalive;
+    uint32_t typeSpecific = 0;  // ACK / ACKACK number, DROPREQ message number
+    uint32_t timestampUs = 0;
+    uint32_t destinationSocket = 0;
+};
+
+struct Handshake {
+    uint32_t version = kHandshakeVersion5;
+    uint16_t encryption = 0;
+    uint16_t extension = 0;
+    uint32_t initialSequence = 0;
+    uint32_t mtu = 1500;
+    uint32_t flowWindow = 8192;
+    HandshakeType type = HandshakeType::kInduction;
+    uint32_t socketId = 0;
+    uint32_t cookie = 0;
+    uint32_t peerAddress[4] = {0, 0, 0, 0};
+
+    // Extensions, conclusion only.
+    bool hasSrtInfo = false;
+    uint16_t srtCommand = kCmdHsReq;  // kCmdHsRsp when a listener answers
+    uint32_t srtVersion = 0;
+    uint32_t srtFlags = 0;
+    uint16_t receiverDelayMs = 0;
+    uint16_t senderDelayMs = 0;
+    std::string streamId;
+};
+
+// Receiver's full ACK. Light ACKs carry only |lastAcknowledged|.
+struct Ack {
+    uint32_t lastAcknowledged = 0;  // first sequence not yet received
+    uint32_t rttUs = 0;
+    uint32_t rttVarianceUs = 0;
+    uint32_t availableBuffer = 0;  // packets
+    uint32_t packetsPerSecond = 0;
+    uint32_t linkCapacity = 0;  // packets per second
+    uint32_t bytesPerSecond = 0;
+    bool light = false;
+};
+
+inline bool IsControl(const uint8_t* packet) { return (packet[0] & 0x80) != 0; }
+
+// Sequence arithmetic over the 31-bit space: |a| - |b|, assuming they are within half of it.
+int32_t SequenceOffset(uint32_t a, uint32_t b);
+inline uint32_t SequenceNext(uint32_t sequence) { return (sequence + 1) & kMaxSequence; }
+
+void WriteDataHeader(uint8_t* out, const DataHeader& header);
+bool ReadDataHeader(const uint8_t* packet, size_t size, DataHeader& header);
+void WriteControlHeader(uint8_t* out, const ControlHeader& header);
+bool ReadControlHeader(const uint8_t* packet, size_t size, ControlHeader& header);
+
+// Whole packets: header plus control information field.
+std::vector<uint8_t> BuildHandshake(const ControlHeader& header, const Handshake& handshake);
+bool ParseHandshake(const uint8_t* packet, size_t size, Handshake& handshake);
+std::vector<uint8_t> BuildAck(const ControlHeader& header, const Ack& ack);
+bool ParseAck(const uint8_t* packet, size_t size, Ack& ack);
+// Losses as inclusive [first, last] ranges; single packets have first == last.
+std::vector<uint8_t> BuildNak(const ControlHeader& header, const std::vector<std::pair<uint32_t, uint32_t>>& ranges);
+bool ParseNak(const uint8_t* packet, size_t size, std::vector<std::pair<uint32_t, uint32_t>>& ranges);
+std::vector<uint8_t> BuildDropRequest(const ControlHeader& header, uint32_t firstSequence, uint32_t lastSequence);
+bool ParseDropRequest(const uint8_t* packet, size_t size, uint32_t& firstSequence, uint32_t& lastSequence);
+std::vector<uint8_t> BuildControl(const ControlHeader& header);  // keepalive, ACKACK, shutdown
+
+}  // namespace astra::srt
+
+#endif  // ASTRASTREAM_SRTPACKET_H
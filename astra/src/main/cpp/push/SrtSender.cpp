@@ -0,0 +1,608 @@
+#include "SrtSender.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "../common/AstraLog.h"
+#include "../stream/MediaClock.h"
+
+namespace astra {
+
+namespace {
+constexpr const char* kTag = "SrtSender";
+constexpr int kTickMs = 10;  // SRT's SYN interval: ACK cadence on the receiver
+constexpr int64_t kHandshakeRetryUs = 250000;
+constexpr int64_t kKeepaliveIntervalUs = 1000000;
+constexpr int64_t kStatsLogIntervalUs = 5000000;
+constexpr int kSocketBufferBytes = 1 << 20;
+constexpr size_t kSendBatch = 64;
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string PercentDecode(const std::string& value) {
+    std::string decoded;
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size() && HexValue(value[i + 1]) >= 0 && HexValue(value[i + 2]) >= 0) {
+            decoded.push_back(static_cast<char>(HexValue(value[i + 1]) * 16 + HexValue(value[i + 2])));
+            i += 2;
+        } else {
+            decoded.push_back(value[i]);
+        }
+    }
+    return decoded;
+}
+}  // namespace
+
+bool ParseSrtUrl(const std::string& url, SrtOptions& options, std::string& error) {
+    constexpr char kScheme[] = "srt://";
+    constexpr size_t kSchemeLength = sizeof(kScheme) - 1;
+    if (url.size() <= kSchemeLength || strncasecmp(url.c_str(), kScheme, kSchemeLength) != 0) {
+        error = "not an srt:// url";
+        return false;
+    }
+    const size_t query = url.find('?', kSchemeLength);
+    std::string authority = url.substr(kSchemeLength, query == std::string::npos ? std::string::npos : query - kSchemeLength);
+    while (!authority.empty() && authority.back() == '/') {
+        authority.pop_back();
+    }
+    size_t portSeparator = authority.rfind(':');
+    if (!authority.empty() && authority.front() == '[') {
+        const size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            error = "unterminated IPv6 address";
+            return false;
+        }
+        options.host = authority.substr(1, close - 1);
+        portSeparator = close + 1 < authority.size() && authority[close + 1] == ':' ? close + 1 : std::string::npos;
+    } else {
+        options.host = authority.substr(0, portSeparator);
+    }
+    const long port = portSeparator == std::string::npos ? 0 : std::strtol(authority.c_str() + portSeparator + 1, nullptr, 10);
+    if (options.host.empty() || port <= 0 || port > 65535) {
+        error = "srt url needs host:port";
+        return false;
+    }
+    options.port = static_cast<uint16_t>(port);
+
+    size_t position = query == std::string::npos ? url.size() : query + 1;
+    while (position < url.size()) {
+        size_t end = url.find('&', position);
+        if (end == std::string::npos) {
+            end = url.size();
+        }
+        const std::string pair = url.substr(position, end - position);
+        position = end + 1;
+        const size_t equals = pair.find('=');
+        const std::string key = pair.substr(0, equals);
+        const std::string value = equals == std::string::npos ? "" : PercentDecode(pair.substr(equals + 1));
+        if (key == "latency") {
+            options.latencyMs = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (key == "streamid") {
+            options.streamId = value;
+        } else if (key == "connect_timeout") {
+            options.connectTimeoutMs = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (key == "mode") {
+            if (!value.empty() && value != "caller") {
+                error = "only caller mode is supported";
+                return false;
+            }
+        } else if (key == "passphrase" || key == "pbkeylen") {
+            error = "encryption is not supported";
+            return false;
+        } else if (!key.empty()) {
+            ASTRA_LOGW(kTag, "ignoring srt url option %s", key.c_str());
+        }
+    }
+    if (options.latencyMs == 0 || options.latencyMs > 0xFFFF) {
+        error = "latency out of range";
+        return false;
+    }
+    return true;
+}
+
+SrtSender::SrtSender() {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0) {
+        wakeRead_ = fds[0];
+        wakeWrite_ = fds[1];
+    }
+    receiveBuffer_.resize(2048);
+}
+
+SrtSender::~SrtSender() {
+    closeSocket();
+    if (wakeRead_ >= 0) {
+        ::close(wakeRead_);
+    }
+    if (wakeWrite_ >= 0) {
+        ::close(wakeWrite_);
+    }
+}
+
+bool SrtSender::connect(const SrtOptions& options, std::string& error) {
+    closeSocket();
+    closing_ = false;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    const std::string port = std::to_string(options.port);
+    if (::getaddrinfo(options.host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr) {
+        error = "cannot resolve " + options.host;
+        return false;
+    }
+    socket_ = ::socket(result->ai_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    // A connected UDP socket only sees the peer's packets and reports ICMP unreachable.
+    const bool ok = socket_ >= 0 && ::connect(socket_, result->ai_addr, result->ai_addrlen) == 0;
+    ::freeaddrinfo(result);
+    if (!ok) {
+        error = "socket setup failed errno=" + std::to_string(errno);
+        closeSocket();
+        return false;
+    }
+    ::setsockopt(socket_, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    ::setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queue_.clear();
+    }
+    inFlight_.clear();
+    losses_.clear();
+    peerClosed_ = false;
+    idleTimeoutUs_ = static_cast<int64_t>(options.peerIdleTimeoutMs) * 1000;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_ = SrtStats{};
+    }
+    if (!handshake(options, error)) {
+        closeSocket();
+        return false;
+    }
+    connected_ = true;
+    ASTRA_LOGI(kTag, "connected %s:%u latency=%lld ms peer socket=%08x",
+               options.host.c_str(), options.port, static_cast<long long>(latencyUs_ / 1000), peerSocketId_);
+    return true;
+}
+
+bool SrtSender::handshake(const SrtOptions& options, std::string& error) {
+    std::random_device random;
+    socketId_ = (random() & 0x3FFFFFFF) | 1;
+    const uint32_t initialSequence = random() & srt::kMaxSequence;
+    startUs_ = MonotonicNowUs();
+    const int64_t deadlineUs = startUs_ + static_cast<int64_t>(options.connectTimeoutMs) * 1000;
+
+    srt::ControlHeader header;
+    header.type = srt::ControlType::kHandshake;
+
+    srt::Handshake induction;
+    induction.version = srt::kHandshakeVersion4;
+    induction.extension = srt::kUdtDgram;
+    induction.initialSequence = initialSequence;
+    induction.type = srt::HandshakeType::kInduction;
+    induction.socketId = socketId_;
+    header.timestampUs = elapsedUs(MonotonicNowUs());
+    srt::Handshake reply;
+    if (!exchange(srt::BuildHandshake(header, induction), srt::HandshakeType::kInduction, reply, deadlineUs)) {
+        error = closing_ ? "closed during handshake" : "no induction response";
+        return false;
+    }
+    if (reply.version < srt::kHandshakeVersion5 || reply.extension != srt::kInductionMagic) {
+        error = "peer does not offer the HSv5 handshake";
+        return false;
+    }
+
+    srt::Handshake conclusion;
+    conclusion.version = srt::kHandshakeVersion5;
+    conclusion.extension = srt::kExtHsReq | (options.streamId.empty() ? 0 : srt::kExtConfig);
+    conclusion.initialSequence = initialSequence;
+    conclusion.type = srt::HandshakeType::kConclusion;
+    conclusion.socketId = socketId_;
+    conclusion.cookie = reply.cookie;
+    conclusion.hasSrtInfo = true;
+    conclusion.srtCommand = srt::kCmdHsReq;
+    conclusion.srtVersion = srt::kSrtVersion;
+    conclusion.srtFlags = srt::kFlagTsbpdSend | srt::kFlagTsbpdRecv | srt::kFlagTooLateDrop |
+                          srt::kFlagPeriodicNak | srt::kFlagRexmit;
+    conclusion.receiverDelayMs = static_cast<uint16_t>(options.latencyMs);
+    conclusion.senderDelayMs = static_cast<uint16_t>(options.latencyMs);
+    conclusion.streamId = options.streamId;
+    header.timestampUs = elapsedUs(MonotonicNowUs());
+    if (!exchange(srt::BuildHandshake(header, conclusion), srt::HandshakeType::kConclusion, reply, deadlineUs)) {
+        error = closing_ ? "closed during handshake" : "no conclusion response";
+        return false;
+    }
+    const auto type = static_cast<uint32_t>(reply.type);
+    if (type >= static_cast<uint32_t>(srt::HandshakeType::kRejectBase) && type < 0xFFFFFF00u) {
+        error = "rejected by listener, reason " + std::to_string(type - static_cast<uint32_t>(srt::HandshakeType::kRejectBase));
+        return false;
+    }
+
+    peerSocketId_ = reply.socketId;
+    flowWindow_ = std::max<uint32_t>(reply.flowWindow, 32);
+    // The receiver delays by the larger of the two latencies; that is the budget here too.
+    const uint32_t latencyMs = reply.hasSrtInfo ? std::max<uint32_t>(options.latencyMs, reply.receiverDelayMs)
+                                                : options.latencyMs;
+    latencyUs_ = static_cast<int64_t>(latencyMs) * 1000;
+    nextSequence_ = initialSequence;
+    nextMessage_ = 1;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.latencyMs = latencyMs;
+    return true;
+}
+
+bool SrtSender::exchange(const std::vector<uint8_t>& request, srt::HandshakeType expected,
+                         srt::Handshake& response, int64_t deadlineUs) {
+    int64_t nextSendUs = 0;
+    while (!closing_) {
+        const int64_t nowUs = MonotonicNowUs();
+        if (nowUs >= deadlineUs) {
+            return false;
+        }
+        if (nowUs >= nextSendUs) {
+            sendControl(request);
+            nextSendUs = nowUs + kHandshakeRetryUs;
+        }
+        pollfd fds[2] = {{socket_, POLLIN, 0}, {wakeRead_, POLLIN, 0}};
+        const int timeoutMs = static_cast<int>((std::min(nextSendUs, deadlineUs) - nowUs + 999) / 1000);
+        if (::poll(fds, 2, timeoutMs) <= 0 || (fds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+        const ssize_t size = ::recv(socket_, receiveBuffer_.data(), receiveBuffer_.size(), 0);
+        if (size <= 0 || !srt::ParseHandshake(receiveBuffer_.data(), static_cast<size_t>(size), response)) {
+            continue;
+        }
+        const auto type = static_cast<uint32_t>(response.type);
+        const bool rejected = type >= static_cast<uint32_t>(srt::HandshakeType::kRejectBase) && type < 0xFFFFFF00u;
+        if (response.type == expected || (expected == srt::HandshakeType::kConclusion && rejected)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SrtSender::run() {
+    if (socket_ < 0) {
+        return false;
+    }
+    int64_t nowUs = MonotonicNowUs();
+    lastReceiveUs_ = nowUs;
+    lastSendUs_ = nowUs;
+    int64_t nextLogUs = nowUs + kStatsLogIntervalUs;
+    bool healthy = true;
+    while (!closing_) {
+        pollfd fds[2] = {{socket_, POLLIN, 0}, {wakeRead_, POLLIN, 0}};
+        ::poll(fds, 2, kTickMs);
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (::read(wakeRead_, drain, sizeof(drain)) > 0) {
+            }
+        }
+        nowUs = MonotonicNowUs();
+        receivePackets(nowUs);
+        if (peerClosed_) {
+            ASTRA_LOGW(kTag, "peer closed the connection");
+            healthy = false;
+            break;
+        }
+        if (nowUs - lastReceiveUs_ > idleTimeoutUs_) {
+            ASTRA_LOGW(kTag, "peer silent for %lld ms", static_cast<long long>((nowUs - lastReceiveUs_) / 1000));
+            healthy = false;
+            break;
+        }
+        dropTooLate(nowUs);
+        sendRetransmissions(nowUs);
+        sendNew(nowUs);
+        if (nowUs - lastSendUs_ >= kKeepaliveIntervalUs) {
+            srt::ControlHeader header;
+            header.type = srt::ControlType::kKeepalive;
+            header.timestampUs = elapsedUs(nowUs);
+            header.destinationSocket = peerSocketId_;
+            sendControl(srt::BuildControl(header));
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.inFlightPackets = static_cast<uint32_t>(inFlight_.size());
+            if (nowUs >= nextLogUs) {
+                ASTRA_LOGI(kTag, "rtt=%lld us sent=%llu rexmit=%llu lost=%llu dropped=%llu in-flight=%u",
+                           static_cast<long long>(stats_.rttUs),
+                           static_cast<unsigned long long>(stats_.packetsSent),
+                           static_cast<unsigned long long>(stats_.packetsRetransmitted),
+                           static_cast<unsigned long long>(stats_.packetsLost),
+                           static_cast<unsigned long long>(stats_.packetsDropped),
+                           stats_.inFlightPackets);
+                nextLogUs = nowUs + kStatsLogIntervalUs;
+            }
+        }
+    }
+    if (healthy) {
+        srt::ControlHeader header;
+        header.type = srt::ControlType::kShutdown;
+        header.timestampUs = elapsedUs(MonotonicNowUs());
+        header.destinationSocket = peerSocketId_;
+        sendControl(srt::BuildControl(header));
+    }
+    connected_ = false;
+    closeSocket();
+    inFlight_.clear();
+    losses_.clear();
+    return healthy;
+}
+
+void SrtSender::close() {
+    closing_ = true;
+    if (wakeWrite_ >= 0) {
+        const char byte = 1;
+        (void) ::write(wakeWrite_, &byte, 1);
+    }
+}
+
+void SrtSender::send(TsDatagramPtr datagram) {
+    if (!datagram || datagram->size == 0 || !connected_) {
+        return;
+    }
+    bool wasEmpty = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        wasEmpty = queue_.empty();
+        queue_.push_back(Queued{std::move(datagram), MonotonicNowUs()});
+    }
+    if (wasEmpty && wakeWrite_ >= 0) {
+        const char byte = 1;
+        (void) ::write(wakeWrite_, &byte, 1);
+    }
+}
+
+int64_t SrtSender::backlogUs() {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return queue_.empty() ? 0 : MonotonicNowUs() - queue_.front().originUs;
+}
+
+SrtStats SrtSender::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+}
+
+uint32_t SrtSender::elapsedUs(int64_t nowUs) const {
+    return static_cast<uint32_t>(nowUs - startUs_);
+}
+
+bool SrtSender::sendControl(const std::vector<uint8_t>& packet) {
+    const ssize_t sent = ::send(socket_, packet.data(), packet.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == ECONNREFUSED) {
+        peerClosed_ = true;
+    }
+    lastSendUs_ = MonotonicNowUs();
+    return sent == static_cast<ssize_t>(packet.size());
+}
+
+bool SrtSender::sendData(InFlight& packet, bool retransmission, int64_t nowUs) {
+    srt::DataHeader header;
+    header.sequence = packet.sequence;
+    header.messageNumber = packet.messageNumber;
+    header.retransmitted = retransmission;
+    // The origin time, not the send time: the receiver schedules playback from it.
+    header.timestampUs = elapsedUs(packet.originUs);
+    header.destinationSocket = peerSocketId_;
+    uint8_t bytes[srt::kHeaderSize];
+    srt::WriteDataHeader(bytes, header);
+    iovec parts[2] = {{bytes, sizeof(bytes)}, {packet.datagram->bytes.data(), packet.datagram->size}};
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = 2;
+    const ssize_t sent = ::sendmsg(socket_, &message, MSG_NOSIGNAL);
+    packet.lastSentUs = nowUs;
+    lastSendUs_ = nowUs;
+    if (sent < 0) {
+        if (errno == ECONNREFUSED) {
+            peerClosed_ = true;
+        }
+        // Counted as sent: the receiver reports the gap and it is retransmitted.
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (retransmission) {
+        ++stats_.packetsRetransmitted;
+    } else {
+        ++stats_.packetsSent;
+    }
+    stats_.bytesSent += packet.datagram->size;
+    return true;
+}
+
+void SrtSender::receivePackets(int64_t nowUs) {
+    while (true) {
+        const ssize_t size = ::recv(socket_, receiveBuffer_.data(), receiveBuffer_.size(), MSG_DONTWAIT);
+        if (size < 0) {
+            if (errno == ECONNREFUSED) {
+                peerClosed_ = true;
+            }
+            return;
+        }
+        srt::ControlHeader header;
+        if (!srt::ReadControlHeader(receiveBuffer_.data(), static_cast<size_t>(size), header)) {
+            continue;  // a receiver sends no data back
+        }
+        lastReceiveUs_ = nowUs;
+        switch (header.type) {
+            case srt::ControlType::kAck:
+                onAck(receiveBuffer_.data(), static_cast<size_t>(size), header.typeSpecific);
+                break;
+            case srt::ControlType::kNak:
+                onNak(receiveBuffer_.data(), static_cast<size_t>(size));
+                break;
+            case srt::ControlType::kShutdown:
+                peerClosed_ = true;
+                return;
+            default:
+                break;  // keepalive, repeated handshake responses
+        }
+    }
+}
+
+void SrtSender::onAck(const uint8_t* packet, size_t size, uint32_t ackNumber) {
+    srt::Ack ack;
+    if (!srt::ParseAck(packet, size, ack)) {
+        return;
+    }
+    if (!ack.light) {
+        // The receiver measures RTT from the ACK / ACKACK round trip.
+        srt::ControlHeader header;
+        header.type = srt::ControlType::kAckAck;
+        header.typeSpecific = ackNumber;
+        header.timestampUs = elapsedUs(MonotonicNowUs());
+        header.destinationSocket = peerSocketId_;
+        sendControl(srt::BuildControl(header));
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.rttUs = ack.rttUs;
+        stats_.rttVarianceUs = ack.rttVarianceUs;
+        if (ack.bytesPerSecond > 0) {
+            stats_.receiveRateBps = static_cast<uint64_t>(ack.bytesPerSecond) * 8;
+        }
+        if (ack.linkCapacity > 0) {
+            stats_.linkCapacityPps = ack.linkCapacity;
+        }
+    }
+    while (!inFlight_.empty() && srt::SequenceOffset(ack.lastAcknowledged, inFlight_.front().sequence) > 0) {
+        inFlight_.pop_front();
+    }
+}
+
+void SrtSender::onNak(const uint8_t* packet, size_t size) {
+    if (!srt::ParseNak(packet, size, nakRanges_) || inFlight_.empty()) {
+        return;
+    }
+    const uint32_t base = inFlight_.front().sequence;
+    const auto count = static_cast<int32_t>(inFlight_.size());
+    uint64_t reported = 0;
+    for (const auto& [first, last] : nakRanges_) {
+        const int32_t begin = std::max(srt::SequenceOffset(first, base), 0);
+        const int32_t end = std::min(srt::SequenceOffset(last, base), count - 1);
+        for (int32_t index = begin; index <= end; ++index) {
+            InFlight& entry = inFlight_[static_cast<size_t>(index)];
+            if (!entry.retransmitPending) {
+                entry.retransmitPending = true;
+                losses_.push_back(entry.sequence);
+                reported += entry.retransmitted ? 0 : 1;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.packetsLost += reported;
+}
+
+void SrtSender::dropTooLate(int64_t nowUs) {
+    uint64_t dropped = 0;
+    {
+        // Never sent and already past the budget: the receiver could not play it.
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        while (!queue_.empty() && nowUs - queue_.front().originUs > latencyUs_) {
+            queue_.pop_front();
+            ++dropped;
+        }
+    }
+    // Sent packets get an RTT and two ACK periods more for the acknowledgement to come back;
+    // whatever is still missing after that can no longer be played.
+    const int64_t limitUs = latencyUs_ + stats().rttUs + 2 * kTickMs * 1000;
+    if (!inFlight_.empty() && nowUs - inFlight_.front().originUs > limitUs) {
+        const uint32_t first = inFlight_.front().sequence;
+        const uint32_t message = inFlight_.front().messageNumber;
+        uint32_t last = first;
+        while (!inFlight_.empty() && nowUs - inFlight_.front().originUs > limitUs) {
+            const InFlight& entry = inFlight_.front();
+            // Never reported missing means it most likely arrived and only the ACK is late.
+            dropped += entry.retransmitPending || entry.retransmitted ? 1 : 0;
+            last = entry.sequence;
+            inFlight_.pop_front();
+        }
+        srt::ControlHeader header;
+        header.type = srt::ControlType::kDropRequest;
+        header.typeSpecific = message;
+        header.timestampUs = elapsedUs(nowUs);
+        header.destinationSocket = peerSocketId_;
+        sendControl(srt::BuildDropRequest(header, first, last));
+    }
+    if (dropped > 0) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsDropped += dropped;
+    }
+}
+
+void SrtSender::sendRetransmissions(int64_t nowUs) {
+    const int64_t rttUs = stats().rttUs;
+    while (!losses_.empty() && !inFlight_.empty()) {
+        const uint32_t sequence = losses_.front();
+        losses_.pop_front();
+        const int32_t index = srt::SequenceOffset(sequence, inFlight_.front().sequence);
+        if (index < 0 || index >= static_cast<int32_t>(inFlight_.size())) {
+            continue;  // acknowledged or dropped since
+        }
+        InFlight& entry = inFlight_[static_cast<size_t>(index)];
+        // Past the budget a resend would arrive after the receiver's play time; the entry
+        // stays marked until dropTooLate releases it.
+        if (nowUs - entry.originUs > latencyUs_) {
+            continue;
+        }
+        entry.retransmitPending = false;
+        // A report arriving within half an RTT of a resend was sent before that copy arrived.
+        if (entry.retransmitted && nowUs - entry.lastSentUs < rttUs / 2) {
+            continue;
+        }
+        entry.retransmitted = true;
+        sendData(entry, true, nowUs);
+    }
+}
+
+void SrtSender::sendNew(int64_t nowUs) {
+    Queued batch[kSendBatch];
+    while (inFlight_.size() < flowWindow_) {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            const size_t room = std::min<size_t>(flowWindow_ - inFlight_.size(), kSendBatch);
+            while (count < room && !queue_.empty()) {
+                batch[count++] = std::move(queue_.front());
+                queue_.pop_front();
+            }
+        }
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            InFlight entry;
+            entry.sequence = nextSequence_;
+            entry.messageNumber = nextMessage_;
+            entry.originUs = batch[i].originUs;
+            entry.datagram = std::move(batch[i].datagram);
+            nextSequence_ = srt::SequenceNext(nextSequence_);
+            nextMessage_ = nextMessage_ >= srt::kMaxMessageNumber ? 1 : nextMessage_ + 1;
+            inFlight_.push_back(std::move(entry));
+            sendData(inFlight_.back(), false, nowUs);
+        }
+    }
+}
+
+void SrtSender::closeSocket() {
+    if (socket_ >= 0) {
+        ::close(socket_);
+        socket_ = -1;
+    }
+}
+
+}  // namespace astra
@@ -0,0 +1,139 @@
+#ifndef ASTRASTREAM_SRTSENDER_H
+#define ASTRASTREAM_SRTSENDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SrtPacket.h"
+#include "../stream/TsMuxer.h"
+
+namespace astra {
+
+struct SrtOptions {
+    std::string host;
+    uint16_t port = 0;
+    std::string streamId;
+    uint32_t latencyMs = 120;  // TSBPD delay asked of the receiver, libsrt's default
+    uint32_t connectTimeoutMs = 3000;
+    uint32_t peerIdleTimeoutMs = 5000;
+};
+
+// srt://host:port[?latency=<ms>&streamid=<id>&mode=caller]. Encryption is not implemented,
+// so a passphrase is rejected rather than silently ignored.
+bool ParseSrtUrl(const std::string& url, SrtOptions& options, std::string& error);
+
+struct SrtStats {
+    int64_t rttUs = 0;  // smoothed, as the receiver measures it with ACK / ACKACK
+    int64_t rttVarianceUs = 0;
+    uint64_t packetsSent = 0;  // first transmissions
+    uint64_t packetsRetransmitted = 0;
+    uint64_t packetsLost = 0;  // reported missing by the receiver (NAK)
+    uint64_t packetsDropped = 0;  // too late for the latency budget, sent or not
+    uint64_t bytesSent = 0;  // payload, retransmissions included
+    uint64_t receiveRateBps = 0;  // receiver's estimate, from full ACKs
+    uint32_t linkCapacityPps = 0;
+    uint32_t inFlightPackets = 0;  // sent, not yet acknowledged
+    uint32_t latencyMs = 0;  // negotiated
+};
+
+// SRT caller in live mode over one UDP socket, implemented in-tree (no libsrt): HSv5
+// handshake with HSREQ and Stream ID, data packets carrying the TsMuxer datagrams as they
+// are (no copy; a datagram is kept until acknowledged or dropped), ACK / ACKACK, NAK-driven
+// retransmission and keepalives.
+//
+// The negotiated latency is the budget for every packet: the receiver plays a packet at its
+// origin time plus the latency, so a queued packet older than that is dropped unsent, a lost
+// one is no longer retransmitted, and unacknowledged packets are released (with a DROPREQ so
+// the receiver stops waiting) once the ACK could not plausibly still come. Late data never
+// competes with fresh data for the link. connect() and run() belong to one worker thread; send() and close() may be
+// called from any thread.
+class SrtSender {
+public:
+    SrtSender();
+    ~SrtSender();
+    SrtSender(const SrtSender&) = delete;
+    SrtSender& operator=(const SrtSender&) = delete;
+
+    // Blocking caller handshake. |error| explains a failure.
+    bool connect(const SrtOptions& options, std::string& error);
+    // Services the connection until close() (true) or link failure (false).
+    bool run();
+    void close();
+
+    void send(TsDatagramPtr datagram);
+    [[nodiscard]] SrtStats stats() const;
+    // Time the oldest datagram not yet sent has waited; 0 when none is queued.
+    [[nodiscard]] int64_t backlogUs();
+    [[nodiscard]] bool connected() const { return connected_.load(); }
+
+private:
+    struct Queued {
+        TsDatagramPtr datagram;
+        int64_t originUs = 0;
+    };
+
+    struct InFlight {
+        uint32_t sequence = 0;
+        uint32_t messageNumber = 0;
+        int64_t originUs = 0;
+        int64_t lastSentUs = 0;
+        bool retransmitPending = false;
+        bool retransmitted = false;
+        TsDatagramPtr datagram;
+    };
+
+    uint32_t elapsedUs(int64_t nowUs) const;
+    bool sendControl(const std::vector<uint8_t>& packet);
+    bool sendData(InFlight& packet, bool retransmission, int64_t nowUs);
+    bool handshake(const SrtOptions& options, std::string& error);
+    // Resends |request| until a handshake of type |expected| (or a rejection) comes back.
+    bool exchange(const std::vector<uint8_t>& request, srt::HandshakeType expected,
+                  srt::Handshake& response, int64_t deadlineUs);
+
+    void receivePackets(int64_t nowUs);
+    void onAck(const uint8_t* packet, size_t size, uint32_t ackNumber);
+    void onNak(const uint8_t* packet, size_t size);
+    void dropTooLate(int64_t nowUs);
+    void sendRetransmissions(int64_t nowUs);
+    void sendNew(int64_t nowUs);
+    void closeSocket();
+
+    int socket_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> closing_{false};
+
+    int64_t startUs_ = 0;
+    int64_t latencyUs_ = 0;
+    int64_t idleTimeoutUs_ = 0;
+    uint32_t socketId_ = 0;
+    uint32_t peerSocketId_ = 0;
+    uint32_t flowWindow_ = 8192;
+    uint32_t nextSequence_ = 0;
+    uint32_t nextMessage_ = 1;
+    int64_t lastSendUs_ = 0;
+    int64_t lastReceiveUs_ = 0;
+    bool peerClosed_ = false;
+
+    std::mutex queueMutex_;
+    std::deque<Queued> queue_;
+
+    // Worker thread only.
+    std::deque<InFlight> inFlight_;  // consecutive sequence numbers from the oldest unacknowledged
+    std::deque<uint32_t> losses_;
+    std::vector<uint8_t> receiveBuffer_;
+    std::vector<std::pair<uint32_t, uint32_t>> nakRanges_;
+
+    mutable std::mutex statsMutex_;
+    SrtStats stats_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_SRTSENDER_H
@@ -131,6 +131,15 @@ void EncodeRendererNative::draw() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void EncodeRendererNative::drawLayer(int width, int height) {
+    if (!initialized_ || width <= 0 || height <= 0) {
+        return;
+    }
+    glViewport(0, 0, width, height);
+    draw();
+    glViewport(0, 0, surfaceWidth_, surfaceHeight_);
+}
+
 void EncodeRendererNative::updateWatermark(JNIEnv* env,
                                            jobject bitmap,
                                            const std::vector<float>& coords,
@@ -14,6 +14,10 @@ public:
     void initialize(int width, int height);
     void surfaceChanged(int width, int height);
     void draw();
+    // Simulcast: the same frame into another layer's surface, already current, at that
+    // layer's size. Geometry is in NDC, so the viewport does the scaling; layers are
+    // expected to share the primary aspect ratio.
+    void drawLayer(int width, int height);
     void updateWatermark(JNIEnv* env, jobject bitmap, const std::vector<float>& coords, float scale);
     void release();
 
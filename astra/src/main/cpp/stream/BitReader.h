@@ -0,0 +1,153 @@
+#ifndef ASTRASTREAM_BITREADER_H
+#define ASTRASTREAM_BITREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace astra {
+
+// MSB-first reader for parameter sets, slice headers and OBU headers. Up to 64 bits are
+// cached: a refill loads eight bytes as one big-endian word unless one of them is 0x03, the
+// only byte that can be an emulation prevention byte, and walks byte by byte only then.
+// ue(v) / se(v) find their prefix with one count-leading-zeros. Reading past the end yields
+// zero bits and sets failed().
+class BitReader {
+public:
+    // |nalPayload|: skip emulation prevention bytes (00 00 03), reading the RBSP in place.
+    BitReader(const uint8_t* data, size_t size, bool nalPayload = false)
+        : data_(data), size_(data != nullptr ? size : 0), nalPayload_(nalPayload) {}
+
+    // |count| <= 32.
+    uint32_t readBits(uint32_t count) {
+        if (count == 0) {
+            return 0;
+        }
+        if (cachedBits_ < count) {
+            refill();
+            if (cachedBits_ < count) {
+                failed_ = true;
+                cachedBits_ = count;  // the cache is zero past its valid bits
+            }
+        }
+        const auto value = static_cast<uint32_t>(cache_ >> (64 - count));
+        cache_ <<= count;
+        cachedBits_ -= count;
+        return value;
+    }
+
+    uint32_t readBit() { return readBits(1); }
+
+    void skipBits(uint32_t count) {
+        for (; count > 32; count -= 32) {
+            readBits(32);
+        }
+        readBits(count);
+    }
+
+    // ue(v); also AV1's uvlc(), which codes the same way.
+    uint32_t readUE() {
+        if (cachedBits_ < 32) {
+            refill();
+        }
+        uint32_t leadingZeros = CountLeadingZeros(cache_);
+        if (leadingZeros >= cachedBits_) {
+            refill();
+            leadingZeros = CountLeadingZeros(cache_);
+        }
+        if (leadingZeros >= cachedBits_ || leadingZeros > 31) {
+            failed_ = true;
+            cache_ = 0;
+            cachedBits_ = 0;
+            position_ = size_;
+            return 0;
+        }
+        const uint32_t codeLength = 2 * leadingZeros + 1;
+        if (codeLength <= cachedBits_) {
+            const auto value = static_cast<uint32_t>(cache_ >> (64 - codeLength));
+            cache_ <<= codeLength;
+            cachedBits_ -= codeLength;
+            return value - 1;
+        }
+        cache_ <<= leadingZeros;
+        cachedBits_ -= leadingZeros;
+        return readBits(leadingZeros + 1) - 1;
+    }
+
+    int32_t readSE() {
+        const uint32_t codeNum = readUE();
+        const uint32_t magnitude = (codeNum >> 1) + (codeNum & 1);
+        return (codeNum & 1) != 0 ? static_cast<int32_t>(magnitude) : -static_cast<int32_t>(magnitude);
+    }
+
+    [[nodiscard]] bool failed() const { return failed_; }
+
+private:
+    static uint64_t LoadBigEndian64(const uint8_t* data) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    static uint32_t CountLeadingZeros(uint64_t value) {
+        return value == 0 ? 64 : static_cast<uint32_t>(__builtin_clzll(value));
+    }
+
+    static bool HasByte03(uint64_t word) {
+        const uint64_t x = word ^ 0x0303030303030303ULL;
+        return ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) != 0;
+    }
+
+    void refill() {
+        const uint32_t freeBytes = (64 - cachedBits_) / 8;
+        if (freeBytes == 0) {
+            return;
+        }
+        if (position_ + 8 <= size_) {
+            uint64_t word = LoadBigEndian64(data_ + position_);
+            if (!nalPayload_ || !HasByte03(word)) {
+                word &= ~0ULL << (64 - 8 * freeBytes);
+                cache_ |= word >> cachedBits_;
+                cachedBits_ += 8 * freeBytes;
+                position_ += freeBytes;
+                if (nalPayload_) {
+                    // Zero run going into the next refill, from the last bytes taken.
+                    size_t i = position_ - (freeBytes >= 2 ? 2 : 1);
+                    zeroRun_ = freeBytes >= 2 ? 0 : zeroRun_;
+                    for (; i < position_; ++i) {
+                        zeroRun_ = data_[i] == 0 ? zeroRun_ + 1 : 0;
+                    }
+                }
+                return;
+            }
+        }
+        while (cachedBits_ <= 56 && position_ < size_) {
+            const uint8_t byte = data_[position_++];
+            if (nalPayload_) {
+                if (zeroRun_ >= 2 && byte == 0x03) {
+                    zeroRun_ = 0;
+                    continue;
+                }
+                zeroRun_ = byte == 0 ? zeroRun_ + 1 : 0;
+            }
+            cache_ |= static_cast<uint64_t>(byte) << (56 - cachedBits_);
+            cachedBits_ += 8;
+        }
+    }
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;  // next byte to load
+    uint64_t cache_ = 0;  // next bits, MSB first; zero past cachedBits_
+    uint32_t cachedBits_ = 0;
+    uint32_t zeroRun_ = 0;  // consecutive zero bytes just loaded
+    bool nalPayload_ = false;
+    bool failed_ = false;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_BITREADER_H
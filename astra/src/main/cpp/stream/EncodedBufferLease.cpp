@@ -0,0 +1,153 @@
+#include "EncodedBufferLease.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace astra {
+
+BufferLeaseOwner::BufferLeaseOwner(uint32_t maxLeases, ReleaseFn release)
+    : maxLeases_(maxLeases), release_(std::move(release)) {}
+
+bool BufferLeaseOwner::tryAcquire() {
+    uint32_t current = outstanding_.load();
+    while (current < maxLeases_) {
+        if (outstanding_.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BufferLeaseOwner::giveBack() {
+    outstanding_.fetch_sub(1);
+}
+
+std::shared_ptr<BufferLeaseOwner::Slot> BufferLeaseOwner::lend(size_t index, uint8_t* data, size_t size) {
+    auto slot = std::make_shared<Slot>();
+    slot->index = index;
+    slot->data = data;
+    slot->size = size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    lent_.push_back(slot.get());
+    return slot;
+}
+
+void BufferLeaseOwner::release(Slot& slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unregister(slot);
+        if (!revoked_.load() && release_) {
+            release_(slot.index);
+        }
+    }
+    giveBack();
+}
+
+void BufferLeaseOwner::forget(Slot& slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unregister(slot);
+    }
+    giveBack();
+}
+
+void BufferLeaseOwner::unregister(Slot& slot) {
+    lent_.erase(std::remove(lent_.begin(), lent_.end(), &slot), lent_.end());
+}
+
+void BufferLeaseOwner::revoke() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (revoked_.load()) {
+        return;
+    }
+    for (Slot* slot : lent_) {
+        slot->copy.assign(slot->data, slot->data + slot->size);
+        slot->data = slot->copy.data();
+    }
+    // Readers check the flag between socket waits; the copies are in place before it is set.
+    revoked_.store(true);
+    readersDone_.wait(lock, [this] {
+        return std::none_of(lent_.begin(), lent_.end(), [](const Slot* slot) { return slot->readingInPlace; });
+    });
+}
+
+std::unique_lock<std::mutex> BufferLeaseOwner::pin() {
+    return std::unique_lock<std::mutex>(mutex_);
+}
+
+EncodedBufferLease::EncodedBufferLease(std::shared_ptr<BufferLeaseOwner> owner,
+                                       size_t index,
+                                       uint8_t* data,
+                                       size_t size)
+    : owner_(std::move(owner)) {
+    if (owner_) {
+        slot_ = owner_->lend(index, data, size);
+    }
+}
+
+EncodedBufferLease::~EncodedBufferLease() {
+    reset();
+}
+
+EncodedBufferLease::EncodedBufferLease(EncodedBufferLease&& other) noexcept
+    : owner_(std::move(other.owner_)), slot_(std::move(other.slot_)) {}
+
+EncodedBufferLease& EncodedBufferLease::operator=(EncodedBufferLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        owner_ = std::move(other.owner_);
+        slot_ = std::move(other.slot_);
+    }
+    return *this;
+}
+
+std::unique_lock<std::mutex> EncodedBufferLease::pin() const {
+    if (!owner_) {
+        return {};
+    }
+    return owner_->pin();
+}
+
+const uint8_t* EncodedBufferLease::beginRead() {
+    if (!owner_) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(owner_->mutex_);
+    slot_->readingInPlace = !owner_->revoked_.load();
+    return slot_->data;
+}
+
+const uint8_t* EncodedBufferLease::followCopy() {
+    if (!owner_) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(owner_->mutex_);
+    if (slot_->readingInPlace) {
+        slot_->readingInPlace = false;
+        owner_->readersDone_.notify_all();
+    }
+    return slot_->data;
+}
+
+void EncodedBufferLease::endRead() {
+    followCopy();
+}
+
+void EncodedBufferLease::detach() {
+    if (owner_) {
+        owner_->forget(*slot_);
+        owner_.reset();
+    }
+    slot_.reset();
+}
+
+void EncodedBufferLease::reset() {
+    if (owner_) {
+        endRead();
+        owner_->release(*slot_);
+        owner_.reset();
+    }
+    slot_.reset();
+}
+
+}  // namespace astra
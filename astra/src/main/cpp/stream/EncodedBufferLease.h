@@ -0,0 +1,102 @@
+#ifndef ASTRASTREAM_ENCODEDBUFFERLEASE_H
+#define ASTRASTREAM_ENCODEDBUFFERLEASE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace astra {
+
+// Shared between an encoder and the output buffers it lends to the sender. The encoder
+// revokes it before stopping the codec: buffers still lent are copied out first, so frames
+// queued behind a slow link are sent from the copy instead of being lost.
+class BufferLeaseOwner {
+public:
+    using ReleaseFn = std::function<void(size_t index)>;
+
+    // One lent buffer. |data| points into the codec until revoke() moves it to |copy|.
+    struct Slot {
+        size_t index = 0;
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> copy;
+        bool readingInPlace = false;  // a send is reading the codec buffer without the lock
+    };
+
+    BufferLeaseOwner(uint32_t maxLeases, ReleaseFn release);
+
+    bool tryAcquire();
+    void giveBack();
+    std::shared_ptr<Slot> lend(size_t index, uint8_t* data, size_t size);
+    void release(Slot& slot);
+    void forget(Slot& slot);  // back to the caller, who releases the buffer itself
+    // Copies every lent buffer, then waits for sends reading one in place to move to the
+    // copy, which they do at their next wait for the socket. Never waits on a blocked write.
+    void revoke();
+    std::unique_lock<std::mutex> pin();
+
+    [[nodiscard]] uint32_t outstanding() const { return outstanding_.load(); }
+    [[nodiscard]] bool revoked() const { return revoked_.load(); }
+
+private:
+    friend class EncodedBufferLease;
+
+    void unregister(Slot& slot);
+
+    const uint32_t maxLeases_;
+    ReleaseFn release_;
+    std::atomic<uint32_t> outstanding_{0};
+    std::mutex mutex_;
+    std::condition_variable readersDone_;
+    std::vector<Slot*> lent_;
+    std::atomic<bool> revoked_{false};
+};
+
+class EncodedBufferLease {
+public:
+    EncodedBufferLease() = default;
+    EncodedBufferLease(std::shared_ptr<BufferLeaseOwner> owner,
+                       size_t index,
+                       uint8_t* data,
+                       size_t size);
+    ~EncodedBufferLease();
+
+    EncodedBufferLease(EncodedBufferLease&& other) noexcept;
+    EncodedBufferLease& operator=(EncodedBufferLease&& other) noexcept;
+    EncodedBufferLease(const EncodedBufferLease&) = delete;
+    EncodedBufferLease& operator=(const EncodedBufferLease&) = delete;
+
+    explicit operator bool() const { return owner_ != nullptr; }
+    // Where the bytes are now: the codec buffer, or its copy once revoked. Stable while
+    // pinned or between beginRead() and endRead().
+    uint8_t* data() const { return slot_ ? slot_->data : nullptr; }
+    size_t size() const { return slot_ ? slot_->size : 0; }
+
+    // Keeps revoke() from moving the bytes while they are read; hold it briefly.
+    std::unique_lock<std::mutex> pin() const;
+
+    // Reading without the lock, e.g. across a socket write. beginRead() returns the bytes;
+    // while they are still in the codec, the reader calls followCopy() as soon as revoked()
+    // is set and carries on from the returned copy, which has the same layout.
+    const uint8_t* beginRead();
+    [[nodiscard]] bool revoked() const { return owner_ && owner_->revoked(); }
+    const uint8_t* followCopy();
+    void endRead();
+
+    // Returns the lease slot without releasing the buffer, which stays with the caller.
+    void detach();
+    void reset();
+
+private:
+    std::shared_ptr<BufferLeaseOwner> owner_;
+    std::shared_ptr<BufferLeaseOwner::Slot> slot_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_ENCODEDBUFFERLEASE_H
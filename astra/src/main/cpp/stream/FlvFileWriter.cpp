@@ -0,0 +1,258 @@
+#include "FlvFileWriter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "../common/AstraLog.h"
+
+namespace astra {
+
+namespace {
+constexpr const char* kTag = "FlvFileWriter";
+constexpr size_t kBlockAlignment = 4096;
+constexpr uint8_t kTagTypeScript = 18;
+
+bool WriteFully(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Offset just past the AMF0 number marker of |key| inside an onMetaData body, or 0.
+size_t FindNumberProperty(const std::vector<uint8_t>& body, const char* key) {
+    const size_t length = std::strlen(key);
+    std::vector<uint8_t> pattern{static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+    pattern.insert(pattern.end(), key, key + length);
+    pattern.push_back(0x00);
+    const auto it = std::search(body.begin(), body.end(), pattern.begin(), pattern.end());
+    if (it == body.end() || static_cast<size_t>(body.end() - it) < pattern.size() + 8) {
+        return 0;
+    }
+    return static_cast<size_t>(it - body.begin()) + pattern.size();
+}
+}  // namespace
+
+FlvFileWriter::~FlvFileWriter() {
+    close();
+    for (Block& block : blocks_) {
+        std::free(block.data);
+    }
+}
+
+bool FlvFileWriter::open(const std::string& path, bool hasAudio, bool hasVideo) {
+    if (fd_ >= 0) {
+        close();
+    }
+    for (Block& block : blocks_) {
+        if (block.data == nullptr) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, kBlockAlignment, kBlockSize) != 0) {
+                ASTRA_LOGE(kTag, "open: cannot allocate %zu byte block", kBlockSize);
+                return false;
+            }
+            block.data = static_cast<uint8_t*>(memory);
+        }
+        block.used = 0;
+    }
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        ASTRA_LOGE(kTag, "open %s failed errno=%d", path.c_str(), errno);
+        return false;
+    }
+    active_ = 0;
+    offset_ = 0;
+    durationOffset_ = 0;
+    filesizeOffset_ = 0;
+    sawMedia_ = false;
+    tags_ = 0;
+    stats_ = Stats{};
+    pending_ = -1;
+    stopping_ = false;
+    failed_ = false;
+    writer_ = std::thread(&FlvFileWriter::writerLoop, this);
+
+    const auto header = FlvMuxer::buildFileHeader(hasAudio, hasVideo);
+    append(header.data(), header.size());
+    return true;
+}
+
+bool FlvFileWriter::writeTag(uint8_t tagType, uint32_t timestamp, const ByteSpan* parts, size_t count) {
+    if (fd_ < 0 || failed_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    size_t dataSize = 0;
+    for (size_t i = 0; i < count; ++i) {
+        dataSize += parts[i].size;
+    }
+    uint8_t header[FlvMuxer::kTagHeaderSize];
+    FlvMuxer::writeTagHeader(header, tagType, static_cast<uint32_t>(dataSize), timestamp);
+    append(header, sizeof(header));
+    if (tagType == kTagTypeScript) {
+        notePatchOffsets(parts, count, offset_);
+    } else {
+        firstTimestamp_ = sawMedia_ ? std::min(firstTimestamp_, timestamp) : timestamp;
+        lastTimestamp_ = sawMedia_ ? std::max(lastTimestamp_, timestamp) : timestamp;
+        sawMedia_ = true;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        append(parts[i].data, parts[i].size);
+    }
+    uint8_t previousTagSize[FlvMuxer::kPreviousTagSizeSize];
+    FlvMuxer::writePreviousTagSize(previousTagSize, static_cast<uint32_t>(dataSize));
+    append(previousTagSize, sizeof(previousTagSize));
+    ++tags_;
+    return !failed_.load(std::memory_order_relaxed);
+}
+
+bool FlvFileWriter::writeTag(uint8_t tagType, uint32_t timestamp, const std::vector<uint8_t>& body) {
+    const ByteSpan part{body.data(), body.size()};
+    return writeTag(tagType, timestamp, &part, 1);
+}
+
+bool FlvFileWriter::close() {
+    if (fd_ < 0) {
+        return true;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [&] { return pending_ < 0; });
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    bool ok = !failed_.load();
+    Block& tail = blocks_[active_];
+    if (ok && tail.used > 0) {
+        ok = WriteFully(fd_, tail.data, tail.used);
+    }
+    tail.used = 0;
+    if (ok) {
+        const double duration = sawMedia_ ? static_cast<double>(lastTimestamp_ - firstTimestamp_) / 1000.0 : 0.0;
+        ok = patchNumber(durationOffset_, duration) && patchNumber(filesizeOffset_, static_cast<double>(offset_));
+    }
+    if (ok && ::fdatasync(fd_) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        ASTRA_LOGE(kTag, "close: recording incomplete errno=%d bytes=%llu",
+                   errno, static_cast<unsigned long long>(offset_));
+    }
+    ::close(fd_);
+    fd_ = -1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes = offset_;
+    stats_.tags = tags_;
+    return ok;
+}
+
+FlvFileWriter::Stats FlvFileWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FlvFileWriter::append(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        Block& block = blocks_[active_];
+        const size_t count = std::min(size, kBlockSize - block.used);
+        std::memcpy(block.data + block.used, data, count);
+        block.used += count;
+        offset_ += count;
+        data += count;
+        size -= count;
+        if (block.used == kBlockSize) {
+            submitActive();
+        }
+    }
+}
+
+void FlvFileWriter::submitActive() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pending_ >= 0) {
+            const auto begin = std::chrono::steady_clock::now();
+            cond_.wait(lock, [&] { return pending_ < 0; });
+            ++stats_.stalls;
+            stats_.stallUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+        }
+        pending_ = static_cast<int>(active_);
+        stats_.bytes = offset_;
+        stats_.tags = tags_;
+    }
+    cond_.notify_all();
+    active_ ^= 1;
+    blocks_[active_].used = 0;
+}
+
+void FlvFileWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [&] { return pending_ >= 0 || stopping_; });
+        if (pending_ < 0) {
+            return;
+        }
+        Block& block = blocks_[static_cast<size_t>(pending_)];
+        lock.unlock();
+        bool ok = true;
+        if (!failed_.load(std::memory_order_relaxed)) {
+            ok = WriteFully(fd_, block.data, block.used);
+        }
+        lock.lock();
+        if (!ok) {
+            ASTRA_LOGE(kTag, "block write failed errno=%d", errno);
+            failed_ = true;
+        }
+        ++stats_.blocks;
+        pending_ = -1;
+        cond_.notify_all();
+    }
+}
+
+void FlvFileWriter::notePatchOffsets(const ByteSpan* parts, size_t count, uint64_t bodyOffset) {
+    std::vector<uint8_t> body;
+    for (size_t i = 0; i < count; ++i) {
+        body.insert(body.end(), parts[i].data, parts[i].data + parts[i].size);
+    }
+    if (std::search(body.begin(), body.end(), "onMetaData", "onMetaData" + 10) == body.end()) {
+        return;
+    }
+    if (const size_t duration = FindNumberProperty(body, "duration")) {
+        durationOffset_ = bodyOffset + duration;
+    }
+    if (const size_t filesize = FindNumberProperty(body, "filesize")) {
+        filesizeOffset_ = bodyOffset + filesize;
+    }
+}
+
+bool FlvFileWriter::patchNumber(uint64_t offset, double value) {
+    if (offset == 0) {
+        return true;
+    }
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    return ::pwrite(fd_, bytes, sizeof(bytes), static_cast<off_t>(offset)) == static_cast<ssize_t>(sizeof(bytes));
+}
+
+}  // namespace astra
@@ -0,0 +1,84 @@
+#ifndef ASTRASTREAM_FLVFILEWRITER_H
+#define ASTRASTREAM_FLVFILEWRITER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FlvMuxer.h"
+
+namespace astra {
+
+// Appends FLV tags to a file through two block-sized, page-aligned buffers. The caller copies
+// each tag into the filling block; a writer thread stores the other one, so the caller only
+// waits when storage falls a whole block behind. Every write but the final tail is a full
+// block at a block-aligned offset. close() patches onMetaData's duration and filesize.
+class FlvFileWriter {
+public:
+    static constexpr size_t kBlockSize = 1 << 20;
+
+    struct Stats {
+        uint64_t bytes = 0;
+        uint64_t tags = 0;
+        uint32_t blocks = 0;
+        uint32_t stalls = 0;  // appends that waited for the writer thread
+        int64_t stallUs = 0;
+    };
+
+    FlvFileWriter() = default;
+    ~FlvFileWriter();
+    FlvFileWriter(const FlvFileWriter&) = delete;
+    FlvFileWriter& operator=(const FlvFileWriter&) = delete;
+
+    bool open(const std::string& path, bool hasAudio, bool hasVideo);
+    // Writes tag header, the concatenated |parts| as the body, and PreviousTagSize. False
+    // once a write has failed; the file is then left as far as it got.
+    bool writeTag(uint8_t tagType, uint32_t timestamp, const ByteSpan* parts, size_t count);
+    bool writeTag(uint8_t tagType, uint32_t timestamp, const std::vector<uint8_t>& body);
+    bool close();
+
+    [[nodiscard]] bool isOpen() const { return fd_ >= 0; }
+    // Byte and tag counts advance per block; exact after close().
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Block {
+        uint8_t* data = nullptr;
+        size_t used = 0;
+    };
+
+    void append(const uint8_t* data, size_t size);
+    void submitActive();
+    void writerLoop();
+    void notePatchOffsets(const ByteSpan* parts, size_t count, uint64_t bodyOffset);
+    bool patchNumber(uint64_t offset, double value);
+
+    int fd_ = -1;
+    std::array<Block, 2> blocks_{};
+    size_t active_ = 0;
+    uint64_t offset_ = 0;  // bytes appended so far
+    uint64_t durationOffset_ = 0;  // file offsets of onMetaData values, 0 when absent
+    uint64_t filesizeOffset_ = 0;
+    uint32_t firstTimestamp_ = 0;
+    uint32_t lastTimestamp_ = 0;
+    bool sawMedia_ = false;
+    uint64_t tags_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    Stats stats_;
+    int pending_ = -1;  // block handed to the writer thread
+    bool stopping_ = false;
+    std::atomic<bool> failed_{false};
+    std::thread writer_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_FLVFILEWRITER_H
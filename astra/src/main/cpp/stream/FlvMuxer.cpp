@@ -6,10 +6,14 @@
 #include <cstddef>
 #include <cstring>
 
+#include "../common/AstraLog.h"
+
 namespace astra {
 
 namespace {
 
+constexpr const char* kTag = "FlvMuxer";
+
 constexpr uint8_t kFlvSoundFormatAac = 10;
 constexpr uint8_t kFlvSoundRate44k = 3;
 constexpr uint8_t kFlvSoundSize16Bit = 1;
@@ -20,11 +24,22 @@ constexpr uint8_t kFlvVideoFrameInter = 2;
 
 constexpr uint8_t kFlvAvcSequenceHeader = 0;
 constexpr uint8_t kFlvAvcNalu = 1;
+constexpr uint8_t kFlvAvcEndOfSequence = 2;
+constexpr uint8_t kFlvCodecIdAvc = 7;
+
+// Enhanced RTMP: IsExHeader bit, then a 3-bit frame type and a 4-bit packet type.
+constexpr uint8_t kExVideoHeaderFlag = 0x80;
+constexpr uint8_t kExPacketSequenceStart = 0;
+constexpr uint8_t kExPacketSequenceEnd = 2;
+constexpr uint8_t kExPacketCodedFramesX = 3;
+constexpr size_t kVideoHeaderSize = 5;
 
 constexpr uint8_t kAudNalTypeH264 = 9;
 constexpr uint8_t kSpsNalTypeH264 = 7;
 constexpr uint8_t kPpsNalTypeH264 = 8;
 constexpr uint8_t kIdrNalTypeH264 = 5;
+constexpr uint8_t kSliceNalTypeH264 = 1;
+constexpr uint8_t kPrefixNalTypeH264 = 14;
 
 constexpr uint8_t kAudNalTypeH265 = 35;
 constexpr uint8_t kVpsNalTypeH265 = 32;
@@ -34,6 +49,18 @@ constexpr uint8_t kIdrWRadlTypeH265 = 19;
 constexpr uint8_t kIdrNLpTypeH265 = 20;
 constexpr uint8_t kCraTypeH265 = 21;
 
+constexpr uint8_t kObuSequenceHeader = 1;
+constexpr uint8_t kObuTemporalDelimiter = 2;
+constexpr uint8_t kObuFrameHeader = 3;
+constexpr uint8_t kObuFrame = 6;
+constexpr uint8_t kObuRedundantFrameHeader = 7;
+constexpr uint8_t kObuTileList = 8;
+constexpr uint8_t kObuPadding = 15;
+constexpr uint8_t kObuExtensionFlag = 0x04;
+constexpr uint8_t kObuHasSizeField = 0x02;
+constexpr uint8_t kAv1ConfigMarkerVersion = 0x81;  // av1C marker bit and version 1
+constexpr size_t kAv1ConfigHeaderSize = 4;
+
 struct StartCode {
     size_t offset = 0;
     size_t length = 0;
@@ -65,30 +92,43 @@ StartCode FindStartCode(const uint8_t* data, size_t start, size_t size) {
     return result;
 }
 
-std::vector<std::vector<uint8_t>> SplitAnnexbNalUnits(const uint8_t* data,
-                                                       size_t size) {
-    std::vector<std::vector<uint8_t>> nalUnits;
-    if (data == nullptr || size == 0) {
-        return nalUnits;
-    }
+struct NalRange {
+    size_t startCodeOffset = 0;
+    size_t startCodeLength = 0;
+    size_t end = 0;
 
-    size_t position = 0;
-    StartCode start = FindStartCode(data, position, size);
-    if (!start.found) {
-        return nalUnits;
+    size_t nalOffset() const { return startCodeOffset + startCodeLength; }
+    size_t nalSize() const { return end - nalOffset(); }
+};
+
+std::vector<NalRange> FindAnnexbNalRanges(const uint8_t* data, size_t size) {
+    std::vector<NalRange> ranges;
+    if (data == nullptr || size == 0) {
+        return ranges;
     }
 
-    position = start.offset + start.length;
-    while (true) {
+    StartCode start = FindStartCode(data, 0, size);
+    while (start.found) {
+        const size_t position = start.offset + start.length;
         StartCode next = FindStartCode(data, position, size);
-        size_t nalEnd = next.found ? next.offset : size;
+        const size_t nalEnd = next.found ? next.offset : size;
         if (nalEnd > position) {
-            nalUnits.emplace_back(data + position, data + nalEnd);
+            NalRange range;
+            range.startCodeOffset = start.offset;
+            range.startCodeLength = start.length;
+            range.end = nalEnd;
+            ranges.push_back(range);
         }
-        if (!next.found) {
-            break;
-        }
-        position = next.offset + next.length;
+        start = next;
+    }
+    return ranges;
+}
+
+std::vector<std::vector<uint8_t>> SplitAnnexbNalUnits(const uint8_t* data,
+                                                       size_t size) {
+    std::vector<std::vector<uint8_t>> nalUnits;
+    for (const auto& range : FindAnnexbNalRanges(data, size)) {
+        nalUnits.emplace_back(data + range.nalOffset(), data + range.end);
     }
     return nalUnits;
 }
@@ -115,6 +155,124 @@ std::vector<std::vector<uint8_t>> SplitLengthPrefixedNalUnits(const uint8_t* dat
     return nalUnits;
 }
 
+struct ObuRange {
+    size_t offset = 0;
+    size_t headerSize = 0;  // obu_header, extension byte and leb128 size
+    size_t end = 0;
+    bool hasSizeField = false;
+
+    size_t size() const { return end - offset; }
+    size_t payloadOffset() const { return offset + headerSize; }
+    size_t payloadSize() const { return end - payloadOffset(); }
+};
+
+bool ReadLeb128(const uint8_t* data, size_t size, size_t& position, uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (position >= size) {
+            return false;
+        }
+        const uint8_t byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppendLeb128(std::vector<uint8_t>& out, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        out.push_back(byte);
+    } while (value != 0);
+}
+
+// Low-overhead bitstream format: every OBU carries its size except, optionally, the last
+// one. Empty when the buffer is not an OBU sequence.
+std::vector<ObuRange> FindObuRanges(const uint8_t* data, size_t size) {
+    std::vector<ObuRange> ranges;
+    size_t position = 0;
+    while (data != nullptr && position < size) {
+        const uint8_t header = data[position];
+        if ((header & 0x80) != 0) {  // obu_forbidden_bit
+            ranges.clear();
+            break;
+        }
+        ObuRange range;
+        range.offset = position;
+        range.hasSizeField = (header & kObuHasSizeField) != 0;
+        size_t cursor = position + ((header & kObuExtensionFlag) != 0 ? 2 : 1);
+        if (cursor > size) {
+            ranges.clear();
+            break;
+        }
+        uint64_t payloadSize = size - cursor;
+        if (range.hasSizeField && (!ReadLeb128(data, size, cursor, payloadSize) || payloadSize > size - cursor)) {
+            ranges.clear();
+            break;
+        }
+        range.headerSize = cursor - position;
+        range.end = cursor + static_cast<size_t>(payloadSize);
+        ranges.push_back(range);
+        position = range.end;
+    }
+    return ranges;
+}
+
+uint8_t ObuType(const uint8_t* obu) { return (obu[0] >> 3) & 0x0F; }
+
+// temporal_id from obu_extension_header; 0 when the OBU has none or |layers| is 1.
+uint8_t ObuTemporalId(uint32_t layers, const uint8_t* obu, size_t headerSize) {
+    if (layers <= 1 || (obu[0] & kObuExtensionFlag) == 0 || headerSize < 2) {
+        return 0;
+    }
+    return static_cast<uint8_t>(std::min<uint32_t>(obu[1] >> 5, layers - 1));
+}
+
+// Temporal sub-layer a NAL unit belongs to out of |layers|, 0 when it does not say or the
+// encoder runs without layering. HEVC carries nuh_temporal_id_plus1 in every NAL header.
+// H.264 has temporal_id only in the SVC prefix NAL (type 14) some encoders put ahead of each
+// slice; otherwise a slice nothing references (nal_ref_idc 0) is taken as the top layer. That
+// only holds under a layering schema: a plain encoder emits such slices as ordinary frames.
+uint8_t NalTemporalId(VideoCodecId codec, uint32_t layers, const uint8_t* nal, size_t size) {
+    if (layers <= 1) {
+        return 0;
+    }
+    const uint8_t top = static_cast<uint8_t>(layers - 1);
+    if (codec == VideoCodecId::kH265) {
+        return size >= 2 && (nal[1] & 0x07) != 0 ? std::min<uint8_t>((nal[1] & 0x07) - 1, top) : 0;
+    }
+    const uint8_t nalType = nal[0] & 0x1F;
+    if (nalType == kPrefixNalTypeH264) {
+        // svc_extension_flag, then 23 bits of nal_unit_header_svc_extension() to temporal_id.
+        return size >= 4 && (nal[1] & 0x80) != 0 ? std::min<uint8_t>(nal[3] >> 5, top) : 0;
+    }
+    if (nalType == kSliceNalTypeH264 && (nal[0] & 0x60) == 0) {
+        return top;
+    }
+    return 0;
+}
+
+// The OBU with obu_has_size_field set, as av1C configOBUs and ISOBMFF / FLV samples carry it.
+void AppendSizedObu(std::vector<uint8_t>& out, const uint8_t* data, const ObuRange& range) {
+    if (range.hasSizeField) {
+        out.insert(out.end(), data + range.offset, data + range.end);
+        return;
+    }
+    const bool extension = (data[range.offset] & kObuExtensionFlag) != 0;
+    out.push_back(static_cast<uint8_t>(data[range.offset] | kObuHasSizeField));
+    if (extension) {
+        out.push_back(data[range.offset + 1]);
+    }
+    AppendLeb128(out, range.payloadSize());
+    out.insert(out.end(), data + range.payloadOffset(), data + range.end);
+}
+
 uint32_t AudioSampleRateToIndex(uint32_t sampleRate) {
     switch (sampleRate) {
         case 96000: return 0;
@@ -134,74 +292,40 @@ uint32_t AudioSampleRateToIndex(uint32_t sampleRate) {
     }
 }
 
-// Bit reader used for HEVC profile parsing
-class BitReader {
-public:
-    explicit BitReader(const std::vector<uint8_t>& data) : data_(data) {}
+}  // namespace
 
-    uint32_t readBits(uint32_t count) {
-        uint32_t value = 0;
-        for (uint32_t i = 0; i < count; ++i) {
-            value <<= 1U;
-            if (byteOffset_ >= data_.size()) {
-                continue;
-            }
-            uint8_t current = data_[byteOffset_];
-            uint8_t bit = (current >> (7U - bitOffset_)) & 0x01U;
-            value |= bit;
-            ++bitOffset_;
-            if (bitOffset_ == 8U) {
-                bitOffset_ = 0U;
-                ++byteOffset_;
-            }
-        }
-        return value;
+uint32_t VideoFourCc(VideoCodecId codec) {
+    switch (codec) {
+        case VideoCodecId::kH265: return kFourCcHevc;
+        case VideoCodecId::kAv1: return kFourCcAv1;
+        default: return 0;
     }
+}
 
-    uint32_t readBit() { return readBits(1U); }
-
-    uint32_t readUE() {
-        uint32_t leadingZeroBits = 0;
-        while (readBit() == 0U && leadingZeroBits < 32U) {
-            ++leadingZeroBits;
-        }
-        if (leadingZeroBits == 32U) {
-            return 0U;
-        }
-        if (leadingZeroBits == 0U) {
-            return 1U;
-        }
-        uint32_t suffix = readBits(leadingZeroBits);
-        return ((1U << leadingZeroBits) - 1U) + suffix;
+VideoTagInfo InspectVideoTag(const uint8_t* body, size_t size) {
+    VideoTagInfo info;
+    if (body == nullptr || size == 0) {
+        return info;
     }
-
-private:
-    const std::vector<uint8_t>& data_;
-    size_t byteOffset_ = 0;
-    uint32_t bitOffset_ = 0;
-};
-
-std::vector<uint8_t> ToRbsp(const std::vector<uint8_t>& nal) {
-    std::vector<uint8_t> rbsp;
-    if (nal.size() <= 2) {
-        return rbsp;
-    }
-    rbsp.reserve(nal.size());
-    uint32_t zeroCount = 0;
-    for (size_t i = 2; i < nal.size(); ++i) {
-        uint8_t byte = nal[i];
-        if (zeroCount >= 2 && byte == 0x03) {
-            zeroCount = 0;
-            continue;
+    if ((body[0] & kExVideoHeaderFlag) != 0) {
+        const uint8_t packetType = body[0] & 0x0F;
+        info.keyFrame = ((body[0] >> 4) & 0x07) == kFlvVideoFrameKey;
+        info.sequenceHeader = packetType == kExPacketSequenceStart;
+        info.sequenceEnd = packetType == kExPacketSequenceEnd;
+        if (size >= kVideoHeaderSize) {
+            info.fourCc = (static_cast<uint32_t>(body[1]) << 24) | (static_cast<uint32_t>(body[2]) << 16) |
+                          (static_cast<uint32_t>(body[3]) << 8) | body[4];
         }
-        rbsp.push_back(byte);
-        zeroCount = (byte == 0) ? zeroCount + 1 : 0;
+        return info;
     }
-    return rbsp;
+    info.keyFrame = (body[0] >> 4) == kFlvVideoFrameKey;
+    // Only AVC carries an AVCPacketType; an end of sequence is written as a key "frame".
+    const bool avc = (body[0] & 0x0F) == kFlvCodecIdAvc && size > 1;
+    info.sequenceHeader = avc && body[1] == kFlvAvcSequenceHeader;
+    info.sequenceEnd = avc && body[1] == kFlvAvcEndOfSequence;
+    return info;
 }
 
-}  // namespace
-
 void FlvMuxer::reset() {
     metadataSent_ = false;
     videoSequenceSent_ = false;
@@ -209,14 +333,31 @@ void FlvMuxer::reset() {
     sps_.clear();
     pps_.clear();
     vps_.clear();
+    av1ReducedStillPicture_ = false;
+    spsInfo_.reset();
+    spsHash_ = 0;
+    ppsHash_ = 0;
+    vpsHash_ = 0;
+    parameterSetGeneration_ = 0;
+    sentGeneration_ = 0;
+    decoderConfig_.clear();
+    decoderConfigGeneration_ = 0;
 }
 
 void FlvMuxer::setVideoConfig(const VideoConfig& config) {
     videoConfig_ = config;
+    decoderConfig_.clear();
     metadataSent_ = false;
     videoSequenceSent_ = false;
 }
 
+void FlvMuxer::updateVideoConfig(const VideoConfig& config) {
+    videoConfig_.width = config.width;
+    videoConfig_.height = config.height;
+    videoConfig_.fps = config.fps;
+    videoConfig_.temporalLayers = config.temporalLayers;
+}
+
 void FlvMuxer::setAudioConfig(const AudioConfig& config) {
     audioConfig_ = config;
     metadataSent_ = false;
@@ -227,7 +368,24 @@ bool FlvMuxer::videoSequenceReady() const {
     if (videoConfig_.codec == VideoCodecId::kH264) {
         return !sps_.empty() && !pps_.empty();
     }
-    return !vps_.empty() && !sps_.empty() && !pps_.empty();
+    // The hvcC and av1C fields come from the parsed sequence header.
+    if (videoConfig_.codec == VideoCodecId::kAv1) {
+        return !sps_.empty() && spsInfo_.has_value();
+    }
+    return !vps_.empty() && !sps_.empty() && !pps_.empty() && spsInfo_.has_value();
+}
+
+VideoConfig FlvMuxer::streamVideoConfig() const {
+    VideoConfig config = videoConfig_;
+    if (spsInfo_.has_value()) {
+        config.width = spsInfo_->width;
+        config.height = spsInfo_->height;
+        const double frameRate = spsInfo_->frameRate();
+        if (frameRate >= 1.0) {
+            config.fps = static_cast<uint32_t>(std::lround(frameRate));
+        }
+    }
+    return config;
 }
 
 bool FlvMuxer::audioSequenceReady() const {
@@ -235,9 +393,14 @@ bool FlvMuxer::audioSequenceReady() const {
 }
 
 std::optional<std::vector<uint8_t>> FlvMuxer::buildMetadataTag() const {
-    if (videoConfig_.width == 0 || videoConfig_.height == 0 || videoConfig_.fps == 0) {
+    const VideoConfig stream = streamVideoConfig();
+    if (stream.width == 0 || stream.height == 0 || stream.fps == 0) {
         return std::nullopt;
     }
+    // 29.97 stays 29.97 rather than the rounded fps.
+    const double frameRate = spsInfo_.has_value() && spsInfo_->frameRate() >= 1.0
+                                 ? spsInfo_->frameRate()
+                                 : static_cast<double>(stream.fps);
 
     std::vector<uint8_t> payload;
 
@@ -280,12 +443,17 @@ std::optional<std::vector<uint8_t>> FlvMuxer::buildMetadataTag() const {
     payload.push_back(0x00);
     payload.push_back(0x00);
     payload.push_back(0x00);
-    payload.push_back(0x07);  // number of elements
-
-    writeNumberProperty("width", static_cast<double>(videoConfig_.width));
-    writeNumberProperty("height", static_cast<double>(videoConfig_.height));
-    writeNumberProperty("framerate", static_cast<double>(videoConfig_.fps));
-    writeNumberProperty("videocodecid", videoConfig_.codec == VideoCodecId::kH264 ? 7.0 : 12.0);
+    payload.push_back(0x0A);  // number of elements
+
+    // Zero on a live stream; a file writer patches both when it closes.
+    writeNumberProperty("duration", 0.0);
+    writeNumberProperty("filesize", 0.0);
+    writeNumberProperty("width", static_cast<double>(stream.width));
+    writeNumberProperty("height", static_cast<double>(stream.height));
+    writeNumberProperty("framerate", frameRate);
+    // Enhanced RTMP puts the FourCC here as a number.
+    const uint32_t fourCc = VideoFourCc(videoConfig_.codec);
+    writeNumberProperty("videocodecid", fourCc != 0 ? static_cast<double>(fourCc) : kFlvCodecIdAvc);
     writeNumberProperty("audiosamplerate", static_cast<double>(audioConfig_.sampleRate));
     writeNumberProperty("audiosamplesize", static_cast<double>(audioConfig_.sampleSizeBits));
     writeBooleanProperty("stereo", audioConfig_.channels > 1);
@@ -303,25 +471,41 @@ std::optional<std::vector<uint8_t>> FlvMuxer::buildVideoSequenceHeader() {
         return std::nullopt;
     }
 
-    std::vector<uint8_t> payload;
-    payload.reserve(5 + sps_.size() + pps_.size() + vps_.size() + 64);
+    std::vector<uint8_t> payload(kVideoHeaderSize);
+    const std::vector<uint8_t>& config = cachedDecoderConfigurationRecord();
+    payload.reserve(kVideoHeaderSize + config.size());
+    writeVideoHeader(payload.data(), true, VideoPacket::kSequenceStart);
+    payload.insert(payload.end(), config.begin(), config.end());
 
-    uint8_t header = buildVideoHeader(videoConfig_.codec, true, true);
-    payload.push_back(header);
-    payload.push_back(kFlvAvcSequenceHeader);
-    payload.push_back(0x00);
-    payload.push_back(0x00);
-    payload.push_back(0x00);
+    videoSequenceSent_ = true;
+    sentGeneration_ = parameterSetGeneration_;
+    return payload;
+}
 
-    if (videoConfig_.codec == VideoCodecId::kH264) {
-        auto config = buildAvcDecoderConfigurationRecord();
-        payload.insert(payload.end(), config.begin(), config.end());
-    } else {
-        auto config = buildHevcDecoderConfigurationRecord();
-        payload.insert(payload.end(), config.begin(), config.end());
+std::optional<std::vector<uint8_t>> FlvMuxer::buildDecoderConfigurationRecord() const {
+    if (!videoSequenceReady()) {
+        return std::nullopt;
     }
+    return cachedDecoderConfigurationRecord();
+}
 
-    videoSequenceSent_ = true;
+const std::vector<uint8_t>& FlvMuxer::cachedDecoderConfigurationRecord() const {
+    if (decoderConfig_.empty() || decoderConfigGeneration_ != parameterSetGeneration_) {
+        if (videoConfig_.codec == VideoCodecId::kH264) {
+            decoderConfig_ = buildAvcDecoderConfigurationRecord();
+        } else if (videoConfig_.codec == VideoCodecId::kAv1) {
+            decoderConfig_ = buildAv1CodecConfigurationRecord();
+        } else {
+            decoderConfig_ = buildHevcDecoderConfigurationRecord();
+        }
+        decoderConfigGeneration_ = parameterSetGeneration_;
+    }
+    return decoderConfig_;
+}
+
+std::vector<uint8_t> FlvMuxer::buildVideoSequenceEnd() const {
+    std::vector<uint8_t> payload(kVideoHeaderSize);
+    writeVideoHeader(payload.data(), true, VideoPacket::kSequenceEnd);
     return payload;
 }
 
@@ -340,11 +524,223 @@ std::optional<std::vector<uint8_t>> FlvMuxer::buildAudioSequenceHeader() const {
     return payload;
 }
 
+FlvMuxer::NalAction FlvMuxer::classifyNal(const uint8_t* nal, size_t size) const {
+    if (nal == nullptr || size == 0) {
+        return NalAction::kDrop;
+    }
+    if (videoConfig_.codec == VideoCodecId::kH264) {
+        const uint8_t nalType = nal[0] & 0x1F;
+        switch (nalType) {
+            case kAudNalTypeH264: return NalAction::kDrop;
+            case kSpsNalTypeH264: return NalAction::kSps;
+            case kPpsNalTypeH264: return NalAction::kPps;
+            case kIdrNalTypeH264: return NalAction::kKeySlice;
+            default: return NalAction::kSlice;
+        }
+    }
+    const uint8_t nalType = static_cast<uint8_t>((nal[0] >> 1) & 0x3F);
+    switch (nalType) {
+        case kAudNalTypeH265: return NalAction::kDrop;
+        case kVpsNalTypeH265: return NalAction::kVps;
+        case kSpsNalTypeH265: return NalAction::kSps;
+        case kPpsNalTypeH265: return NalAction::kPps;
+        case kIdrWRadlTypeH265:
+        case kIdrNLpTypeH265:
+        case kCraTypeH265:
+            return NalAction::kKeySlice;
+        default:
+            return NalAction::kSlice;
+    }
+}
+
+bool FlvMuxer::captureParameterSet(NalAction action, const uint8_t* nal, size_t size) {
+    switch (action) {
+        case NalAction::kVps:
+            storeParameterSet(vps_, vpsHash_, nal, size);
+            return true;
+        case NalAction::kSps:
+            captureSps(nal, size);
+            return true;
+        case NalAction::kPps:
+            storeParameterSet(pps_, ppsHash_, nal, size);
+            return true;
+        case NalAction::kDrop:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool FlvMuxer::storeParameterSet(std::vector<uint8_t>& target, uint64_t& hash, const uint8_t* nal, size_t size) {
+    const uint64_t incoming = ParameterSetHash(nal, size);
+    if (size == target.size() && incoming == hash) {
+        return false;
+    }
+    target.assign(nal, nal + size);
+    hash = incoming;
+    ++parameterSetGeneration_;
+    return true;
+}
+
+void FlvMuxer::captureSps(const uint8_t* nal, size_t size) {
+    if (!storeParameterSet(sps_, spsHash_, nal, size)) {
+        return;
+    }
+    SpsInfo info;
+    const bool parsed = videoConfig_.codec == VideoCodecId::kH264 ? ParseH264Sps(nal, size, info)
+                                                                  : ParseHevcSps(nal, size, info);
+    onSpsParsed(parsed, info);
+}
+
+void FlvMuxer::onSpsParsed(bool parsed, const SpsInfo& info) {
+    if (!parsed) {
+        spsInfo_.reset();
+        ASTRA_LOGW(kTag, "sequence header did not parse (codec %u)", static_cast<unsigned>(videoConfig_.codec));
+        return;
+    }
+    spsInfo_ = info;
+    ASTRA_LOGI(kTag, "sequence header: %ux%u (coded %ux%u) profile=%u level=%u chroma=%u depth=%u fps=%.3f",
+               info.width, info.height, info.codedWidth, info.codedHeight, info.profileIdc, info.levelIdc,
+               info.chromaFormatIdc, info.bitDepthLuma, info.frameRate());
+    if (videoConfig_.width != 0 && videoConfig_.height != 0 &&
+        (info.width != videoConfig_.width || info.height != videoConfig_.height)) {
+        ASTRA_LOGW(kTag, "encoder produces %ux%u, %ux%u was requested; signalling the stream size",
+                   info.width, info.height, videoConfig_.width, videoConfig_.height);
+    }
+}
+
+FlvMuxer::NalAction FlvMuxer::classifyObu(const uint8_t* obu, size_t size, size_t headerSize) const {
+    switch (ObuType(obu)) {
+        case kObuTemporalDelimiter:
+        case kObuRedundantFrameHeader:
+        case kObuTileList:
+        case kObuPadding:
+            return NalAction::kDrop;
+        case kObuSequenceHeader:
+            return NalAction::kSps;
+        case kObuFrameHeader:
+        case kObuFrame: {
+            if (av1ReducedStillPicture_) {
+                return NalAction::kKeySlice;
+            }
+            if (size <= headerSize) {
+                return NalAction::kSlice;
+            }
+            // uncompressed_header() opens with show_existing_frame, frame_type (2 bits) and
+            // show_frame; only a shown KEY_FRAME is a random access point.
+            const uint8_t bits = obu[headerSize];
+            const bool keyFrame = (bits & 0x80) == 0 && ((bits >> 5) & 0x03) == 0 && (bits & 0x10) != 0;
+            return keyFrame ? NalAction::kKeySlice : NalAction::kSlice;
+        }
+        default:
+            return NalAction::kSlice;  // tile groups, metadata
+    }
+}
+
+void FlvMuxer::captureAv1SequenceHeader(const uint8_t* obu, size_t size) {
+    // Encoders repeat the sequence header with every key frame.
+    const uint64_t hash = ParameterSetHash(obu, size);
+    if (!sps_.empty() && hash == spsHash_) {
+        return;
+    }
+    const std::vector<ObuRange> ranges = FindObuRanges(obu, size);
+    if (ranges.size() != 1 || ranges.front().payloadSize() == 0) {
+        return;
+    }
+    sps_.clear();
+    AppendSizedObu(sps_, obu, ranges.front());
+    // seq_profile (3), still_picture (1), reduced_still_picture_header (1)
+    av1ReducedStillPicture_ = (obu[ranges.front().payloadOffset()] & 0x08) != 0;
+    spsHash_ = hash;
+    ++parameterSetGeneration_;
+    SpsInfo info;
+    const bool parsed =
+        ParseAv1SequenceHeader(obu + ranges.front().payloadOffset(), ranges.front().payloadSize(), info);
+    onSpsParsed(parsed, info);
+}
+
+bool FlvMuxer::captureAv1CodecConfiguration(const uint8_t* data, size_t size) {
+    if (size < kAv1ConfigHeaderSize || data[0] != kAv1ConfigMarkerVersion) {
+        return false;
+    }
+    const uint8_t* obus = data + kAv1ConfigHeaderSize;
+    for (const auto& range : FindObuRanges(obus, size - kAv1ConfigHeaderSize)) {
+        if (ObuType(obus + range.offset) == kObuSequenceHeader) {
+            captureAv1SequenceHeader(obus + range.offset, range.size());
+        }
+    }
+    return true;
+}
+
+ParsedVideoFrame FlvMuxer::parseAv1Frame(const uint8_t* data, size_t size) {
+    ParsedVideoFrame frame;
+    if (captureAv1CodecConfiguration(data, size)) {
+        return frame;
+    }
+    const std::vector<ObuRange> ranges = FindObuRanges(data, size);
+    frame.payload.reserve(size + 8);
+    for (const auto& range : ranges) {
+        const uint8_t* obu = data + range.offset;
+        const NalAction action = classifyObu(obu, range.size(), range.headerSize);
+        if (action == NalAction::kDrop) {
+            continue;
+        }
+        if (action == NalAction::kSps) {
+            captureAv1SequenceHeader(obu, range.size());
+        } else if (action == NalAction::kKeySlice) {
+            frame.isKeyFrame = true;
+        }
+        frame.temporalId = std::max(frame.temporalId,
+                                    ObuTemporalId(videoConfig_.temporalLayers, obu, range.headerSize));
+        AppendSizedObu(frame.payload, data, range);
+    }
+    return frame;
+}
+
+ParsedVideoSlices FlvMuxer::sliceAv1Frame(const uint8_t* data, size_t size) {
+    ParsedVideoSlices slices;
+    if (captureAv1CodecConfiguration(data, size)) {
+        return slices;
+    }
+    const std::vector<ObuRange> ranges = FindObuRanges(data, size);
+    for (const auto& range : ranges) {
+        const bool kept = classifyObu(data + range.offset, range.size(), range.headerSize) != NalAction::kDrop;
+        if (kept && !range.hasSizeField) {
+            return slices;
+        }
+    }
+
+    for (const auto& range : ranges) {
+        const uint8_t* obu = data + range.offset;
+        const NalAction action = classifyObu(obu, range.size(), range.headerSize);
+        if (action == NalAction::kDrop) {
+            continue;
+        }
+        if (action == NalAction::kSps) {
+            captureAv1SequenceHeader(obu, range.size());
+        } else if (action == NalAction::kKeySlice) {
+            slices.isKeyFrame = true;
+        }
+        slices.temporalId = std::max(slices.temporalId,
+                                     ObuTemporalId(videoConfig_.temporalLayers, obu, range.headerSize));
+        if (!slices.spans.empty() && slices.spans.back().data + slices.spans.back().size == obu) {
+            slices.spans.back().size += range.size();
+        } else {
+            slices.spans.push_back(ByteSpan{obu, range.size()});
+        }
+        slices.payloadSize += range.size();
+    }
+    return slices;
+}
+
 ParsedVideoFrame FlvMuxer::parseVideoFrame(const uint8_t* data, size_t size) {
     ParsedVideoFrame frame;
     if (data == nullptr || size == 0) {
         return frame;
     }
+    if (videoConfig_.codec == VideoCodecId::kAv1) {
+        return parseAv1Frame(data, size);
+    }
 
     std::vector<std::vector<uint8_t>> nalUnits = SplitAnnexbNalUnits(data, size);
     if (nalUnits.empty()) {
@@ -359,44 +755,16 @@ ParsedVideoFrame FlvMuxer::parseVideoFrame(const uint8_t* data, size_t size) {
             continue;
         }
 
-        uint8_t nalType = 0;
-        if (videoConfig_.codec == VideoCodecId::kH264) {
-            nalType = nal[0] & 0x1F;
-            if (nalType == kAudNalTypeH264) {
-                continue;
-            }
-            if (nalType == kSpsNalTypeH264) {
-                sps_.assign(nal.begin(), nal.end());
-                continue;
-            }
-            if (nalType == kPpsNalTypeH264) {
-                pps_.assign(nal.begin(), nal.end());
-                continue;
-            }
-            if (nalType == kIdrNalTypeH264) {
-                keyFrame = true;
-            }
-        } else {
-            nalType = static_cast<uint8_t>((nal[0] >> 1) & 0x3F);
-            if (nalType == kAudNalTypeH265) {
-                continue;
-            }
-            if (nalType == kVpsNalTypeH265) {
-                vps_.assign(nal.begin(), nal.end());
-                continue;
-            }
-            if (nalType == kSpsNalTypeH265) {
-                sps_.assign(nal.begin(), nal.end());
-                continue;
-            }
-            if (nalType == kPpsNalTypeH265) {
-                pps_.assign(nal.begin(), nal.end());
-                continue;
-            }
-            if (nalType == kIdrWRadlTypeH265 || nalType == kIdrNLpTypeH265 || nalType == kCraTypeH265) {
-                keyFrame = true;
-            }
+        const NalAction action = classifyNal(nal.data(), nal.size());
+        if (captureParameterSet(action, nal.data(), nal.size())) {
+            continue;
+        }
+        if (action == NalAction::kKeySlice) {
+            keyFrame = true;
         }
+        frame.temporalId = std::max(
+                frame.temporalId,
+                NalTemporalId(videoConfig_.codec, videoConfig_.temporalLayers, nal.data(), nal.size()));
 
         uint32_t nalSize = static_cast<uint32_t>(nal.size());
         payload.push_back(static_cast<uint8_t>((nalSize >> 24) & 0xFF));
@@ -411,20 +779,73 @@ ParsedVideoFrame FlvMuxer::parseVideoFrame(const uint8_t* data, size_t size) {
     return frame;
 }
 
+ParsedVideoSlices FlvMuxer::sliceVideoFrameInPlace(uint8_t* data, size_t size) {
+    if (videoConfig_.codec == VideoCodecId::kAv1) {
+        return data != nullptr ? sliceAv1Frame(data, size) : ParsedVideoSlices{};
+    }
+    ParsedVideoSlices slices;
+    const std::vector<NalRange> ranges = FindAnnexbNalRanges(data, size);
+    if (ranges.empty()) {
+        return slices;
+    }
+
+    // Validate before touching the buffer: every NAL that stays in the payload needs a
+    // 4-byte start code to become its length prefix, otherwise the caller copies instead.
+    for (const auto& range : ranges) {
+        const NalAction action = classifyNal(data + range.nalOffset(), range.nalSize());
+        const bool kept = action == NalAction::kSlice || action == NalAction::kKeySlice;
+        if (kept && range.startCodeLength != 4) {
+            return slices;
+        }
+    }
+
+    for (const auto& range : ranges) {
+        const uint8_t* nal = data + range.nalOffset();
+        const NalAction action = classifyNal(nal, range.nalSize());
+        if (captureParameterSet(action, nal, range.nalSize())) {
+            continue;
+        }
+        if (action == NalAction::kKeySlice) {
+            slices.isKeyFrame = true;
+        }
+        slices.temporalId = std::max(
+                slices.temporalId,
+                NalTemporalId(videoConfig_.codec, videoConfig_.temporalLayers, nal, range.nalSize()));
+
+        const auto nalSize = static_cast<uint32_t>(range.nalSize());
+        uint8_t* prefix = data + range.startCodeOffset;
+        prefix[0] = static_cast<uint8_t>((nalSize >> 24) & 0xFF);
+        prefix[1] = static_cast<uint8_t>((nalSize >> 16) & 0xFF);
+        prefix[2] = static_cast<uint8_t>((nalSize >> 8) & 0xFF);
+        prefix[3] = static_cast<uint8_t>(nalSize & 0xFF);
+
+        const size_t spanSize = range.end - range.startCodeOffset;
+        if (!slices.spans.empty() &&
+            slices.spans.back().data + slices.spans.back().size == prefix) {
+            slices.spans.back().size += spanSize;
+        } else {
+            slices.spans.push_back(ByteSpan{prefix, spanSize});
+        }
+        slices.payloadSize += spanSize;
+    }
+    return slices;
+}
+
+std::array<uint8_t, 5> FlvMuxer::buildVideoTagHeader(bool isKeyFrame) const {
+    std::array<uint8_t, kVideoHeaderSize> header{};
+    writeVideoHeader(header.data(), isKeyFrame, VideoPacket::kCodedFrames);
+    return header;
+}
+
 std::vector<uint8_t> FlvMuxer::buildVideoTag(const ParsedVideoFrame& frame) const {
     std::vector<uint8_t> payload;
     if (!frame.hasData()) {
         return payload;
     }
 
-    payload.reserve(5 + frame.payload.size());
-
-    uint8_t header = buildVideoHeader(videoConfig_.codec, frame.isKeyFrame, false);
-    payload.push_back(header);
-    payload.push_back(kFlvAvcNalu);
-    payload.push_back(0x00);
-    payload.push_back(0x00);
-    payload.push_back(0x00);
+    payload.resize(kVideoHeaderSize);
+    payload.reserve(kVideoHeaderSize + frame.payload.size());
+    writeVideoHeader(payload.data(), frame.isKeyFrame, VideoPacket::kCodedFrames);
     payload.insert(payload.end(), frame.payload.begin(), frame.payload.end());
     return payload;
 }
@@ -442,6 +863,45 @@ std::vector<uint8_t> FlvMuxer::buildAudioTag(const uint8_t* data, size_t size) c
     return payload;
 }
 
+std::array<uint8_t, FlvMuxer::kFileHeaderSize> FlvMuxer::buildFileHeader(bool hasAudio, bool hasVideo) {
+    std::array<uint8_t, kFileHeaderSize> header{'F', 'L', 'V', 0x01, 0x00, 0x00, 0x00, 0x00, 0x09};
+    header[4] = static_cast<uint8_t>((hasAudio ? 0x04 : 0x00) | (hasVideo ? 0x01 : 0x00));
+    return header;  // PreviousTagSize0 stays zero
+}
+
+void FlvMuxer::writeTagHeader(uint8_t* out, uint8_t tagType, uint32_t dataSize, uint32_t timestamp) {
+    out[0] = tagType;
+    out[1] = static_cast<uint8_t>((dataSize >> 16) & 0xFF);
+    out[2] = static_cast<uint8_t>((dataSize >> 8) & 0xFF);
+    out[3] = static_cast<uint8_t>(dataSize & 0xFF);
+    out[4] = static_cast<uint8_t>((timestamp >> 16) & 0xFF);
+    out[5] = static_cast<uint8_t>((timestamp >> 8) & 0xFF);
+    out[6] = static_cast<uint8_t>(timestamp & 0xFF);
+    out[7] = static_cast<uint8_t>((timestamp >> 24) & 0xFF);  // TimestampExtended
+    out[8] = 0x00;  // StreamID
+    out[9] = 0x00;
+    out[10] = 0x00;
+}
+
+void FlvMuxer::writePreviousTagSize(uint8_t* out, uint32_t dataSize) {
+    const uint32_t tagSize = static_cast<uint32_t>(kTagHeaderSize) + dataSize;
+    out[0] = static_cast<uint8_t>((tagSize >> 24) & 0xFF);
+    out[1] = static_cast<uint8_t>((tagSize >> 16) & 0xFF);
+    out[2] = static_cast<uint8_t>((tagSize >> 8) & 0xFF);
+    out[3] = static_cast<uint8_t>(tagSize & 0xFF);
+}
+
+std::vector<uint8_t> FlvMuxer::buildFlvTag(uint8_t tagType,
+                                           const std::vector<uint8_t>& payload,
+                                           uint32_t timestamp) {
+    const auto dataSize = static_cast<uint32_t>(payload.size());
+    std::vector<uint8_t> tag(kTagHeaderSize + payload.size() + kPreviousTagSizeSize);
+    writeTagHeader(tag.data(), tagType, dataSize, timestamp);
+    std::copy(payload.begin(), payload.end(), tag.begin() + kTagHeaderSize);
+    writePreviousTagSize(tag.data() + kTagHeaderSize + payload.size(), dataSize);
+    return tag;
+}
+
 std::array<uint8_t, 2> FlvMuxer::buildAudioHeader(const AudioConfig& /*config*/, bool isSequence) {
     std::array<uint8_t, 2> header{};
     header[0] = static_cast<uint8_t>((kFlvSoundFormatAac & 0x0F) << 4);
@@ -452,18 +912,39 @@ std::array<uint8_t, 2> FlvMuxer::buildAudioHeader(const AudioConfig& /*config*/,
     return header;
 }
 
-uint8_t FlvMuxer::buildVideoHeader(VideoCodecId codec,
-                                    bool isKeyFrame,
-                                    bool isSequence) {
-    uint8_t header = 0;
-    header |= static_cast<uint8_t>((isKeyFrame ? kFlvVideoFrameKey : kFlvVideoFrameInter) << 4);
-    header |= static_cast<uint8_t>((codec == VideoCodecId::kH264 ? 7 : 12) & 0x0F);
-    return header;
+void FlvMuxer::writeVideoHeader(uint8_t* out, bool isKeyFrame, VideoPacket packet) const {
+    const uint8_t frameType = isKeyFrame ? kFlvVideoFrameKey : kFlvVideoFrameInter;
+    const uint32_t fourCc = VideoFourCc(videoConfig_.codec);
+    if (fourCc == 0) {
+        out[0] = static_cast<uint8_t>((frameType << 4) | kFlvCodecIdAvc);
+        switch (packet) {
+            case VideoPacket::kSequenceStart: out[1] = kFlvAvcSequenceHeader; break;
+            case VideoPacket::kCodedFrames: out[1] = kFlvAvcNalu; break;
+            case VideoPacket::kSequenceEnd: out[1] = kFlvAvcEndOfSequence; break;
+        }
+        out[2] = 0x00;  // composition time
+        out[3] = 0x00;
+        out[4] = 0x00;
+        return;
+    }
+    // Frames never carry a composition offset (no B-frames), so CodedFramesX (3) replaces
+    // CodedFrames (1) and its 3-byte composition time.
+    uint8_t packetType = kExPacketCodedFramesX;
+    switch (packet) {
+        case VideoPacket::kSequenceStart: packetType = kExPacketSequenceStart; break;
+        case VideoPacket::kCodedFrames: packetType = kExPacketCodedFramesX; break;
+        case VideoPacket::kSequenceEnd: packetType = kExPacketSequenceEnd; break;
+    }
+    out[0] = static_cast<uint8_t>(kExVideoHeaderFlag | (frameType << 4) | packetType);
+    out[1] = static_cast<uint8_t>(fourCc >> 24);
+    out[2] = static_cast<uint8_t>(fourCc >> 16);
+    out[3] = static_cast<uint8_t>(fourCc >> 8);
+    out[4] = static_cast<uint8_t>(fourCc);
 }
 
 std::vector<uint8_t> FlvMuxer::buildAvcDecoderConfigurationRecord() const {
     std::vector<uint8_t> record;
-    record.reserve(11 + sps_.size() + pps_.size());
+    record.reserve(15 + sps_.size() + pps_.size());
     record.push_back(0x01);
     record.push_back(sps_.size() >= 2 ? sps_[1] : 0);
     record.push_back(sps_.size() >= 3 ? sps_[2] : 0);
@@ -479,112 +960,56 @@ std::vector<uint8_t> FlvMuxer::buildAvcDecoderConfigurationRecord() const {
     record.push_back(static_cast<uint8_t>((pps_.size() >> 8) & 0xFF));
     record.push_back(static_cast<uint8_t>(pps_.size() & 0xFF));
     record.insert(record.end(), pps_.begin(), pps_.end());
+
+    // High profiles carry chroma format and bit depths after the parameter sets (ISO/IEC 14496-15).
+    const uint8_t profile = spsInfo_.has_value() ? spsInfo_->profileIdc : 0;
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 144) {
+        record.push_back(static_cast<uint8_t>(0xFC | (spsInfo_->chromaFormatIdc & 0x03)));
+        record.push_back(static_cast<uint8_t>(0xF8 | ((spsInfo_->bitDepthLuma - 8) & 0x07)));
+        record.push_back(static_cast<uint8_t>(0xF8 | ((spsInfo_->bitDepthChroma - 8) & 0x07)));
+        record.push_back(0x00);  // numOfSequenceParameterSetExt
+    }
     return record;
 }
 
 std::vector<uint8_t> FlvMuxer::buildHevcDecoderConfigurationRecord() const {
     std::vector<uint8_t> record;
-    if (sps_.empty()) {
+    if (!spsInfo_.has_value()) {
         return record;
     }
-
-    std::vector<uint8_t> rbsp = ToRbsp(sps_);
-    BitReader reader(rbsp);
-
-    reader.readBits(4);  // sps_video_parameter_set_id
-    uint32_t maxSubLayersMinus1 = reader.readBits(3);
-    bool temporalIdNested = reader.readBit() == 1;
-
-    uint32_t generalProfileSpace = reader.readBits(2);
-    uint32_t generalTierFlag = reader.readBit();
-    uint32_t generalProfileIdc = reader.readBits(5);
-
-    uint32_t generalProfileCompatibilityFlags = 0;
-    for (int i = 0; i < 32; ++i) {
-        generalProfileCompatibilityFlags = (generalProfileCompatibilityFlags << 1) | reader.readBit();
-    }
-
-    uint64_t generalConstraintIndicatorFlags = 0;
-    for (int i = 0; i < 48; ++i) {
-        generalConstraintIndicatorFlags = (generalConstraintIndicatorFlags << 1) | reader.readBit();
-    }
-
-    uint32_t generalLevelIdc = reader.readBits(8);
-
-    std::vector<uint8_t> subLayerProfilePresent(maxSubLayersMinus1);
-    std::vector<uint8_t> subLayerLevelPresent(maxSubLayersMinus1);
-    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
-        subLayerProfilePresent[i] = static_cast<uint8_t>(reader.readBit());
-        subLayerLevelPresent[i] = static_cast<uint8_t>(reader.readBit());
-    }
-
-    if (maxSubLayersMinus1 > 0) {
-        for (uint32_t i = maxSubLayersMinus1; i < 8; ++i) {
-            reader.readBits(2);
-        }
-    }
-
-    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
-        if (subLayerProfilePresent[i]) {
-            reader.readBits(2);
-            reader.readBits(1);
-            reader.readBits(5);
-            for (int j = 0; j < 32; ++j) reader.readBit();
-            for (int j = 0; j < 48; ++j) reader.readBit();
-        }
-        if (subLayerLevelPresent[i]) {
-            reader.readBits(8);
-        }
-    }
-
-    reader.readUE();  // sps_seq_parameter_set_id
-    uint32_t chromaFormatIdc = reader.readUE();
-    if (chromaFormatIdc == 3) {
-        reader.readBit();
-    }
-
-    reader.readUE();  // pic_width_in_luma_samples
-    reader.readUE();  // pic_height_in_luma_samples
-
-    if (reader.readBit()) {
-        reader.readUE();
-        reader.readUE();
-        reader.readUE();
-        reader.readUE();
-    }
-
-    uint32_t bitDepthLumaMinus8 = reader.readUE();
-    uint32_t bitDepthChromaMinus8 = reader.readUE();
+    const SpsInfo& info = *spsInfo_;
 
     record.reserve(38 + vps_.size() + sps_.size() + pps_.size());
     record.push_back(0x01);
-    record.push_back(static_cast<uint8_t>((generalProfileSpace << 6) |
-                                          (generalTierFlag << 5) |
-                                          (generalProfileIdc & 0x1F)));
-    record.push_back(static_cast<uint8_t>((generalProfileCompatibilityFlags >> 24) & 0xFF));
-    record.push_back(static_cast<uint8_t>((generalProfileCompatibilityFlags >> 16) & 0xFF));
-    record.push_back(static_cast<uint8_t>((generalProfileCompatibilityFlags >> 8) & 0xFF));
-    record.push_back(static_cast<uint8_t>(generalProfileCompatibilityFlags & 0xFF));
+    record.push_back(static_cast<uint8_t>((info.profileSpace << 6) |
+                                          ((info.tierFlag & 0x01) << 5) |
+                                          (info.profileIdc & 0x1F)));
+    record.push_back(static_cast<uint8_t>((info.profileCompatibilityFlags >> 24) & 0xFF));
+    record.push_back(static_cast<uint8_t>((info.profileCompatibilityFlags >> 16) & 0xFF));
+    record.push_back(static_cast<uint8_t>((info.profileCompatibilityFlags >> 8) & 0xFF));
+    record.push_back(static_cast<uint8_t>(info.profileCompatibilityFlags & 0xFF));
 
     for (int shift = 40; shift >= 0; shift -= 8) {
-        record.push_back(static_cast<uint8_t>((generalConstraintIndicatorFlags >> shift) & 0xFF));
+        record.push_back(static_cast<uint8_t>((info.constraintIndicatorFlags >> shift) & 0xFF));
     }
-    record.push_back(static_cast<uint8_t>(generalLevelIdc & 0xFF));
+    record.push_back(info.levelIdc);
 
     uint16_t minSpatialSegmentation = 0x0FFF;
     record.push_back(static_cast<uint8_t>((0xF0) | ((minSpatialSegmentation >> 8) & 0x0F)));
     record.push_back(static_cast<uint8_t>(minSpatialSegmentation & 0xFF));
 
     record.push_back(static_cast<uint8_t>((0xFC) | 0x00));
-    record.push_back(static_cast<uint8_t>((0xFC) | (chromaFormatIdc & 0x03)));
-    record.push_back(static_cast<uint8_t>((0xF8) | (bitDepthLumaMinus8 & 0x07)));
-    record.push_back(static_cast<uint8_t>((0xF8) | (bitDepthChromaMinus8 & 0x07)));
+    record.push_back(static_cast<uint8_t>((0xFC) | (info.chromaFormatIdc & 0x03)));
+    record.push_back(static_cast<uint8_t>((0xF8) | ((info.bitDepthLuma - 8) & 0x07)));
+    record.push_back(static_cast<uint8_t>((0xF8) | ((info.bitDepthChroma - 8) & 0x07)));
 
-    record.push_back(0x00);
-    record.push_back(0x00);
+    // avgFrameRate in frames per 256 seconds, 0 when the VUI has no timing.
+    const auto avgFrameRate = static_cast<uint16_t>(std::min(info.frameRate() * 256.0, 65535.0));
+    record.push_back(static_cast<uint8_t>((avgFrameRate >> 8) & 0xFF));
+    record.push_back(static_cast<uint8_t>(avgFrameRate & 0xFF));
 
-    uint8_t temporalLayers = static_cast<uint8_t>(std::min<uint32_t>(maxSubLayersMinus1 + 1, 8) - 1);
-    uint8_t flagsByte = static_cast<uint8_t>((0 << 6) | (temporalLayers << 3) | (temporalIdNested ? 1 << 2 : 0) | 0x03);
+    uint8_t temporalLayers = static_cast<uint8_t>(std::min<uint32_t>(info.maxSubLayers, 8) - 1);
+    uint8_t flagsByte = static_cast<uint8_t>((0 << 6) | (temporalLayers << 3) | (info.temporalIdNested ? 1 << 2 : 0) | 0x03);
     record.push_back(flagsByte);
     record.push_back(0x03);
 
@@ -604,4 +1029,27 @@ std::vector<uint8_t> FlvMuxer::buildHevcDecoderConfigurationRecord() const {
     return record;
 }
 
+std::vector<uint8_t> FlvMuxer::buildAv1CodecConfigurationRecord() const {
+    std::vector<uint8_t> record;
+    if (!spsInfo_.has_value()) {
+        return record;
+    }
+    const SpsInfo& info = *spsInfo_;
+    const uint32_t highBitdepth = info.bitDepthLuma > 8 ? 1U : 0U;
+    const uint32_t twelveBit = info.bitDepthLuma == 12 ? 1U : 0U;
+    const uint32_t monochrome = info.chromaFormatIdc == 0 ? 1U : 0U;
+    const uint32_t subsamplingX = info.chromaFormatIdc != 3 ? 1U : 0U;  // monochrome is 1, 1
+    const uint32_t subsamplingY = info.chromaFormatIdc <= 1 ? 1U : 0U;
+
+    record.reserve(kAv1ConfigHeaderSize + sps_.size());
+    record.push_back(kAv1ConfigMarkerVersion);
+    record.push_back(static_cast<uint8_t>((info.profileIdc << 5) | (info.levelIdc & 0x1F)));
+    record.push_back(static_cast<uint8_t>(((info.tierFlag & 0x01) << 7) | (highBitdepth << 6) | (twelveBit << 5) |
+                                          (monochrome << 4) | (subsamplingX << 3) | (subsamplingY << 2) |
+                                          (info.chromaSamplePosition & 0x03)));
+    record.push_back(0x00);  // no initial_presentation_delay
+    record.insert(record.end(), sps_.begin(), sps_.end());  // configOBUs
+    return record;
+}
+
 }  // namespace astra
@@ -7,18 +7,41 @@
 #include <optional>
 #include <vector>
 
+#include "SpsParser.h"
+
 namespace astra {
 
 enum class VideoCodecId : uint8_t {
     kH264 = 7,
     kH265 = 12,
+    kAv1 = 13,  // no legacy FLV codec id; only ever written with the 'av01' FourCC
 };
 
+// Enhanced RTMP video FourCCs as written on the wire (big-endian). H.264 keeps the legacy
+// codec id 7 header, which every ingest understands.
+constexpr uint32_t kFourCcHevc = 0x68766331;  // 'hvc1'
+constexpr uint32_t kFourCcAv1 = 0x61763031;  // 'av01'
+
+// FourCC used in ExVideoTagHeader for |codec|, 0 when it uses the legacy header.
+uint32_t VideoFourCc(VideoCodecId codec);
+
+// Frame type and packet kind of a video tag body, legacy or ExVideoTagHeader.
+struct VideoTagInfo {
+    bool keyFrame = false;
+    bool sequenceHeader = false;
+    bool sequenceEnd = false;
+    uint32_t fourCc = 0;  // 0 for a legacy header
+};
+VideoTagInfo InspectVideoTag(const uint8_t* body, size_t size);
+
 struct VideoConfig {
     VideoCodecId codec{VideoCodecId::kH264};
     uint32_t width = 0;
     uint32_t height = 0;
     uint32_t fps = 0;
+    // Temporal layers the encoder is actually producing. Set by the encoder after configure;
+    // with 1, every frame reports temporalId 0 whatever its NAL headers suggest.
+    uint32_t temporalLayers = 1;
 };
 
 struct AudioConfig {
@@ -29,11 +52,27 @@ struct AudioConfig {
 };
 
 struct ParsedVideoFrame {
-    std::vector<uint8_t> payload;  // length-prefixed NAL units combined
+    std::vector<uint8_t> payload;  // length-prefixed NAL units combined; AV1: sized OBUs
     bool isKeyFrame = false;
+    // Temporal sub-layer (SVC-T); 0 unless VideoConfig::temporalLayers > 1. Frames of the top
+    // layer are not referenced by any other and can be dropped without breaking decode.
+    uint8_t temporalId = 0;
     bool hasData() const { return !payload.empty(); }
 };
 
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+struct ParsedVideoSlices {
+    std::vector<ByteSpan> spans;  // length-prefixed NAL (or sized OBU) runs inside the caller's buffer
+    size_t payloadSize = 0;
+    bool isKeyFrame = false;
+    uint8_t temporalId = 0;  // as in ParsedVideoFrame
+    bool hasData() const { return payloadSize > 0; }
+};
+
 class FlvMuxer {
 public:
     FlvMuxer() = default;
@@ -42,9 +81,17 @@ public:
 
     void setVideoConfig(const VideoConfig& config);
     void setAudioConfig(const AudioConfig& config);
+    // Same codec at a new size or frame rate (encoder switched mid-stream): keeps the sent
+    // state, so the next parameter sets go out as a sequence change rather than a restart.
+    void updateVideoConfig(const VideoConfig& config);
 
     [[nodiscard]] const VideoConfig& videoConfig() const { return videoConfig_; }
     [[nodiscard]] const AudioConfig& audioConfig() const { return audioConfig_; }
+    // Parse of the captured SPS (AV1: sequence header), empty until one arrives or if it did
+    // not parse.
+    [[nodiscard]] const std::optional<SpsInfo>& spsInfo() const { return spsInfo_; }
+    // videoConfig() with the size and, when signalled, the frame rate the bitstream carries.
+    [[nodiscard]] VideoConfig streamVideoConfig() const;
 
     [[nodiscard]] bool videoSequenceReady() const;
     [[nodiscard]] bool audioSequenceReady() const;
@@ -53,6 +100,15 @@ public:
     bool hasSentAudioSequence() const { return audioSequenceSent_; }
     bool hasSentMetadata() const { return metadataSent_; }
 
+    // Bumped each time a captured parameter set really changes; encoders that repeat them
+    // ahead of every IDR leave it alone.
+    [[nodiscard]] uint32_t parameterSetGeneration() const { return parameterSetGeneration_; }
+    // The parameter sets changed after the sequence header went out (e.g. a resolution
+    // switch): the next key frame needs a fresh one, and onMetaData, ahead of it.
+    [[nodiscard]] bool videoSequenceChanged() const {
+        return videoSequenceSent_ && sentGeneration_ != parameterSetGeneration_;
+    }
+
     void markVideoSequenceSent() { videoSequenceSent_ = true; }
     void markAudioSequenceSent() { audioSequenceSent_ = true; }
     void markMetadataSent() { metadataSent_ = true; }
@@ -60,12 +116,53 @@ public:
     [[nodiscard]] std::optional<std::vector<uint8_t>> buildMetadataTag() const;
     [[nodiscard]] std::optional<std::vector<uint8_t>> buildVideoSequenceHeader();
     [[nodiscard]] std::optional<std::vector<uint8_t>> buildAudioSequenceHeader() const;
+    // End-of-sequence tag, sent when the stream stops after its sequence header went out.
+    [[nodiscard]] std::vector<uint8_t> buildVideoSequenceEnd() const;
+    // avcC / hvcC / av1C body from the captured parameter sets, shared with containers other than FLV.
+    // Built once per parameterSetGeneration().
+    [[nodiscard]] std::optional<std::vector<uint8_t>> buildDecoderConfigurationRecord() const;
 
     [[nodiscard]] ParsedVideoFrame parseVideoFrame(const uint8_t* data, size_t size);
+    // Rewrites 4-byte start codes into length prefixes inside |data| and returns the kept
+    // NAL runs without copying. Empty when the buffer cannot be rewritten in place. AV1 OBUs
+    // already carry their sizes, so they are only sliced; an OBU without one needs the copy.
+    [[nodiscard]] ParsedVideoSlices sliceVideoFrameInPlace(uint8_t* data, size_t size);
+    // Legacy AVC header with a zero composition time, or ExVideoTagHeader CodedFramesX
+    // (composition time implied zero): five bytes either way.
+    [[nodiscard]] std::array<uint8_t, 5> buildVideoTagHeader(bool isKeyFrame) const;
     std::vector<uint8_t> buildVideoTag(const ParsedVideoFrame& frame) const;
     std::vector<uint8_t> buildAudioTag(const uint8_t* data, size_t size) const;
 
+    // File framing, for writing tags to disk rather than into RTMP messages.
+    static constexpr size_t kFileHeaderSize = 13;  // header plus PreviousTagSize0
+    static constexpr size_t kTagHeaderSize = 11;
+    static constexpr size_t kPreviousTagSizeSize = 4;
+    static std::array<uint8_t, kFileHeaderSize> buildFileHeader(bool hasAudio, bool hasVideo);
+    static void writeTagHeader(uint8_t* out, uint8_t tagType, uint32_t dataSize, uint32_t timestamp);
+    static void writePreviousTagSize(uint8_t* out, uint32_t dataSize);
+    // Complete tag including its trailing PreviousTagSize.
+    static std::vector<uint8_t> buildFlvTag(uint8_t tagType,
+                                            const std::vector<uint8_t>& payload,
+                                            uint32_t timestamp);
+
 private:
+    enum class NalAction : uint8_t {
+        kDrop,
+        kVps,
+        kSps,
+        kPps,
+        kSlice,
+        kKeySlice,
+    };
+
+    NalAction classifyNal(const uint8_t* nal, size_t size) const;
+    bool captureParameterSet(NalAction action, const uint8_t* nal, size_t size);
+    // Copies |nal| into |target| unless it hashes the same as what is there; true on a change.
+    bool storeParameterSet(std::vector<uint8_t>& target, uint64_t& hash, const uint8_t* nal, size_t size);
+    // Parses a new SPS; a repeat of the current one is not copied or parsed again.
+    void captureSps(const uint8_t* nal, size_t size);
+    void onSpsParsed(bool parsed, const SpsInfo& info);
+
     bool parseAnnexbFrame(const uint8_t* data,
                           size_t size,
                           std::vector<uint8_t>& payload,
@@ -74,28 +171,46 @@ private:
                         size_t size,
                         std::vector<uint8_t>& payload,
                         bool& isKeyFrame);
+    // AV1 low-overhead bitstream: temporal delimiters, padding and redundant frame headers
+    // are dropped; the sequence header is captured and stays in the sample.
+    NalAction classifyObu(const uint8_t* obu, size_t size, size_t headerSize) const;
+    void captureAv1SequenceHeader(const uint8_t* obu, size_t size);
+    ParsedVideoFrame parseAv1Frame(const uint8_t* data, size_t size);
+    ParsedVideoSlices sliceAv1Frame(const uint8_t* data, size_t size);
+    // True for an av1C record (the encoder's codec-config buffer); its config OBUs are captured.
+    bool captureAv1CodecConfiguration(const uint8_t* data, size_t size);
 
     void ensureMetadataDefaults();
 
-    std::vector<uint8_t> buildFlvTag(uint8_t tagType,
-                                     const std::vector<uint8_t>& payload) const;
-    static void writeTagHeader(std::vector<uint8_t>& buffer,
-                               uint8_t tagType,
-                               uint32_t dataSize);
     static std::array<uint8_t, 2> buildAudioHeader(const AudioConfig& config, bool isSequence);
-    static uint8_t buildVideoHeader(VideoCodecId codec,
-                                    bool isKeyFrame,
-                                    bool isSequence);
-
+    enum class VideoPacket : uint8_t {
+        kSequenceStart,
+        kCodedFrames,
+        kSequenceEnd,
+    };
+    void writeVideoHeader(uint8_t* out, bool isKeyFrame, VideoPacket packet) const;
+
+    // Rebuilt only when parameterSetGeneration_ moved; videoSequenceReady() must hold.
+    const std::vector<uint8_t>& cachedDecoderConfigurationRecord() const;
     std::vector<uint8_t> buildAvcDecoderConfigurationRecord() const;
     std::vector<uint8_t> buildHevcDecoderConfigurationRecord() const;
+    std::vector<uint8_t> buildAv1CodecConfigurationRecord() const;
 
     VideoConfig videoConfig_{};
     AudioConfig audioConfig_{};
 
-    std::vector<uint8_t> sps_;
+    std::vector<uint8_t> sps_;  // AV1: the sequence header OBU, with its size field
     std::vector<uint8_t> pps_;
     std::vector<uint8_t> vps_;
+    bool av1ReducedStillPicture_ = false;  // every frame is a key frame
+    std::optional<SpsInfo> spsInfo_;
+    uint64_t spsHash_ = 0;  // ParameterSetHash of the bytes spsInfo_ was parsed from
+    uint64_t ppsHash_ = 0;
+    uint64_t vpsHash_ = 0;
+    uint32_t parameterSetGeneration_ = 0;
+    uint32_t sentGeneration_ = 0;  // generation of the last sequence header built
+    mutable std::vector<uint8_t> decoderConfig_;  // record for decoderConfigGeneration_
+    mutable uint32_t decoderConfigGeneration_ = 0;
 
     bool metadataSent_ = false;
     bool videoSequenceSent_ = false;
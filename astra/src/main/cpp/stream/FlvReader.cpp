@@ -0,0 +1,195 @@
+#include "FlvReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "FlvMuxer.h"
+#include "../common/AstraLog.h"
+
+namespace astra {
+
+namespace {
+constexpr const char* kTag = "FlvReader";
+constexpr uint8_t kTagAudio = 8;
+constexpr uint8_t kTagVideo = 9;
+constexpr uint8_t kTagScript = 18;
+
+uint32_t ReadU24(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+}
+
+uint32_t ReadU32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | ReadU24(p + 1);
+}
+
+const FlvTagView& HeaderAt(const std::vector<FlvTagView>& headers, uint64_t offset) {
+    static const FlvTagView kNone;
+    if (headers.empty()) {
+        return kNone;
+    }
+    auto it = std::upper_bound(headers.begin(), headers.end(), offset,
+                               [](uint64_t value, const FlvTagView& header) { return value < header.offset; });
+    return it == headers.begin() ? headers.front() : *(it - 1);
+}
+}  // namespace
+
+FlvReader::~FlvReader() {
+    close();
+}
+
+bool FlvReader::open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ASTRA_LOGE(kTag, "open %s failed errno=%d", path.c_str(), errno);
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(FlvMuxer::kFileHeaderSize)) {
+        ASTRA_LOGE(kTag, "open %s: not an FLV file", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ASTRA_LOGE(kTag, "mmap %s failed errno=%d", path.c_str(), errno);
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapping);
+    size_ = static_cast<size_t>(info.st_size);
+    const uint32_t headerSize = ReadU32(data_ + 5);
+    if (data_[0] != 'F' || data_[1] != 'L' || data_[2] != 'V' || headerSize < 9 ||
+        headerSize + FlvMuxer::kPreviousTagSizeSize > size_) {
+        ASTRA_LOGE(kTag, "open %s: bad FLV header", path.c_str());
+        close();
+        return false;
+    }
+    hasAudio_ = (data_[4] & 0x04) != 0;
+    hasVideo_ = (data_[4] & 0x01) != 0;
+    firstTagOffset_ = headerSize + FlvMuxer::kPreviousTagSizeSize;
+    ::madvise(mapping, size_, MADV_SEQUENTIAL);
+    buildIndex();
+    ::madvise(mapping, size_, MADV_NORMAL);
+    cursor_ = firstTagOffset_;
+    ASTRA_LOGI(kTag, "opened %s tags=%zu keyframes=%zu duration=%u ms",
+               path.c_str(), tagCount_, keyframes_.size(), lastTimestamp_);
+    return true;
+}
+
+void FlvReader::close() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    end_ = 0;
+    cursor_ = 0;
+    tagCount_ = 0;
+    lastTimestamp_ = 0;
+    keyframes_.clear();
+    metadata_ = FlvTagView{};
+    videoSequences_.clear();
+    audioSequences_.clear();
+}
+
+bool FlvReader::next(FlvTagView& tag) {
+    if (!readTag(cursor_, tag)) {
+        return false;
+    }
+    cursor_ = tag.offset + FlvMuxer::kTagHeaderSize + tag.size + FlvMuxer::kPreviousTagSizeSize;
+    return true;
+}
+
+uint32_t FlvReader::seek(uint32_t timestampMs) {
+    if (keyframes_.empty()) {
+        rewind();
+        return 0;
+    }
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), timestampMs,
+                               [](uint32_t value, const Keyframe& entry) { return value < entry.timestamp; });
+    if (it != keyframes_.begin()) {
+        --it;
+    }
+    cursor_ = it->offset;
+    return it->timestamp;
+}
+
+const FlvTagView& FlvReader::videoSequenceHeaderAt(uint64_t offset) const {
+    return HeaderAt(videoSequences_, offset);
+}
+
+const FlvTagView& FlvReader::audioSequenceHeaderAt(uint64_t offset) const {
+    return HeaderAt(audioSequences_, offset);
+}
+
+bool FlvReader::readTag(uint64_t offset, FlvTagView& tag) const {
+    const size_t limit = end_ > 0 ? end_ : size_;
+    if (offset + FlvMuxer::kTagHeaderSize > limit) {
+        return false;
+    }
+    const uint8_t* header = data_ + offset;
+    const uint32_t dataSize = ReadU24(header + 1);
+    if (offset + FlvMuxer::kTagHeaderSize + dataSize + FlvMuxer::kPreviousTagSizeSize > limit) {
+        return false;
+    }
+    tag.type = header[0] & 0x1F;
+    tag.timestamp = ReadU24(header + 4) | (static_cast<uint32_t>(header[7]) << 24);
+    tag.body = header + FlvMuxer::kTagHeaderSize;
+    tag.size = dataSize;
+    tag.offset = offset;
+    tag.keyFrame = false;
+    tag.sequenceHeader = false;
+    tag.sequenceEnd = false;
+    if (tag.type == kTagVideo && dataSize >= 2) {
+        const VideoTagInfo info = InspectVideoTag(tag.body, dataSize);
+        tag.keyFrame = info.keyFrame;
+        tag.sequenceHeader = info.sequenceHeader;
+        tag.sequenceEnd = info.sequenceEnd;
+    } else if (tag.type == kTagAudio && dataSize >= 2) {
+        tag.sequenceHeader = (tag.body[0] >> 4) == 10 && tag.body[1] == 0;
+    }
+    return true;
+}
+
+void FlvReader::buildIndex() {
+    uint64_t offset = firstTagOffset_;
+    FlvTagView tag;
+    while (readTag(offset, tag)) {
+        ++tagCount_;
+        lastTimestamp_ = std::max(lastTimestamp_, tag.timestamp);
+        if (tag.type == kTagVideo) {
+            hasVideo_ = true;
+            if (tag.sequenceHeader) {
+                videoSequences_.push_back(tag);
+            } else if (tag.keyFrame && !tag.sequenceEnd) {
+                keyframes_.push_back(Keyframe{tag.timestamp, tag.offset});
+            }
+        } else if (tag.type == kTagAudio) {
+            hasAudio_ = true;
+            if (tag.sequenceHeader) {
+                audioSequences_.push_back(tag);
+            }
+        } else if (tag.type == kTagScript && metadata_.body == nullptr) {
+            metadata_ = tag;
+        }
+        offset = tag.offset + FlvMuxer::kTagHeaderSize + tag.size + FlvMuxer::kPreviousTagSizeSize;
+    }
+    end_ = static_cast<size_t>(offset);
+    if (end_ < size_) {
+        ASTRA_LOGW(kTag, "ignoring %zu trailing bytes after the last whole tag", size_ - end_);
+    }
+    // Timestamps can step back at a splice; keep the index sorted so seek stays a binary search.
+    if (!std::is_sorted(keyframes_.begin(), keyframes_.end(),
+                        [](const Keyframe& a, const Keyframe& b) { return a.timestamp < b.timestamp; })) {
+        std::stable_sort(keyframes_.begin(), keyframes_.end(),
+                         [](const Keyframe& a, const Keyframe& b) { return a.timestamp < b.timestamp; });
+    }
+}
+
+}  // namespace astra
@@ -0,0 +1,86 @@
+#ifndef ASTRASTREAM_FLVREADER_H
+#define ASTRASTREAM_FLVREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace astra {
+
+// One tag of a mapped FLV file. |body| points into the mapping and stays valid until the
+// reader is closed.
+struct FlvTagView {
+    uint8_t type = 0;  // 8 audio, 9 video, 18 script data
+    uint32_t timestamp = 0;
+    const uint8_t* body = nullptr;
+    uint32_t size = 0;
+    uint64_t offset = 0;  // of the tag header
+    bool keyFrame = false;
+    bool sequenceHeader = false;  // video (legacy or SequenceStart) or AAC sequence header
+    bool sequenceEnd = false;  // AVC end of sequence or SequenceEnd; flagged as a keyframe
+};
+
+// Read-only FLV demuxer over an mmap'd file. open() walks the tags once to build the
+// keyframe index and remember the first onMetaData and every sequence header; after that next()
+// hands out views without copying and seek() finds a keyframe by binary search. A truncated
+// tail, as left by a recording that never closed, ends the file at the last whole tag.
+class FlvReader {
+public:
+    struct Keyframe {
+        uint32_t timestamp = 0;
+        uint64_t offset = 0;
+    };
+
+    FlvReader() = default;
+    ~FlvReader();
+    FlvReader(const FlvReader&) = delete;
+    FlvReader& operator=(const FlvReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Next tag from the cursor; false at the end of the file.
+    bool next(FlvTagView& tag);
+    // Moves the cursor to the last keyframe at or before |timestampMs| (the first keyframe
+    // when none is earlier) and returns its timestamp. Without video, rewinds to the start.
+    uint32_t seek(uint32_t timestampMs);
+    void rewind() { cursor_ = firstTagOffset_; }
+    [[nodiscard]] uint64_t cursor() const { return cursor_; }
+
+    [[nodiscard]] bool isOpen() const { return data_ != nullptr; }
+    [[nodiscard]] bool hasAudio() const { return hasAudio_; }
+    [[nodiscard]] bool hasVideo() const { return hasVideo_; }
+    [[nodiscard]] size_t tagCount() const { return tagCount_; }
+    [[nodiscard]] uint32_t durationMs() const { return lastTimestamp_; }
+    [[nodiscard]] const std::vector<Keyframe>& keyframes() const { return keyframes_; }
+    // Zero-sized views when the file has none.
+    [[nodiscard]] const FlvTagView& metadata() const { return metadata_; }
+    [[nodiscard]] const FlvTagView& videoSequenceHeader() const { return videoSequenceHeaderAt(0); }
+    [[nodiscard]] const FlvTagView& audioSequenceHeader() const { return audioSequenceHeaderAt(0); }
+    // The header in effect for the tag at |offset|: the last one before it, else the first.
+    [[nodiscard]] const FlvTagView& videoSequenceHeaderAt(uint64_t offset) const;
+    [[nodiscard]] const FlvTagView& audioSequenceHeaderAt(uint64_t offset) const;
+
+private:
+    bool readTag(uint64_t offset, FlvTagView& tag) const;
+    void buildIndex();
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t end_ = 0;  // one past the last whole tag
+    uint64_t firstTagOffset_ = 0;
+    uint64_t cursor_ = 0;
+    bool hasAudio_ = false;
+    bool hasVideo_ = false;
+    size_t tagCount_ = 0;
+    uint32_t lastTimestamp_ = 0;
+    std::vector<Keyframe> keyframes_;
+    FlvTagView metadata_;
+    std::vector<FlvTagView> videoSequences_;  // in file order
+    std::vector<FlvTagView> audioSequences_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_FLVREADER_H
@@ -0,0 +1,161 @@
+#include "FlvReplayer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "MediaClock.h"
+#include "../common/AstraLog.h"
+
+namespace astra {
+
+namespace {
+constexpr const char* kTag = "FlvReplayer";
+constexpr uint8_t kTagVideo = 9;
+constexpr uint8_t kTagScript = 18;
+constexpr uint32_t kDefaultFrameGapMs = 33;
+constexpr uint64_t kNoHeader = UINT64_MAX;
+}  // namespace
+
+FlvReplayer::FlvReplayer(TagSink sink) : sink_(std::move(sink)) {}
+
+FlvReplayer::~FlvReplayer() {
+    stop();
+}
+
+bool FlvReplayer::start(const std::string& path, const Options& options) {
+    stop();
+    if (!sink_ || !reader_.open(path)) {
+        return false;
+    }
+    options_ = options;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_ = Stats{};
+    }
+    stopping_ = false;
+    thread_ = std::thread(&FlvReplayer::run, this);
+    return true;
+}
+
+void FlvReplayer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    reader_.close();
+}
+
+void FlvReplayer::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return stats_.finished || stopping_.load(); });
+}
+
+FlvReplayer::Stats FlvReplayer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool FlvReplayer::sleepUntil(int64_t deadlineUs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int64_t waitUs = deadlineUs - MonotonicNowUs();
+    if (waitUs > 0) {
+        cond_.wait_for(lock, std::chrono::microseconds(waitUs), [&] { return stopping_.load(); });
+    }
+    return !stopping_;
+}
+
+void FlvReplayer::run() {
+    const uint32_t startTimestamp = reader_.seek(options_.startMs);
+    // As a live session opens: the file's onMetaData, then the sequence headers in effect at
+    // the start keyframe. Later headers are forwarded where they sit in the file.
+    const FlvTagView& metadata = reader_.metadata();
+    if (metadata.body != nullptr) {
+        sink_(metadata.type, metadata.body, metadata.size, 0);
+    }
+    uint64_t videoHeaderSent = kNoHeader;
+    uint64_t audioHeaderSent = kNoHeader;
+    auto sendHeadersAtCursor = [&](uint32_t timestamp) {
+        const FlvTagView& video = reader_.videoSequenceHeaderAt(reader_.cursor());
+        if (video.body != nullptr && video.offset != videoHeaderSent) {
+            sink_(video.type, video.body, video.size, timestamp);
+            videoHeaderSent = video.offset;
+        }
+        const FlvTagView& audio = reader_.audioSequenceHeaderAt(reader_.cursor());
+        if (audio.body != nullptr && audio.offset != audioHeaderSent) {
+            sink_(audio.type, audio.body, audio.size, timestamp);
+            audioHeaderSent = audio.offset;
+        }
+    };
+    sendHeadersAtCursor(0);
+
+    const int64_t beginUs = MonotonicNowUs();
+    uint32_t loopBase = 0;  // rebased timestamp of this loop's first tag
+    uint32_t lastOut = 0;
+    uint32_t lastVideoIn = startTimestamp;
+    uint32_t frameGap = kDefaultFrameGapMs;
+    uint32_t loops = 0;
+    FlvTagView tag;
+    while (!stopping_) {
+        if (!reader_.next(tag)) {
+            ++loops;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.loops = loops;
+            }
+            if (options_.loops != 0 && loops >= options_.loops) {
+                break;
+            }
+            // Continue one frame after the previous loop so timestamps never step back.
+            loopBase = lastOut + frameGap;
+            reader_.seek(options_.startMs);
+            sendHeadersAtCursor(loopBase);
+            continue;
+        }
+        if (tag.type == kTagScript && tag.offset == metadata.offset) {
+            continue;  // sent up front
+        }
+        if (tag.sequenceHeader) {
+            uint64_t& sent = tag.type == kTagVideo ? videoHeaderSent : audioHeaderSent;
+            if (tag.offset == sent) {
+                continue;  // sent up front
+            }
+            sent = tag.offset;
+        } else if (tag.sequenceEnd) {
+            videoHeaderSent = kNoHeader;  // the next loop has to open with one again
+        }
+        if (tag.type == kTagVideo) {
+            if (tag.timestamp > lastVideoIn) {
+                frameGap = std::min(tag.timestamp - lastVideoIn, 1000u);
+            }
+            lastVideoIn = tag.timestamp;
+        }
+        // Audio muxed just ahead of the opening keyframe clamps to the loop start.
+        const uint32_t timestamp = loopBase + (tag.timestamp > startTimestamp ? tag.timestamp - startTimestamp : 0);
+        lastOut = std::max(lastOut, timestamp);
+        if (options_.speed > 0) {
+            const int64_t dueUs = beginUs + static_cast<int64_t>(timestamp * 1000.0 / options_.speed);
+            if (!sleepUntil(dueUs)) {
+                break;
+            }
+            const int64_t lateUs = MonotonicNowUs() - dueUs;
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.maxLateUs = std::max(stats_.maxLateUs, lateUs);
+        }
+        sink_(tag.type, tag.body, tag.size, timestamp);
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.tags;
+        stats_.bytes += tag.size;
+    }
+    ASTRA_LOGI(kTag, "replay ended loops=%u tags=%llu", loops, static_cast<unsigned long long>(stats().tags));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.finished = true;
+    }
+    cond_.notify_all();
+}
+
+}  // namespace astra
@@ -0,0 +1,67 @@
+#ifndef ASTRASTREAM_FLVREPLAYER_H
+#define ASTRASTREAM_FLVREPLAYER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "FlvReader.h"
+
+namespace astra {
+
+// Plays an FLV recording back tag by tag on its own thread, handing each body unchanged to a
+// sink (normally the sender's enqueue path). Used to reproduce field captures byte for byte
+// and, with a speed above 1 or looping, as a deterministic load generator for the sender.
+class FlvReplayer {
+public:
+    struct Options {
+        double speed = 1.0;  // media time per wall time; 0 sends as fast as the sink accepts
+        uint32_t startMs = 0;  // begins at the keyframe at or before this
+        uint32_t loops = 1;  // 0: until stop()
+    };
+
+    struct Stats {
+        uint64_t tags = 0;
+        uint64_t bytes = 0;
+        uint32_t loops = 0;
+        int64_t maxLateUs = 0;  // worst sink call behind its scheduled time
+        bool finished = false;
+    };
+
+    // |timestamp| is rebased to start at zero and keeps rising across loops.
+    using TagSink = std::function<void(uint8_t tagType, const uint8_t* body, size_t size, uint32_t timestamp)>;
+
+    explicit FlvReplayer(TagSink sink);
+    ~FlvReplayer();
+    FlvReplayer(const FlvReplayer&) = delete;
+    FlvReplayer& operator=(const FlvReplayer&) = delete;
+
+    bool start(const std::string& path, const Options& options);
+    void stop();
+    // Blocks until the last loop has been handed to the sink or stop() is called.
+    void wait();
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    void run();
+    bool sleepUntil(int64_t deadlineUs);
+
+    TagSink sink_;
+    FlvReader reader_;
+    Options options_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    Stats stats_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_FLVREPLAYER_H
@@ -0,0 +1,503 @@
+#include "Fmp4Muxer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace astra {
+
+namespace {
+
+constexpr size_t kBoxHeader = 8;
+constexpr size_t kFullBoxHeader = 12;
+constexpr uint32_t kAacFrameSamples = 1024;
+constexpr int64_t kAudioOnlyFragmentUs = 1000000;
+
+// Sample flags (ISO/IEC 14496-12 8.8.3.1): sync samples depend on nothing, the rest depend on
+// earlier samples and are not sync samples.
+constexpr uint32_t kSyncSampleFlags = 0x02000000;
+constexpr uint32_t kNonSyncSampleFlags = 0x01010000;
+
+constexpr uint32_t kTfhdDefaultBaseIsMoof = 0x020000;
+constexpr uint32_t kTrunDataOffset = 0x000001;
+constexpr uint32_t kTrunSampleDuration = 0x000100;
+constexpr uint32_t kTrunSampleSize = 0x000200;
+constexpr uint32_t kTrunSampleFlags = 0x000400;
+
+constexpr uint32_t kUnityMatrix[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+constexpr uint16_t kLanguageUndetermined = 0x55C4;  // "und"
+
+constexpr char kVideoHandlerName[] = "VideoHandler";
+constexpr char kSoundHandlerName[] = "SoundHandler";
+
+// Fixed-size boxes, header included.
+constexpr size_t kFtypSize = kBoxHeader + 8 + 3 * 4;
+constexpr size_t kMvhdSize = kFullBoxHeader + 96;
+constexpr size_t kTkhdSize = kFullBoxHeader + 80;
+constexpr size_t kMdhdSize = kFullBoxHeader + 20;
+constexpr size_t kHdlrSize = kFullBoxHeader + 20 + sizeof(kVideoHandlerName);
+constexpr size_t kVmhdSize = kFullBoxHeader + 8;
+constexpr size_t kSmhdSize = kFullBoxHeader + 4;
+constexpr size_t kDinfSize = kBoxHeader + kFullBoxHeader + 4 + kFullBoxHeader;
+constexpr size_t kEmptyTableSize = kFullBoxHeader + 4;  // stts, stsc, stco
+constexpr size_t kStszSize = kFullBoxHeader + 8;
+constexpr size_t kVisualSampleEntrySize = kBoxHeader + 78;
+constexpr size_t kAudioSampleEntrySize = kBoxHeader + 28;
+constexpr size_t kTrexSize = kFullBoxHeader + 20;
+constexpr size_t kMfhdSize = kFullBoxHeader + 4;
+constexpr size_t kTfhdSize = kFullBoxHeader + 4;
+constexpr size_t kTfdtSize = kFullBoxHeader + 8;
+constexpr size_t kTrunHeaderSize = kFullBoxHeader + 8;
+constexpr size_t kVideoTrunEntry = 12;  // duration, size, flags
+constexpr size_t kAudioTrunEntry = 8;  // duration, size
+
+static_assert(sizeof(kVideoHandlerName) == sizeof(kSoundHandlerName), "hdlr size is shared");
+
+// Writes big-endian fields front to back into memory sized in advance.
+class BoxWriter {
+public:
+    explicit BoxWriter(uint8_t* out) : out_(out) {}
+
+    void u8(uint32_t value) { out_[position_++] = static_cast<uint8_t>(value); }
+    void u16(uint32_t value) {
+        u8(value >> 8);
+        u8(value);
+    }
+    void u24(uint32_t value) {
+        u8(value >> 16);
+        u16(value);
+    }
+    void u32(uint32_t value) {
+        u16(value >> 16);
+        u16(value);
+    }
+    void u64(uint64_t value) {
+        u32(static_cast<uint32_t>(value >> 32));
+        u32(static_cast<uint32_t>(value));
+    }
+    void bytes(const void* data, size_t size) {
+        std::memcpy(out_ + position_, data, size);
+        position_ += size;
+    }
+    void zeros(size_t count) {
+        std::memset(out_ + position_, 0, count);
+        position_ += count;
+    }
+    void box(size_t size, const char* type) {
+        u32(static_cast<uint32_t>(size));
+        bytes(type, 4);
+    }
+    void fullBox(size_t size, const char* type, uint8_t version, uint32_t flags) {
+        box(size, type);
+        u8(version);
+        u24(flags);
+    }
+    void matrix() {
+        for (uint32_t value : kUnityMatrix) {
+            u32(value);
+        }
+    }
+
+    [[nodiscard]] size_t position() const { return position_; }
+
+private:
+    uint8_t* out_;
+    size_t position_ = 0;
+};
+
+size_t EsdsSize(size_t ascSize) {
+    // ES_Descriptor(3) + DecoderConfigDescriptor(13) + DecoderSpecificInfo + SLConfigDescriptor(1),
+    // each behind a one-byte tag and a one-byte length.
+    return kFullBoxHeader + 2 + 3 + 2 + 13 + 2 + ascSize + 2 + 1;
+}
+
+size_t StblSize(size_t sampleEntrySize) {
+    const size_t stsd = kFullBoxHeader + 4 + sampleEntrySize;
+    return kBoxHeader + stsd + 3 * kEmptyTableSize + kStszSize;
+}
+
+size_t TrakSize(size_t mediaHeaderSize, size_t sampleEntrySize) {
+    const size_t minf = kBoxHeader + mediaHeaderSize + kDinfSize + StblSize(sampleEntrySize);
+    const size_t mdia = kBoxHeader + kMdhdSize + kHdlrSize + minf;
+    return kBoxHeader + kTkhdSize + mdia;
+}
+
+void WriteTkhd(BoxWriter& w, uint32_t trackId, bool audio, uint32_t width, uint32_t height) {
+    w.fullBox(kTkhdSize, "tkhd", 0, 0x000003);  // enabled, in movie
+    w.u32(0);  // creation_time
+    w.u32(0);  // modification_time
+    w.u32(trackId);
+    w.u32(0);
+    w.u32(0);  // duration: fragments carry it
+    w.zeros(8);
+    w.u16(0);  // layer
+    w.u16(0);  // alternate_group
+    w.u16(audio ? 0x0100 : 0);  // volume
+    w.u16(0);
+    w.matrix();
+    w.u32(width << 16);
+    w.u32(height << 16);
+}
+
+void WriteMdhdHdlr(BoxWriter& w, uint32_t timescale, bool audio) {
+    w.fullBox(kMdhdSize, "mdhd", 0, 0);
+    w.u32(0);
+    w.u32(0);
+    w.u32(timescale);
+    w.u32(0);
+    w.u16(kLanguageUndetermined);
+    w.u16(0);
+
+    w.fullBox(kHdlrSize, "hdlr", 0, 0);
+    w.u32(0);
+    w.bytes(audio ? "soun" : "vide", 4);
+    w.zeros(12);
+    w.bytes(audio ? kSoundHandlerName : kVideoHandlerName, sizeof(kVideoHandlerName));
+}
+
+void WriteDinf(BoxWriter& w) {
+    w.box(kDinfSize, "dinf");
+    w.fullBox(kFullBoxHeader + 4 + kFullBoxHeader, "dref", 0, 0);
+    w.u32(1);
+    w.fullBox(kFullBoxHeader, "url ", 0, 0x000001);  // media in the same file
+}
+
+void WriteStblTables(BoxWriter& w) {
+    w.fullBox(kEmptyTableSize, "stts", 0, 0);
+    w.u32(0);
+    w.fullBox(kEmptyTableSize, "stsc", 0, 0);
+    w.u32(0);
+    w.fullBox(kStszSize, "stsz", 0, 0);
+    w.u32(0);
+    w.u32(0);
+    w.fullBox(kEmptyTableSize, "stco", 0, 0);
+    w.u32(0);
+}
+
+}  // namespace
+
+Fmp4Muxer::Fmp4Muxer(const Options& options) : options_(options) {}
+
+void Fmp4Muxer::setVideoTrack(const VideoConfig& config, std::vector<uint8_t> decoderConfigurationRecord) {
+    videoConfig_ = config;
+    decoderConfigurationRecord_ = std::move(decoderConfigurationRecord);
+    hasVideo_ = !decoderConfigurationRecord_.empty();
+    init_.clear();
+    videoSamples_.reserve(256);
+    videoData_.reserve(options_.videoCapacity);
+}
+
+void Fmp4Muxer::setAudioTrack(const AudioConfig& config) {
+    audioConfig_ = config;
+    hasAudio_ = !config.asc.empty() && config.asc.size() < 64 && config.sampleRate > 0;
+    init_.clear();
+    audioSamples_.reserve(256);
+    audioData_.reserve(options_.audioCapacity);
+}
+
+const std::vector<uint8_t>& Fmp4Muxer::initSegment() {
+    if (init_.empty() && (hasVideo_ || hasAudio_)) {
+        buildInitSegment();
+    }
+    return init_;
+}
+
+void Fmp4Muxer::buildInitSegment() {
+    const size_t videoEntry = kVisualSampleEntrySize + kBoxHeader + decoderConfigurationRecord_.size();
+    const size_t audioEntry = kAudioSampleEntrySize + EsdsSize(audioConfig_.asc.size());
+    const size_t videoTrak = hasVideo_ ? TrakSize(kVmhdSize, videoEntry) : 0;
+    const size_t audioTrak = hasAudio_ ? TrakSize(kSmhdSize, audioEntry) : 0;
+    const size_t trackCount = (hasVideo_ ? 1 : 0) + (hasAudio_ ? 1 : 0);
+    const size_t mvex = kBoxHeader + trackCount * kTrexSize;
+    const size_t moov = kBoxHeader + kMvhdSize + videoTrak + audioTrak + mvex;
+
+    init_.resize(kFtypSize + moov);
+    BoxWriter w(init_.data());
+
+    w.box(kFtypSize, "ftyp");
+    w.bytes("iso6", 4);
+    w.u32(0);
+    w.bytes("iso6", 4);
+    w.bytes("cmfc", 4);
+    w.bytes("mp41", 4);
+
+    w.box(moov, "moov");
+    w.fullBox(kMvhdSize, "mvhd", 0, 0);
+    w.u32(0);
+    w.u32(0);
+    w.u32(1000);  // timescale
+    w.u32(0);  // duration: unknown, fragmented
+    w.u32(0x00010000);  // rate 1.0
+    w.u16(0x0100);  // volume 1.0
+    w.zeros(10);
+    w.matrix();
+    w.zeros(24);
+    w.u32(kAudioTrackId + 1);  // next_track_ID
+
+    if (hasVideo_) {
+        const char* sampleEntry = "avc1";
+        const char* configBox = "avcC";
+        if (videoConfig_.codec == VideoCodecId::kH265) {
+            sampleEntry = "hvc1";
+            configBox = "hvcC";
+        } else if (videoConfig_.codec == VideoCodecId::kAv1) {
+            sampleEntry = "av01";
+            configBox = "av1C";
+        }
+        w.box(videoTrak, "trak");
+        WriteTkhd(w, kVideoTrackId, false, videoConfig_.width, videoConfig_.height);
+        w.box(videoTrak - kBoxHeader - kTkhdSize, "mdia");
+        WriteMdhdHdlr(w, kVideoTimescale, false);
+        w.box(kBoxHeader + kVmhdSize + kDinfSize + StblSize(videoEntry), "minf");
+        w.fullBox(kVmhdSize, "vmhd", 0, 0x000001);
+        w.zeros(8);
+        WriteDinf(w);
+        w.box(StblSize(videoEntry), "stbl");
+        w.fullBox(kFullBoxHeader + 4 + videoEntry, "stsd", 0, 0);
+        w.u32(1);
+        w.box(videoEntry, sampleEntry);
+        w.zeros(6);
+        w.u16(1);  // data_reference_index
+        w.zeros(16);
+        w.u16(videoConfig_.width);
+        w.u16(videoConfig_.height);
+        w.u32(0x00480000);  // 72 dpi
+        w.u32(0x00480000);
+        w.u32(0);
+        w.u16(1);  // frame_count
+        w.zeros(32);  // compressorname
+        w.u16(0x0018);  // depth
+        w.u16(0xFFFF);
+        w.box(kBoxHeader + decoderConfigurationRecord_.size(), configBox);
+        w.bytes(decoderConfigurationRecord_.data(), decoderConfigurationRecord_.size());
+        WriteStblTables(w);
+    }
+
+    if (hasAudio_) {
+        const size_t ascSize = audioConfig_.asc.size();
+        w.box(audioTrak, "trak");
+        WriteTkhd(w, kAudioTrackId, true, 0, 0);
+        w.box(audioTrak - kBoxHeader - kTkhdSize, "mdia");
+        WriteMdhdHdlr(w, audioConfig_.sampleRate, true);
+        w.box(kBoxHeader + kSmhdSize + kDinfSize + StblSize(audioEntry), "minf");
+        w.fullBox(kSmhdSize, "smhd", 0, 0);
+        w.zeros(4);
+        WriteDinf(w);
+        w.box(StblSize(audioEntry), "stbl");
+        w.fullBox(kFullBoxHeader + 4 + audioEntry, "stsd", 0, 0);
+        w.u32(1);
+        w.box(audioEntry, "mp4a");
+        w.zeros(6);
+        w.u16(1);
+        w.zeros(8);
+        w.u16(std::max<uint8_t>(audioConfig_.channels, 1));
+        w.u16(16);
+        w.u32(0);
+        w.u32(std::min<uint32_t>(audioConfig_.sampleRate, 0xFFFF) << 16);
+        w.fullBox(EsdsSize(ascSize), "esds", 0, 0);
+        w.u8(0x03);  // ES_Descriptor
+        w.u8(static_cast<uint32_t>(3 + 2 + 13 + 2 + ascSize + 2 + 1));
+        w.u16(kAudioTrackId);
+        w.u8(0);
+        w.u8(0x04);  // DecoderConfigDescriptor
+        w.u8(static_cast<uint32_t>(13 + 2 + ascSize));
+        w.u8(0x40);  // MPEG-4 Audio
+        w.u8(0x15);  // AudioStream, upstream 0, reserved 1
+        w.u24(0);  // bufferSizeDB
+        w.u32(0);  // maxBitrate
+        w.u32(0);  // avgBitrate
+        w.u8(0x05);  // DecoderSpecificInfo
+        w.u8(static_cast<uint32_t>(ascSize));
+        w.bytes(audioConfig_.asc.data(), ascSize);
+        w.u8(0x06);  // SLConfigDescriptor
+        w.u8(1);
+        w.u8(0x02);
+        WriteStblTables(w);
+    }
+
+    w.box(mvex, "mvex");
+    for (uint32_t trackId : {kVideoTrackId, kAudioTrackId}) {
+        if ((trackId == kVideoTrackId && !hasVideo_) || (trackId == kAudioTrackId && !hasAudio_)) {
+            continue;
+        }
+        w.fullBox(kTrexSize, "trex", 0, 0);
+        w.u32(trackId);
+        w.u32(1);  // default_sample_description_index
+        w.u32(trackId == kAudioTrackId ? kAacFrameSamples : 0);
+        w.u32(0);
+        w.u32(trackId == kAudioTrackId ? kSyncSampleFlags : 0);
+    }
+}
+
+uint64_t Fmp4Muxer::videoTicks(int64_t ptsUs) const {
+    const int64_t relativeUs = std::max<int64_t>(ptsUs - epochUs_, 0);
+    return static_cast<uint64_t>(relativeUs) * kVideoTimescale / 1000000;
+}
+
+void Fmp4Muxer::addVideoSample(const ByteSpan* parts, size_t count, int64_t ptsUs, bool keyFrame) {
+    if (!hasVideo_) {
+        return;
+    }
+    if (!started_) {
+        if (!keyFrame) {
+            return;
+        }
+        started_ = true;
+        epochUs_ = ptsUs;
+    }
+    uint64_t ticks = videoTicks(ptsUs);
+    if (!videoSamples_.empty()) {
+        ticks = std::max(ticks, lastVideoTicks_ + 1);
+        // Cut before this sample if keeping it would carry the part past its target, so parts
+        // stay within the advertised duration at a steady frame rate.
+        const uint64_t spanTicks = (ticks - videoBaseTicks_) + (ticks - lastVideoTicks_);
+        const bool partDue = options_.partDurationUs > 0 &&
+                static_cast<int64_t>(spanTicks * 1000000 / kVideoTimescale) > options_.partDurationUs;
+        if (keyFrame || partDue) {
+            emitFragment(ticks);
+        } else {
+            videoSamples_.back().duration = static_cast<uint32_t>(ticks - lastVideoTicks_);
+            lastVideoDuration_ = videoSamples_.back().duration;
+        }
+    }
+    if (videoSamples_.empty()) {
+        videoBaseTicks_ = ticks;
+    }
+    Sample sample;
+    sample.keyFrame = keyFrame;
+    for (size_t i = 0; i < count; ++i) {
+        videoData_.insert(videoData_.end(), parts[i].data, parts[i].data + parts[i].size);
+        sample.size += static_cast<uint32_t>(parts[i].size);
+    }
+    videoSamples_.push_back(sample);
+    lastVideoTicks_ = ticks;
+}
+
+void Fmp4Muxer::addAudioSample(const uint8_t* data, size_t size, int64_t ptsUs) {
+    if (!hasAudio_ || data == nullptr || size == 0) {
+        return;
+    }
+    if (!started_) {
+        if (hasVideo_) {
+            return;  // fragments open on a video keyframe
+        }
+        started_ = true;
+        epochUs_ = ptsUs;
+    }
+    if (ptsUs < epochUs_) {
+        return;
+    }
+    if (!audioAnchored_) {
+        // Later audio advances by whole frames so the track never drifts from its own clock.
+        audioTicks_ = static_cast<uint64_t>(ptsUs - epochUs_) * audioConfig_.sampleRate / 1000000;
+        audioBaseTicks_ = audioTicks_;
+        audioAnchored_ = true;
+    }
+    if (!hasVideo_ && !audioSamples_.empty()) {
+        const int64_t fragmentUs = options_.partDurationUs > 0 ? options_.partDurationUs : kAudioOnlyFragmentUs;
+        if (static_cast<int64_t>((audioTicks_ - audioBaseTicks_) * 1000000 / audioConfig_.sampleRate) >= fragmentUs) {
+            emitFragment(0);
+        }
+    }
+    audioData_.insert(audioData_.end(), data, data + size);
+    audioSamples_.push_back(Sample{static_cast<uint32_t>(size), kAacFrameSamples, true});
+    audioTicks_ += kAacFrameSamples;
+}
+
+void Fmp4Muxer::flush() {
+    if (videoSamples_.empty() && audioSamples_.empty()) {
+        return;
+    }
+    const uint32_t lastDuration = lastVideoDuration_ > 0 ? lastVideoDuration_ : kVideoTimescale / 30;
+    emitFragment(lastVideoTicks_ + lastDuration);
+}
+
+size_t Fmp4Muxer::moofSize() const {
+    size_t size = kBoxHeader + kMfhdSize;
+    if (!videoSamples_.empty()) {
+        size += kBoxHeader + kTfhdSize + kTfdtSize + kTrunHeaderSize + videoSamples_.size() * kVideoTrunEntry;
+    }
+    if (!audioSamples_.empty()) {
+        size += kBoxHeader + kTfhdSize + kTfdtSize + kTrunHeaderSize + audioSamples_.size() * kAudioTrunEntry;
+    }
+    return size;
+}
+
+void Fmp4Muxer::emitFragment(uint64_t videoEndTicks) {
+    if (videoSamples_.empty() && audioSamples_.empty()) {
+        return;
+    }
+    if (!videoSamples_.empty()) {
+        videoSamples_.back().duration = static_cast<uint32_t>(std::max<uint64_t>(videoEndTicks - lastVideoTicks_, 1));
+        lastVideoDuration_ = videoSamples_.back().duration;
+    }
+
+    const size_t moof = moofSize();
+    const size_t mdat = kBoxHeader + videoData_.size() + audioData_.size();
+    header_.resize(moof + kBoxHeader);
+    BoxWriter w(header_.data());
+    ++sequence_;
+
+    w.box(moof, "moof");
+    w.fullBox(kMfhdSize, "mfhd", 0, 0);
+    w.u32(sequence_);
+
+    // data_offset counts from the start of moof; mdat holds the video run, then the audio run.
+    size_t dataOffset = moof + kBoxHeader;
+    auto writeTraf = [&](uint32_t trackId, uint64_t baseTicks, const std::vector<Sample>& samples, bool video) {
+        const size_t entry = video ? kVideoTrunEntry : kAudioTrunEntry;
+        const size_t trun = kTrunHeaderSize + samples.size() * entry;
+        w.box(kBoxHeader + kTfhdSize + kTfdtSize + trun, "traf");
+        w.fullBox(kTfhdSize, "tfhd", 0, kTfhdDefaultBaseIsMoof);
+        w.u32(trackId);
+        w.fullBox(kTfdtSize, "tfdt", 1, 0);
+        w.u64(baseTicks);
+        w.fullBox(trun, "trun", 0,
+                  kTrunDataOffset | kTrunSampleDuration | kTrunSampleSize | (video ? kTrunSampleFlags : 0));
+        w.u32(static_cast<uint32_t>(samples.size()));
+        w.u32(static_cast<uint32_t>(dataOffset));
+        for (const Sample& sample : samples) {
+            w.u32(sample.duration);
+            w.u32(sample.size);
+            if (video) {
+                w.u32(sample.keyFrame ? kSyncSampleFlags : kNonSyncSampleFlags);
+            }
+            dataOffset += sample.size;
+        }
+    };
+    if (!videoSamples_.empty()) {
+        writeTraf(kVideoTrackId, videoBaseTicks_, videoSamples_, true);
+    }
+    if (!audioSamples_.empty()) {
+        writeTraf(kAudioTrackId, audioBaseTicks_, audioSamples_, false);
+    }
+    w.box(mdat, "mdat");
+
+    FragmentInfo info;
+    info.sequence = sequence_;
+    info.bytes = moof + mdat;
+    if (!videoSamples_.empty()) {
+        info.startUs = static_cast<int64_t>(videoBaseTicks_ * 1000000 / kVideoTimescale);
+        info.durationUs = static_cast<int64_t>((videoEndTicks - videoBaseTicks_) * 1000000 / kVideoTimescale);
+        info.independent = videoSamples_.front().keyFrame;
+    } else {
+        info.startUs = static_cast<int64_t>(audioBaseTicks_ * 1000000 / audioConfig_.sampleRate);
+        info.durationUs = static_cast<int64_t>((audioTicks_ - audioBaseTicks_) * 1000000 / audioConfig_.sampleRate);
+        info.independent = true;
+    }
+    if (sink_) {
+        const ByteSpan parts[] = {
+                {header_.data(), header_.size()},
+                {videoData_.data(), videoData_.size()},
+                {audioData_.data(), audioData_.size()},
+        };
+        sink_(parts, 3, info);
+    }
+
+    videoSamples_.clear();
+    videoData_.clear();
+    audioSamples_.clear();
+    audioData_.clear();
+    audioBaseTicks_ = audioTicks_;
+}
+
+}  // namespace astra
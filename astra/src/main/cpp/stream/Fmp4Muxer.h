@@ -0,0 +1,109 @@
+#ifndef ASTRASTREAM_FMP4MUXER_H
+#define ASTRASTREAM_FMP4MUXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "FlvMuxer.h"
+
+namespace astra {
+
+// Streaming fragmented MP4 (CMAF-style) writer. Video samples arrive already length-prefixed
+// (AV1: sized OBUs), as FlvMuxer::parseVideoFrame / sliceVideoFrameInPlace produce them,
+// and the sample entry is built from FlvMuxer::buildDecoderConfigurationRecord, so one
+// parse of the encoder output feeds both containers. The init segment (ftyp + moov) is produced once; after that every
+// fragment is one moof followed by one mdat, cut at each keyframe or, with a part duration,
+// before the sample that would take the pending run past it.
+//
+// Box sizes are computed before anything is written, so each box is written once, front to
+// back, into buffers allocated up front; nothing is patched afterwards. Sample payloads are
+// copied once into staging buffers that the emitted mdat points into.
+class Fmp4Muxer {
+public:
+    static constexpr uint32_t kVideoTrackId = 1;
+    static constexpr uint32_t kAudioTrackId = 2;
+    static constexpr uint32_t kVideoTimescale = 90000;
+
+    struct Options {
+        int64_t partDurationUs = 0;  // 0: one fragment per GOP
+        size_t videoCapacity = 4 << 20;  // staging reserved per fragment
+        size_t audioCapacity = 256 << 10;
+    };
+
+    struct FragmentInfo {
+        uint32_t sequence = 0;  // mfhd sequence number, from 1
+        int64_t startUs = 0;  // decode time of the first sample, from the first keyframe
+        int64_t durationUs = 0;
+        bool independent = false;  // starts with a keyframe
+        size_t bytes = 0;
+    };
+
+    // |parts| are moof + mdat header, then the video and audio payloads; valid during the call.
+    using FragmentSink = std::function<void(const ByteSpan* parts, size_t count, const FragmentInfo& info)>;
+
+    Fmp4Muxer() = default;
+    explicit Fmp4Muxer(const Options& options);
+
+    // Tracks must be set before the init segment is built; later changes need a new muxer.
+    void setVideoTrack(const VideoConfig& config, std::vector<uint8_t> decoderConfigurationRecord);
+    void setAudioTrack(const AudioConfig& config);
+    void setFragmentSink(FragmentSink sink) { sink_ = std::move(sink); }
+
+    [[nodiscard]] bool hasVideo() const { return hasVideo_; }
+    [[nodiscard]] bool hasAudio() const { return hasAudio_; }
+    // ftyp + moov; empty until a track is set.
+    [[nodiscard]] const std::vector<uint8_t>& initSegment();
+
+    // |parts| hold length-prefixed NAL units. Samples before the first keyframe are dropped.
+    void addVideoSample(const ByteSpan* parts, size_t count, int64_t ptsUs, bool keyFrame);
+    // One raw AAC access unit (1024 samples).
+    void addAudioSample(const uint8_t* data, size_t size, int64_t ptsUs);
+    // Emits whatever is pending; the last video sample repeats the previous duration.
+    void flush();
+
+private:
+    struct Sample {
+        uint32_t size = 0;
+        uint32_t duration = 0;
+        bool keyFrame = false;
+    };
+
+    uint64_t videoTicks(int64_t ptsUs) const;
+    void emitFragment(uint64_t videoEndTicks);
+    size_t moofSize() const;
+    void buildInitSegment();
+
+    Options options_;
+    FragmentSink sink_;
+
+    VideoConfig videoConfig_{};
+    AudioConfig audioConfig_{};
+    std::vector<uint8_t> decoderConfigurationRecord_;
+    bool hasVideo_ = false;
+    bool hasAudio_ = false;
+    std::vector<uint8_t> init_;
+
+    bool started_ = false;
+    int64_t epochUs_ = 0;
+    uint32_t sequence_ = 0;
+
+    std::vector<Sample> videoSamples_;
+    std::vector<uint8_t> videoData_;
+    uint64_t videoBaseTicks_ = 0;  // tfdt of the pending video run
+    uint64_t lastVideoTicks_ = 0;  // decode time of the newest pending sample
+    uint32_t lastVideoDuration_ = 0;
+
+    std::vector<Sample> audioSamples_;
+    std::vector<uint8_t> audioData_;
+    uint64_t audioTicks_ = 0;  // decode time of the next audio sample
+    uint64_t audioBaseTicks_ = 0;
+    bool audioAnchored_ = false;
+
+    std::vector<uint8_t> header_;  // moof + mdat header of the fragment being emitted
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_FMP4MUXER_H
@@ -0,0 +1,86 @@
+#include "HlsPlaylist.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+
+namespace astra {
+
+namespace {
+
+void AppendFormat(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+void AppendFormat(std::string& out, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) {
+        out.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+    }
+}
+
+double Seconds(int64_t us) {
+    return static_cast<double>(us) / 1e6;
+}
+
+}  // namespace
+
+std::string RenderLlHlsPlaylist(const std::deque<HlsSegment>& segments, const HlsPlaylistParams& params) {
+    int64_t longestUs = params.targetDurationUs;
+    for (const HlsSegment& segment : segments) {
+        longestUs = std::max(longestUs, segment.durationUs);
+    }
+    const auto targetDuration = static_cast<long long>((longestUs + 999999) / 1000000);
+
+    std::string out;
+    out.reserve(256 + segments.size() * 96 + params.partSegments * 12 * 96);
+    out += "#EXTM3U\n#EXT-X-VERSION:9\n";
+    AppendFormat(out, "#EXT-X-TARGETDURATION:%lld\n", targetDuration);
+    AppendFormat(out, "#EXT-X-PART-INF:PART-TARGET=%.3f\n", Seconds(params.partTargetUs));
+    AppendFormat(out, "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%.3f\n", Seconds(params.partTargetUs * 3));
+    AppendFormat(out, "#EXT-X-MEDIA-SEQUENCE:%" PRIu64 "\n", segments.empty() ? 0 : segments.front().sequence);
+    if (params.discontinuitySequence > 0) {
+        AppendFormat(out, "#EXT-X-DISCONTINUITY-SEQUENCE:%" PRIu64 "\n", params.discontinuitySequence);
+    }
+    const auto initUriOf = [&params](const HlsSegment& segment) -> const std::string& {
+        return segment.initUri.empty() ? params.initUri : segment.initUri;
+    };
+    AppendFormat(out, "#EXT-X-MAP:URI=\"%s\"\n", (segments.empty() ? params.initUri : initUriOf(segments.front())).c_str());
+
+    const size_t firstWithParts = segments.size() > params.partSegments ? segments.size() - params.partSegments : 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const HlsSegment& segment = segments[i];
+        if (segment.discontinuity) {
+            out += "#EXT-X-DISCONTINUITY\n";
+        }
+        if (i > 0 && initUriOf(segment) != initUriOf(segments[i - 1])) {
+            AppendFormat(out, "#EXT-X-MAP:URI=\"%s\"\n", initUriOf(segment).c_str());
+        }
+        if (i >= firstWithParts && !params.ended) {
+            for (const HlsPart& part : segment.parts) {
+                AppendFormat(out, "#EXT-X-PART:DURATION=%.5f,URI=\"%s\",BYTERANGE=\"%" PRIu64 "@%" PRIu64 "\"%s\n",
+                             Seconds(part.durationUs),
+                             segment.uri.c_str(),
+                             part.size,
+                             part.offset,
+                             part.independent ? ",INDEPENDENT=YES" : "");
+            }
+        }
+        if (segment.complete) {
+            AppendFormat(out, "#EXTINF:%.5f,\n%s\n", Seconds(segment.durationUs), segment.uri.c_str());
+        }
+    }
+    if (params.ended) {
+        out += "#EXT-X-ENDLIST\n";
+    } else if (!segments.empty() && !segments.back().complete) {
+        const HlsSegment& open = segments.back();
+        AppendFormat(out, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\",BYTERANGE-START=%" PRIu64 "\n",
+                     open.uri.c_str(), open.bytes);
+    }
+    return out;
+}
+
+}  // namespace astra
@@ -0,0 +1,45 @@
+#ifndef ASTRASTREAM_HLSPLAYLIST_H
+#define ASTRASTREAM_HLSPLAYLIST_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace astra {
+
+// A CMAF part, stored as a byte range of its segment's file.
+struct HlsPart {
+    int64_t durationUs = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    bool independent = false;
+};
+
+struct HlsSegment {
+    uint64_t sequence = 0;
+    std::string uri;
+    int64_t durationUs = 0;
+    uint64_t bytes = 0;
+    std::vector<HlsPart> parts;
+    bool complete = false;
+    std::string initUri;  // empty: HlsPlaylistParams::initUri
+    bool discontinuity = false;  // first segment after an encoder switch
+};
+
+struct HlsPlaylistParams {
+    std::string initUri;
+    uint64_t discontinuitySequence = 0;  // discontinuities that have left the window
+    int64_t targetDurationUs = 2000000;
+    int64_t partTargetUs = 200000;
+    size_t partSegments = 3;  // newest segments that keep their EXT-X-PART lines
+    bool ended = false;
+};
+
+// Low-latency HLS media playlist for |segments| (oldest first, the last one possibly still
+// growing): parts for the newest segments, a preload hint for the next part.
+std::string RenderLlHlsPlaylist(const std::deque<HlsSegment>& segments, const HlsPlaylistParams& params);
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_HLSPLAYLIST_H
@@ -0,0 +1,20 @@
+#ifndef ASTRASTREAM_MEDIACLOCK_H
+#define ASTRASTREAM_MEDIACLOCK_H
+
+#include <time.h>
+
+#include <cstdint>
+
+namespace astra {
+
+// CLOCK_MONOTONIC in microseconds: the epoch shared by surface frame timestamps,
+// AAudio hardware timestamps and the sender's FLV clock.
+inline int64_t MonotonicNowUs() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000LL + now.tv_nsec / 1000;
+}
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_MEDIACLOCK_H
@@ -0,0 +1,451 @@
+#include "SpsParser.h"
+
+#include <algorithm>
+
+#include "BitReader.h"
+
+namespace astra {
+
+namespace {
+
+constexpr uint8_t kExtendedSar = 255;
+
+// SubWidthC / SubHeightC for chroma_format_idc 0..3 (monochrome crops in luma samples).
+constexpr uint32_t kSubWidthC[] = {1, 2, 2, 1};
+constexpr uint32_t kSubHeightC[] = {1, 2, 1, 1};
+
+bool HasChromaFormatFields(uint8_t profileIdc) {
+    switch (profileIdc) {
+        case 100: case 110: case 122: case 244: case 44: case 83:
+        case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void SkipH264ScalingList(BitReader& reader, int size) {
+    int32_t lastScale = 8;
+    int32_t nextScale = 8;
+    for (int j = 0; j < size; ++j) {
+        if (nextScale != 0) {
+            nextScale = (lastScale + reader.readSE() + 256) % 256;
+        }
+        lastScale = nextScale == 0 ? lastScale : nextScale;
+    }
+}
+
+// Fields shared by the H.264 and HEVC VUI up to chroma_loc_info.
+void SkipVuiVideoFields(BitReader& reader) {
+    if (reader.readBit()) {  // aspect_ratio_info_present_flag
+        if (reader.readBits(8) == kExtendedSar) {
+            reader.readBits(16);  // sar_width
+            reader.readBits(16);  // sar_height
+        }
+    }
+    if (reader.readBit()) {  // overscan_info_present_flag
+        reader.readBit();
+    }
+    if (reader.readBit()) {  // video_signal_type_present_flag
+        reader.readBits(4);  // video_format, video_full_range_flag
+        if (reader.readBit()) {  // colour_description_present_flag
+            reader.readBits(24);
+        }
+    }
+    if (reader.readBit()) {  // chroma_loc_info_present_flag
+        reader.readUE();
+        reader.readUE();
+    }
+}
+
+void ReadTiming(BitReader& reader, SpsInfo& info) {
+    info.numUnitsInTick = reader.readBits(32);
+    info.timeScale = reader.readBits(32);
+    info.timingInfoPresent = info.numUnitsInTick != 0 && info.timeScale != 0;
+}
+
+void SkipHevcProfileTierLevel(BitReader& reader, uint32_t maxSubLayersMinus1, SpsInfo& info) {
+    info.profileSpace = static_cast<uint8_t>(reader.readBits(2));
+    info.tierFlag = static_cast<uint8_t>(reader.readBit());
+    info.profileIdc = static_cast<uint8_t>(reader.readBits(5));
+    info.profileCompatibilityFlags = reader.readBits(32);
+    info.constraintIndicatorFlags = static_cast<uint64_t>(reader.readBits(16)) << 32;
+    info.constraintIndicatorFlags |= reader.readBits(32);
+    info.levelIdc = static_cast<uint8_t>(reader.readBits(8));
+
+    bool subLayerProfilePresent[8] = {};
+    bool subLayerLevelPresent[8] = {};
+    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
+        subLayerProfilePresent[i] = reader.readBit() == 1U;
+        subLayerLevelPresent[i] = reader.readBit() == 1U;
+    }
+    if (maxSubLayersMinus1 > 0) {
+        reader.skipBits(2 * (8 - maxSubLayersMinus1));  // reserved_zero_2bits
+    }
+    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
+        if (subLayerProfilePresent[i]) {
+            reader.skipBits(2 + 1 + 5 + 32 + 48);
+        }
+        if (subLayerLevelPresent[i]) {
+            reader.readBits(8);
+        }
+    }
+}
+
+void SkipHevcScalingListData(BitReader& reader) {
+    for (uint32_t sizeId = 0; sizeId < 4; ++sizeId) {
+        for (uint32_t matrixId = 0; matrixId < 6; matrixId += sizeId == 3 ? 3 : 1) {
+            if (!reader.readBit()) {  // scaling_list_pred_mode_flag
+                reader.readUE();  // scaling_list_pred_matrix_id_delta
+                continue;
+            }
+            const uint32_t coefficients = std::min<uint32_t>(64, 1U << (4 + (sizeId << 1)));
+            if (sizeId > 1) {
+                reader.readSE();  // scaling_list_dc_coef_minus8
+            }
+            for (uint32_t i = 0; i < coefficients; ++i) {
+                reader.readSE();
+            }
+        }
+    }
+}
+
+// st_ref_pic_set() as it appears in the SPS; returns NumDeltaPocs of the set, which a later
+// set predicted from it needs.
+uint32_t SkipHevcShortTermRefPicSet(BitReader& reader, uint32_t index, const uint32_t* numDeltaPocs) {
+    if (index != 0 && reader.readBit()) {  // inter_ref_pic_set_prediction_flag
+        reader.readBit();  // delta_rps_sign
+        reader.readUE();  // abs_delta_rps_minus1
+        const uint32_t reference = numDeltaPocs[index - 1];  // delta_idx_minus1 is 0 in the SPS
+        uint32_t count = 0;
+        for (uint32_t j = 0; j <= reference; ++j) {
+            const bool used = reader.readBit() == 1U;  // used_by_curr_pic_flag
+            if (used || reader.readBit()) {  // use_delta_flag
+                ++count;
+            }
+        }
+        return count;
+    }
+    const uint32_t negative = reader.readUE();
+    const uint32_t positive = reader.readUE();
+    if (negative > 16 || positive > 16) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < negative + positive; ++i) {
+        reader.readUE();  // delta_poc_s*_minus1
+        reader.readBit();  // used_by_curr_pic_s*_flag
+    }
+    return negative + positive;
+}
+
+}  // namespace
+
+double SpsInfo::frameRate() const {
+    return timingInfoPresent ? static_cast<double>(timeScale) / numUnitsInTick : 0.0;
+}
+
+bool ParseH264Sps(const uint8_t* nal, size_t size, SpsInfo& info) {
+    if (nal == nullptr || size < 4) {
+        return false;
+    }
+    BitReader reader(nal + 1, size - 1, true);
+    info = SpsInfo{};
+    info.profileIdc = static_cast<uint8_t>(reader.readBits(8));
+    info.constraintFlags = static_cast<uint8_t>(reader.readBits(8));
+    info.levelIdc = static_cast<uint8_t>(reader.readBits(8));
+    reader.readUE();  // seq_parameter_set_id
+
+    bool separateColourPlane = false;
+    if (HasChromaFormatFields(info.profileIdc)) {
+        info.chromaFormatIdc = static_cast<uint8_t>(std::min<uint32_t>(reader.readUE(), 3));
+        if (info.chromaFormatIdc == 3) {
+            separateColourPlane = reader.readBit() == 1U;
+        }
+        info.bitDepthLuma = static_cast<uint8_t>(8 + std::min<uint32_t>(reader.readUE(), 6));
+        info.bitDepthChroma = static_cast<uint8_t>(8 + std::min<uint32_t>(reader.readUE(), 6));
+        reader.readBit();  // qpprime_y_zero_transform_bypass_flag
+        if (reader.readBit()) {  // seq_scaling_matrix_present_flag
+            const int lists = info.chromaFormatIdc != 3 ? 8 : 12;
+            for (int i = 0; i < lists; ++i) {
+                if (reader.readBit()) {
+                    SkipH264ScalingList(reader, i < 6 ? 16 : 64);
+                }
+            }
+        }
+    }
+
+    reader.readUE();  // log2_max_frame_num_minus4
+    const uint32_t pocType = reader.readUE();
+    if (pocType == 0) {
+        reader.readUE();  // log2_max_pic_order_cnt_lsb_minus4
+    } else if (pocType == 1) {
+        reader.readBit();  // delta_pic_order_always_zero_flag
+        reader.readSE();  // offset_for_non_ref_pic
+        reader.readSE();  // offset_for_top_to_bottom_field
+        const uint32_t cycle = reader.readUE();
+        if (cycle > 255) {
+            return false;
+        }
+        for (uint32_t i = 0; i < cycle; ++i) {
+            reader.readSE();
+        }
+    }
+    reader.readUE();  // max_num_ref_frames
+    reader.readBit();  // gaps_in_frame_num_value_allowed_flag
+    const uint32_t widthInMbs = reader.readUE() + 1;
+    const uint32_t heightInMapUnits = reader.readUE() + 1;
+    const uint32_t frameMbsOnly = reader.readBit();
+    if (!frameMbsOnly) {
+        reader.readBit();  // mb_adaptive_frame_field_flag
+    }
+    reader.readBit();  // direct_8x8_inference_flag
+
+    info.codedWidth = widthInMbs * 16;
+    info.codedHeight = (2 - frameMbsOnly) * heightInMapUnits * 16;
+    info.width = info.codedWidth;
+    info.height = info.codedHeight;
+    if (reader.readBit()) {  // frame_cropping_flag
+        const uint32_t left = reader.readUE();
+        const uint32_t right = reader.readUE();
+        const uint32_t top = reader.readUE();
+        const uint32_t bottom = reader.readUE();
+        const uint8_t chroma = separateColourPlane ? 0 : info.chromaFormatIdc;
+        const uint32_t cropX = kSubWidthC[chroma];
+        const uint32_t cropY = kSubHeightC[chroma] * (2 - frameMbsOnly);
+        const uint64_t cropWidth = static_cast<uint64_t>(cropX) * (left + right);
+        const uint64_t cropHeight = static_cast<uint64_t>(cropY) * (top + bottom);
+        if (cropWidth >= info.codedWidth || cropHeight >= info.codedHeight) {
+            return false;
+        }
+        info.width = info.codedWidth - static_cast<uint32_t>(cropWidth);
+        info.height = info.codedHeight - static_cast<uint32_t>(cropHeight);
+    }
+
+    if (reader.readBit()) {  // vui_parameters_present_flag
+        SkipVuiVideoFields(reader);
+        if (reader.readBit()) {  // timing_info_present_flag
+            ReadTiming(reader, info);
+            // H.264 ticks count fields: two per frame.
+            info.numUnitsInTick *= 2;
+        }
+    }
+    return !reader.failed();
+}
+
+bool ParseHevcSps(const uint8_t* nal, size_t size, SpsInfo& info) {
+    if (nal == nullptr || size < 4) {
+        return false;
+    }
+    BitReader reader(nal + 2, size - 2, true);
+    info = SpsInfo{};
+    reader.readBits(4);  // sps_video_parameter_set_id
+    const uint32_t maxSubLayersMinus1 = reader.readBits(3);
+    info.maxSubLayers = static_cast<uint8_t>(maxSubLayersMinus1 + 1);
+    info.temporalIdNested = reader.readBit() == 1U;
+    SkipHevcProfileTierLevel(reader, maxSubLayersMinus1, info);
+
+    reader.readUE();  // sps_seq_parameter_set_id
+    info.chromaFormatIdc = static_cast<uint8_t>(std::min<uint32_t>(reader.readUE(), 3));
+    bool separateColourPlane = false;
+    if (info.chromaFormatIdc == 3) {
+        separateColourPlane = reader.readBit() == 1U;
+    }
+    info.codedWidth = reader.readUE();
+    info.codedHeight = reader.readUE();
+    info.width = info.codedWidth;
+    info.height = info.codedHeight;
+    if (reader.readBit()) {  // conformance_window_flag
+        const uint8_t chroma = separateColourPlane ? 0 : info.chromaFormatIdc;
+        const uint64_t cropWidth = static_cast<uint64_t>(kSubWidthC[chroma]) * (reader.readUE() + reader.readUE());
+        const uint64_t cropHeight = static_cast<uint64_t>(kSubHeightC[chroma]) * (reader.readUE() + reader.readUE());
+        if (cropWidth >= info.codedWidth || cropHeight >= info.codedHeight) {
+            return false;
+        }
+        info.width = info.codedWidth - static_cast<uint32_t>(cropWidth);
+        info.height = info.codedHeight - static_cast<uint32_t>(cropHeight);
+    }
+    info.bitDepthLuma = static_cast<uint8_t>(8 + std::min<uint32_t>(reader.readUE(), 8));
+    info.bitDepthChroma = static_cast<uint8_t>(8 + std::min<uint32_t>(reader.readUE(), 8));
+    const uint32_t log2MaxPocLsb = reader.readUE() + 4;
+    const bool subLayerOrderingInfo = reader.readBit() == 1U;
+    for (uint32_t i = subLayerOrderingInfo ? 0 : maxSubLayersMinus1; i <= maxSubLayersMinus1; ++i) {
+        reader.readUE();  // sps_max_dec_pic_buffering_minus1
+        reader.readUE();  // sps_max_num_reorder_pics
+        reader.readUE();  // sps_max_latency_increase_plus1
+    }
+    reader.readUE();  // log2_min_luma_coding_block_size_minus3
+    reader.readUE();  // log2_diff_max_min_luma_coding_block_size
+    reader.readUE();  // log2_min_luma_transform_block_size_minus2
+    reader.readUE();  // log2_diff_max_min_luma_transform_block_size
+    reader.readUE();  // max_transform_hierarchy_depth_inter
+    reader.readUE();  // max_transform_hierarchy_depth_intra
+    if (reader.readBit() && reader.readBit()) {  // scaling_list_enabled, sps_scaling_list_data_present
+        SkipHevcScalingListData(reader);
+    }
+    reader.readBit();  // amp_enabled_flag
+    reader.readBit();  // sample_adaptive_offset_enabled_flag
+    if (reader.readBit()) {  // pcm_enabled_flag
+        reader.readBits(8);  // pcm bit depths
+        reader.readUE();
+        reader.readUE();
+        reader.readBit();
+    }
+    const uint32_t shortTermSets = reader.readUE();
+    if (shortTermSets > 64) {
+        return false;
+    }
+    uint32_t numDeltaPocs[64] = {};
+    for (uint32_t i = 0; i < shortTermSets; ++i) {
+        numDeltaPocs[i] = SkipHevcShortTermRefPicSet(reader, i, numDeltaPocs);
+    }
+    if (reader.readBit()) {  // long_term_ref_pics_present_flag
+        const uint32_t longTermPics = reader.readUE();
+        if (longTermPics > 32) {
+            return false;
+        }
+        for (uint32_t i = 0; i < longTermPics; ++i) {
+            reader.skipBits(log2MaxPocLsb + 1);  // lt_ref_pic_poc_lsb_sps, used_by_curr_pic_lt_sps_flag
+        }
+    }
+    reader.readBit();  // sps_temporal_mvp_enabled_flag
+    reader.readBit();  // strong_intra_smoothing_enabled_flag
+
+    if (reader.readBit()) {  // vui_parameters_present_flag
+        SkipVuiVideoFields(reader);
+        reader.readBits(3);  // neutral_chroma, field_seq, frame_field_info_present
+        if (reader.readBit()) {  // default_display_window_flag
+            for (int i = 0; i < 4; ++i) {
+                reader.readUE();
+            }
+        }
+        if (reader.readBit()) {  // vui_timing_info_present_flag
+            ReadTiming(reader, info);
+        }
+    }
+    return !reader.failed();
+}
+
+bool ParseAv1SequenceHeader(const uint8_t* payload, size_t size, SpsInfo& info) {
+    if (payload == nullptr || size == 0) {
+        return false;
+    }
+    BitReader reader(payload, size);
+    info = SpsInfo{};
+    info.profileIdc = static_cast<uint8_t>(reader.readBits(3));
+    reader.readBit();  // still_picture
+    const bool reducedStillPictureHeader = reader.readBit() == 1U;
+    if (reducedStillPictureHeader) {
+        info.levelIdc = static_cast<uint8_t>(reader.readBits(5));
+    } else {
+        bool decoderModelInfoPresent = false;
+        uint32_t bufferDelayLength = 0;
+        if (reader.readBit()) {  // timing_info_present_flag
+            ReadTiming(reader, info);
+            if (reader.readBit()) {  // equal_picture_interval
+                reader.readUE();  // num_ticks_per_picture_minus_1, uvlc()
+            }
+            decoderModelInfoPresent = reader.readBit() == 1U;
+            if (decoderModelInfoPresent) {
+                bufferDelayLength = reader.readBits(5) + 1;
+                reader.readBits(32);  // num_units_in_decoding_tick
+                reader.readBits(10);  // buffer_removal_time / frame_presentation_time lengths
+            }
+        }
+        const bool initialDisplayDelayPresent = reader.readBit() == 1U;
+        const uint32_t operatingPoints = reader.readBits(5) + 1;
+        for (uint32_t i = 0; i < operatingPoints; ++i) {
+            reader.readBits(12);  // operating_point_idc
+            const uint32_t level = reader.readBits(5);
+            const uint32_t tier = level > 7 ? reader.readBit() : 0U;
+            if (decoderModelInfoPresent && reader.readBit()) {
+                reader.skipBits(2 * bufferDelayLength + 1);  // decoder/encoder_buffer_delay, low_delay_mode_flag
+            }
+            if (initialDisplayDelayPresent && reader.readBit()) {
+                reader.readBits(4);
+            }
+            if (i == 0) {
+                info.levelIdc = static_cast<uint8_t>(level);
+                info.tierFlag = static_cast<uint8_t>(tier);
+            }
+        }
+    }
+    const uint32_t widthBits = reader.readBits(4) + 1;
+    const uint32_t heightBits = reader.readBits(4) + 1;
+    info.codedWidth = reader.readBits(widthBits) + 1;  // max_frame_width_minus_1
+    info.codedHeight = reader.readBits(heightBits) + 1;
+    info.width = info.codedWidth;
+    info.height = info.codedHeight;
+    if (!reducedStillPictureHeader && reader.readBit()) {  // frame_id_numbers_present_flag
+        reader.readBits(7);
+    }
+    reader.readBits(3);  // use_128x128_superblock, enable_filter_intra, enable_intra_edge_filter
+    if (!reducedStillPictureHeader) {
+        reader.readBits(4);  // interintra, masked compound, warped motion, dual filter
+        const bool enableOrderHint = reader.readBit() == 1U;
+        if (enableOrderHint) {
+            reader.readBits(2);  // enable_jnt_comp, enable_ref_frame_mvs
+        }
+        const uint32_t forceScreenContentTools = reader.readBit() ? 2U : reader.readBit();
+        if (forceScreenContentTools > 0 && reader.readBit() == 0U) {  // seq_choose_integer_mv
+            reader.readBit();
+        }
+        if (enableOrderHint) {
+            reader.readBits(3);  // order_hint_bits_minus_1
+        }
+    }
+    reader.readBits(3);  // enable_superres, enable_cdef, enable_restoration
+
+    // color_config()
+    const bool highBitdepth = reader.readBit() == 1U;
+    const bool twelveBit = info.profileIdc == 2 && highBitdepth && reader.readBit() == 1U;
+    info.bitDepthLuma = static_cast<uint8_t>(twelveBit ? 12 : highBitdepth ? 10 : 8);
+    info.bitDepthChroma = info.bitDepthLuma;
+    const bool monochrome = info.profileIdc != 1 && reader.readBit() == 1U;
+    uint32_t colorPrimaries = 2;  // unspecified
+    uint32_t transferCharacteristics = 2;
+    uint32_t matrixCoefficients = 2;
+    if (reader.readBit()) {  // color_description_present_flag
+        colorPrimaries = reader.readBits(8);
+        transferCharacteristics = reader.readBits(8);
+        matrixCoefficients = reader.readBits(8);
+    }
+    uint32_t subsamplingX = 1;
+    uint32_t subsamplingY = 1;
+    if (monochrome) {
+        reader.readBit();  // color_range
+    } else if (colorPrimaries == 1 && transferCharacteristics == 13 && matrixCoefficients == 0) {
+        subsamplingX = 0;  // sRGB: 4:4:4
+        subsamplingY = 0;
+    } else {
+        reader.readBit();  // color_range
+        if (info.profileIdc == 1) {
+            subsamplingX = 0;
+            subsamplingY = 0;
+        } else if (info.profileIdc == 2) {
+            subsamplingY = 0;
+            if (twelveBit) {
+                subsamplingX = reader.readBit();
+                subsamplingY = subsamplingX ? reader.readBit() : 0U;
+            }
+        }
+        if (subsamplingX && subsamplingY) {
+            info.chromaSamplePosition = static_cast<uint8_t>(reader.readBits(2));
+        }
+    }
+    if (monochrome) {
+        info.chromaFormatIdc = 0;
+    } else {
+        info.chromaFormatIdc = subsamplingX ? (subsamplingY ? 1 : 2) : 3;
+    }
+    return !reader.failed();
+}
+
+uint64_t ParameterSetHash(const uint8_t* data, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+}  // namespace astra
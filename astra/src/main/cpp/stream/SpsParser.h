@@ -0,0 +1,52 @@
+#ifndef ASTRASTREAM_SPSPARSER_H
+#define ASTRASTREAM_SPSPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace astra {
+
+// What a sequence-level header says about the stream, as opposed to what the encoder was
+// asked for: MediaCodec aligns dimensions, picks its own profile and level and may signal a
+// frame rate. Filled from an H.264 or HEVC SPS NAL unit or an AV1 sequence header OBU.
+struct SpsInfo {
+    uint32_t width = 0;  // display size, cropping applied
+    uint32_t height = 0;
+    uint32_t codedWidth = 0;
+    uint32_t codedHeight = 0;
+    uint8_t chromaFormatIdc = 1;  // 0 monochrome, 1 4:2:0, 2 4:2:2, 3 4:4:4
+    uint8_t bitDepthLuma = 8;
+    uint8_t bitDepthChroma = 8;
+
+    // H.264 profile_idc / constraint_set flags / level_idc; HEVC general_*; AV1 seq_profile,
+    // seq_level_idx[0] and seq_tier[0].
+    uint8_t profileIdc = 0;
+    uint8_t constraintFlags = 0;
+    uint8_t levelIdc = 0;
+    uint8_t tierFlag = 0;
+    uint8_t profileSpace = 0;  // HEVC
+    uint32_t profileCompatibilityFlags = 0;  // HEVC
+    uint64_t constraintIndicatorFlags = 0;  // HEVC, 48 bits
+    uint8_t maxSubLayers = 1;  // HEVC sps_max_sub_layers_minus1 + 1
+    bool temporalIdNested = false;  // HEVC
+    uint8_t chromaSamplePosition = 0;  // AV1
+
+    // VUI / timing_info; frameRate() is 0 when the stream does not signal it.
+    bool timingInfoPresent = false;
+    uint32_t numUnitsInTick = 0;
+    uint32_t timeScale = 0;
+    double frameRate() const;
+};
+
+// |nal| starts at the NAL unit header; emulation prevention bytes are handled.
+bool ParseH264Sps(const uint8_t* nal, size_t size, SpsInfo& info);
+bool ParseHevcSps(const uint8_t* nal, size_t size, SpsInfo& info);
+// |payload| is the sequence header OBU payload, past the OBU header and size.
+bool ParseAv1SequenceHeader(const uint8_t* payload, size_t size, SpsInfo& info);
+
+// FNV-1a over a parameter set: the cache key for its parse.
+uint64_t ParameterSetHash(const uint8_t* data, size_t size);
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_SPSPARSER_H
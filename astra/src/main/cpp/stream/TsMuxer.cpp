@@ -0,0 +1,479 @@
+#include "TsMuxer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace astra {
+
+namespace {
+
+constexpr size_t kPacketSize = TsDatagram::kPacketSize;
+constexpr size_t kPacketPayload = kPacketSize - 4;
+constexpr uint8_t kSyncByte = 0x47;
+constexpr uint16_t kPatPid = 0x0000;
+constexpr uint16_t kProgramNumber = 1;
+constexpr uint16_t kTransportStreamId = 1;
+
+constexpr uint8_t kStreamTypeAdtsAac = 0x0F;
+constexpr uint8_t kStreamTypeH264 = 0x1B;
+constexpr uint8_t kStreamTypeHevc = 0x24;
+constexpr uint8_t kVideoStreamId = 0xE0;
+constexpr uint8_t kAudioStreamId = 0xC0;
+
+constexpr uint8_t kAdaptationRandomAccess = 0x40;
+constexpr uint8_t kAdaptationPcr = 0x10;
+constexpr size_t kPcrSize = 6;
+constexpr size_t kPesHeaderSize = 14;  // start code, id, length, flags, PTS
+constexpr size_t kAdtsHeaderSize = 7;
+
+// PTS starts this far ahead of the PCR so decoders can buffer before presenting.
+constexpr int64_t kPtsOffsetTicks = 63000;  // 700 ms at 90 kHz
+constexpr uint64_t kTimestampMask = (uint64_t{1} << 33) - 1;
+
+constexpr uint8_t kStartCode[4] = {0x00, 0x00, 0x00, 0x01};
+constexpr uint8_t kH264Aud[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0};
+constexpr uint8_t kHevcAud[] = {0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50};
+
+// CRC-32/MPEG-2 as used by PSI sections: polynomial 0x04C11DB7, no reflection.
+uint32_t Crc32Mpeg(const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+            }
+            entries[i] = crc;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+void WriteTimestamp(uint8_t* out, uint8_t prefix, uint64_t ticks) {
+    out[0] = static_cast<uint8_t>((prefix << 4) | ((ticks >> 29) & 0x0E) | 0x01);
+    out[1] = static_cast<uint8_t>(ticks >> 22);
+    out[2] = static_cast<uint8_t>(((ticks >> 14) & 0xFE) | 0x01);
+    out[3] = static_cast<uint8_t>(ticks >> 7);
+    out[4] = static_cast<uint8_t>(((ticks << 1) & 0xFE) | 0x01);
+}
+
+void WritePcr(uint8_t* out, uint64_t base) {
+    out[0] = static_cast<uint8_t>(base >> 25);
+    out[1] = static_cast<uint8_t>(base >> 17);
+    out[2] = static_cast<uint8_t>(base >> 9);
+    out[3] = static_cast<uint8_t>(base >> 1);
+    out[4] = static_cast<uint8_t>(((base & 0x01) << 7) | 0x7E);  // reserved bits, extension 0
+    out[5] = 0x00;
+}
+
+size_t WritePesHeader(uint8_t* out, uint8_t streamId, size_t payloadSize, uint64_t pts) {
+    out[0] = 0x00;
+    out[1] = 0x00;
+    out[2] = 0x01;
+    out[3] = streamId;
+    // Video PES may leave the length open; audio always fits.
+    const size_t length = payloadSize + kPesHeaderSize - 6;
+    const size_t field = (streamId == kVideoStreamId && length > 0xFFFF) ? 0 : length;
+    out[4] = static_cast<uint8_t>(field >> 8);
+    out[5] = static_cast<uint8_t>(field);
+    out[6] = 0x80;  // '10', not scrambled
+    out[7] = 0x80;  // PTS only: encoder output carries no B-frames
+    out[8] = 5;
+    WriteTimestamp(out + 9, 0x2, pts);
+    return kPesHeaderSize;
+}
+
+uint16_t ReadU16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+// Appends the NAL units of one avcC / hvcC array as Annex-B.
+bool AppendParameterSets(const std::vector<uint8_t>& record, size_t& offset, size_t count,
+                         std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < count; ++i) {
+        if (offset + 2 > record.size()) {
+            return false;
+        }
+        const size_t length = ReadU16(record.data() + offset);
+        offset += 2;
+        if (offset + length > record.size()) {
+            return false;
+        }
+        out.insert(out.end(), std::begin(kStartCode), std::end(kStartCode));
+        out.insert(out.end(), record.begin() + static_cast<ptrdiff_t>(offset),
+                   record.begin() + static_cast<ptrdiff_t>(offset + length));
+        offset += length;
+    }
+    return true;
+}
+
+bool ParameterSetsFromRecord(VideoCodecId codec, const std::vector<uint8_t>& record, std::vector<uint8_t>& out) {
+    if (codec == VideoCodecId::kH265) {
+        if (record.size() < 23) {
+            return false;
+        }
+        size_t offset = 23;
+        for (size_t array = 0; array < record[22]; ++array) {
+            if (offset + 3 > record.size()) {
+                return false;
+            }
+            const size_t count = ReadU16(record.data() + offset + 1);
+            offset += 3;
+            if (!AppendParameterSets(record, offset, count, out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (record.size() < 7) {
+        return false;
+    }
+    size_t offset = 6;
+    if (!AppendParameterSets(record, offset, record[5] & 0x1F, out) || offset >= record.size()) {
+        return false;
+    }
+    const size_t ppsCount = record[offset++];
+    return AppendParameterSets(record, offset, ppsCount, out);
+}
+
+}  // namespace
+
+void TsDatagramRecycler::operator()(TsDatagram* datagram) const {
+    if (const auto owner = pool.lock()) {
+        owner->recycle(datagram);
+    } else {
+        delete datagram;
+    }
+}
+
+std::shared_ptr<TsDatagramPool> TsDatagramPool::create(size_t maxPooled) {
+    return std::shared_ptr<TsDatagramPool>(new TsDatagramPool(maxPooled));
+}
+
+TsDatagramPtr TsDatagramPool::acquire() {
+    std::unique_ptr<TsDatagram> datagram;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            datagram = std::move(free_.back());
+            free_.pop_back();
+        } else {
+            ++allocations_;
+        }
+    }
+    if (!datagram) {
+        datagram = std::make_unique<TsDatagram>();
+    }
+    datagram->size = 0;
+    datagram->ptsUs = 0;
+    datagram->keyFrame = false;
+    return TsDatagramPtr(datagram.release(), TsDatagramRecycler{weak_from_this()});
+}
+
+uint64_t TsDatagramPool::allocations() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_;
+}
+
+void TsDatagramPool::recycle(TsDatagram* datagram) {
+    std::unique_ptr<TsDatagram> owned(datagram);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < maxPooled_) {
+        free_.push_back(std::move(owned));
+    }
+}
+
+TsMuxer::TsMuxer(std::shared_ptr<TsDatagramPool> pool) : pool_(std::move(pool)) {}
+
+bool TsMuxer::setVideoTrack(const VideoConfig& config, const std::vector<uint8_t>& decoderConfigurationRecord) {
+    if (config.codec == VideoCodecId::kAv1) {
+        return false;  // no AV1 stream_type in ISO/IEC 13818-1
+    }
+    std::vector<uint8_t> prefix;
+    if (config.codec == VideoCodecId::kH265) {
+        prefix.assign(std::begin(kHevcAud), std::end(kHevcAud));
+    } else {
+        prefix.assign(std::begin(kH264Aud), std::end(kH264Aud));
+    }
+    const size_t audSize = prefix.size();
+    if (!ParameterSetsFromRecord(config.codec, decoderConfigurationRecord, prefix)) {
+        return false;
+    }
+    videoConfig_ = config;
+    keyFramePrefix_ = std::move(prefix);
+    audPrefixSize_ = audSize;
+    hasVideo_ = true;
+    return true;
+}
+
+bool TsMuxer::setAudioTrack(const AudioConfig& config) {
+    if (config.asc.size() < 2) {
+        return false;
+    }
+    const uint8_t objectType = config.asc[0] >> 3;
+    const uint8_t frequencyIndex = static_cast<uint8_t>(((config.asc[0] & 0x07) << 1) | (config.asc[1] >> 7));
+    const uint8_t channels = (config.asc[1] >> 3) & 0x0F;
+    if (objectType == 0 || objectType > 4) {
+        return false;  // ADTS carries only the four MPEG-2 profiles
+    }
+    // Length fields (bytes 3-5) are filled per frame.
+    adtsHeader_ = {0xFF, 0xF1,
+                   static_cast<uint8_t>(((objectType - 1) << 6) | (frequencyIndex << 2) | (channels >> 2)),
+                   static_cast<uint8_t>((channels & 0x03) << 6), 0x00, 0x1F, 0xFC};
+    hasAudio_ = true;
+    return true;
+}
+
+void TsMuxer::addVideoSample(const ByteSpan* parts, size_t count, int64_t ptsUs, bool keyFrame) {
+    if (!hasVideo_ || (!started_ && !keyFrame)) {
+        return;
+    }
+    beginStream(ptsUs);
+    spans_.clear();
+    spans_.push_back(ByteSpan{keyFramePrefix_.data(), keyFrame ? keyFramePrefix_.size() : audPrefixSize_});
+    size_t payloadSize = spans_.back().size;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* data = parts[i].data;
+        size_t remaining = parts[i].size;
+        while (remaining > 4) {
+            const size_t length = (static_cast<size_t>(data[0]) << 24) | (static_cast<size_t>(data[1]) << 16) |
+                                  (static_cast<size_t>(data[2]) << 8) | data[3];
+            if (length == 0 || length > remaining - 4) {
+                break;
+            }
+            // The length prefix and the start code are the same size.
+            spans_.push_back(ByteSpan{kStartCode, sizeof(kStartCode)});
+            spans_.push_back(ByteSpan{data + 4, length});
+            payloadSize += 4 + length;
+            data += 4 + length;
+            remaining -= 4 + length;
+        }
+    }
+
+    if (keyFrame) {
+        writeTables();
+        lastTablesUs_ = ptsUs;
+    }
+    uint8_t header[kPesHeaderSize];
+    const uint64_t pts = ticks(ptsUs);
+    PesUnit unit;
+    unit.pid = kVideoPid;
+    unit.continuity = &videoContinuity_;
+    unit.header = header;
+    unit.headerSize = WritePesHeader(header, kVideoStreamId, payloadSize, pts);
+    unit.spans = spans_.data();
+    unit.spanCount = spans_.size();
+    unit.payloadSize = payloadSize;
+    unit.randomAccess = keyFrame;
+    unit.withPcr = keyFrame || ptsUs - lastPcrUs_ >= kPcrIntervalUs;
+    unit.pcrBase = (pts + kTimestampMask + 1 - kPtsOffsetTicks) & kTimestampMask;
+    if (unit.withPcr) {
+        lastPcrUs_ = ptsUs;
+    }
+    writePes(unit, ptsUs, keyFrame);
+}
+
+void TsMuxer::addAudioSample(const uint8_t* data, size_t size, int64_t ptsUs) {
+    // With video the stream opens on a keyframe; audio before it has nothing to sync to.
+    if (!hasAudio_ || size == 0 || (hasVideo_ && !started_)) {
+        return;
+    }
+    beginStream(ptsUs);
+    const size_t frameLength = kAdtsHeaderSize + size;
+    if (frameLength > 0x1FFF) {
+        return;
+    }
+    std::array<uint8_t, kAdtsHeaderSize> adts = adtsHeader_;
+    adts[3] = static_cast<uint8_t>(adts[3] | (frameLength >> 11));
+    adts[4] = static_cast<uint8_t>(frameLength >> 3);
+    adts[5] = static_cast<uint8_t>(((frameLength & 0x07) << 5) | 0x1F);
+    const ByteSpan spans[2] = {{adts.data(), adts.size()}, {data, size}};
+
+    const bool audioOnly = !hasVideo_;
+    if (audioOnly && (stats_.pesUnits == 0 || ptsUs - lastTablesUs_ >= kTableIntervalUs)) {
+        writeTables();
+        lastTablesUs_ = ptsUs;
+    }
+    uint8_t header[kPesHeaderSize];
+    const uint64_t pts = ticks(ptsUs);
+    PesUnit unit;
+    unit.pid = kAudioPid;
+    unit.continuity = &audioContinuity_;
+    unit.header = header;
+    unit.headerSize = WritePesHeader(header, kAudioStreamId, frameLength, pts);
+    unit.spans = spans;
+    unit.spanCount = 2;
+    unit.payloadSize = frameLength;
+    unit.randomAccess = audioOnly;
+    unit.withPcr = audioOnly && (stats_.pesUnits == 0 || ptsUs - lastPcrUs_ >= kPcrIntervalUs);
+    unit.pcrBase = (pts + kTimestampMask + 1 - kPtsOffsetTicks) & kTimestampMask;
+    if (unit.withPcr) {
+        lastPcrUs_ = ptsUs;
+    }
+    writePes(unit, ptsUs, false);
+}
+
+void TsMuxer::flush() {
+    if (current_ && current_->size > 0) {
+        ++stats_.datagrams;
+        if (sink_) {
+            sink_(std::move(current_));
+        }
+    }
+    current_.reset();
+}
+
+void TsMuxer::beginStream(int64_t ptsUs) {
+    if (!started_) {
+        started_ = true;
+        epochUs_ = ptsUs;
+        lastPcrUs_ = ptsUs - kPcrIntervalUs;
+        lastTablesUs_ = ptsUs;
+    }
+}
+
+uint64_t TsMuxer::ticks(int64_t ptsUs) const {
+    const int64_t value = (ptsUs - epochUs_) * 9 / 100 + kPtsOffsetTicks;
+    return static_cast<uint64_t>(std::max<int64_t>(value, 0)) & kTimestampMask;
+}
+
+void TsMuxer::writeTables() {
+    uint8_t pat[16] = {0x00, 0xB0, 13,
+                       kTransportStreamId >> 8, kTransportStreamId & 0xFF, 0xC1, 0x00, 0x00,
+                       kProgramNumber >> 8, kProgramNumber & 0xFF,
+                       0xE0 | (kPmtPid >> 8), kPmtPid & 0xFF};
+    const uint32_t patCrc = Crc32Mpeg(pat, 12);
+    for (int i = 0; i < 4; ++i) {
+        pat[12 + i] = static_cast<uint8_t>(patCrc >> (24 - 8 * i));
+    }
+    writeSection(kPatPid, patContinuity_, pat, sizeof(pat));
+
+    const uint16_t pcrPid = hasVideo_ ? kVideoPid : kAudioPid;
+    const size_t streams = (hasVideo_ ? 1 : 0) + (hasAudio_ ? 1 : 0);
+    const size_t sectionLength = 9 + 5 * streams + 4;
+    uint8_t pmt[32] = {0x02, static_cast<uint8_t>(0xB0 | (sectionLength >> 8)), static_cast<uint8_t>(sectionLength),
+                       kProgramNumber >> 8, kProgramNumber & 0xFF, 0xC1, 0x00, 0x00,
+                       static_cast<uint8_t>(0xE0 | (pcrPid >> 8)), static_cast<uint8_t>(pcrPid), 0xF0, 0x00};
+    size_t size = 12;
+    const auto addStream = [&](uint8_t type, uint16_t pid) {
+        pmt[size++] = type;
+        pmt[size++] = static_cast<uint8_t>(0xE0 | (pid >> 8));
+        pmt[size++] = static_cast<uint8_t>(pid);
+        pmt[size++] = 0xF0;
+        pmt[size++] = 0x00;
+    };
+    if (hasVideo_) {
+        addStream(videoConfig_.codec == VideoCodecId::kH265 ? kStreamTypeHevc : kStreamTypeH264, kVideoPid);
+    }
+    if (hasAudio_) {
+        addStream(kStreamTypeAdtsAac, kAudioPid);
+    }
+    const uint32_t pmtCrc = Crc32Mpeg(pmt, size);
+    for (int i = 0; i < 4; ++i) {
+        pmt[size++] = static_cast<uint8_t>(pmtCrc >> (24 - 8 * i));
+    }
+    writeSection(kPmtPid, pmtContinuity_, pmt, size);
+}
+
+void TsMuxer::writeSection(uint16_t pid, uint8_t& continuity, const uint8_t* section, size_t size) {
+    uint8_t* packet = nextPacket(0, false, false);
+    packet[0] = kSyncByte;
+    packet[1] = static_cast<uint8_t>(0x40 | (pid >> 8));
+    packet[2] = static_cast<uint8_t>(pid);
+    packet[3] = static_cast<uint8_t>(0x10 | (continuity++ & 0x0F));
+    packet[4] = 0x00;  // pointer field
+    std::memcpy(packet + 5, section, size);
+    std::memset(packet + 5 + size, 0xFF, kPacketSize - 5 - size);
+    commitPacket();
+}
+
+void TsMuxer::writePes(const PesUnit& unit, int64_t ptsUs, bool keyFrame) {
+    size_t remaining = unit.headerSize + unit.payloadSize;
+    size_t headerOffset = 0;
+    size_t spanIndex = 0;
+    size_t spanOffset = 0;
+    bool first = true;
+    while (remaining > 0) {
+        uint8_t* packet = nextPacket(ptsUs, keyFrame && first, first);
+        uint8_t flags = 0;
+        if (first) {
+            flags = static_cast<uint8_t>((unit.randomAccess ? kAdaptationRandomAccess : 0) |
+                                         (unit.withPcr ? kAdaptationPcr : 0));
+        }
+        size_t adaptationSize = flags != 0 ? 2 + ((flags & kAdaptationPcr) ? kPcrSize : 0) : 0;
+        size_t payload = kPacketPayload - adaptationSize;
+        if (remaining < payload) {
+            // The last packet is padded through the adaptation field.
+            adaptationSize += payload - remaining;
+            payload = remaining;
+        }
+        packet[0] = kSyncByte;
+        packet[1] = static_cast<uint8_t>((first ? 0x40 : 0x00) | (unit.pid >> 8));
+        packet[2] = static_cast<uint8_t>(unit.pid);
+        packet[3] = static_cast<uint8_t>((adaptationSize > 0 ? 0x30 : 0x10) | ((*unit.continuity)++ & 0x0F));
+        uint8_t* out = packet + 4;
+        if (adaptationSize > 0) {
+            out[0] = static_cast<uint8_t>(adaptationSize - 1);
+            if (adaptationSize > 1) {
+                out[1] = flags;
+                size_t position = 2;
+                if (flags & kAdaptationPcr) {
+                    WritePcr(out + 2, unit.pcrBase);
+                    position += kPcrSize;
+                }
+                std::memset(out + position, 0xFF, adaptationSize - position);
+            }
+            out += adaptationSize;
+        }
+
+        remaining -= payload;
+        if (headerOffset < unit.headerSize) {
+            const size_t count = std::min(payload, unit.headerSize - headerOffset);
+            std::memcpy(out, unit.header + headerOffset, count);
+            headerOffset += count;
+            out += count;
+            payload -= count;
+        }
+        while (payload > 0) {
+            const ByteSpan& span = unit.spans[spanIndex];
+            const size_t count = std::min(payload, span.size - spanOffset);
+            std::memcpy(out, span.data + spanOffset, count);
+            out += count;
+            payload -= count;
+            spanOffset += count;
+            if (spanOffset == span.size) {
+                ++spanIndex;
+                spanOffset = 0;
+            }
+        }
+        commitPacket();
+        first = false;
+    }
+    ++stats_.pesUnits;
+}
+
+uint8_t* TsMuxer::nextPacket(int64_t ptsUs, bool keyFrame, bool startsPes) {
+    if (!current_) {
+        current_ = pool_->acquire();
+    }
+    if (startsPes) {
+        current_->ptsUs = ptsUs;
+        current_->keyFrame = current_->keyFrame || keyFrame;
+    }
+    return current_->bytes.data() + current_->size;
+}
+
+void TsMuxer::commitPacket() {
+    current_->size += kPacketSize;
+    ++stats_.packets;
+    if (current_->size == TsDatagram::kCapacity) {
+        flush();
+    }
+}
+
+}  // namespace astra
@@ -0,0 +1,150 @@
+#ifndef ASTRASTREAM_TSMUXER_H
+#define ASTRASTREAM_TSMUXER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "FlvMuxer.h"
+
+namespace astra {
+
+class TsDatagramPool;
+
+// Seven transport packets: the payload of one SRT or UDP datagram.
+struct TsDatagram {
+    static constexpr size_t kPacketSize = 188;
+    static constexpr size_t kPacketsPerDatagram = 7;
+    static constexpr size_t kCapacity = kPacketSize * kPacketsPerDatagram;
+
+    std::array<uint8_t, kCapacity> bytes{};
+    size_t size = 0;  // whole packets only
+    int64_t ptsUs = 0;  // media time of the newest PES started in this datagram
+    bool keyFrame = false;  // carries the start of a keyframe PES
+};
+
+// Returns a datagram to its pool, or frees it once the pool is gone.
+struct TsDatagramRecycler {
+    std::weak_ptr<TsDatagramPool> pool;
+    void operator()(TsDatagram* datagram) const;
+};
+
+using TsDatagramPtr = std::unique_ptr<TsDatagram, TsDatagramRecycler>;
+
+// Free list shared between the muxing thread and whichever thread sends the datagrams;
+// dropping a TsDatagramPtr anywhere hands the buffer back.
+class TsDatagramPool : public std::enable_shared_from_this<TsDatagramPool> {
+public:
+    static std::shared_ptr<TsDatagramPool> create(size_t maxPooled = 256);
+
+    TsDatagramPtr acquire();
+    [[nodiscard]] uint64_t allocations() const;
+
+private:
+    friend struct TsDatagramRecycler;
+    explicit TsDatagramPool(size_t maxPooled) : maxPooled_(maxPooled) {}
+    void recycle(TsDatagram* datagram);
+
+    const size_t maxPooled_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<TsDatagram>> free_;
+    uint64_t allocations_ = 0;
+};
+
+// MPEG-2 transport stream writer for the SRT/UDP transports. Video samples arrive
+// length-prefixed, as FlvMuxer::parseVideoFrame / sliceVideoFrameInPlace produce them; the
+// 4-byte length prefixes are written out as start codes while the PES is packetized, and
+// keyframes get an access unit delimiter plus the parameter sets from the decoder
+// configuration record. Audio becomes one ADTS frame per PES. PAT and PMT precede every
+// keyframe (or follow kTableIntervalUs on audio-only streams) and the PCR rides on the
+// first packet of PES units on the PCR PID, at least every kPcrIntervalUs.
+//
+// Packets are written straight into pooled datagram buffers; nothing is staged per frame.
+// A datagram is handed to the sink when its seventh packet is written or on flush().
+class TsMuxer {
+public:
+    static constexpr uint16_t kPmtPid = 0x1000;
+    static constexpr uint16_t kVideoPid = 0x100;
+    static constexpr uint16_t kAudioPid = 0x101;
+    static constexpr int64_t kPcrIntervalUs = 40000;
+    static constexpr int64_t kTableIntervalUs = 500000;
+
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t datagrams = 0;
+        uint64_t pesUnits = 0;
+    };
+
+    using DatagramSink = std::function<void(TsDatagramPtr datagram)>;
+
+    explicit TsMuxer(std::shared_ptr<TsDatagramPool> pool = TsDatagramPool::create());
+
+    // |decoderConfigurationRecord| is the avcC / hvcC body (FlvMuxer::buildDecoderConfigurationRecord).
+    bool setVideoTrack(const VideoConfig& config, const std::vector<uint8_t>& decoderConfigurationRecord);
+    bool setAudioTrack(const AudioConfig& config);
+    void setDatagramSink(DatagramSink sink) { sink_ = std::move(sink); }
+
+    [[nodiscard]] bool hasVideo() const { return hasVideo_; }
+    [[nodiscard]] bool hasAudio() const { return hasAudio_; }
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+    [[nodiscard]] const std::shared_ptr<TsDatagramPool>& pool() const { return pool_; }
+
+    // |parts| hold length-prefixed NAL units. Samples before the first keyframe are dropped.
+    void addVideoSample(const ByteSpan* parts, size_t count, int64_t ptsUs, bool keyFrame);
+    // One raw AAC access unit; an ADTS header is generated from the AudioSpecificConfig.
+    void addAudioSample(const uint8_t* data, size_t size, int64_t ptsUs);
+    // Hands over the partly filled datagram, if any.
+    void flush();
+
+private:
+    struct PesUnit {
+        uint16_t pid = 0;
+        uint8_t* continuity = nullptr;
+        const uint8_t* header = nullptr;  // PES header
+        size_t headerSize = 0;
+        const ByteSpan* spans = nullptr;  // elementary stream data
+        size_t spanCount = 0;
+        size_t payloadSize = 0;
+        bool randomAccess = false;
+        bool withPcr = false;
+        uint64_t pcrBase = 0;
+    };
+
+    void beginStream(int64_t ptsUs);
+    uint64_t ticks(int64_t ptsUs) const;
+    void writeTables();
+    void writeSection(uint16_t pid, uint8_t& continuity, const uint8_t* section, size_t size);
+    void writePes(const PesUnit& unit, int64_t ptsUs, bool keyFrame);
+    uint8_t* nextPacket(int64_t ptsUs, bool keyFrame, bool startsPes);
+    void commitPacket();
+
+    std::shared_ptr<TsDatagramPool> pool_;
+    DatagramSink sink_;
+    TsDatagramPtr current_;
+    Stats stats_;
+
+    VideoConfig videoConfig_{};
+    bool hasVideo_ = false;
+    bool hasAudio_ = false;
+    std::vector<uint8_t> keyFramePrefix_;  // AUD + parameter sets, Annex-B
+    size_t audPrefixSize_ = 0;  // the AUD alone, written in front of other frames
+    std::array<uint8_t, 7> adtsHeader_{};
+
+    bool started_ = false;
+    int64_t epochUs_ = 0;
+    int64_t lastPcrUs_ = 0;
+    int64_t lastTablesUs_ = 0;
+    uint8_t patContinuity_ = 0;
+    uint8_t pmtContinuity_ = 0;
+    uint8_t videoContinuity_ = 0;
+    uint8_t audioContinuity_ = 0;
+    std::vector<ByteSpan> spans_;  // reused gather list for the current PES
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_TSMUXER_H
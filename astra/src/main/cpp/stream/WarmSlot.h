@@ -0,0 +1,77 @@
+#ifndef ASTRASTREAM_WARMSLOT_H
+#define ASTRASTREAM_WARMSLOT_H
+
+#include <functional>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace astra {
+
+// One object that is slow to create (an encoder), prepared on a background thread ahead of
+// the call that needs it. take() joins the preparation, so a caller that comes early waits
+// only for the rest of it; one prepared for another configuration is released instead.
+// Not thread-safe: the owner serialises prepare(), take() and reset().
+template <typename Config, typename Resource>
+class WarmSlot {
+public:
+    using Create = std::function<std::optional<Resource>(const Config&)>;
+    using Destroy = std::function<void(Resource&)>;
+    using Matches = std::function<bool(const Config& prepared, const Config& requested)>;
+
+    WarmSlot(Matches matches, Destroy destroy) : matches_(std::move(matches)), destroy_(std::move(destroy)) {}
+    ~WarmSlot() { reset(); }
+    WarmSlot(const WarmSlot&) = delete;
+    WarmSlot& operator=(const WarmSlot&) = delete;
+
+    // Starts preparing for |config|; false when that is already prepared or under way.
+    bool prepare(const Config& config, Create create) {
+        if (thread_.joinable() && matches_(config_, config)) {
+            return false;
+        }
+        reset();
+        config_ = config;
+        thread_ = std::thread([this, config, create = std::move(create)] { resource_ = create(config); });
+        return true;
+    }
+
+    // The prepared object when it serves |config|. Empty when nothing was prepared, creating
+    // it failed, or it was for another configuration.
+    std::optional<Resource> take(const Config& config) {
+        if (!thread_.joinable()) {
+            return std::nullopt;
+        }
+        thread_.join();
+        if (!resource_.has_value() || !matches_(config_, config)) {
+            reset();
+            return std::nullopt;
+        }
+        Resource taken = std::move(*resource_);
+        resource_.reset();
+        return taken;
+    }
+
+    // Joins a running preparation and releases what it made.
+    void reset() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (resource_.has_value()) {
+            destroy_(*resource_);
+            resource_.reset();
+        }
+    }
+
+    [[nodiscard]] bool pending() const { return thread_.joinable(); }
+
+private:
+    Matches matches_;
+    Destroy destroy_;
+    std::thread thread_;  // fills resource_; joined before it is read
+    Config config_{};
+    std::optional<Resource> resource_;
+};
+
+}  // namespace astra
+
+#endif  // ASTRASTREAM_WARMSLOT_H
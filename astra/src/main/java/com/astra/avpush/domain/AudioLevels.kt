@@ -0,0 +1,23 @@
+package com.astra.avpush.domain
+
+import kotlin.math.log10
+
+data class ChannelLevel(
+    /** Largest absolute sample in the window, linear full scale (0..1). */
+    val peak: Float,
+    val rms: Float,
+    /** Full-scale samples since capture started. */
+    val clippedSamples: Long
+) {
+    val peakDbfs: Float get() = toDbfs(peak)
+    val rmsDbfs: Float get() = toDbfs(rms)
+
+    private fun toDbfs(linear: Float): Float =
+        if (linear <= 0f) Float.NEGATIVE_INFINITY else 20f * log10(linear)
+}
+
+data class AudioLevels(
+    /** CLOCK_MONOTONIC capture time of the end of the metering window, in microseconds. */
+    val timestampUs: Long,
+    val channels: List<ChannelLevel>
+)
@@ -0,0 +1,12 @@
+package com.astra.avpush.domain
+
+data class AudioPipelineStats(
+    val overruns: Long,
+    val droppedFrames: Long,
+    val underruns: Long,
+    val bufferedFrames: Long,
+    /** Estimated capture clock drift against CLOCK_MONOTONIC, in ppm. */
+    val clockDriftPpm: Double = 0.0,
+    /** AAC frames sent from the silent-frame cache instead of the encoder (DTX). */
+    val dtxFrames: Long = 0
+)
@@ -0,0 +1,10 @@
+package com.astra.avpush.domain
+
+/**
+ * How an extra PCM source is mixed over the microphone.
+ *
+ * [STREAM] is a continuous feed on its own clock (e.g. playback capture) and is resampled
+ * slightly to stay aligned with the microphone. [CLIP] plays whatever has been queued,
+ * such as sound effects, and is silent in between.
+ */
+enum class AudioSourceKind { STREAM, CLIP }
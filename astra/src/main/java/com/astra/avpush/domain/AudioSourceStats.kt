@@ -0,0 +1,9 @@
+package com.astra.avpush.domain
+
+data class AudioSourceStats(
+    val overruns: Long,
+    val underruns: Long,
+    /** Rate trim currently applied to keep the source aligned with the microphone, in ppm. */
+    val driftPpm: Double,
+    val bufferedFrames: Long
+)
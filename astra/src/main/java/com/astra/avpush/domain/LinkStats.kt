@@ -0,0 +1,17 @@
+package com.astra.avpush.domain
+
+data class LinkStats(
+    /** Round-trip time as measured by the receiver. */
+    val rttUs: Long,
+    val packetsSent: Long,
+    val packetsRetransmitted: Long,
+    /** Packets the receiver reported missing. */
+    val packetsLost: Long,
+    /** Packets given up on because they could no longer arrive within the latency. */
+    val packetsDropped: Long,
+    val bytesSent: Long,
+    /** Receiving rate estimated by the peer, in bits per second. */
+    val receiveRateBps: Long,
+    /** Negotiated end-to-end latency. */
+    val latencyMs: Int
+)
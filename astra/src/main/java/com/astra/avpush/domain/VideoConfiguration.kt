@@ -16,12 +16,21 @@ class VideoConfiguration(
     val codec: VideoCodec = VideoCodec.H264,
     val mime: String = codec.mimeType,
     val spspps: ByteBuffer? = null,
-    val surface: Surface? = null
+    val surface: Surface? = null,
+    /** Send encoder output buffers without copying; meant for very high bitrates. */
+    val zeroCopyOutput: Boolean = false,
+    /**
+     * Temporal layers (1-3). Above 1 the encoder is asked for `android.generic.N` and, while the
+     * link lags, the sender drops the top layer instead of waiting for a key frame.
+     */
+    val temporalLayers: Int = 1
 ) {
     enum class ICODEC { ENCODE, DECODE, }
 
     enum class VideoCodec(val mimeType: String, val flvCodecId: Int) {
         H264(MediaFormat.MIMETYPE_VIDEO_AVC, 7),
-        H265(MediaFormat.MIMETYPE_VIDEO_HEVC, 12)
+        H265(MediaFormat.MIMETYPE_VIDEO_HEVC, 12),
+        /** No legacy FLV codec id; sent as Enhanced RTMP 'av01'. Needs a hardware AV1 encoder. */
+        AV1(MediaFormat.MIMETYPE_VIDEO_AV1, 13)
     }
 }
@@ -0,0 +1,107 @@
+package com.astra.avpush.infrastructure.audio
+
+import android.annotation.SuppressLint
+import android.media.AudioAttributes
+import android.media.AudioFormat
+import android.media.AudioPlaybackCaptureConfiguration
+import android.media.AudioRecord
+import android.media.projection.MediaProjection
+import android.os.Build
+import androidx.annotation.RequiresApi
+import com.astra.avpush.domain.AudioSourceKind
+import com.astra.avpush.infrastructure.stream.nativebridge.NativeSender
+import com.astra.avpush.runtime.AstraLog
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Captures app/game playback through [MediaProjection] and feeds it to the native mixer as a
+ * [AudioSourceKind.STREAM] source. The caller owns the projection and the RECORD_AUDIO grant.
+ */
+@RequiresApi(Build.VERSION_CODES.Q)
+class PlaybackCaptureSource(
+    private val sender: NativeSender,
+    private val projection: MediaProjection,
+    private val sampleRate: Int = 48000,
+    private val channels: Int = 2
+) {
+
+    private val tag = "PlaybackCaptureSource"
+    @Volatile private var running = false
+    private var record: AudioRecord? = null
+    private var worker: Thread? = null
+    private var sourceId = -1
+
+    @SuppressLint("MissingPermission")
+    fun start(): Boolean {
+        if (running) return true
+        val channelMask = if (channels == 2) AudioFormat.CHANNEL_IN_STEREO else AudioFormat.CHANNEL_IN_MONO
+        val minBuffer = AudioRecord.getMinBufferSize(sampleRate, channelMask, AudioFormat.ENCODING_PCM_16BIT)
+        if (minBuffer <= 0) {
+            AstraLog.e(tag, "Unsupported playback capture format rate=$sampleRate channels=$channels")
+            return false
+        }
+        val captureConfig = AudioPlaybackCaptureConfiguration.Builder(projection)
+            .addMatchingUsage(AudioAttributes.USAGE_MEDIA)
+            .addMatchingUsage(AudioAttributes.USAGE_GAME)
+            .addMatchingUsage(AudioAttributes.USAGE_UNKNOWN)
+            .build()
+        val audioRecord = AudioRecord.Builder()
+            .setAudioPlaybackCaptureConfig(captureConfig)
+            .setAudioFormat(
+                AudioFormat.Builder()
+                    .setEncoding(AudioFormat.ENCODING_PCM_16BIT)
+                    .setSampleRate(sampleRate)
+                    .setChannelMask(channelMask)
+                    .build()
+            )
+            .setBufferSizeInBytes(minBuffer * 2)
+            .build()
+        val id = sender.addAudioSource(sampleRate, channels, AudioSourceKind.STREAM)
+        if (id < 0) {
+            audioRecord.release()
+            return false
+        }
+        sourceId = id
+        record = audioRecord
+        running = true
+        audioRecord.startRecording()
+        // ~10 ms reads keep the mixer ring topped up without large bursts.
+        val chunkBytes = (sampleRate / 100) * channels * 2
+        worker = Thread({ pump(audioRecord, chunkBytes) }, tag).apply { start() }
+        return true
+    }
+
+    fun stop() {
+        if (!running) return
+        running = false
+        worker?.join()
+        worker = null
+        record?.run {
+            stop()
+            release()
+        }
+        record = null
+        sender.removeAudioSource(sourceId)
+        sourceId = -1
+    }
+
+    fun setGain(gain: Float) {
+        if (sourceId >= 0) sender.setAudioSourceGain(sourceId, gain)
+    }
+
+    private fun pump(audioRecord: AudioRecord, chunkBytes: Int) {
+        val buffer = ByteBuffer.allocateDirect(chunkBytes).order(ByteOrder.nativeOrder())
+        while (running) {
+            val read = audioRecord.read(buffer, chunkBytes, AudioRecord.READ_BLOCKING)
+            if (read < 0) {
+                AstraLog.e(tag, "AudioRecord read failed $read")
+                break
+            }
+            if (read > 0) {
+                sender.pushAudioSource(sourceId, buffer, 0, read)
+            }
+            buffer.clear()
+        }
+    }
+}
@@ -17,6 +17,7 @@ class CameraRecorder(
     private val renderer: EncodeRenderer = EncodeRenderer(textureId)
     private var rendererMode = GLSurfaceView.RENDERERMODE_CONTINUOUSLY
     private var glThread: EncodeRendererThread? = null
+    @Volatile
     private var surface: Surface? = null
     private var configuration: VideoConfiguration = VideoConfiguration()
 
@@ -35,6 +36,43 @@ class CameraRecorder(
         }
     }
 
+    /**
+     * Moves rendering to [targetSurface] at [videoConfiguration]'s size and frame rate; the
+     * surface it replaces is released after [onSwitched] runs on the render thread. False when
+     * not rendering, in which case [onSwitched] never runs.
+     */
+    fun switchSurface(targetSurface: Surface, videoConfiguration: VideoConfiguration, onSwitched: () -> Unit): Boolean {
+        val thread = glThread ?: return false
+        configuration = videoConfiguration
+        thread.setRenderFps(videoConfiguration.fps)
+        thread.switchSurface(targetSurface, videoConfiguration.width, videoConfiguration.height) {
+            // Taken when the switch is applied: the surface rendered to until now.
+            val previous = surface
+            surface = targetSurface
+            onSwitched()
+            previous?.release()
+        }
+        return true
+    }
+
+    /**
+     * Simulcast: also renders each frame into [targetSurface], an encoder input of its own
+     * size. The surface is released once the render thread has let go of it.
+     */
+    fun addLayer(layer: Int, targetSurface: Surface, videoConfiguration: VideoConfiguration) {
+        val thread = glThread ?: run {
+            targetSurface.release()
+            return
+        }
+        thread.addLayerSurface(layer, targetSurface, videoConfiguration.width, videoConfiguration.height) {
+            targetSurface.release()
+        }
+    }
+
+    fun removeLayer(layer: Int) {
+        glThread?.removeLayerSurface(layer)
+    }
+
     fun stop() {
         glThread?.onDestory()
         glThread = null
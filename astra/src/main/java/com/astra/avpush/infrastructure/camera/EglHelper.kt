@@ -15,6 +15,7 @@ class EglHelper {
     private var display: EGLDisplay? = null
     private var context: EGLContext? = null
     private var surface: EGLSurface? = null
+    private var config: EGLConfig? = null
 
     val eglContext: EGLContext?
         get() = context
@@ -43,6 +44,7 @@ class EglHelper {
         check(egl.eglChooseConfig(eglDisplay, attributes, configs, configs.size, numConfig)) { "Failed to obtain EGLConfig" }
         val resolvedConfig = configs.firstOrNull { it != null }
         check(resolvedConfig != null) { "EGLConfig not resolved" }
+        config = resolvedConfig
         val contextAttrs = intArrayOf(EGL14.EGL_CONTEXT_CLIENT_VERSION, 2, EGL10.EGL_NONE)
         context = egl.eglCreateContext(eglDisplay, resolvedConfig, sharedContext ?: EGL10.EGL_NO_CONTEXT, contextAttrs)
         check(context != null && context !== EGL10.EGL_NO_CONTEXT) { "Failed to create EGLContext" }
@@ -52,17 +54,53 @@ class EglHelper {
     }
 
     fun makeCurrent() {
+        makeCurrent(surface ?: return)
+    }
+
+    fun makeCurrent(eglSurface: EGLSurface) {
         val egl = egl ?: return
         val eglDisplay = display ?: return
-        val eglSurface = surface ?: return
         val eglContext = context ?: return
         check(egl.eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) { "eglMakeCurrent failed" }
     }
 
+    /** A further window surface on the same context, e.g. a simulcast encoder input. */
+    fun createWindowSurface(target: Surface): EGLSurface? {
+        val egl = egl ?: return null
+        val eglDisplay = display ?: return null
+        val eglConfig = config ?: return null
+        return egl.eglCreateWindowSurface(eglDisplay, eglConfig, target, null)
+            ?.takeIf { it !== EGL10.EGL_NO_SURFACE }
+    }
+
+    fun destroyWindowSurface(eglSurface: EGLSurface) {
+        val egl = egl ?: return
+        val eglDisplay = display ?: return
+        egl.eglDestroySurface(eglDisplay, eglSurface)
+    }
+
+    /** Renders into [target] from now on, keeping the context and its textures. */
+    fun switchSurface(target: Surface) {
+        val egl = egl ?: return
+        val eglDisplay = display ?: return
+        val eglConfig = config ?: return
+        val next = egl.eglCreateWindowSurface(eglDisplay, eglConfig, target, null)
+        check(next != null && next !== EGL10.EGL_NO_SURFACE) { "Failed to create EGLSurface" }
+        val previous = surface
+        surface = next
+        makeCurrent()
+        if (previous != null && previous !== EGL10.EGL_NO_SURFACE) {
+            egl.eglDestroySurface(eglDisplay, previous)
+        }
+    }
+
     fun swapBuffers(): Boolean {
+        return swapBuffers(surface ?: return false)
+    }
+
+    fun swapBuffers(eglSurface: EGLSurface): Boolean {
         val egl = egl ?: return false
         val eglDisplay = display ?: return false
-        val eglSurface = surface ?: return false
         return egl.eglSwapBuffers(eglDisplay, eglSurface)
     }
 
@@ -82,6 +120,7 @@ class EglHelper {
             egl.eglTerminate(eglDisplay)
         }
         surface = null
+        config = null
         context = null
         display = null
         this.egl = null
@@ -1,9 +1,12 @@
 package com.astra.avpush.infrastructure.camera
 
+import android.view.Surface
 import com.astra.avpush.presentation.widget.GLSurfaceView
 import com.astra.avpush.presentation.widget.GlThreadConfig
 import com.astra.avpush.runtime.AstraLog
 import java.lang.ref.WeakReference
+import java.util.concurrent.ConcurrentLinkedQueue
+import javax.microedition.khronos.egl.EGLSurface
 import kotlin.math.max
 
 open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) : Thread() {
@@ -55,6 +58,41 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
     private var mWidth = 1080
     private var mHeight = 1920;
 
+    /**
+     * 待切换的目标窗口，在渲染线程上生效
+     */
+    @Volatile
+    private var pendingSwitch: SurfaceSwitch? = null
+
+    /**
+     * 联播（simulcast）层：每帧在主窗口之后按各自尺寸再画到这些编码器窗口
+     */
+    private val layerRequests = ConcurrentLinkedQueue<LayerRequest>()
+
+    /**
+     * 已在渲染线程上创建 EGLSurface 的层，仅渲染线程访问
+     */
+    private val attachedLayers = HashMap<Int, Pair<LayerSurface, EGLSurface>>()
+
+    private class LayerSurface(
+        val surface: Surface,
+        val width: Int,
+        val height: Int,
+        val onDetached: () -> Unit
+    )
+
+    /**
+     * [surface] 为 null 表示移除该层
+     */
+    private class LayerRequest(val layer: Int, val surface: LayerSurface?)
+
+    private class SurfaceSwitch(
+        val surface: Surface,
+        val width: Int,
+        val height: Int,
+        val onSwitched: () -> Unit
+    )
+
     override fun run() {
         super.run()
         //实例化 EGL 环境搭建的帮组类
@@ -98,6 +136,8 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
                         throw RuntimeException("mRendererMode is wrong value");
                     }
                 }
+                //切换窗口
+                val switch = applySwitch()
                 //开始创建
                 onCreate(mWidth, mHeight)
                 //改变窗口
@@ -105,6 +145,8 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
                 //开始绘制
                 onDraw()
                 this.isStart = true
+                //新窗口已有画面
+                switch?.onSwitched?.invoke()
             }
         }
     }
@@ -117,6 +159,68 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
         this.mHeight = height
     }
 
+    /**
+     * 切换到新的窗口（编码器热切换），画完第一帧后回调 [onSwitched]
+     */
+    fun switchSurface(surface: Surface, width: Int, height: Int, onSwitched: () -> Unit) {
+        pendingSwitch = SurfaceSwitch(surface, width, height, onSwitched)
+        requestRenderer()
+    }
+
+    /**
+     * 添加联播层窗口；移除后在渲染线程上回调 [onDetached]，之后才可释放 [surface]
+     */
+    fun addLayerSurface(layer: Int, surface: Surface, width: Int, height: Int, onDetached: () -> Unit) {
+        layerRequests.add(LayerRequest(layer, LayerSurface(surface, width, height, onDetached)))
+    }
+
+    fun removeLayerSurface(layer: Int) {
+        layerRequests.add(LayerRequest(layer, null))
+    }
+
+    private fun detachLayer(layer: Int) {
+        val (surface, eglSurface) = attachedLayers.remove(layer) ?: return
+        mEGLHelper.destroyWindowSurface(eglSurface)
+        surface.onDetached()
+    }
+
+    private fun syncLayers() {
+        while (true) {
+            val request = layerRequests.poll() ?: break
+            detachLayer(request.layer)
+            val surface = request.surface ?: continue
+            val eglSurface = mEGLHelper.createWindowSurface(surface.surface)
+            if (eglSurface == null) {
+                AstraLog.e(TAG, "layer ${request.layer}: EGL surface unavailable")
+                surface.onDetached()
+                continue
+            }
+            attachedLayers[request.layer] = surface to eglSurface
+        }
+    }
+
+    private fun drawLayers(view: GlThreadConfig) {
+        syncLayers()
+        if (attachedLayers.isEmpty()) {
+            return
+        }
+        for ((layer, eglSurface) in attachedLayers.values) {
+            mEGLHelper.makeCurrent(eglSurface)
+            view.renderer()?.onDrawLayer(layer.width, layer.height)
+            mEGLHelper.swapBuffers(eglSurface)
+        }
+        mEGLHelper.makeCurrent()
+    }
+
+    private fun applySwitch(): SurfaceSwitch? {
+        val switch = pendingSwitch ?: return null
+        pendingSwitch = null
+        mEGLHelper.switchSurface(switch.surface)
+        setRendererSize(switch.width, switch.height)
+        isChange = true
+        return switch
+    }
+
     fun setRenderFps(fps: Int) {
         val sanitized = fps.coerceIn(1, 120)
         mDrawFpsRate = sanitized.toLong()
@@ -174,6 +278,7 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
                 view.renderer()?.onDraw()
 
             this.mEGLHelper.swapBuffers()
+            drawLayers(view)
         }
     }
 
@@ -201,6 +306,8 @@ open class GLThread(private val weakReference: WeakReference<GlThreadConfig>) :
      * 释放资源
      */
     private fun release() {
+        syncLayers()
+        attachedLayers.keys.toList().forEach(::detachLayer)
         mEGLHelper.release()
         weakReference.clear()
     }
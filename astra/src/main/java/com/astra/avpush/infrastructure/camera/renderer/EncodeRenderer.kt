@@ -51,6 +51,10 @@ class EncodeRenderer(private val textureId: Int) : GlRenderer {
         nativeOnDraw(ensureHandle())
     }
 
+    override fun onDrawLayer(width: Int, height: Int) {
+        nativeOnDrawLayer(ensureHandle(), width, height)
+    }
+
     fun setWatemark(watermark: Watermark) {
         pendingWatermark = watermark
         attemptApplyWatermark()
@@ -113,6 +117,7 @@ class EncodeRenderer(private val textureId: Int) : GlRenderer {
     private external fun nativeOnSurfaceCreate(handle: Long, width: Int, height: Int)
     private external fun nativeOnSurfaceChanged(handle: Long, width: Int, height: Int)
     private external fun nativeOnDraw(handle: Long)
+    private external fun nativeOnDrawLayer(handle: Long, width: Int, height: Int)
     private external fun nativeApplyWatermark(
         handle: Long,
         bitmap: Bitmap,
@@ -0,0 +1,47 @@
+package com.astra.avpush.infrastructure.stream.nativebridge
+
+import com.astra.avpush.domain.AudioLevels
+import com.astra.avpush.domain.ChannelLevel
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reads the level snapshot the capture callback publishes into native memory (layout in
+ * LevelMeter.h). The writer bumps the sequence to odd before and back to even after each
+ * update, so a read that sees the same even value on both sides is consistent.
+ */
+internal class AudioLevelReader(buffer: ByteBuffer) {
+
+    private val snapshot = buffer.duplicate().order(ByteOrder.nativeOrder())
+
+    fun read(): AudioLevels? {
+        repeat(MAX_ATTEMPTS) {
+            val before = snapshot.getInt(SEQUENCE_OFFSET)
+            if (before and 1 != 0) return@repeat
+            val channelCount = snapshot.getInt(CHANNELS_OFFSET).coerceIn(0, MAX_CHANNELS)
+            val timestampUs = snapshot.getLong(TIME_OFFSET)
+            val channels = List(channelCount) { index ->
+                val base = HEADER_BYTES + index * CHANNEL_BYTES
+                ChannelLevel(
+                    peak = snapshot.getFloat(base),
+                    rms = snapshot.getFloat(base + 4),
+                    clippedSamples = snapshot.getInt(base + 8).toLong() and 0xFFFFFFFFL
+                )
+            }
+            if (snapshot.getInt(SEQUENCE_OFFSET) == before) {
+                return if (before == 0 || channelCount == 0) null else AudioLevels(timestampUs, channels)
+            }
+        }
+        return null
+    }
+
+    private companion object {
+        const val SEQUENCE_OFFSET = 0
+        const val CHANNELS_OFFSET = 4
+        const val TIME_OFFSET = 8
+        const val HEADER_BYTES = 16
+        const val CHANNEL_BYTES = 16
+        const val MAX_CHANNELS = 8
+        const val MAX_ATTEMPTS = 4
+    }
+}
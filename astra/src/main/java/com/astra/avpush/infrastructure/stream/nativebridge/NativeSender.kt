@@ -4,9 +4,15 @@ import android.media.AudioFormat
 import android.view.Surface
 import com.astra.avpush.domain.OnConnectListener
 import com.astra.avpush.domain.AudioConfiguration
+import com.astra.avpush.domain.AudioLevels
+import com.astra.avpush.domain.AudioPipelineStats
+import com.astra.avpush.domain.AudioSourceKind
+import com.astra.avpush.domain.AudioSourceStats
+import com.astra.avpush.domain.LinkStats
 import com.astra.avpush.domain.VideoConfiguration
 import com.astra.avpush.runtime.AstraLog
 import com.astra.avpush.unified.TransportProtocol
+import java.nio.ByteBuffer
 
 class NativeSender internal constructor(
     private val handle: Long,
@@ -15,6 +21,9 @@ class NativeSender internal constructor(
 
     private val tag = "NativeSender-${protocol.name}"
     private val callbackProxy = NativeSenderCallbackProxy(handle)
+    private val levelReader by lazy(LazyThreadSafetyMode.PUBLICATION) {
+        NativeSenderBridge.nativeGetAudioLevelBuffer(handle)?.let(::AudioLevelReader)
+    }
 
     init {
         NativeSenderRegistry.register(handle)
@@ -33,12 +42,58 @@ class NativeSender internal constructor(
         NativeSenderBridge.nativeConnect(handle, callbackProxy, url)
     }
 
+    /**
+     * Simulcast: opens the connection for [layer] (1..N; 0 is the [connect] stream) to [url].
+     * Connect a layer before preparing its encoder with [prepareVideoLayer]. Its connection
+     * events are logged only; the callback reports the primary stream.
+     */
+    fun connectLayer(layer: Int, url: String): Boolean {
+        AstraLog.d(tag) { "connectLayer layer=$layer url=${maskUrl(url)}" }
+        return NativeSenderBridge.nativeConnectLayer(handle, layer, url)
+    }
+
+    fun disconnectLayer(layer: Int) {
+        NativeSenderBridge.nativeDisconnectLayer(handle, layer)
+    }
+
     fun close() {
         AstraLog.d(tag) { "close invoked" }
         NativeSenderBridge.nativeClose(handle)
         NativeSenderRegistry.onClosed(handle)
     }
 
+    /**
+     * Sends an FLV recording (e.g. one made with [startRecording]) over the current connection
+     * instead of encoder output, tags unchanged. [speed] scales the pace (0 = as fast as the
+     * link takes it); [loops] 0 repeats until [stopReplay] or [close].
+     */
+    fun startReplay(path: String, speed: Double = 1.0, loops: Int = 1): Boolean {
+        return NativeSenderBridge.nativeStartReplay(handle, path, speed, loops)
+    }
+
+    fun stopReplay() {
+        NativeSenderBridge.nativeStopReplay(handle)
+    }
+
+    /**
+     * Transport statistics of the live connection, or null when not connected or the
+     * protocol has none (RTMP runs over TCP). Populated for SRT.
+     */
+    fun linkStats(): LinkStats? {
+        val values = NativeSenderBridge.nativeGetLinkStats(handle)
+        if (values == null || values.size < 8) return null
+        return LinkStats(
+            rttUs = values[0],
+            packetsSent = values[1],
+            packetsRetransmitted = values[2],
+            packetsLost = values[3],
+            packetsDropped = values[4],
+            bytesSent = values[5],
+            receiveRateBps = values[6],
+            latencyMs = values[7].toInt()
+        )
+    }
+
     fun configureSession(audio: AudioConfiguration, video: VideoConfiguration) {
         val bytesPerSample = when (audio.encoding) {
             AudioFormat.ENCODING_PCM_8BIT -> 1
@@ -56,7 +111,8 @@ class NativeSender internal constructor(
             video.fps,
             video.maxBps,
             video.ifi,
-            video.codec.ordinal
+            video.codec.ordinal,
+            video.temporalLayers
         )
     }
 
@@ -68,7 +124,9 @@ class NativeSender internal constructor(
             config.fps,
             config.maxBps,
             config.ifi,
-            config.codec.ordinal
+            config.codec.ordinal,
+            config.zeroCopyOutput,
+            config.temporalLayers
         )
     }
 
@@ -80,6 +138,54 @@ class NativeSender internal constructor(
         NativeSenderBridge.nativeUpdateVideoBitrate(handle, bps)
     }
 
+    /**
+     * Starts a standby encoder for [config] (same codec) and returns its input surface; the
+     * current encoder keeps streaming. Blocks while the codec is configured.
+     */
+    fun prepareVideoReconfigure(config: VideoConfiguration): Surface? {
+        return NativeSenderBridge.nativePrepareVideoReconfigure(
+            handle,
+            config.width,
+            config.height,
+            config.fps,
+            config.maxBps,
+            config.ifi,
+            config.codec.ordinal
+        )
+    }
+
+    /**
+     * Simulcast: an encoder of its own for [layer] at [config], fed through the returned
+     * surface; it joins a running session straight away. Audio is shared with layer 0.
+     */
+    fun prepareVideoLayer(layer: Int, config: VideoConfiguration): Surface? {
+        return NativeSenderBridge.nativePrepareVideoLayer(
+            handle,
+            layer,
+            config.width,
+            config.height,
+            config.fps,
+            config.maxBps,
+            config.ifi,
+            config.codec.ordinal,
+            config.zeroCopyOutput,
+            config.temporalLayers
+        )
+    }
+
+    fun releaseVideoLayer(layer: Int) {
+        NativeSenderBridge.nativeReleaseVideoLayer(handle, layer)
+    }
+
+    fun updateVideoLayerBps(layer: Int, bps: Int) {
+        NativeSenderBridge.nativeUpdateVideoLayerBitrate(handle, layer, bps)
+    }
+
+    /** Switches to the standby encoder once frames are being rendered into its surface. */
+    fun commitVideoReconfigure(): Boolean {
+        return NativeSenderBridge.nativeCommitVideoReconfigure(handle)
+    }
+
     fun startSession() {
         NativeSenderBridge.nativeStartSession(handle)
     }
@@ -100,6 +206,102 @@ class NativeSender internal constructor(
         NativeSenderBridge.nativeSetMute(handle, muted)
     }
 
+    /**
+     * Records the encoded streams to an FLV file at [path], next to the live push or without
+     * one. The file opens at the next video keyframe and is finalized (duration, size) by
+     * [stopRecording]. Returns false when no stream is configured or the file cannot be created.
+     */
+    fun startRecording(path: String): Boolean {
+        return NativeSenderBridge.nativeStartRecording(handle, path)
+    }
+
+    /** Flushes and closes the recording; false if any write failed. */
+    fun stopRecording(): Boolean {
+        return NativeSenderBridge.nativeStopRecording(handle)
+    }
+
+    /**
+     * Writes low-latency HLS into [directory] for an edge server to serve: `index.m3u8`,
+     * `init.mp4` and one `.m4s` file per segment, with parts addressed by byte range. Segments
+     * start on keyframes; only the newest [windowSegments] are kept. Runs alongside the push.
+     */
+    fun startHls(
+        directory: String,
+        partDurationMs: Int = 200,
+        segmentDurationMs: Int = 2000,
+        windowSegments: Int = 6
+    ): Boolean {
+        return NativeSenderBridge.nativeStartHls(handle, directory, partDurationMs, segmentDurationMs, windowSegments)
+    }
+
+    /** Writes the remaining media and ends the playlist. */
+    fun stopHls() {
+        NativeSenderBridge.nativeStopHls(handle)
+    }
+
+    fun audioPipelineStats(): AudioPipelineStats? {
+        val values = NativeSenderBridge.nativeGetAudioPipelineStats(handle)
+        if (values == null || values.size < 6) return null
+        return AudioPipelineStats(
+            overruns = values[0],
+            droppedFrames = values[1],
+            underruns = values[2],
+            bufferedFrames = values[3],
+            clockDriftPpm = values[4] / 1000.0,
+            dtxFrames = values[5]
+        )
+    }
+
+    /**
+     * Audio DTX (off by default). Once the mixed input stays at or below [silenceThresholdDbfs]
+     * for ~190 ms, the AAC encoder is bypassed and tiny cached silent frames are sent at the
+     * normal cadence; the first louder block goes straight back to the encoder. The default
+     * only catches mute and digital silence; raise it to also cover a quiet room.
+     */
+    fun setAudioDtx(enabled: Boolean, silenceThresholdDbfs: Float = DEFAULT_DTX_THRESHOLD_DBFS) {
+        NativeSenderBridge.nativeSetAudioDtx(handle, enabled, silenceThresholdDbfs)
+    }
+
+    /**
+     * Latest microphone levels, refreshed every ~50 ms by the capture callback. Cheap enough
+     * to poll per UI frame: it reads shared native memory without crossing JNI. Null until
+     * the first window completes.
+     */
+    fun audioLevels(): AudioLevels? = levelReader?.read()
+
+    /**
+     * Registers a 16-bit PCM source mixed over the microphone. Returns its id, or -1 when the
+     * mixer is full or the audio encoder is not configured. Sources are dropped on reconfigure.
+     */
+    fun addAudioSource(sampleRate: Int, channels: Int, kind: AudioSourceKind): Int {
+        return NativeSenderBridge.nativeAddAudioSource(handle, sampleRate, channels, kind.ordinal)
+    }
+
+    fun removeAudioSource(sourceId: Int) {
+        NativeSenderBridge.nativeRemoveAudioSource(handle, sourceId)
+    }
+
+    /** [buffer] must be a direct buffer holding interleaved 16-bit PCM. */
+    fun pushAudioSource(sourceId: Int, buffer: ByteBuffer, offset: Int, size: Int): Boolean {
+        return NativeSenderBridge.nativePushAudioSourcePcm(handle, sourceId, buffer, offset, size)
+    }
+
+    /** Gain in [0, 1]; [MICROPHONE_SOURCE_ID] addresses the microphone. */
+    fun setAudioSourceGain(sourceId: Int, gain: Float) {
+        NativeSenderBridge.nativeSetAudioSourceGain(handle, sourceId, gain)
+    }
+
+    fun audioSourceStats(sourceId: Int): AudioSourceStats? {
+        val values = NativeSenderBridge.nativeGetAudioSourceStats(handle, sourceId)
+        if (values == null || values.size < 4) return null
+        return AudioSourceStats(
+            overruns = values[0],
+            underruns = values[1],
+            driftPpm = values[2] / 1000.0,
+            bufferedFrames = values[3]
+        )
+    }
+
     fun dispose() {
         AstraLog.d(tag) { "dispose invoked" }
         NativeSenderBridge.nativeDestroySender(handle)
@@ -119,4 +321,9 @@ class NativeSender internal constructor(
         }
         return url.substring(0, separatorIndex + 1) + maskedSuffix
     }
+
+    companion object {
+        const val MICROPHONE_SOURCE_ID = 0
+        const val DEFAULT_DTX_THRESHOLD_DBFS = -84f
+    }
 }
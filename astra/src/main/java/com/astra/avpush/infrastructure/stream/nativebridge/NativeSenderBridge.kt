@@ -1,6 +1,7 @@
 package com.astra.avpush.infrastructure.stream.nativebridge
 
 import android.view.Surface
+import java.nio.ByteBuffer
 
 /**
  * Native bridge exposing sender operations implemented in C++.
@@ -18,6 +19,11 @@ internal object NativeSenderBridge {
 
     external fun nativeConnect(handle: Long, callback: NativeSenderCallbackProxy, url: String)
     external fun nativeClose(handle: Long)
+    external fun nativeConnectLayer(handle: Long, layer: Int, url: String): Boolean
+    external fun nativeDisconnectLayer(handle: Long, layer: Int)
+    external fun nativeStartReplay(handle: Long, path: String, speed: Double, loops: Int): Boolean
+    external fun nativeStopReplay(handle: Long)
+    external fun nativeGetLinkStats(handle: Long): LongArray?
 
     external fun nativeConfigureVideo(
         handle: Long,
@@ -48,7 +54,8 @@ internal object NativeSenderBridge {
         videoFps: Int,
         videoBitrateKbps: Int,
         iframeInterval: Int,
-        codecOrdinal: Int
+        codecOrdinal: Int,
+        temporalLayers: Int
     )
 
     external fun nativePrepareVideoSurface(
@@ -58,7 +65,9 @@ internal object NativeSenderBridge {
         fps: Int,
         bitrateKbps: Int,
         iframeInterval: Int,
-        codecOrdinal: Int
+        codecOrdinal: Int,
+        zeroCopyOutput: Boolean,
+        temporalLayers: Int
     ): Surface?
 
     external fun nativeReleaseVideoSurface(handle: Long)
@@ -66,13 +75,67 @@ internal object NativeSenderBridge {
     external fun nativeStartVideo(handle: Long)
     external fun nativeStopVideo(handle: Long)
     external fun nativeUpdateVideoBitrate(handle: Long, bitrateKbps: Int)
+    external fun nativePrepareVideoReconfigure(
+        handle: Long,
+        width: Int,
+        height: Int,
+        fps: Int,
+        bitrateKbps: Int,
+        iframeInterval: Int,
+        codecOrdinal: Int
+    ): Surface?
+
+    external fun nativeCommitVideoReconfigure(handle: Long): Boolean
+
+    external fun nativePrepareVideoLayer(
+        handle: Long,
+        layer: Int,
+        width: Int,
+        height: Int,
+        fps: Int,
+        bitrateKbps: Int,
+        iframeInterval: Int,
+        codecOrdinal: Int,
+        zeroCopyOutput: Boolean,
+        temporalLayers: Int
+    ): Surface?
+
+    external fun nativeReleaseVideoLayer(handle: Long, layer: Int)
+    external fun nativeUpdateVideoLayerBitrate(handle: Long, layer: Int, bitrateKbps: Int)
 
     external fun nativeStartAudio(handle: Long)
     external fun nativeStopAudio(handle: Long)
+    external fun nativeGetAudioPipelineStats(handle: Long): LongArray?
+    external fun nativeSetAudioDtx(handle: Long, enabled: Boolean, silenceThresholdDbfs: Float)
+
+    external fun nativeAddAudioSource(handle: Long, sampleRate: Int, channels: Int, kindOrdinal: Int): Int
+    external fun nativeRemoveAudioSource(handle: Long, sourceId: Int)
+    external fun nativePushAudioSourcePcm(
+        handle: Long,
+        sourceId: Int,
+        buffer: ByteBuffer,
+        offset: Int,
+        size: Int
+    ): Boolean
+    external fun nativeSetAudioSourceGain(handle: Long, sourceId: Int, gain: Float)
+    external fun nativeGetAudioSourceStats(handle: Long, sourceId: Int): LongArray?
+    external fun nativeGetAudioLevelBuffer(handle: Long): ByteBuffer?
 
     external fun nativeStartSession(handle: Long)
     external fun nativePauseSession(handle: Long)
     external fun nativeResumeSession(handle: Long)
     external fun nativeStopSession(handle: Long)
     external fun nativeSetMute(handle: Long, muted: Boolean)
+
+    external fun nativeStartRecording(handle: Long, path: String): Boolean
+    external fun nativeStopRecording(handle: Long): Boolean
+
+    external fun nativeStartHls(
+        handle: Long,
+        directory: String,
+        partDurationMs: Int,
+        segmentDurationMs: Int,
+        windowSegments: Int
+    ): Boolean
+    external fun nativeStopHls(handle: Long)
 }
@@ -16,7 +16,7 @@ object NativeSenderFactory {
     fun createForProtocol(protocol: TransportProtocol): NativeSender {
         AstraLog.d(TAG) { "resolve native sender for protocol=${protocol.displayName}" }
         return when (protocol) {
-            TransportProtocol.RTMP -> newSender(protocol)
+            TransportProtocol.RTMP, TransportProtocol.SRT -> newSender(protocol)
             else -> throw UnsupportedOperationException(
                 "Protocol ${protocol.displayName} is not supported natively yet"
             )
@@ -11,6 +11,7 @@ import com.astra.avpush.infrastructure.stream.nativebridge.NativeSender
 import com.astra.avpush.runtime.AstraLog
 import com.astrastream.avpush.R
 import com.astra.avpush.unified.StreamError
+import java.util.concurrent.atomic.AtomicBoolean
 
 data class LiveSessionConfig(
     val audio: AudioConfiguration,
@@ -33,6 +34,9 @@ class AVLiveView @JvmOverloads constructor(
     private var encoderRecorder: CameraRecorder? = null
     private var encoderWatermark: Watermark? = null
     private var streaming = false
+    private val simulcastLayers = mutableSetOf<Int>()
+    // Set from a prepared reconfigure until its commit runs on the render thread.
+    private val reconfiguring = AtomicBoolean(false)
 
     init {
         attachCameraCallbacks()
@@ -143,6 +147,8 @@ class AVLiveView @JvmOverloads constructor(
             return
         }
         streaming = false
+        reconfiguring.set(false)
+        simulcastLayers.toList().forEach(::removeSimulcastLayer)
         encoderRecorder?.stop()
         encoderRecorder = null
         activeSender?.stopSession()
@@ -161,6 +167,82 @@ class AVLiveView @JvmOverloads constructor(
         activeSender?.updateVideoBps(bps)
     }
 
+    /**
+     * Adds a simulcast rendition while streaming: the camera frames are also rendered at
+     * [videoConfiguration]'s size into an encoder of their own, pushed to [url] on a separate
+     * connection, with the audio of the primary stream. [layer] is 1..N and names the
+     * rendition for [removeSimulcastLayer]. Blocks for the encoder configure.
+     */
+    fun addSimulcastLayer(layer: Int, url: String, videoConfiguration: VideoConfiguration): Boolean {
+        val sender = activeSender
+        val recorder = encoderRecorder
+        if (!streaming || sender == null || recorder == null || layer <= 0) {
+            AstraLog.w(logTag, "addSimulcastLayer ignored: layer=$layer streaming=$streaming")
+            return false
+        }
+        removeSimulcastLayer(layer)
+        if (!sender.connectLayer(layer, url)) {
+            return false
+        }
+        val surface = sender.prepareVideoLayer(layer, videoConfiguration) ?: run {
+            AstraLog.e(logTag, "addSimulcastLayer: encoder for layer $layer unavailable")
+            sender.disconnectLayer(layer)
+            return false
+        }
+        recorder.addLayer(layer, surface, videoConfiguration)
+        simulcastLayers.add(layer)
+        return true
+    }
+
+    fun removeSimulcastLayer(layer: Int) {
+        if (!simulcastLayers.remove(layer)) return
+        encoderRecorder?.removeLayer(layer)
+        activeSender?.releaseVideoLayer(layer)
+        activeSender?.disconnectLayer(layer)
+    }
+
+    /**
+     * Switches the live encoder to [videoConfiguration]'s size, frame rate and bitrate without
+     * reconnecting: the current encoder keeps streaming while the new one is configured, and
+     * the stream continues from the new encoder's first key frame. Blocks for the configure,
+     * so call it off the main thread. The codec cannot change; returns false if it would, while
+     * a previous switch is still under way, or when the switch could not be prepared. When not
+     * streaming this is [setVideoConfigure].
+     */
+    fun reconfigureVideo(videoConfiguration: VideoConfiguration): Boolean {
+        if (videoConfiguration.codec != sessionConfig.video.codec) {
+            AstraLog.w(logTag, "reconfigureVideo ignored: codec change needs a restart")
+            return false
+        }
+        val sender = activeSender
+        val recorder = encoderRecorder
+        if (!streaming || sender == null || recorder == null) {
+            setVideoConfigure(videoConfiguration)
+            return true
+        }
+        if (!reconfiguring.compareAndSet(false, true)) {
+            AstraLog.w(logTag, "reconfigureVideo ignored: previous switch still under way")
+            return false
+        }
+        val surface = sender.prepareVideoReconfigure(videoConfiguration) ?: run {
+            AstraLog.e(logTag, "reconfigureVideo: standby encoder unavailable")
+            reconfiguring.set(false)
+            return false
+        }
+        val switched = recorder.switchSurface(surface, videoConfiguration) {
+            sender.commitVideoReconfigure()
+            reconfiguring.set(false)
+        }
+        if (!switched) {
+            AstraLog.e(logTag, "reconfigureVideo: encoder renderer not running")
+            surface.release()
+            reconfiguring.set(false)
+            return false
+        }
+        sessionConfig = sessionConfig.copy(video = videoConfiguration)
+        return true
+    }
+
     private fun configureNativeSession() {
         val sender = activeSender ?: return
         sender.configureSession(sessionConfig.audio, sessionConfig.video)
@@ -199,7 +281,9 @@ class AVLiveView @JvmOverloads constructor(
             codec = codec,
             mime = mime,
             spspps = spspps,
-            surface = surface
+            surface = surface,
+            zeroCopyOutput = zeroCopyOutput,
+            temporalLayers = temporalLayers
         )
     }
 
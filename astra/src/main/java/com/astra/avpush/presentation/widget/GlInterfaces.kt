@@ -7,6 +7,8 @@ interface GlRenderer {
     fun onSurfaceCreate(width: Int, height: Int) {}
     fun onSurfaceChange(width: Int, height: Int) {}
     fun onDraw() {}
+    /** Simulcast: the frame just drawn, again into a layer surface of [width] x [height]. */
+    fun onDrawLayer(width: Int, height: Int) {}
 }
 
 interface GlThreadConfig {
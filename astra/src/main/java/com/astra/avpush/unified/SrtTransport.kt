@@ -0,0 +1,160 @@
+package com.astra.avpush.unified
+
+import com.astra.avpush.infrastructure.stream.nativebridge.NativeSender
+import com.astra.avpush.infrastructure.stream.nativebridge.NativeSenderFactory
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import java.net.URLEncoder
+import java.time.Duration
+
+/**
+ * SRT 传输实现（MPEG-TS over SRT live 模式），与 RTMP 共用 NativeSenderBridge。
+ * 延迟与 streamid 通过 URL 参数传给 native 层。
+ */
+class SrtTransport(private val config: SrtConfig) : StreamTransport {
+
+    override val id: TransportId = config.id
+    override val protocol: TransportProtocol = TransportProtocol.SRT
+
+    private val sender: NativeSender = NativeSenderFactory.createForProtocol(protocol)
+
+    private val _state = MutableStateFlow<TransportState>(TransportState.DISCONNECTED)
+    override val state: StateFlow<TransportState> = _state.asStateFlow()
+
+    private val _stats = MutableStateFlow(
+        TransportStats(
+            transportId = id,
+            protocol = protocol,
+            state = TransportState.DISCONNECTED,
+            bytesSent = 0,
+            packetsLost = 0,
+            rtt = Duration.ZERO,
+            jitter = Duration.ZERO,
+            bandwidth = 0,
+            connectionTime = Duration.ZERO
+        )
+    )
+    override val stats: StateFlow<TransportStats> = _stats.asStateFlow()
+
+    override suspend fun connect() {
+        if (_state.value == TransportState.STREAMING || _state.value == TransportState.CONNECTING) {
+            return
+        }
+        _state.value = TransportState.CONNECTING
+        runCatching { withContext(Dispatchers.IO) { sender.connect(buildUrl(config)) } }
+            .onSuccess {
+                _state.value = TransportState.STREAMING
+            }
+            .onFailure { error ->
+                _state.value = TransportState.ERROR(
+                    TransportError.ConnectionFailed(
+                        transport = protocol,
+                        detail = error.message ?: "SRT connection failed",
+                        error = error
+                    )
+                )
+            }
+    }
+
+    override suspend fun disconnect() {
+        sender.close()
+        _state.value = TransportState.DISCONNECTED
+    }
+
+    override suspend fun sendAudioData(data: AudioData) {
+        // Native pipeline already owns audio capture/encode; no action required.
+    }
+
+    override suspend fun sendVideoData(data: VideoData) {
+        // Native pipeline already owns video capture/encode; no action required.
+    }
+
+    override fun updateBitrate(bitrate: Int) {
+        sender.updateVideoBps(bitrate)
+    }
+
+    override fun getConnectionQuality(): ConnectionQuality {
+        val link = sender.linkStats()
+        return when {
+            _state.value is TransportState.ERROR -> ConnectionQuality.POOR
+            link == null -> ConnectionQuality.FAIR
+            link.packetsDropped > 0 -> ConnectionQuality.POOR
+            link.packetsSent > 0 && link.packetsRetransmitted * 20 > link.packetsSent -> ConnectionQuality.FAIR
+            else -> ConnectionQuality.GOOD
+        }
+    }
+
+    override fun getProtocolSpecificStats(): Map<String, Any> {
+        val link = sender.linkStats() ?: return emptyMap()
+        _stats.value = _stats.value.copy(
+            state = _state.value,
+            bytesSent = link.bytesSent,
+            packetsLost = link.packetsLost,
+            rtt = Duration.ofNanos(link.rttUs * 1000),
+            bandwidth = (link.receiveRateBps / 1000).toInt()
+        )
+        return mapOf(
+            "rttUs" to link.rttUs,
+            "packetsSent" to link.packetsSent,
+            "packetsRetransmitted" to link.packetsRetransmitted,
+            "packetsLost" to link.packetsLost,
+            "packetsDropped" to link.packetsDropped,
+            "latencyMs" to link.latencyMs
+        )
+    }
+
+    override fun supportsCapability(capability: String): Boolean {
+        return capability in getSupportedCapabilities()
+    }
+
+    override fun getSupportedCapabilities(): List<String> = listOf(
+        TransportCapabilities.LOW_LATENCY,
+        TransportCapabilities.ADAPTIVE_BITRATE,
+        TransportCapabilities.STATISTICS
+    )
+
+    private companion object {
+        fun buildUrl(config: SrtConfig): String {
+            val separator = if (config.serverUrl.contains('?')) '&' else '?'
+            val builder = StringBuilder(config.serverUrl)
+                .append(separator)
+                .append("latency=").append(config.latency.toMillis())
+            // URLEncoder writes a space as '+', which the native URL parser keeps literally
+            // (as SRT tools do); a literal '+' is already %2B here.
+            config.streamId?.let {
+                builder.append("&streamid=").append(URLEncoder.encode(it, "UTF-8").replace("+", "%20"))
+            }
+            return builder.toString()
+        }
+    }
+}
+
+class SrtTransportFactory : TransportFactory {
+    override val supportedProtocol: TransportProtocol = TransportProtocol.SRT
+
+    override fun create(config: TransportConfig): StreamTransport {
+        require(config is SrtConfig) { "Expected SrtConfig, got ${config::class.simpleName}" }
+        return SrtTransport(config)
+    }
+
+    override fun validateConfig(config: TransportConfig): ConfigValidationResult {
+        if (config !is SrtConfig) {
+            return ConfigValidationResult(isValid = false, errors = listOf("Invalid config type"))
+        }
+        val errors = mutableListOf<String>()
+        if (!config.serverUrl.startsWith("srt://")) {
+            errors += "Server URL must start with srt://"
+        }
+        if (config.encryption != SrtEncryption.NONE) {
+            errors += "SRT encryption is not supported by the native sender"
+        }
+        val latencyMs = config.latency.toMillis()
+        if (latencyMs < 20 || latencyMs > 65535) {
+            errors += "Latency must be between 20 ms and 65535 ms"
+        }
+        return ConfigValidationResult(errors.isEmpty(), errors)
+    }
+}